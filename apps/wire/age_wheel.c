@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/age_wheel.c
+ * @brief         Hierarchical timer wheel for flow table aging
+ */
+
+#ifndef _AGE_WHEEL_C_
+#define _AGE_WHEEL_C_
+
+#include "config.h"
+
+#ifdef CFG_AGE_WHEEL
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <std/reg_utils.h>
+
+#include "age_wheel.h"
+#include "host_ring.h"
+
+#ifdef CFG_CONNTRACK
+#include "conntrack.h"
+#endif
+
+#ifdef CFG_FLOWREC
+#include "flowrec.h"
+#endif
+
+/*
+ * Each bucket has two halves.  The count word holds the half links are
+ * added to (AGE_CNT_HALF) and the number of links in it, the aging context
+ * switches the half atomically before it walks the other one.
+ */
+__export __emem uint32_t age_cnt[AGE_BUCKETS];
+__export __emem __align64 uint32_t age_bucket[AGE_BUCKETS][2][AGE_BUCKET_SZ];
+
+HOST_RING_DECLARE(age_export, struct age_rec, AGE_EXPORT_ENTRIES);
+
+__export __emem struct age_cfg age_cfg;
+__export __emem struct age_cntrs age_cntrs;
+
+/* Sleep granularity of the aging context, in ME cycles */
+#define AGE_SLEEP               4096
+
+/* Links read from a bucket at a time */
+#define AGE_CHUNK               8
+
+/* Reads of a link claimed but not yet written before it is given up */
+#define AGE_LINK_TRIES          16
+
+
+/*
+ * Link into the bucket covering @tmo units from @now.  The bucket may be
+ * the one being popped when the clocks of the MEs differ, the link then
+ * goes to the half that is not being walked.
+ */
+__intrinsic static int
+age_link_at(uint32_t link, uint32_t tmo, uint32_t now)
+{
+    __xrw uint32_t cnt;
+    __xwrite uint32_t link_out;
+    __gpr uint32_t half;
+    __gpr uint32_t n;
+    __gpr uint32_t exp;
+    __gpr uint32_t slot;
+    __gpr unsigned int lvl;
+    __gpr unsigned int shf;
+    __gpr unsigned int b;
+
+    if (tmo == 0)
+        tmo = 1;
+    exp = now + tmo;
+
+    for (lvl = 0; lvl < AGE_LEVELS; lvl++) {
+        shf = lvl * AGE_SLOTS_SHF;
+        if ((exp >> shf) - (now >> shf) < AGE_SLOTS)
+            break;
+    }
+
+    if (lvl == AGE_LEVELS) {
+        /* Beyond the span of the wheel, relinked when the bucket pops */
+        lvl = AGE_LEVELS - 1;
+        slot = (now >> shf) + AGE_SLOTS - 1;
+    } else {
+        slot = exp >> shf;
+    }
+
+    b = lvl * AGE_SLOTS + (slot & (AGE_SLOTS - 1));
+    cnt = 1;
+    mem_test_add(&cnt, &age_cnt[b], sizeof(cnt));
+    half = cnt >> AGE_CNT_HALF_shf;
+    n = cnt & AGE_CNT_MASK;
+    if (n >= AGE_BUCKET_SZ) {
+        mem_incr64(&age_cntrs.overflow);
+        return -1;
+    }
+
+    link_out = link;
+    mem_write32(&link_out, &age_bucket[b][half][n], sizeof(link_out));
+    return 0;
+}
+
+__intrinsic void
+age_link(unsigned int tbl, unsigned int idx, unsigned int gen, uint32_t tmo)
+{
+    __gpr struct age_link link;
+
+    link.tbl = tbl;
+    link.gen = gen;
+    link.idx = idx;
+
+    if (age_link_at(link.__raw, tmo, AGE_TS_NOW()) == 0)
+        mem_incr64(&age_cntrs.linked);
+}
+
+/*
+ * Ask the table of a link about its entry and expire or relink it
+ */
+__intrinsic static void
+age_entry(uint32_t link_raw, uint32_t now, unsigned int export)
+{
+    __gpr struct age_link link;
+    __lmem struct age_rec rec;
+    __xwrite struct age_rec rec_out;
+    __gpr int tmo;
+
+    link.__raw = link_raw;
+
+    switch (link.tbl) {
+#ifdef CFG_CONNTRACK
+    case AGE_TBL_CT:
+        tmo = ct_age(link.idx, link.gen, &rec);
+        break;
+#endif
+#ifdef CFG_FLOWREC
+    case AGE_TBL_FR:
+        tmo = fr_age(link.idx, link.gen, &rec);
+        break;
+#endif
+    default:
+        tmo = -1;
+        break;
+    }
+
+    if (tmo < 0) {
+        mem_incr64(&age_cntrs.stale);
+    } else if (tmo > 0) {
+        if (age_link_at(link_raw, tmo, now) == 0)
+            mem_incr64(&age_cntrs.relinked);
+    } else {
+        mem_incr64(&age_cntrs.expired);
+        if (export) {
+            rec.tbl = link.tbl;
+            rec.resv = 0;
+            rec.idx = link.idx;
+            rec.ts = now;
+            reg_cp(&rec_out, &rec, sizeof(rec_out));
+            host_ring_put(&rec_out, age_export, &age_export_wptr,
+                          AGE_EXPORT_ENTRIES, sizeof(rec_out));
+            mem_incr64(&age_cntrs.exported);
+        }
+    }
+}
+
+/*
+ * Read a link that was claimed before the half was switched, waiting for
+ * its producer to write it.  Returns 0 if it never shows up.
+ */
+__intrinsic static uint32_t
+age_link_wait(__mem40 uint32_t *slot)
+{
+    __xread uint32_t link_in;
+    __gpr int tries;
+
+    for (tries = 0; tries < AGE_LINK_TRIES; tries++) {
+        mem_read32(&link_in, slot, sizeof(link_in));
+        if (link_in != 0)
+            return link_in;
+        sleep(AGE_SLEEP / AGE_LINK_TRIES);
+    }
+
+    return 0;
+}
+
+/*
+ * Pop all links of bucket @b.  The half links are added to is switched
+ * with a single swap of the count word, so no producer writes to the
+ * half being walked once its count is known, and links of live entries
+ * go to the other half or to other buckets.  Walked slots are cleared,
+ * an empty slot is a link still being written.
+ */
+__intrinsic static void
+age_bucket_pop(unsigned int b, uint32_t now, unsigned int export)
+{
+    __xread uint32_t cnt_in;
+    __xrw uint32_t cnt_swap;
+    __xread uint32_t links_in[AGE_CHUNK];
+    __xwrite uint32_t zero_out[AGE_CHUNK];
+    __lmem uint32_t links[AGE_CHUNK];
+    __gpr uint32_t half;
+    __gpr unsigned int cnt;
+    __gpr unsigned int i;
+    __gpr unsigned int j;
+
+    /* Only this context changes the half, producers only add */
+    mem_read32(&cnt_in, &age_cnt[b], sizeof(cnt_in));
+    if ((cnt_in & AGE_CNT_MASK) == 0)
+        return;
+    half = cnt_in >> AGE_CNT_HALF_shf;
+    cnt_swap = (half ^ 1) << AGE_CNT_HALF_shf;
+    mem_swap(&cnt_swap, &age_cnt[b], sizeof(cnt_swap));
+
+    cnt = cnt_swap & AGE_CNT_MASK;
+    if (cnt > AGE_BUCKET_SZ)
+        cnt = AGE_BUCKET_SZ;
+
+    for (j = 0; j < AGE_CHUNK; j++)
+        zero_out[j] = 0;
+
+    for (i = 0; i < cnt; i += AGE_CHUNK) {
+        mem_read32(links_in, &age_bucket[b][half][i], sizeof(links_in));
+        reg_cp(links, links_in, sizeof(links));
+        mem_write32(zero_out, &age_bucket[b][half][i], sizeof(zero_out));
+
+        for (j = 0; j < AGE_CHUNK && i + j < cnt; j++) {
+            if (links[j] == 0) {
+                links[j] = age_link_wait(&age_bucket[b][half][i + j]);
+                if (links[j] == 0) {
+                    mem_incr64(&age_cntrs.late);
+                    continue;
+                }
+                mem_write32(zero_out, &age_bucket[b][half][i + j],
+                            sizeof(uint32_t));
+            }
+            age_entry(links[j], now, export);
+        }
+    }
+}
+
+void
+age_wheel_loop(void)
+{
+    __xread struct age_cfg cfg;
+    __lmem uint32_t cur[AGE_LEVELS];
+    __gpr uint32_t now;
+    __gpr uint32_t t;
+    __gpr int lvl;
+
+    now = AGE_TS_NOW();
+    for (lvl = 0; lvl < AGE_LEVELS; lvl++)
+        cur[lvl] = now >> (lvl * AGE_SLOTS_SHF);
+
+    for (;;) {
+        sleep(AGE_SLEEP);
+        now = AGE_TS_NOW();
+        mem_read32(&cfg, &age_cfg, sizeof(cfg));
+
+        /* Higher levels first, their links cascade into lower levels */
+        for (lvl = AGE_LEVELS - 1; lvl >= 0; lvl--) {
+            t = now >> (lvl * AGE_SLOTS_SHF);
+            while (cur[lvl] != t) {
+                cur[lvl]++;
+                age_bucket_pop(lvl * AGE_SLOTS +
+                               (cur[lvl] & (AGE_SLOTS - 1)), now,
+                               cfg.export);
+            }
+        }
+
+#ifdef CFG_FLOWREC
+        fr_flush_stale(now);
+#endif
+    }
+}
+
+#endif /* CFG_AGE_WHEEL */
+
+#endif /* _AGE_WHEEL_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
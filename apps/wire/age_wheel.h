@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/age_wheel.h
+ * @brief         Hierarchical timer wheel for flow table aging
+ *
+ * Flow tables link their entries into the wheel when an entry is created
+ * and a single context on the service ME expires them, so no table is
+ * ever scanned.  The wheel has AGE_LEVELS levels of AGE_SLOTS buckets,
+ * the buckets of level n are AGE_SLOTS^n time units wide.  An entry is
+ * linked into the lowest level whose span covers its timeout, entries
+ * beyond the span of the wheel go to the last bucket of the top level.
+ *
+ * The aging context pops every bucket once its time has come and asks the
+ * owning table about each entry.  Expired entries are deleted by the
+ * table (and optionally exported to the host), live entries are linked
+ * again according to their remaining time.  Refreshing an entry on the
+ * packet path therefore only updates its timestamp: the entry moves to a
+ * later bucket when its current bucket pops, and higher level buckets
+ * cascade into lower levels the same way.
+ *
+ * A link carries a generation number of the entry so that links left
+ * behind by deleted or reused entries are recognised as stale.  Buckets
+ * have a fixed size, entries that do not fit are counted as overflow and
+ * left to the lazy expiry of their table.  Each bucket has two halves so
+ * that links added while it is popped, by an ME whose clock is ahead of
+ * the aging context, are kept for its next turn.
+ */
+
+#ifndef _AGE_WHEEL_H_
+#define _AGE_WHEEL_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/*
+ * Time unit of the wheel, the ME timestamp counter shifted right by
+ * AGE_TS_SHF.  It matches the timestamps of the conntrack table (about
+ * 21 ms at 800 MHz).
+ */
+#ifndef AGE_TS_SHF
+#define AGE_TS_SHF              20
+#endif
+
+/* Wheel geometry, 3 levels of 64 buckets span 2^18 units (~93 min) */
+#ifndef AGE_LEVELS
+#define AGE_LEVELS              3
+#endif
+
+#define AGE_SLOTS_SHF           6
+#define AGE_SLOTS               (1 << AGE_SLOTS_SHF)
+#define AGE_BUCKETS             (AGE_LEVELS * AGE_SLOTS)
+
+/* Links per bucket half, a multiple of 8 */
+#ifndef AGE_BUCKET_SZ
+#define AGE_BUCKET_SZ           4096
+#endif
+
+#if (AGE_BUCKET_SZ % 8) != 0
+#error "AGE_BUCKET_SZ must be a multiple of 8"
+#endif
+
+/* Bucket count word, the half links are added to and their number */
+#define AGE_CNT_HALF_shf        31
+#define AGE_CNT_MASK            ((1 << AGE_CNT_HALF_shf) - 1)
+
+/* Records in the export ring, a power of 2 */
+#ifndef AGE_EXPORT_ENTRIES
+#define AGE_EXPORT_ENTRIES      4096
+#endif
+
+/* Service ME context running age_wheel_loop() */
+#ifndef AGE_WHEEL_CTX
+#define AGE_WHEEL_CTX           7
+#endif
+
+/**
+ * Tables using the wheel, none is 0 so that a link is never 0
+ */
+enum age_tbl {
+    AGE_TBL_CT      = 1,        /** Connection tracking (conntrack.h) */
+    AGE_TBL_FR      = 2,        /** Flow records (flowrec.h) */
+};
+
+/**
+ * Link of an entry in a bucket
+ */
+struct age_link {
+    union {
+        struct {
+            unsigned int tbl:4;         /** enum age_tbl */
+            unsigned int gen:8;         /** Generation of the entry */
+            unsigned int idx:20;        /** Index of the entry */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * Record of an expired entry in the export ring.  The data words are
+ * defined by the table, see tools/age_ctl.py.
+ */
+struct age_rec {
+    union {
+        struct {
+            unsigned int tbl:4;         /** enum age_tbl */
+            unsigned int resv:8;        /** Reserved */
+            unsigned int idx:20;        /** Index of the entry */
+
+            uint32_t ts;                /** Time of expiry, wheel units */
+
+            uint32_t data[6];           /** Table specific */
+
+            uint32_t seq;               /** Ring sequence number */
+        };
+        uint32_t __raw[9];
+    };
+};
+
+/**
+ * Host configuration
+ */
+struct age_cfg {
+    union {
+        struct {
+            unsigned int export:1;      /** Export expired entries */
+            unsigned int resv:31;       /** Reserved */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * Counters
+ */
+struct age_cntrs {
+    uint64_t linked;            /** Entries linked by the tables */
+    uint64_t relinked;          /** Live entries linked again */
+    uint64_t expired;           /** Entries expired */
+    uint64_t stale;             /** Links of deleted or reused entries */
+    uint64_t overflow;          /** Links dropped, bucket full */
+    uint64_t exported;          /** Records written to the export ring */
+    uint64_t late;              /** Links not written in time to be popped */
+};
+
+/**
+ * Current time in wheel units
+ */
+#define AGE_TS_NOW()    ((uint32_t)(me_tsc_read() >> AGE_TS_SHF))
+
+/**
+ * Link a table entry into the wheel.
+ * @param tbl       Table of the entry (enum age_tbl)
+ * @param idx       Index of the entry in its table
+ * @param gen       Generation of the entry
+ * @param tmo       Time until the entry expires, in wheel units
+ */
+__intrinsic void age_link(unsigned int tbl, unsigned int idx,
+                          unsigned int gen, uint32_t tmo);
+
+/**
+ * Aging loop, never returns.  Meant to be run by a single context on the
+ * service ME.
+ */
+void age_wheel_loop(void);
+
+#endif /* _AGE_WHEEL_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -44,6 +44,8 @@
 #define BLM_NBI9_BLQ2_EMU_Q_LOCALITY            (MU_LOCALITY_HIGH)
 #define BLM_NBI9_BLQ3_EMU_Q_LOCALITY            (MU_LOCALITY_HIGH)
 
+/* BLM_EMU_RING_SPREAD leaves the ring islands to blm_cfg.h */
+#ifndef BLM_EMU_RING_SPREAD
 #define BLM_NBI8_BLQ0_EMU_Q_ISLAND              24
 #define BLM_NBI8_BLQ1_EMU_Q_ISLAND              24
 #define BLM_NBI8_BLQ2_EMU_Q_ISLAND              24
@@ -53,6 +55,7 @@
 #define BLM_NBI9_BLQ1_EMU_Q_ISLAND              24
 #define BLM_NBI9_BLQ2_EMU_Q_ISLAND              24
 #define BLM_NBI9_BLQ3_EMU_Q_ISLAND              24
+#endif
 
 #if defined(__NFP_LANG_ASM)
     #ifndef BLM_BLQ_EMEM_TYPE
@@ -92,6 +95,13 @@
 /* EMU Ring 0 NBI8 */
 #define BLM_NBI8_BLQ0_EMU_IMEM0_NUM_BUFS        128
 #define BLM_NBI8_BLQ0_BDSRAM_IMEM0_NUM_BUFS     128
+#ifdef BLM_EMU_RING_SPREAD
+/* From the EMU of the ring, see blm_cfg.h */
+#define BLM_NBI8_BLQ0_EMU_IMEM0_DENSITY         1
+#define BLM_NBI8_BLQ0_EMU_NUM_BUFS              896
+#define BLM_NBI8_BLQ0_BDSRAM_NUM_BUFS           896
+#define BLM_NBI8_BLQ0_EMU_DENSITY               7
+#else
 #ifdef USE_EMEM1
 #define BLM_NBI8_BLQ0_EMU_IMEM0_DENSITY         2
 #define BLM_NBI8_BLQ0_EMU_EMEM0_NUM_BUFS        448
@@ -109,12 +119,13 @@
 #define BLM_NBI8_BLQ0_BDSRAM_EMEM1_NUM_BUFS     0
 #define BLM_NBI8_BLQ0_EMU_EMEM1_DENSITY         0
 #endif
-#define BLM_NBI8_BLQ0_EMU_IMEM1_NUM_BUFS        0
-#define BLM_NBI8_BLQ0_BDSRAM_IMEM1_NUM_BUFS     0
-#define BLM_NBI8_BLQ0_EMU_IMEM1_DENSITY         0
 #define BLM_NBI8_BLQ0_EMU_EMEM2_NUM_BUFS        0
 #define BLM_NBI8_BLQ0_BDSRAM_EMEM2_NUM_BUFS     0
 #define BLM_NBI8_BLQ0_EMU_EMEM2_DENSITY         0
+#endif
+#define BLM_NBI8_BLQ0_EMU_IMEM1_NUM_BUFS        0
+#define BLM_NBI8_BLQ0_BDSRAM_IMEM1_NUM_BUFS     0
+#define BLM_NBI8_BLQ0_EMU_IMEM1_DENSITY         0
 /* EMU Ring 0 NBI9 */
 #define BLM_NBI9_BLQ0_EMU_IMEM0_NUM_BUFS        0
 #define BLM_NBI9_BLQ0_BDSRAM_IMEM0_NUM_BUFS     0
@@ -139,6 +150,11 @@
 #define BLM_NBI8_BLQ1_EMU_IMEM1_NUM_BUFS        0
 #define BLM_NBI8_BLQ1_BDSRAM_IMEM1_NUM_BUFS     0
 #define BLM_NBI8_BLQ1_EMU_IMEM1_DENSITY         0
+#ifdef BLM_EMU_RING_SPREAD
+/* Buffer pools 4-7, see init/nfp_nbi8_dma_i32_i33_2blq.json */
+#define BLM_NBI8_BLQ1_EMU_NUM_BUFS              896
+#define BLM_NBI8_BLQ1_BDSRAM_NUM_BUFS           896
+#else
 #define BLM_NBI8_BLQ1_EMU_EMEM0_NUM_BUFS        0
 #define BLM_NBI8_BLQ1_BDSRAM_EMEM0_NUM_BUFS     0
 #define BLM_NBI8_BLQ1_EMU_EMEM0_DENSITY         0
@@ -148,6 +164,7 @@
 #define BLM_NBI8_BLQ1_EMU_EMEM2_NUM_BUFS        0
 #define BLM_NBI8_BLQ1_BDSRAM_EMEM2_NUM_BUFS     0
 #define BLM_NBI8_BLQ1_EMU_EMEM2_DENSITY         0
+#endif
 /* EMU Ring 1 NBI9 */
 #define BLM_NBI9_BLQ1_EMU_IMEM0_NUM_BUFS        0
 #define BLM_NBI9_BLQ1_BDSRAM_IMEM0_NUM_BUFS     0
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/bridge.c
+ * @brief         L2 learning bridge
+ */
+
+#ifndef _BRIDGE_C_
+#define _BRIDGE_C_
+
+#include "config.h"
+
+#ifdef CFG_BRIDGE
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/mem_cam.h>
+#include <nfp/mem_ring.h>
+#include <std/hash.h>
+
+#include "bridge.h"
+
+/* FDB CAM buckets and the entries matching the CAM slots */
+__export __emem __align64 uint32_t bridge_fdb_cam[BRIDGE_FDB_BUCKETS]
+                                                 [BRIDGE_FDB_BUCKET_SZ];
+__export __emem struct bridge_fdb_entry bridge_fdb[BRIDGE_FDB_ENTRIES];
+
+/* Host written configuration */
+__export __emem struct bridge_port_cfg bridge_port_cfg[BRIDGE_NUM_PORTS];
+__export __emem uint64_t bridge_vlan_flood[BRIDGE_NUM_VLANS];
+__export __emem uint32_t bridge_age_time;
+
+__export __emem struct bridge_cntrs bridge_cntrs;
+
+/* Learn requests from the packet path to the learn context */
+MEM_RING_INIT(bridge_learn_ring, BRIDGE_LEARN_RING_SZ * 4);
+
+/*
+ * Learn rate limiter of this ME, the theoretical arrival time of the next
+ * learn request.  bridge_learn_allowed() only reads the timestamp CSR
+ * between its load and store, so no other context runs in between.
+ */
+__shared __lmem uint64_t bridge_learn_tat;
+
+#define BRIDGE_HASH_SEED        0x62726467
+
+/* Learn requests handled per iteration of the learn loop */
+#define BRIDGE_LEARN_BATCH      16
+#define BRIDGE_LEARN_SLEEP      2048
+
+#define BRIDGE_TS_NOW()         ((uint32_t)(me_tsc_read() >> BRIDGE_TS_SHF))
+
+
+/*
+ * Signature of a key, zero marks empty CAM slots
+ */
+__intrinsic static uint32_t
+bridge_sig(__lmem uint32_t *key)
+{
+    __gpr uint32_t sig;
+
+    sig = hash_me_crc32(key, 2 * sizeof(uint32_t), BRIDGE_HASH_SEED);
+    if (sig == 0)
+        sig = 1;
+
+    return sig;
+}
+
+/*
+ * Look up a key in the FDB.  Returns the index of the entry and copies it
+ * to @e, or returns -1 if not found.
+ */
+__intrinsic static int
+bridge_fdb_lookup(__lmem uint32_t *key, uint32_t sig,
+                  __gpr struct bridge_fdb_entry *e)
+{
+    __xrw struct mem_cam_32bit cam;
+    __xread struct bridge_fdb_entry entry;
+    __gpr unsigned int bucket;
+    __gpr int idx;
+
+    bucket = sig & (BRIDGE_FDB_BUCKETS - 1);
+    cam.search.value = sig;
+    mem_cam_lookup(&cam, bridge_fdb_cam[bucket], 512, 32);
+    if (!mem_cam_lookup_hit(cam))
+        return -1;
+
+    idx = bucket * BRIDGE_FDB_BUCKET_SZ + cam.result.match;
+    mem_read32(&entry, &bridge_fdb[idx], sizeof(entry));
+    if (!entry.valid || entry.__raw[0] != key[0] || entry.__raw[1] != key[1])
+        return -1;
+
+    *e = entry;
+    return idx;
+}
+
+/*
+ * Token bucket of the learn requests of this ME, in GCRA form
+ */
+__intrinsic static int
+bridge_learn_allowed(void)
+{
+    __gpr uint64_t now;
+
+    now = me_tsc_read();
+    if (bridge_learn_tat < now)
+        bridge_learn_tat = now;
+    if (bridge_learn_tat - now >
+        (BRIDGE_LEARN_BURST - 1) * BRIDGE_LEARN_TICKS)
+        return 0;
+
+    bridge_learn_tat += BRIDGE_LEARN_TICKS;
+    return 1;
+}
+
+__intrinsic static void
+bridge_learn_req(__lmem uint32_t *key, uint32_t sig, unsigned int port)
+{
+    __xrw struct bridge_learn_req req;
+
+    if (!bridge_learn_allowed()) {
+        mem_incr64(&bridge_cntrs.learn_limited);
+        return;
+    }
+
+    req.key[0] = key[0];
+    req.key[1] = key[1];
+    req.port = port;
+    req.sig = sig;
+    if (mem_ring_put(MEM_RING_GET_NUM(bridge_learn_ring),
+                     MEM_RING_GET_MEMADDR(bridge_learn_ring),
+                     &req, sizeof(req)) < 0) {
+        mem_incr64(&bridge_cntrs.learn_ring_full);
+        return;
+    }
+
+    mem_incr64(&bridge_cntrs.learn_req);
+}
+
+__intrinsic enum bridge_res
+bridge_pkt(__mem40 char *pbuf, unsigned int l2_off, unsigned int port,
+           uint64_t *ports)
+{
+    __xread struct bridge_port_cfg cfg;
+    __xread uint32_t hdr[4];
+    __xread uint64_t flood_in;
+    __xwrite uint32_t ts_out;
+    __lmem uint32_t key[2];
+    __gpr struct bridge_fdb_entry e;
+    __gpr uint64_t flood;
+    __gpr unsigned int vlan;
+    __gpr uint32_t sig;
+    __gpr uint32_t now;
+    __gpr int idx;
+
+    port &= (BRIDGE_NUM_PORTS - 1);
+    mem_read32(&cfg, &bridge_port_cfg[port], sizeof(cfg));
+    if (!cfg.enable)
+        return BRIDGE_RES_NONE;
+
+    /* Destination, source and the Ethertype/TCI of a tagged frame */
+    mem_read8(hdr, pbuf + l2_off, sizeof(hdr));
+    if ((hdr[3] >> 16) == NET_ETH_TYPE_TPID)
+        vlan = NET_ETH_TCI_VID_of(hdr[3]);
+    else
+        vlan = cfg.pvid;
+
+    /* Learn the source address */
+    if (cfg.learn && !((hdr[1] >> 8) & NET_ETH_GROUP_ADDR)) {
+        key[0] = (hdr[1] << 16) | (hdr[2] >> 16);
+        key[1] = (hdr[2] << 16) | vlan;
+        sig = bridge_sig(key);
+        idx = bridge_fdb_lookup(key, sig, &e);
+        if (idx < 0 || (e.port != port && !e.is_static)) {
+            bridge_learn_req(key, sig, port);
+        } else if (!e.is_static) {
+            now = BRIDGE_TS_NOW();
+            if (now - e.ts >= BRIDGE_TS_REFRESH) {
+                ts_out = now;
+                mem_write32(&ts_out, &bridge_fdb[idx].ts, sizeof(ts_out));
+            }
+        }
+    }
+
+    mem_read64(&flood_in, &bridge_vlan_flood[vlan], sizeof(flood_in));
+    flood = flood_in & ~(1ull << port);
+
+    if ((hdr[0] >> 24) & NET_ETH_GROUP_ADDR) {
+        if (flood == 0)
+            goto filtered;
+        *ports = flood;
+        mem_incr64(&bridge_cntrs.flood);
+        return BRIDGE_RES_FLOOD;
+    }
+
+    key[0] = hdr[0];
+    key[1] = (hdr[1] & 0xffff0000) | vlan;
+    idx = bridge_fdb_lookup(key, bridge_sig(key), &e);
+    if (idx < 0) {
+        if (flood == 0)
+            goto filtered;
+        *ports = flood;
+        mem_incr64(&bridge_cntrs.uuc);
+        return BRIDGE_RES_FLOOD_UUC;
+    }
+
+    /* Destination is on the ingress port */
+    if (e.port == port)
+        goto filtered;
+
+    *ports = 1ull << e.port;
+    mem_incr64(&bridge_cntrs.fwd);
+    return BRIDGE_RES_FWD;
+
+filtered:
+    mem_incr64(&bridge_cntrs.filtered);
+    return BRIDGE_RES_DROP;
+}
+
+/*
+ * Insert or update the entry of a learn request.  Only called from the
+ * learn context, which is the only writer of the FDB apart from timestamp
+ * refreshes.
+ */
+__intrinsic static void
+bridge_learn(__xread struct bridge_learn_req *req)
+{
+    __xrw struct mem_cam_32bit cam;
+    __xread struct bridge_fdb_entry old;
+    __xwrite struct bridge_fdb_entry entry;
+    __xwrite uint32_t upd[2];
+    __gpr unsigned int bucket;
+    __gpr unsigned int idx;
+
+    bucket = req->sig & (BRIDGE_FDB_BUCKETS - 1);
+    cam.search.value = req->sig;
+    mem_cam_lookup_add(&cam, bridge_fdb_cam[bucket], 512, 32);
+    if (mem_cam_lookup_add_fail(cam)) {
+        mem_incr64(&bridge_cntrs.fdb_full);
+        return;
+    }
+
+    idx = bucket * BRIDGE_FDB_BUCKET_SZ + (cam.result.match & 0x7f);
+
+    if (mem_cam_lookup_add_added(cam)) {
+        entry.__raw[0] = req->key[0];
+        entry.__raw[1] = req->key[1];
+        entry.__raw[2] = 0;
+        entry.valid = 1;
+        entry.port = req->port;
+        entry.ts = BRIDGE_TS_NOW();
+        mem_write32(&entry, &bridge_fdb[idx], sizeof(entry));
+        mem_incr64(&bridge_cntrs.learned);
+        return;
+    }
+
+    /* Signature already present, the address moved or was queued twice */
+    mem_read32(&old, &bridge_fdb[idx], sizeof(old));
+    if (old.__raw[0] != req->key[0] || old.__raw[1] != req->key[1]) {
+        mem_incr64(&bridge_cntrs.collision);
+        return;
+    }
+
+    if (old.is_static || old.port == req->port)
+        return;
+
+    upd[0] = (old.__raw[2] & ~0xff) | req->port;
+    upd[1] = BRIDGE_TS_NOW();
+    mem_write32(upd, &bridge_fdb[idx].__raw[2], sizeof(upd));
+    mem_incr64(&bridge_cntrs.moved);
+}
+
+/*
+ * Remove the entries of a bucket that have not been seen for @age units.
+ * The CAM slot is released first so that no new lookup finds the entry.
+ */
+__intrinsic static void
+bridge_age_bucket(unsigned int bucket, uint32_t age)
+{
+    __xread uint32_t state[2];
+    __xwrite uint32_t zero;
+    __gpr unsigned int slot;
+    __gpr unsigned int idx;
+    __gpr uint32_t now;
+
+    now = BRIDGE_TS_NOW();
+    zero = 0;
+
+    for (slot = 0; slot < BRIDGE_FDB_BUCKET_SZ; slot++) {
+        idx = bucket * BRIDGE_FDB_BUCKET_SZ + slot;
+        mem_read32(state, &bridge_fdb[idx].__raw[2], sizeof(state));
+        if (!(state[0] >> 31) || ((state[0] >> 30) & 1))
+            continue;
+        if (now - state[1] < age)
+            continue;
+
+        mem_write32(&zero, &bridge_fdb_cam[bucket][slot], sizeof(zero));
+        mem_write32(&zero, &bridge_fdb[idx].__raw[2], sizeof(zero));
+        mem_incr64(&bridge_cntrs.aged);
+    }
+}
+
+void
+bridge_learn_loop(void)
+{
+    __xread struct bridge_learn_req req;
+    __xread uint32_t age_in;
+    __gpr unsigned int bucket = 0;
+    __gpr unsigned int n;
+    __gpr uint32_t age;
+
+    for (;;) {
+        for (n = 0; n < BRIDGE_LEARN_BATCH; n++) {
+            if (mem_ring_get(MEM_RING_GET_NUM(bridge_learn_ring),
+                             MEM_RING_GET_MEMADDR(bridge_learn_ring),
+                             &req, sizeof(req)) != 0)
+                break;
+            bridge_learn(&req);
+        }
+
+        /* Age one bucket per iteration */
+        mem_read32(&age_in, &bridge_age_time, sizeof(age_in));
+        age = age_in;
+        if (age == 0)
+            age = BRIDGE_AGE_DEFAULT;
+        bridge_age_bucket(bucket, age);
+        bucket = (bucket + 1) & (BRIDGE_FDB_BUCKETS - 1);
+
+        if (n == 0)
+            sleep(BRIDGE_LEARN_SLEEP);
+    }
+}
+
+#endif /* CFG_BRIDGE */
+
+#endif /* _BRIDGE_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/bridge.h
+ * @brief         L2 learning bridge
+ *
+ * The forwarding database (FDB) maps a MAC address and VLAN to an egress
+ * port.  It is a hash of 512 bit CAM buckets in EMEM, each holding the 32
+ * bit signatures of up to 16 entries, with the full entries in a separate
+ * table indexed by the bucket and CAM slot.  Frames are forwarded to the
+ * port of their destination, broadcast, multicast and unknown unicast
+ * frames are flooded to the ports of their VLAN.
+ *
+ * The packet path never writes the FDB, apart from refreshing the
+ * timestamp of known source addresses.  New and moved source addresses
+ * are put on a learn ring, subject to a per ME learn rate limit, and
+ * inserted by a single context on the service ME.  The same context ages
+ * out entries that have not been refreshed for the configured age time.
+ *
+ * The bridge is enabled and configured per ingress port, see
+ * tools/bridge_ctl.py.
+ */
+
+#ifndef _BRIDGE_H_
+#define _BRIDGE_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#ifndef BRIDGE_NUM_PORTS
+#define BRIDGE_NUM_PORTS        64
+#endif
+
+#define BRIDGE_NUM_VLANS        4096
+
+/* FDB size, the number of entries is BRIDGE_FDB_BUCKETS * 16 */
+#ifndef BRIDGE_FDB_BUCKETS
+#define BRIDGE_FDB_BUCKETS      4096
+#endif
+
+#define BRIDGE_FDB_BUCKET_SZ    16
+#define BRIDGE_FDB_ENTRIES      (BRIDGE_FDB_BUCKETS * BRIDGE_FDB_BUCKET_SZ)
+
+#if (BRIDGE_FDB_BUCKETS & (BRIDGE_FDB_BUCKETS - 1)) != 0
+#error "BRIDGE_FDB_BUCKETS must be a power of 2"
+#endif
+
+/*
+ * Entry timestamps are the ME timestamp counter shifted right by
+ * BRIDGE_TS_SHF (about 1.3 ms per unit at 800 MHz).  The packet path
+ * only rewrites the timestamp of an entry once it is BRIDGE_TS_REFRESH
+ * units old.  Entries older than the host configured age time, or
+ * BRIDGE_AGE_DEFAULT if none is set, are removed.
+ */
+#define BRIDGE_TS_SHF           16
+
+#ifndef BRIDGE_TS_REFRESH
+#define BRIDGE_TS_REFRESH       256
+#endif
+
+#ifndef BRIDGE_AGE_DEFAULT
+#define BRIDGE_AGE_DEFAULT      228000  /* about 300 s */
+#endif
+
+/*
+ * Learn rate limit per packet processing ME: one learn request every
+ * BRIDGE_LEARN_TICKS timestamp ticks with bursts of BRIDGE_LEARN_BURST.
+ */
+#ifndef BRIDGE_LEARN_TICKS
+#define BRIDGE_LEARN_TICKS      1000
+#endif
+
+#ifndef BRIDGE_LEARN_BURST
+#define BRIDGE_LEARN_BURST      16
+#endif
+
+/* Learn ring size in 32 bit words */
+#ifndef BRIDGE_LEARN_RING_SZ
+#define BRIDGE_LEARN_RING_SZ    4096
+#endif
+
+/* Service ME context running bridge_learn_loop() */
+#ifndef BRIDGE_LEARN_CTX
+#define BRIDGE_LEARN_CTX        3
+#endif
+
+/**
+ * FDB entry.  The first two words are the lookup key.
+ */
+struct bridge_fdb_entry {
+    union {
+        struct {
+            uint32_t mac_hi;            /** MAC address bytes 0-3 */
+
+            unsigned int mac_lo:16;     /** MAC address bytes 4-5 */
+            unsigned int resv0:4;       /** Reserved, must be zero */
+            unsigned int vlan:12;       /** VLAN ID */
+
+            unsigned int valid:1;       /** Entry in use */
+            unsigned int is_static:1;   /** Never aged or moved */
+            unsigned int resv1:22;      /** Reserved */
+            unsigned int port:8;        /** Egress port */
+
+            uint32_t ts;                /** Last seen, see BRIDGE_TS_SHF */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Learn request, put on the learn ring by the packet path
+ */
+struct bridge_learn_req {
+    union {
+        struct {
+            uint32_t key[2];            /** Key words of the entry */
+            uint32_t port;              /** Ingress port */
+            uint32_t sig;               /** Signature of the key */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Per ingress port configuration
+ */
+struct bridge_port_cfg {
+    union {
+        struct {
+            unsigned int enable:1;      /** Bridge frames from this port */
+            unsigned int learn:1;       /** Learn source addresses */
+            unsigned int resv:18;       /** Reserved */
+            unsigned int pvid:12;       /** VLAN of untagged frames */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * Global counters
+ */
+struct bridge_cntrs {
+    uint64_t fwd;               /** Frames forwarded to a known port */
+    uint64_t flood;             /** Broadcast/multicast frames flooded */
+    uint64_t uuc;               /** Unknown unicast frames flooded */
+    uint64_t filtered;          /** Dropped, no port to send to */
+    uint64_t learn_req;         /** Learn requests queued */
+    uint64_t learn_limited;     /** Learn requests over the rate limit */
+    uint64_t learn_ring_full;   /** Learn requests lost, ring full */
+    uint64_t learned;           /** Entries added */
+    uint64_t moved;             /** Entries moved to another port */
+    uint64_t aged;              /** Entries aged out */
+    uint64_t fdb_full;          /** Entries not added, bucket full */
+    uint64_t collision;         /** Entries not added, signature in use */
+};
+
+/**
+ * Return values of bridge_pkt()
+ */
+enum bridge_res {
+    BRIDGE_RES_NONE      = 0,   /** Bridge not enabled on the port */
+    BRIDGE_RES_FWD       = 1,   /** Known unicast destination */
+    BRIDGE_RES_FLOOD     = 2,   /** Broadcast or multicast, flood */
+    BRIDGE_RES_FLOOD_UUC = 3,   /** Unknown unicast, flood */
+    BRIDGE_RES_DROP      = 4,   /** Frame must be dropped */
+};
+
+/**
+ * Look up the destination of a frame and learn its source.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param port      Ingress port
+ * @param ports     Set to the bitmap of egress ports on FWD and FLOOD
+ * @return          One of enum bridge_res
+ *
+ * The ingress port is never part of @ports.
+ */
+__intrinsic enum bridge_res bridge_pkt(__mem40 char *pbuf, unsigned int l2_off,
+                                       unsigned int port, uint64_t *ports);
+
+/**
+ * Learn and aging loop, never returns.  Must be run by a single context
+ * on the service ME, see BRIDGE_LEARN_CTX.
+ */
+void bridge_learn_loop(void);
+
+#endif /* _BRIDGE_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/cms.c
+ * @brief         Count-min sketch heavy hitter detection
+ */
+
+#ifndef _CMS_C_
+#define _CMS_C_
+
+#include "config.h"
+
+#ifdef CFG_CMS
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/cls.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <std/hash.h>
+#include <std/reg_utils.h>
+
+#include "cms.h"
+#include "flow_hash.h"
+#include "host_ring.h"
+
+__export CMS_MEM __align64 uint32_t cms_sketch[CMS_DEPTH][CMS_WIDTH];
+
+__export __emem struct cms_cfg cms_cfg;
+
+HOST_RING_DECLARE(cms_hh, struct cms_hh_rec, CMS_HH_ENTRIES);
+
+/*
+ * Seeds of the two row hashes.  CRCs of the same polynomial with different
+ * seeds only differ by a constant, so the second hash uses CRC32-C.
+ */
+#define CMS_SEED1               0x636d7331
+#define CMS_SEED2               0x636d7332
+
+
+__intrinsic static void
+cms_report(__lmem uint32_t *key, uint32_t estimate, unsigned int port)
+{
+    __xwrite struct cms_hh_rec rec;
+
+    rec.key[0] = key[0];
+    rec.key[1] = key[1];
+    rec.key[2] = key[2];
+    rec.key[3] = key[3];
+    rec.estimate = estimate;
+    rec.ts = me_tsc_read() >> 16;
+    rec.__raw[6] = (__ISLAND << 24) | ((port & 0xff) << 16);
+
+    host_ring_put(&rec, cms_hh, &cms_hh_wptr, CMS_HH_ENTRIES, sizeof(rec));
+}
+
+__intrinsic void
+cms_pkt(__lmem uint32_t *key, unsigned int len, unsigned int port)
+{
+    __xread struct cms_cfg cfg;
+    __xrw uint32_t cnt;
+    __gpr uint32_t h1, h2;
+    __gpr uint32_t est;
+    __gpr unsigned int row;
+
+    mem_read32(&cfg, &cms_cfg, sizeof(cfg));
+    if (!cfg.enable)
+        return;
+
+    if (cfg.pkts)
+        len = 1;
+
+    h1 = hash_me_crc32(key, FLOW_KEY_WORDS * 4, CMS_SEED1);
+    /* An odd step never maps two rows to the same column */
+    h2 = hash_me_crc32c(key, FLOW_KEY_WORDS * 4, CMS_SEED2) | 1;
+
+    est = 0xffffffff;
+    for (row = 0; row < CMS_DEPTH; row++) {
+        cnt = len;
+#ifdef CMS_CLS
+        cls_test_add(&cnt, &cms_sketch[row][h1 & (CMS_WIDTH - 1)],
+                     sizeof(cnt));
+#else
+        mem_test_add(&cnt, &cms_sketch[row][h1 & (CMS_WIDTH - 1)],
+                     sizeof(cnt));
+#endif
+        if (cnt < est)
+            est = cnt;
+        h1 += h2;
+    }
+
+    /* Report a flow only on the packet that takes it over the threshold */
+    if (est < cfg.threshold && est + len >= cfg.threshold)
+        cms_report(key, est + len, port);
+}
+
+#endif /* CFG_CMS */
+
+#endif /* _CMS_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/cms.h
+ * @brief         Count-min sketch heavy hitter detection
+ *
+ * Every IPv4 flow adds its bytes (or packets) to one counter in each of
+ * CMS_DEPTH rows of CMS_WIDTH counters.  The row indices are derived from
+ * a CRC32 and a CRC32-C hash of the flow key (h1 + i * h2, as proposed by
+ * Kirsch and Mitzenmacher).
+ * The counters are updated with test-and-add, so the minimum of the old
+ * values plus the packet is the estimate of the flow, which never
+ * undercounts and overcounts by at most e/CMS_WIDTH of the total with
+ * probability 1 - e^-CMS_DEPTH (see tools/cms_model.py).
+ *
+ * A flow whose estimate crosses the host configured threshold is pushed
+ * once onto the cms_hh host ring.  The host starts a new measurement
+ * interval by clearing the sketch (tools/cms_ctl.py).
+ *
+ * The sketch lives in IMEM and is shared by all islands.  With CMS_CLS
+ * defined, each island keeps its own sketch in CLS instead, which is
+ * cheaper but only sees the traffic of that island.
+ */
+
+#ifndef _CMS_H_
+#define _CMS_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* Number of rows and log2 of the counters per row */
+#ifndef CMS_DEPTH
+#define CMS_DEPTH               4
+#endif
+
+#ifndef CMS_WIDTH_SHF
+#ifdef CMS_CLS
+#define CMS_WIDTH_SHF           10
+#else
+#define CMS_WIDTH_SHF           14
+#endif
+#endif
+
+#define CMS_WIDTH               (1 << CMS_WIDTH_SHF)
+
+#if CMS_DEPTH < 1 || CMS_DEPTH > 8
+#error "CMS_DEPTH must be between 1 and 8"
+#endif
+
+#ifdef CMS_CLS
+#define CMS_MEM                 __shared __cls
+#else
+#define CMS_MEM                 __imem
+#endif
+
+/* Records in the heavy hitter ring, a power of 2 */
+#ifndef CMS_HH_ENTRIES
+#define CMS_HH_ENTRIES          1024
+#endif
+
+/**
+ * Host configuration
+ */
+struct cms_cfg {
+    union {
+        struct {
+            unsigned int enable:1;      /** Update the sketch */
+            unsigned int pkts:1;        /** Count packets, not bytes */
+            unsigned int resv:30;       /** Reserved */
+
+            uint32_t threshold;         /** Heavy hitter threshold */
+        };
+        uint32_t __raw[2];
+    };
+};
+
+/**
+ * Heavy hitter record
+ */
+struct cms_hh_rec {
+    union {
+        struct {
+            uint32_t key[4];            /** Flow key, see flow_hash.h */
+            uint32_t estimate;          /** Estimate when reported */
+            uint32_t ts;                /** ME timestamp >> 16 */
+            unsigned int isl:8;         /** Reporting island */
+            unsigned int port:8;        /** Ingress port */
+            unsigned int resv0:16;      /** Reserved */
+            uint32_t seq;               /** Ring sequence number */
+        };
+        uint32_t __raw[8];
+    };
+};
+
+/**
+ * Add a packet to the sketch.
+ * @param key       Flow key of the packet (flow_key_frame())
+ * @param len       Frame length in bytes
+ * @param port      Ingress port
+ */
+__intrinsic void cms_pkt(__lmem uint32_t *key, unsigned int len,
+                         unsigned int port);
+
+#endif /* _CMS_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -39,10 +39,66 @@
 #define MAC_TO_PORT(x)      (x / MAC_CHAN_PER_PORT)
 #define PORT_TO_TMQ(x)      (x * TMQ_PER_PORT)
 
+/*
+ * Ports are numbered MAC_TO_PORT() of their first NBI channel, so the TM
+ * queues of a port start at PORT_TO_TMQ() of its number.  The per port
+ * tables of all stages and the host tools use these numbers.  The wire
+ * forwards between MAC ports 0 and 4 (see init/wire.sh), ports 0 and 4.
+ */
+#define WIRE_PORT_A         0
+#define WIRE_PORT_B         4
+
+/*
+ * Number of TM queues of an egress port that packets are spread over
+ * using their flow hash (power of 2, at most TMQ_PER_PORT)
+ */
+#ifndef TMQ_HASH_QUEUES
+#define TMQ_HASH_QUEUES     1
+#endif
+
 #ifndef PKT_NBI_OFFSET
 #define PKT_NBI_OFFSET 64
 #warning PKT_NIB_OFFSET is undefined
 #endif
 
+/*
+ * Optional processing stages, all disabled by default.  Enable them by
+ * passing the defines in wire_APPDEFS, e.g.
+ *   make wire_APPDEFS="-DCFG_POLICER -DCFG_POLICER_PER_FLOW"
+ * All stage sources are always built, the body of each one is under its
+ * flag so that a disabled stage allocates none of its tables.
+ *
+ * - CFG_POLICER            Police packets per ingress port (policer.h)
+ * - CFG_POLICER_PER_FLOW   Police per IPv4 flow instead of per port
+ * - CFG_STORM_CTRL         Broadcast/multicast storm control (storm.h)
+ * - CFG_VXLAN              VXLAN decap/encap per ingress port (vxlan.h)
+ * - CFG_GRE                GRE/NVGRE termination per ingress port (gre.h),
+ *                          use with TMQ_HASH_QUEUES to spread inner flows
+ * - CFG_MPLS               MPLS label switching (mpls_lsr.h)
+ * - CFG_BRIDGE             L2 learning bridge (bridge.h), with
+ *                          CFG_STORM_CTRL also limits unknown unicast
+ * - CFG_REPLICATION        Send flooded frames to all ports of the VLAN
+ *                          (rep.h)
+ * - CFG_MIRROR             Port mirroring with sampling and truncation
+ *                          (mirror.h)
+ * - CFG_CONNTRACK          Stateful TCP connection tracking (conntrack.h)
+ * - CFG_AGE_WHEEL          Timer wheel aging of the conntrack table on the
+ *                          service ME (age_wheel.h)
+ * - CFG_CMS                Count-min sketch heavy hitter detection (cms.h)
+ * - CFG_HLL                Distinct sources and flows per port (hll.h)
+ * - CFG_TOPK               Sampled top-K flows per island (topk.h)
+ * - CFG_SFLOW              sFlow style 1:N packet sampling (sflow.h)
+ * - CFG_FLOWREC            IPFIX style flow records (flowrec.h), requires
+ *                          CFG_AGE_WHEEL
+ * - CFG_TM_CTL             Change TM shaper rates and scheduler weights at
+ *                          run time from the host (tm_ctl.h)
+ * - CFG_TM_ADAPT           Shaper rates following TM queue depths and drops
+ *                          (tm_adapt.h), requires CFG_TM_CTL
+ * - CFG_WRED               WRED with ECN marking per egress queue class
+ *                          (wred.h)
+ * - CFG_QOS                PCP/DSCP to egress TM queue classification
+ *                          (qos.h), with CFG_WRED a class per queue
+ */
+
 
 #endif /* __APP_CONFIG_H__ */
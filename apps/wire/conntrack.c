@@ -0,0 +1,778 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/conntrack.c
+ * @brief         Stateful TCP connection tracking
+ */
+
+#ifndef _CONNTRACK_C_
+#define _CONNTRACK_C_
+
+#include "config.h"
+
+#ifdef CFG_CONNTRACK
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <net/ip.h>
+#include <net/tcp.h>
+#include <net/hdr_ext.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/mem_cam.h>
+#include <std/hash.h>
+#include <std/reg_utils.h>
+
+#include "conntrack.h"
+
+/* CAM buckets, entry meta words and entries, indexed by bucket and slot */
+__export __emem __align64 uint32_t ct_cam[CT_BUCKETS][CT_BUCKET_SZ];
+__export __emem __align64 struct ct_meta ct_meta[CT_BUCKETS][CT_BUCKET_SZ];
+__export __emem struct ct_entry ct_tbl[CT_ENTRIES];
+
+__export __emem struct ct_port_cfg ct_port_cfg[CT_NUM_PORTS];
+__export __emem struct ct_cntrs ct_cntrs;
+
+/*
+ * Frames are read at a two byte offset so that the IP header is word
+ * aligned, see pkt_count.c
+ */
+#define CT_START_OFF            2
+#define CT_BUF_SZ               64
+
+#define CT_HASH_SEED            0x636f6e6e
+
+/* Attempts to take the lock of an entry before giving up */
+#define CT_LOCK_TRIES           16
+
+/* Lower bound of the acceptable ack window, as used by Linux */
+#define CT_MAX_ACKWIN           66000
+
+/* Window scale not negotiated */
+#define CT_WSCALE_NONE          15
+
+#define CT_TS_NOW()     ((uint32_t)(me_tsc_read() >> CT_TS_SHF) & CT_TS_MASK)
+
+#define CT_SEQ_BEFORE(_a, _b)   ((int32_t)((_a) - (_b)) < 0)
+#define CT_SEQ_AFTER(_a, _b)    CT_SEQ_BEFORE(_b, _a)
+
+/**
+ * Classes of TCP flag combinations driving the state machine
+ */
+enum ct_flag_class {
+    CT_F_SYN    = 0,
+    CT_F_SYNACK = 1,
+    CT_F_FIN    = 2,
+    CT_F_ACK    = 3,
+    CT_F_RST    = 4,
+    CT_F_NONE   = 5,
+};
+
+/**
+ * The fields of a TCP segment used for tracking
+ */
+struct ct_seg {
+    uint32_t seq;               /** Sequence number */
+    uint32_t ack;               /** Acknowledgement number */
+    uint32_t end;               /** Sequence number after the segment */
+    uint32_t win;               /** Unscaled window */
+    unsigned int flags:8;       /** TCP flags */
+    unsigned int cls:8;         /** enum ct_flag_class */
+    unsigned int dir:1;         /** Sent by side b */
+    unsigned int wscale:4;      /** Window scale option of a SYN */
+    unsigned int resv:11;
+};
+
+struct ct_hdrs {
+    union {
+        struct eth_hdr  eth;
+        struct vlan_hdr vlan;
+        struct ip4_hdr  ip4;
+        struct tcp_hdr  tcp;
+    };
+};
+
+
+__intrinsic static enum ct_flag_class
+ct_flag_class(unsigned int flags)
+{
+    if (flags & NET_TCP_FLAG_RST)
+        return CT_F_RST;
+    if (flags & NET_TCP_FLAG_SYN)
+        return (flags & NET_TCP_FLAG_ACK) ? CT_F_SYNACK : CT_F_SYN;
+    if (flags & NET_TCP_FLAG_FIN)
+        return CT_F_FIN;
+    if (flags & NET_TCP_FLAG_ACK)
+        return CT_F_ACK;
+    return CT_F_NONE;
+}
+
+__intrinsic static unsigned int
+ct_timeout(unsigned int state)
+{
+    switch (state) {
+    case CT_S_SYN_SENT:
+        return CT_TMO_SYN_SENT;
+    case CT_S_SYN_RECV:
+        return CT_TMO_SYN_RECV;
+    case CT_S_ESTABLISHED:
+        return CT_TMO_ESTABLISHED;
+    case CT_S_FIN_WAIT:
+        return CT_TMO_FIN_WAIT;
+    case CT_S_CLOSE_WAIT:
+        return CT_TMO_CLOSE_WAIT;
+    case CT_S_LAST_ACK:
+        return CT_TMO_LAST_ACK;
+    case CT_S_TIME_WAIT:
+        return CT_TMO_TIME_WAIT;
+    case CT_S_CLOSE:
+        return CT_TMO_CLOSE;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Returns non-zero if an entry with meta word @meta is unused or timed
+ * out at time @now.
+ */
+__intrinsic static int
+ct_expired(uint32_t meta, uint32_t now)
+{
+    __gpr unsigned int state;
+    __gpr uint32_t age;
+
+    state = (meta >> 27) & 0xf;
+    if (state == CT_S_NONE)
+        return 1;
+
+    age = (now - meta) & CT_TS_MASK;
+    return age >= ct_timeout(state);
+}
+
+/*
+ * Next state of a connection in @state for a segment of class @cls.
+ * @reply is set for segments sent by the side that did not open the
+ * connection.
+ */
+__intrinsic static enum ct_state
+ct_next_state(unsigned int state, unsigned int cls, unsigned int reply)
+{
+    switch (cls) {
+    case CT_F_SYN:
+        if (reply)
+            return CT_S_INVALID;
+        if (state == CT_S_NONE || state == CT_S_SYN_SENT ||
+            state == CT_S_TIME_WAIT || state == CT_S_CLOSE)
+            return CT_S_SYN_SENT;
+        return CT_S_INVALID;
+
+    case CT_F_SYNACK:
+        if (!reply)
+            return CT_S_INVALID;
+        if (state == CT_S_SYN_SENT || state == CT_S_SYN_RECV)
+            return CT_S_SYN_RECV;
+        if (state == CT_S_ESTABLISHED)
+            return CT_S_ESTABLISHED;
+        return CT_S_INVALID;
+
+    case CT_F_FIN:
+        switch (state) {
+        case CT_S_SYN_RECV:
+        case CT_S_ESTABLISHED:
+            return CT_S_FIN_WAIT;
+        case CT_S_FIN_WAIT:
+        case CT_S_CLOSE_WAIT:
+        case CT_S_LAST_ACK:
+            return CT_S_LAST_ACK;
+        case CT_S_TIME_WAIT:
+        case CT_S_CLOSE:
+            return state;
+        default:
+            return CT_S_INVALID;
+        }
+
+    case CT_F_ACK:
+        switch (state) {
+        case CT_S_SYN_SENT:
+            return reply ? CT_S_INVALID : CT_S_SYN_SENT;
+        case CT_S_SYN_RECV:
+            return reply ? CT_S_SYN_RECV : CT_S_ESTABLISHED;
+        case CT_S_FIN_WAIT:
+            return CT_S_CLOSE_WAIT;
+        case CT_S_LAST_ACK:
+            return CT_S_TIME_WAIT;
+        case CT_S_ESTABLISHED:
+        case CT_S_CLOSE_WAIT:
+        case CT_S_TIME_WAIT:
+        case CT_S_CLOSE:
+            return state;
+        default:
+            return CT_S_INVALID;
+        }
+
+    case CT_F_RST:
+        return (state == CT_S_NONE) ? CT_S_INVALID : CT_S_CLOSE;
+
+    default:
+        return CT_S_INVALID;
+    }
+}
+
+/*
+ * Find the window scale option in the TCP options at @off in the packet
+ * buffer.  Returns the shift count or CT_WSCALE_NONE.
+ */
+__intrinsic static unsigned int
+ct_wscale(__mem40 char *pbuf, unsigned int off, unsigned int len)
+{
+    __xread uint32_t opt_in[12];
+    __lmem uint32_t opt[12];
+    __gpr unsigned int i;
+    __gpr unsigned int end;
+    __gpr unsigned int kind;
+    __gpr unsigned int olen;
+
+    /* Read 8B aligned, the options start at byte (off & 7) */
+    mem_read64(opt_in, pbuf + (off & ~7), sizeof(opt_in));
+    reg_cp(opt, opt_in, sizeof(opt));
+
+#define CT_OPT_BYTE(_i) ((opt[(_i) >> 2] >> (24 - 8 * ((_i) & 3))) & 0xff)
+
+    i = off & 7;
+    end = i + len;
+    while (i + 1 < end) {
+        kind = CT_OPT_BYTE(i);
+        if (kind == 0)
+            break;
+        if (kind == 1) {
+            i++;
+            continue;
+        }
+        olen = CT_OPT_BYTE(i + 1);
+        if (olen < 2)
+            break;
+        if (kind == 3 && olen == 3 && i + 2 < end) {
+            kind = CT_OPT_BYTE(i + 2);
+            return (kind > 14) ? 14 : kind;
+        }
+        i += olen;
+    }
+
+#undef CT_OPT_BYTE
+
+    return CT_WSCALE_NONE;
+}
+
+/*
+ * Set up the entry for a new connection opened (or picked up) by
+ * segment @seg.
+ */
+__intrinsic static void
+ct_entry_init(__lmem struct ct_entry *e, __lmem uint32_t *key,
+              __gpr struct ct_seg *seg)
+{
+    __gpr int i;
+
+    for (i = 0; i < sizeof(struct ct_entry) / 4; i++)
+        e->__raw[i] = 0;
+    for (i = 0; i < CT_KEY_WORDS; i++)
+        e->__raw[i] = key[i];
+
+    e->orig = seg->dir;
+    e->wscale_a = CT_WSCALE_NONE;
+    e->wscale_b = CT_WSCALE_NONE;
+    if (seg->cls != CT_F_SYN) {
+        /* Picked up, the scale of the windows is unknown */
+        e->wscale_a = 14;
+        e->wscale_b = 14;
+    }
+}
+
+/*
+ * Check a segment against the windows of the connection and update them.
+ * Returns zero if the segment is out of window.
+ */
+__intrinsic static int
+ct_win_update(__lmem struct ct_entry *e, __gpr struct ct_seg *seg)
+{
+    __lmem struct ct_win *s;
+    __lmem struct ct_win *r;
+    __gpr unsigned int shf;
+    __gpr uint32_t win;
+    __gpr uint32_t ack;
+    __gpr uint32_t maxack;
+
+    s = &e->win[seg->dir];
+    r = &e->win[!seg->dir];
+
+    /* Negotiate the window scale on the handshake */
+    if (seg->cls == CT_F_SYN || seg->cls == CT_F_SYNACK) {
+        if (seg->dir)
+            e->wscale_b = seg->wscale;
+        else
+            e->wscale_a = seg->wscale;
+        if (seg->cls == CT_F_SYNACK &&
+            (e->wscale_a == CT_WSCALE_NONE ||
+             e->wscale_b == CT_WSCALE_NONE)) {
+            e->wscale_a = 0;
+            e->wscale_b = 0;
+        }
+    }
+
+    /* Windows of SYN segments are never scaled */
+    shf = 0;
+    if (!(seg->flags & NET_TCP_FLAG_SYN)) {
+        shf = seg->dir ? e->wscale_b : e->wscale_a;
+        if (shf == CT_WSCALE_NONE)
+            shf = 0;
+    }
+    win = seg->win << shf;
+    if (win == 0)
+        win = 1;
+
+    if (s->maxwin == 0) {
+        /* First segment seen from this side */
+        s->end = seg->end;
+        s->maxwin = win;
+        s->maxend = seg->end + win;
+    } else {
+        ack = seg->ack;
+        if (!(seg->flags & NET_TCP_FLAG_ACK) || r->maxwin == 0)
+            ack = r->end;
+        maxack = (s->maxwin > CT_MAX_ACKWIN) ? s->maxwin : CT_MAX_ACKWIN;
+
+        if (!CT_SEQ_BEFORE(seg->seq, s->maxend + 1) ||
+            !CT_SEQ_AFTER(seg->end, s->end - r->maxwin - 1) ||
+            !CT_SEQ_BEFORE(ack, r->end + 1) ||
+            !CT_SEQ_AFTER(ack, r->end - maxack - 1))
+            return 0;
+
+        if (s->maxwin < win)
+            s->maxwin = win;
+        if (CT_SEQ_AFTER(seg->end, s->end))
+            s->end = seg->end;
+    }
+
+    if ((seg->flags & NET_TCP_FLAG_ACK) &&
+        (r->maxwin == 0 || CT_SEQ_AFTER(seg->ack + win, r->maxend)))
+        r->maxend = seg->ack + win;
+
+    return 1;
+}
+
+/*
+ * Take the lock of the entry with meta word @meta.  Returns the previous
+ * meta word, with the lock bit set if the lock could not be taken.
+ */
+__intrinsic static uint32_t
+ct_lock(__mem40 struct ct_meta *meta)
+{
+    __xrw uint32_t val;
+    __gpr int tries;
+
+    for (tries = 0; tries < CT_LOCK_TRIES; tries++) {
+        val = CT_META_LOCK;
+        mem_test_set(&val, meta, sizeof(val));
+        if (!(val & CT_META_LOCK))
+            break;
+    }
+
+    return val;
+}
+
+/*
+ * Write the meta word of an entry, which also releases its lock
+ */
+__intrinsic static void
+ct_unlock(__mem40 struct ct_meta *meta, unsigned int state, uint32_t now)
+{
+    __xwrite uint32_t val;
+
+    val = (state << 27) | now;
+    mem_write32(&val, meta, sizeof(val));
+}
+
+/*
+ * Find a slot for a new connection in a full bucket, following the
+ * eviction policy in conntrack.h.  Returns the slot with its lock taken or
+ * -1.
+ */
+__intrinsic static int
+ct_evict(unsigned int bucket, uint32_t sig, uint32_t now)
+{
+    __xread uint32_t meta_in[CT_BUCKET_SZ];
+    __xwrite uint32_t sig_out;
+    __lmem uint32_t metas[CT_BUCKET_SZ];
+    __gpr int slot;
+    __gpr int victim = -1;
+    __gpr uint32_t meta;
+    __gpr uint32_t age;
+    __gpr uint32_t oldest = 0;
+    __gpr unsigned int state;
+
+    mem_read32(meta_in, ct_meta[bucket], sizeof(meta_in));
+    reg_cp(metas, meta_in, sizeof(metas));
+
+    for (slot = 0; slot < CT_BUCKET_SZ; slot++) {
+        meta = metas[slot];
+        if (meta & CT_META_LOCK)
+            continue;
+        if (ct_expired(meta, now)) {
+            victim = slot;
+            break;
+        }
+        state = (meta >> 27) & 0xf;
+        if (state == CT_S_ESTABLISHED)
+            continue;
+        age = (now - meta) & CT_TS_MASK;
+        if (victim < 0 || age > oldest) {
+            victim = slot;
+            oldest = age;
+        }
+    }
+
+    if (victim < 0)
+        return -1;
+
+    meta = ct_lock(&ct_meta[bucket][victim]);
+    if (meta & CT_META_LOCK)
+        return -1;
+
+    /* Another context may have refreshed or reused the entry since the
+     * bucket was read, only an unchanged or expired entry is evicted */
+    if (meta != metas[victim] && !ct_expired(meta, now)) {
+        ct_unlock(&ct_meta[bucket][victim], (meta >> 27) & 0xf,
+                  meta & CT_TS_MASK);
+        return -1;
+    }
+
+    if (ct_expired(meta, now))
+        mem_incr64(&ct_cntrs.expired);
+    else
+        mem_incr64(&ct_cntrs.evicted);
+
+    sig_out = sig;
+    mem_write32(&sig_out, &ct_cam[bucket][victim], sizeof(sig_out));
+
+    return victim;
+}
+
+__intrinsic enum ct_res
+ct_pkt(__mem40 char *pbuf, unsigned int l2_off, unsigned int port)
+{
+    __xread struct ct_port_cfg cfg;
+    __xread uint32_t pkt_buf[CT_BUF_SZ / 4];
+    __xread struct ct_entry entry_in;
+    __xwrite struct ct_entry entry_out;
+    __xrw struct mem_cam_32bit cam;
+#ifdef CFG_AGE_WHEEL
+    __xwrite uint32_t sig_out;
+#endif
+    __lmem uint32_t buf[CT_BUF_SZ / 4];
+    __lmem uint32_t key[CT_KEY_WORDS];
+    __lmem struct ct_entry e;
+    __gpr struct ct_hdrs h;
+    __gpr struct ct_seg seg;
+    __gpr int off = CT_START_OFF;
+    __gpr int res;
+    __gpr int next_proto;
+    __gpr uint32_t src, dst;
+    __gpr unsigned int sport, dport;
+    __gpr unsigned int ip_len;
+    __gpr unsigned int tcp_off;
+    __gpr unsigned int tcp_len;
+    __gpr uint32_t sig;
+    __gpr uint32_t now;
+    __gpr uint32_t meta;
+    __gpr unsigned int bucket;
+    __gpr unsigned int state;
+    __gpr unsigned int prev;
+    __gpr unsigned int next;
+    __gpr int slot;
+    __gpr int idx;
+    __gpr unsigned int gen;
+    __gpr int may_open;
+    __gpr int created = 0;
+    __gpr int evicted = 0;
+    __mem40 struct ct_meta *mp;
+
+    mem_read32(&cfg, &ct_port_cfg[port & (CT_NUM_PORTS - 1)], sizeof(cfg));
+    if (!cfg.enable)
+        return CT_RES_NONE;
+
+    mem_read64(pkt_buf, pbuf + l2_off - CT_START_OFF, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+
+    res = he_eth(buf, off, &h.eth);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto == HE_8021Q) {
+        res = he_vlan(buf, off, &h.vlan);
+        next_proto = HE_RES_PROTO_of(res);
+        off += HE_RES_LEN_of(res);
+    }
+
+    if (next_proto != HE_IP4)
+        return CT_RES_NONE;
+
+    res = he_ip4(buf, off, &h.ip4);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    /* Only the first fragment carries the ports */
+    if (next_proto != HE_TCP || NET_IP_IS_FRAG(h.ip4.frag) ||
+        !he_tcp_fit(CT_BUF_SZ, off))
+        return CT_RES_NONE;
+
+    src = h.ip4.src;
+    dst = h.ip4.dst;
+    ip_len = h.ip4.len - (h.ip4.hl << 2);
+    tcp_off = off;
+
+    he_tcp(buf, off, &h.tcp);
+    sport = h.tcp.sport;
+    dport = h.tcp.dport;
+    tcp_len = h.tcp.off << 2;
+
+    seg.seq = h.tcp.seq;
+    seg.ack = h.tcp.ack;
+    seg.win = h.tcp.win;
+    seg.flags = h.tcp.flags;
+    seg.cls = ct_flag_class(seg.flags);
+    seg.end = seg.seq + ip_len - tcp_len;
+    if (seg.flags & NET_TCP_FLAG_SYN)
+        seg.end++;
+    if (seg.flags & NET_TCP_FLAG_FIN)
+        seg.end++;
+    seg.wscale = CT_WSCALE_NONE;
+    if ((seg.flags & NET_TCP_FLAG_SYN) && tcp_len > sizeof(struct tcp_hdr))
+        seg.wscale = ct_wscale(pbuf, l2_off - CT_START_OFF + tcp_off +
+                               sizeof(struct tcp_hdr),
+                               tcp_len - sizeof(struct tcp_hdr));
+
+    /* Symmetric key, side a is the lower address/port pair */
+    if (src < dst || (src == dst && sport <= dport)) {
+        seg.dir = 0;
+        key[0] = src;
+        key[1] = dst;
+        key[2] = (sport << 16) | dport;
+    } else {
+        seg.dir = 1;
+        key[0] = dst;
+        key[1] = src;
+        key[2] = (dport << 16) | sport;
+    }
+
+    sig = hash_me_crc32(key, sizeof(key), CT_HASH_SEED);
+    if (sig == 0)
+        sig = 1;
+    bucket = sig & (CT_BUCKETS - 1);
+    now = CT_TS_NOW();
+
+    /* Only segments that may open a connection add to the table */
+    may_open = cfg.allow_new &&
+        (seg.cls == CT_F_SYN || (cfg.loose && seg.cls == CT_F_ACK));
+
+    cam.search.value = sig;
+    if (may_open) {
+        mem_cam_lookup_add(&cam, ct_cam[bucket], 512, 32);
+        if (mem_cam_lookup_add_fail(cam)) {
+            slot = ct_evict(bucket, sig, now);
+            if (slot < 0) {
+                mem_incr64(&ct_cntrs.full);
+                return CT_RES_DROP;
+            }
+            evicted = 1;
+            created = 1;
+        } else {
+            slot = cam.result.match & 0x7f;
+            created = mem_cam_lookup_add_added(cam);
+        }
+    } else {
+        mem_cam_lookup(&cam, ct_cam[bucket], 512, 32);
+        if (!mem_cam_lookup_hit(cam))
+            goto refused;
+        slot = cam.result.match;
+    }
+
+    idx = bucket * CT_BUCKET_SZ + slot;
+    mp = &ct_meta[bucket][slot];
+
+    /* The eviction returns the slot locked */
+    if (!evicted) {
+        meta = ct_lock(mp);
+        if (meta & CT_META_LOCK) {
+            /* Heavily contended, the segment can not be checked and a
+             * firewall must not pass it unchecked */
+            mem_incr64(&ct_cntrs.contended);
+            return CT_RES_DROP;
+        }
+    }
+
+    mem_read32(&entry_in, &ct_tbl[idx], sizeof(entry_in));
+    reg_cp(&e, &entry_in, sizeof(e));
+    gen = e.gen;
+
+    state = CT_S_NONE;
+    prev = CT_S_NONE;
+    if (!created) {
+        if (e.__raw[0] != key[0] || e.__raw[1] != key[1] ||
+            e.__raw[2] != key[2]) {
+            /* Signature collision with another connection */
+            ct_unlock(mp, (meta >> 27) & 0xf, meta & CT_TS_MASK);
+            goto refused;
+        }
+
+        if (ct_expired(meta, now)) {
+            if (((meta >> 27) & 0xf) != CT_S_NONE)
+                mem_incr64(&ct_cntrs.expired);
+            if (!may_open) {
+                ct_unlock(mp, CT_S_NONE, now);
+                goto refused;
+            }
+#ifdef CFG_AGE_WHEEL
+            /* The aging context may have released the slot */
+            sig_out = sig;
+            mem_write32(&sig_out, &ct_cam[bucket][slot], sizeof(sig_out));
+#endif
+            created = 1;
+        } else {
+            state = (meta >> 27) & 0xf;
+            prev = state;
+            /* A closed connection may be reopened from either side */
+            if (seg.cls == CT_F_SYN &&
+                (state == CT_S_TIME_WAIT || state == CT_S_CLOSE)) {
+                state = CT_S_NONE;
+                created = 1;
+            }
+        }
+    }
+
+    if (created) {
+        ct_entry_init(&e, key, &seg);
+        e.gen = gen + 1;
+    }
+
+    if (created && seg.cls == CT_F_ACK)
+        next = CT_S_ESTABLISHED;
+    else
+        next = ct_next_state(state, seg.cls, seg.dir ^ e.orig);
+
+    if (next == CT_S_INVALID) {
+        ct_unlock(mp, prev, now);
+        mem_incr64(&ct_cntrs.invalid);
+        return CT_RES_DROP;
+    }
+
+    if (!ct_win_update(&e, &seg)) {
+        ct_unlock(mp, prev, now);
+        mem_incr64(&ct_cntrs.out_of_window);
+        return CT_RES_DROP;
+    }
+
+    reg_cp(&entry_out, &e, sizeof(entry_out));
+    mem_write32(&entry_out, &ct_tbl[idx], sizeof(entry_out));
+    ct_unlock(mp, next, now);
+
+    if (created) {
+#ifdef CFG_AGE_WHEEL
+        age_link(AGE_TBL_CT, idx, e.gen, ct_timeout(next));
+#endif
+        if (seg.cls == CT_F_SYN)
+            mem_incr64(&ct_cntrs.created);
+        else
+            mem_incr64(&ct_cntrs.picked_up);
+    }
+    if (next != state) {
+        if (next == CT_S_ESTABLISHED)
+            mem_incr64(&ct_cntrs.established);
+        else if (next == CT_S_TIME_WAIT || next == CT_S_CLOSE)
+            mem_incr64(&ct_cntrs.closed);
+    }
+
+    return CT_RES_PASS;
+
+refused:
+    mem_incr64(&ct_cntrs.refused);
+    return CT_RES_DROP;
+}
+
+#ifdef CFG_AGE_WHEEL
+int
+ct_age(unsigned int idx, unsigned int gen, __lmem struct age_rec *rec)
+{
+    __xread struct ct_entry entry;
+    __xwrite uint32_t sig_out;
+    __gpr unsigned int bucket;
+    __gpr unsigned int slot;
+    __gpr unsigned int state;
+    __gpr uint32_t meta;
+    __gpr uint32_t now;
+    __gpr uint32_t age;
+    __gpr uint32_t tmo;
+    __mem40 struct ct_meta *mp;
+
+    bucket = idx / CT_BUCKET_SZ;
+    slot = idx % CT_BUCKET_SZ;
+    mp = &ct_meta[bucket][slot];
+
+    meta = ct_lock(mp);
+    if (meta & CT_META_LOCK) {
+        /* Busy, look again a bit later */
+        return 1;
+    }
+
+    mem_read32(&entry, &ct_tbl[idx], sizeof(entry));
+    state = (meta >> 27) & 0xf;
+    if (entry.gen != gen || state == CT_S_NONE) {
+        ct_unlock(mp, state, meta & CT_TS_MASK);
+        return -1;
+    }
+
+    now = CT_TS_NOW();
+    age = (now - meta) & CT_TS_MASK;
+    tmo = ct_timeout(state);
+    if (age < tmo) {
+        ct_unlock(mp, state, meta & CT_TS_MASK);
+        return tmo - age;
+    }
+
+    /* Free the CAM slot before the entry is unlocked */
+    sig_out = 0;
+    mem_write32(&sig_out, &ct_cam[bucket][slot], sizeof(sig_out));
+    ct_unlock(mp, CT_S_NONE, now);
+    mem_incr64(&ct_cntrs.expired);
+
+    rec->data[0] = entry.__raw[0];
+    rec->data[1] = entry.__raw[1];
+    rec->data[2] = entry.__raw[2];
+    rec->data[3] = (state << 24) | (entry.orig << 23);
+    rec->data[4] = meta & CT_TS_MASK;
+    rec->data[5] = 0;
+
+    return 0;
+}
+#endif
+
+#endif /* CFG_CONNTRACK */
+
+#endif /* _CONNTRACK_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/conntrack.h
+ * @brief         Stateful TCP connection tracking
+ *
+ * Tracks IPv4 TCP connections in a fixed size table in EMEM.  The key is
+ * symmetric: the address/port pairs of both ends are stored in ascending
+ * order, so both directions of a connection find the same entry.  Each
+ * entry holds the TCP state (a reduced version of the Linux conntrack
+ * state machine) and per direction sequence windows checked as described
+ * in "Real Stateful TCP Packet Filtering in IP Filter" (G. van Rooij).
+ *
+ * The table is a hash of 512 bit CAM buckets holding the 32 bit
+ * signatures of 16 entries.  A separate meta word per entry holds a lock
+ * bit, the state and the last seen timestamp, so that the meta words of a
+ * whole bucket are read with a single command when a slot is needed.
+ * Entries time out depending on their state and are reclaimed lazily.
+ * When a new connection hashes to a full bucket, the eviction policy is:
+ *  1. an expired entry, otherwise
+ *  2. the least recently seen entry that is not established (opening or
+ *     closing connections), otherwise
+ *  3. the new connection is refused.
+ *
+ * With CFG_AGE_WHEEL, new entries are also linked into the aging timer
+ * wheel, which deletes them from the service ME once they time out and
+ * can export them to the host.
+ *
+ * Firewall behaviour is configured per ingress port (see
+ * tools/ct_ctl.py): whether connections may be opened from the port,
+ * and whether connections already in progress are picked up (loose).
+ */
+
+#ifndef _CONNTRACK_H_
+#define _CONNTRACK_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include "age_wheel.h"
+
+#ifndef CT_NUM_PORTS
+#define CT_NUM_PORTS            64
+#endif
+
+/* Table size, the number of entries is CT_BUCKETS * 16 */
+#ifndef CT_BUCKETS
+#define CT_BUCKETS              16384
+#endif
+
+#define CT_BUCKET_SZ            16
+#define CT_ENTRIES              (CT_BUCKETS * CT_BUCKET_SZ)
+
+#if (CT_BUCKETS & (CT_BUCKETS - 1)) != 0
+#error "CT_BUCKETS must be a power of 2"
+#endif
+
+/*
+ * Timestamps are the ME timestamp counter shifted right by CT_TS_SHF,
+ * about 21 ms per unit at 800 MHz, and kept in 27 bits.
+ */
+#define CT_TS_SHF               20
+#define CT_TS_MASK              ((1 << 27) - 1)
+#define CT_SECS(_s)             ((_s) * 48)
+
+/* Timeouts per state */
+#define CT_TMO_SYN_SENT         CT_SECS(120)
+#define CT_TMO_SYN_RECV         CT_SECS(60)
+#define CT_TMO_ESTABLISHED      CT_SECS(432000)
+#define CT_TMO_FIN_WAIT         CT_SECS(120)
+#define CT_TMO_CLOSE_WAIT       CT_SECS(60)
+#define CT_TMO_LAST_ACK         CT_SECS(30)
+#define CT_TMO_TIME_WAIT        CT_SECS(120)
+#define CT_TMO_CLOSE            CT_SECS(10)
+
+/**
+ * TCP connection states
+ */
+enum ct_state {
+    CT_S_NONE        = 0,
+    CT_S_SYN_SENT    = 1,
+    CT_S_SYN_RECV    = 2,
+    CT_S_ESTABLISHED = 3,
+    CT_S_FIN_WAIT    = 4,
+    CT_S_CLOSE_WAIT  = 5,
+    CT_S_LAST_ACK    = 6,
+    CT_S_TIME_WAIT   = 7,
+    CT_S_CLOSE       = 8,
+    CT_S_INVALID     = 15,      /** Packet not valid in the state */
+};
+
+/**
+ * Entry meta word
+ */
+struct ct_meta {
+    union {
+        struct {
+            unsigned int lock:1;        /** Entry being updated */
+            unsigned int state:4;       /** enum ct_state */
+            unsigned int ts:27;         /** Last seen, see CT_TS_SHF */
+        };
+        uint32_t __raw;
+    };
+};
+
+#define CT_META_LOCK            (1 << 31)
+
+/**
+ * Sequence window of one direction
+ */
+struct ct_win {
+    uint32_t end;               /** Highest sequence number sent + 1 */
+    uint32_t maxend;            /** Highest ack + window seen from peer */
+    uint32_t maxwin;            /** Largest (scaled) window sent */
+};
+
+/**
+ * Connection entry.  Side a is the lower of the two address/port pairs.
+ */
+struct ct_entry {
+    union {
+        struct {
+            uint32_t ip_a;              /** Address of side a */
+            uint32_t ip_b;              /** Address of side b */
+            unsigned int port_a:16;     /** Port of side a */
+            unsigned int port_b:16;     /** Port of side b */
+
+            unsigned int orig:1;        /** Side that opened (1: b) */
+            unsigned int resv0:15;      /** Reserved */
+            unsigned int gen:8;         /** Generation, see age_wheel.h */
+            unsigned int wscale_a:4;    /** Window scale of side a */
+            unsigned int wscale_b:4;    /** Window scale of side b */
+
+            struct ct_win win[2];       /** Windows of sides a and b */
+
+            uint32_t resv1[2];          /** Reserved */
+        };
+        uint32_t __raw[12];
+    };
+};
+
+#define CT_KEY_WORDS            3
+
+/**
+ * Per ingress port configuration
+ */
+struct ct_port_cfg {
+    union {
+        struct {
+            unsigned int enable:1;      /** Track TCP from this port */
+            unsigned int allow_new:1;   /** Connections may be opened */
+            unsigned int loose:1;       /** Pick up existing connections */
+            unsigned int resv:29;       /** Reserved */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * Global counters
+ */
+struct ct_cntrs {
+    uint64_t created;           /** Connections created */
+    uint64_t picked_up;         /** Connections picked up mid stream */
+    uint64_t established;       /** Connections established */
+    uint64_t closed;            /** Connections closed (FIN or RST) */
+    uint64_t expired;           /** Entries reclaimed after timeout */
+    uint64_t evicted;           /** Live entries evicted */
+    uint64_t full;              /** New connections refused, no slot */
+    uint64_t refused;           /** New connections not allowed */
+    uint64_t invalid;           /** Dropped, invalid in the state */
+    uint64_t out_of_window;     /** Dropped, outside the windows */
+    uint64_t contended;         /** Dropped, entry locked too long */
+};
+
+/**
+ * Return values of ct_pkt()
+ */
+enum ct_res {
+    CT_RES_NONE = 0,            /** Not tracked */
+    CT_RES_PASS = 1,            /** Valid packet of a connection */
+    CT_RES_DROP = 2,            /** Packet must be dropped */
+};
+
+/**
+ * Track a TCP packet and decide whether it may pass.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param port      Ingress port
+ * @return          One of enum ct_res
+ */
+__intrinsic enum ct_res ct_pkt(__mem40 char *pbuf, unsigned int l2_off,
+                               unsigned int port);
+
+/**
+ * Age out an entry, called by the aging timer wheel.
+ * @param idx       Index of the entry
+ * @param gen       Generation of the entry when it was linked
+ * @param rec       Export record, the data words are filled in with the
+ *                  key (3 words), state and last seen timestamp
+ * @return          -1 if the link is stale, 0 if the entry expired and
+ *                  was deleted, otherwise the time until it expires
+ */
+int ct_age(unsigned int idx, unsigned int gen, __lmem struct age_rec *rec);
+
+#endif /* _CONNTRACK_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
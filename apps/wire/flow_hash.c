@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/flow_hash.c
+ * @brief         Flow hash over the headers of an Ethernet frame
+ */
+
+#ifndef _FLOW_HASH_C_
+#define _FLOW_HASH_C_
+
+#include "config.h"
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <net/ip.h>
+#include <net/udp.h>
+#include <net/hdr_ext.h>
+#include <std/hash.h>
+
+#include "flow_hash.h"
+
+struct flow_hash_hdrs {
+    union {
+        struct eth_hdr  eth;
+        struct vlan_hdr vlan;
+        struct ip4_hdr  ip4;
+        struct udp_hdr  udp;
+    };
+};
+
+__intrinsic int
+flow_key_frame(__lmem uint32_t *buf, int off, __lmem uint32_t *key)
+{
+    __gpr struct flow_hash_hdrs h;
+    __gpr int res;
+    __gpr int next_proto;
+
+    res = he_eth(buf, off, &h.eth);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    key[FLOW_KEY_SRC] = h.eth.dst.a[4] << 8 | h.eth.dst.a[5];
+    key[FLOW_KEY_DST] = h.eth.src.a[4] << 8 | h.eth.src.a[5];
+    key[FLOW_KEY_PROTO] = 0;
+    key[FLOW_KEY_PORTS] = 0;
+
+    if (next_proto == HE_8021Q) {
+        res = he_vlan(buf, off, &h.vlan);
+        next_proto = HE_RES_PROTO_of(res);
+        off += HE_RES_LEN_of(res);
+    }
+
+    if (next_proto != HE_IP4)
+        return 0;
+
+    res = he_ip4(buf, off, &h.ip4);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    key[FLOW_KEY_SRC] = h.ip4.src;
+    key[FLOW_KEY_DST] = h.ip4.dst;
+    key[FLOW_KEY_PROTO] = h.ip4.proto;
+
+    if ((next_proto == HE_TCP || next_proto == HE_UDP) &&
+        !NET_IP_IS_FRAG(h.ip4.frag) &&
+        he_udp_fit(FLOW_HASH_BUF_SZ, off)) {
+        /* Ports are at the same place in TCP and UDP */
+        he_udp(buf, off, &h.udp, 0);
+        key[FLOW_KEY_PORTS] = (h.udp.sport << 16) | h.udp.dport;
+    }
+
+    return off;
+}
+
+__intrinsic uint32_t
+flow_hash_frame(__lmem uint32_t *buf, int off)
+{
+    __lmem uint32_t key[FLOW_KEY_WORDS];
+
+    flow_key_frame(buf, off, key);
+
+    return hash_me_crc32(key, sizeof(key), 0);
+}
+
+#endif /* _FLOW_HASH_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
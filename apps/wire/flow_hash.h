@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/flow_hash.h
+ * @brief         Flow hash over the headers of an Ethernet frame
+ */
+
+#ifndef _FLOW_HASH_H_
+#define _FLOW_HASH_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* Size of the Local Memory buffer passed to flow_hash_frame() */
+#define FLOW_HASH_BUF_SZ        64
+
+/*
+ * Flow key: IPv4 source and destination address, protocol and TCP/UDP
+ * source and destination port (zero if not present)
+ */
+#define FLOW_KEY_WORDS          4
+
+#define FLOW_KEY_SRC            0
+#define FLOW_KEY_DST            1
+#define FLOW_KEY_PROTO          2
+#define FLOW_KEY_PORTS          3
+
+/**
+ * Extract the flow key of an Ethernet frame.
+ * @param buf       Local Memory copy of the start of the frame
+ * @param off       Offset of the Ethernet header in @buf
+ * @param key       Returned flow key, FLOW_KEY_WORDS words
+ * @return          Offset of the IPv4 payload in @buf for IPv4 frames, zero
+ *                  for other frames
+ *
+ * Frames other than IPv4 get a key of the low bytes of the MAC addresses,
+ * see flow_hash_frame().
+ */
+__intrinsic int flow_key_frame(__lmem uint32_t *buf, int off,
+                               __lmem uint32_t *key);
+
+/**
+ * Hash the flow of an Ethernet frame.
+ * @param buf       Local Memory copy of the start of the frame
+ * @param off       Offset of the Ethernet header in @buf
+ * @return          CRC32 over the flow key
+ *
+ * IPv4 frames are hashed on the addresses, protocol and TCP/UDP ports
+ * (skipped for fragments), after an optional VLAN tag.  Other frames are
+ * hashed on the low bytes of the MAC addresses.  Only fields constant for
+ * the life of a flow are used, so all packets of a flow hash the same.
+ */
+__intrinsic uint32_t flow_hash_frame(__lmem uint32_t *buf, int off);
+
+#endif /* _FLOW_HASH_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/flowrec.c
+ * @brief         IPFIX style flow records
+ */
+
+#ifndef _FLOWREC_C_
+#define _FLOWREC_C_
+
+#include "config.h"
+
+#ifdef CFG_FLOWREC
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/ip.h>
+#include <net/tcp.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/mem_cam.h>
+#include <std/hash.h>
+#include <std/reg_utils.h>
+
+#include "flow_hash.h"
+#include "flowrec.h"
+#include "host_ring.h"
+
+#ifndef CFG_AGE_WHEEL
+#error "CFG_FLOWREC requires CFG_AGE_WHEEL"
+#endif
+
+/* CAM buckets and the entries matching the CAM slots */
+__export __emem __align64 uint32_t fr_cam[FR_BUCKETS][FR_BUCKET_SZ];
+__export __emem __align64 struct fr_entry fr_tbl[FR_ENTRIES];
+__export __emem __align64 struct fr_exp fr_exp[FR_ENTRIES];
+
+HOST_RING_DECLARE(fr_export, struct fr_batch, FR_EXPORT_ENTRIES);
+
+__export __emem struct fr_cfg fr_cfg;
+__export __emem struct fr_cntrs fr_cntrs;
+
+/*
+ * Batch being filled by the aging context: its ring counter, number of
+ * records and the time it was claimed, in wheel units
+ */
+__shared __lmem uint32_t fr_batch_seq;
+__shared __lmem uint32_t fr_batch_cnt;
+__shared __lmem uint32_t fr_batch_ts;
+
+#define FR_HASH_SEED            0x666c6f77
+
+#define FR_FIN_FLAGS            (NET_TCP_FLAG_FIN | NET_TCP_FLAG_RST)
+
+
+/*
+ * TCP flags of a frame, @l4_off is the offset of the TCP header in @buf
+ */
+__intrinsic static unsigned int
+fr_tcp_flags(__lmem uint32_t *buf, int l4_off, __lmem uint32_t *key)
+{
+    __gpr unsigned int off;
+
+    if (key[FLOW_KEY_PROTO] != NET_IP_PROTO_TCP || key[FLOW_KEY_PORTS] == 0)
+        return 0;
+
+    off = l4_off + 13;
+    if (off >= FLOW_HASH_BUF_SZ)
+        return 0;
+
+    return (buf[off / 4] >> (8 * (3 - (off & 3)))) & 0xff;
+}
+
+/*
+ * Initialise a new entry and link it into the aging wheel
+ */
+__intrinsic static void
+fr_create(unsigned int idx, __lmem uint32_t *key, uint32_t now,
+          unsigned int len, unsigned int flags, unsigned int port)
+{
+    __xread uint32_t tmo_in;
+    __xrw uint32_t gen;
+    __xwrite uint32_t key_out[FLOW_KEY_WORDS];
+    __xwrite uint32_t ent_out[7];
+    __xwrite uint32_t exp_out[6];
+    __gpr uint32_t tmo;
+    __mem40 struct fr_entry *e;
+
+    e = &fr_tbl[idx];
+
+    gen = 1;
+    mem_test_add(&gen, &e->gen, sizeof(gen));
+
+    reg_cp(key_out, key, sizeof(key_out));
+    mem_write32(key_out, e->key, sizeof(key_out));
+
+    /* first, last, port/flags, pkts and bytes */
+    ent_out[0] = now;
+    ent_out[1] = now;
+    ent_out[2] = (port << 8) | flags;
+    ent_out[3] = 0;
+    ent_out[4] = 1;
+    ent_out[5] = 0;
+    ent_out[6] = len;
+    mem_write32(ent_out, &e->first, sizeof(ent_out));
+
+    exp_out[0] = now;
+    exp_out[1] = 0;
+    exp_out[2] = 0;
+    exp_out[3] = 0;
+    exp_out[4] = 0;
+    exp_out[5] = 0;
+    mem_write32(exp_out, &fr_exp[idx], sizeof(exp_out));
+
+    mem_read32(&tmo_in, &fr_cfg.idle_tmo, sizeof(tmo_in));
+    tmo = (tmo_in != 0) ? tmo_in : FR_IDLE_TMO;
+    age_link(AGE_TBL_FR, idx, gen + 1, tmo);
+
+    mem_incr64(&fr_cntrs.created);
+}
+
+__intrinsic void
+fr_pkt(__lmem uint32_t *buf, int l4_off, __lmem uint32_t *key,
+       unsigned int len, unsigned int port)
+{
+    __xrw struct mem_cam_32bit cam;
+    __xread uint32_t key_in[FLOW_KEY_WORDS];
+    __xwrite uint32_t last_out;
+    __gpr uint32_t sig;
+    __gpr uint32_t now;
+    __gpr unsigned int idx;
+    __gpr unsigned int flags;
+    __mem40 struct fr_entry *e;
+
+    now = FR_TS_NOW();
+    flags = fr_tcp_flags(buf, l4_off, key);
+
+    sig = hash_me_crc32(key, FLOW_KEY_WORDS * 4, FR_HASH_SEED);
+    if (sig == 0)
+        sig = 1;
+
+    cam.search.value = sig;
+    mem_cam_lookup_add(&cam, fr_cam[sig & (FR_BUCKETS - 1)], 512, 32);
+    if (mem_cam_lookup_add_fail(cam)) {
+        mem_incr64(&fr_cntrs.full);
+        return;
+    }
+
+    idx = (sig & (FR_BUCKETS - 1)) * FR_BUCKET_SZ +
+        (cam.result.match & 0x7f);
+    if (mem_cam_lookup_add_added(cam)) {
+        fr_create(idx, key, now, len, flags, port);
+        return;
+    }
+
+    e = &fr_tbl[idx];
+    mem_read32(key_in, e->key, sizeof(key_in));
+    if (key_in[0] != key[0] || key_in[1] != key[1] ||
+        key_in[2] != key[2] || key_in[3] != key[3]) {
+        /* Signature collision with another flow, or the entry of this
+         * one is still being created by another ME */
+        mem_incr64(&fr_cntrs.collision);
+        return;
+    }
+
+    last_out = now;
+    mem_write32(&last_out, &e->last, sizeof(last_out));
+    mem_incr64(&e->pkts);
+    mem_add64_imm(len, &e->bytes);
+    if (flags)
+        mem_bitset_imm(flags, &e->__raw[7]);
+}
+
+/*
+ * Write the header of the current batch, making it visible to the host
+ */
+__intrinsic static void
+fr_flush(void)
+{
+    __xwrite uint32_t hdr_out[3];
+
+    if (fr_batch_cnt == 0)
+        return;
+
+    hdr_out[0] = fr_batch_seq;
+    hdr_out[1] = fr_batch_cnt;
+    hdr_out[2] = FR_TS_NOW();
+    mem_write32(hdr_out,
+                &fr_export[fr_batch_seq & (FR_EXPORT_ENTRIES - 1)].hdr,
+                sizeof(hdr_out));
+
+    fr_batch_cnt = 0;
+    mem_incr64(&fr_cntrs.batches);
+}
+
+/*
+ * Add a record to the current batch, claiming a ring slot for a new one
+ */
+__intrinsic static void
+fr_emit(__lmem struct fr_rec *rec)
+{
+    __xwrite struct fr_rec rec_out;
+
+    if (fr_batch_cnt == 0) {
+        fr_batch_seq = host_ring_claim(&fr_export_wptr);
+        fr_batch_ts = AGE_TS_NOW();
+    }
+
+    reg_cp(&rec_out, rec, sizeof(rec_out));
+    mem_write32(&rec_out,
+                &fr_export[fr_batch_seq & (FR_EXPORT_ENTRIES - 1)]
+                .rec[fr_batch_cnt],
+                sizeof(rec_out));
+    mem_incr64(&fr_cntrs.records);
+
+    fr_batch_cnt++;
+    if (fr_batch_cnt == FR_BATCH_RECS)
+        fr_flush();
+}
+
+void
+fr_flush_stale(uint32_t now)
+{
+    if (fr_batch_cnt != 0 && now - fr_batch_ts >= FR_FLUSH_TMO)
+        fr_flush();
+}
+
+/*
+ * Emit a record of the packets since the previous one, if any
+ */
+__intrinsic static void
+fr_record(unsigned int idx, __xread struct fr_entry *e,
+          __xread struct fr_exp *exp, enum fr_reason reason)
+{
+    __lmem struct fr_rec rec;
+
+    if (e->pkts == exp->pkts)
+        return;
+
+    reg_zero(&rec, sizeof(rec));
+    rec.src = e->key[FLOW_KEY_SRC];
+    rec.dst = e->key[FLOW_KEY_DST];
+    rec.proto = e->key[FLOW_KEY_PROTO];
+    rec.flags = e->flags;
+    rec.reason = reason;
+    rec.port = e->port;
+    rec.ports = e->key[FLOW_KEY_PORTS];
+    rec.pkts = e->pkts - exp->pkts;
+    rec.bytes = e->bytes - exp->bytes;
+    rec.start = exp->start;
+    rec.end = e->last;
+    rec.idx = idx;
+
+    fr_emit(&rec);
+}
+
+int
+fr_age(unsigned int idx, unsigned int gen, __lmem struct age_rec *rec)
+{
+    __xread struct fr_cfg cfg;
+    __xread struct fr_entry e;
+    __xread struct fr_exp exp;
+    __xwrite uint32_t sig_out;
+    __xwrite uint32_t exp_out[6];
+    __gpr uint32_t now;
+    __gpr uint32_t idle;
+    __gpr uint32_t active;
+    __gpr uint32_t tmo;
+    __gpr uint32_t active_tmo;
+    __gpr uint32_t left;
+    __gpr unsigned int fin;
+
+    mem_read32(&e, &fr_tbl[idx], sizeof(e));
+    if ((e.gen & 0xff) != gen)
+        return -1;
+
+    mem_read32(&exp, &fr_exp[idx], sizeof(exp));
+    mem_read32(&cfg, &fr_cfg, sizeof(cfg));
+
+    fin = (e.flags & FR_FIN_FLAGS) != 0;
+    if (fin)
+        tmo = (cfg.fin_tmo != 0) ? cfg.fin_tmo : FR_FIN_TMO;
+    else
+        tmo = (cfg.idle_tmo != 0) ? cfg.idle_tmo : FR_IDLE_TMO;
+    active_tmo = (cfg.active_tmo != 0) ? cfg.active_tmo : FR_ACTIVE_TMO;
+
+    now = FR_TS_NOW();
+    idle = FR_TS_TO_AGE(now - e.last);
+    if (idle >= tmo) {
+        /* Free the CAM slot, later packets create a new entry */
+        sig_out = 0;
+        mem_write32(&sig_out,
+                    &fr_cam[idx / FR_BUCKET_SZ][idx % FR_BUCKET_SZ],
+                    sizeof(sig_out));
+        mem_incr64(&fr_cntrs.expired);
+
+        fr_record(idx, &e, &exp, fin ? FR_END_FIN : FR_END_IDLE);
+
+        rec->data[0] = e.key[FLOW_KEY_SRC];
+        rec->data[1] = e.key[FLOW_KEY_DST];
+        rec->data[2] = e.key[FLOW_KEY_PROTO];
+        rec->data[3] = e.key[FLOW_KEY_PORTS];
+        rec->data[4] = e.first;
+        rec->data[5] = e.last;
+        return 0;
+    }
+
+    left = tmo - idle;
+    active = FR_TS_TO_AGE(now - exp.start);
+    if (active >= active_tmo) {
+        fr_record(idx, &e, &exp, FR_END_ACTIVE);
+        mem_incr64(&fr_cntrs.active);
+
+        /* Counts and flags of the next record start from here */
+        exp_out[0] = now;
+        exp_out[1] = 0;
+        exp_out[2] = e.pkts >> 32;
+        exp_out[3] = e.pkts;
+        exp_out[4] = e.bytes >> 32;
+        exp_out[5] = e.bytes;
+        mem_write32(exp_out, &fr_exp[idx], sizeof(exp_out));
+        if (e.flags)
+            mem_bitclr_imm(e.flags, &fr_tbl[idx].__raw[7]);
+
+        active = 0;
+    }
+
+    if (active_tmo - active < left)
+        left = active_tmo - active;
+    return left;
+}
+
+#endif /* CFG_FLOWREC */
+
+#endif /* _FLOWREC_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
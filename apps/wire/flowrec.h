@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/flowrec.h
+ * @brief         IPFIX style flow records
+ *
+ * IPv4 flows seen by the packet path are kept in a flow cache of 512 bit
+ * CAM buckets keyed by the flow hash.  Each entry counts the packets and
+ * bytes of its flow, the first and last packet time and the OR of the TCP
+ * flags.  Entries are created on the first packet of a flow and linked
+ * into the aging timer wheel (age_wheel.h), so no table is scanned.  A
+ * CAM hit is checked against the key of the entry, packets of a flow whose
+ * hash matches another flow of the bucket are only counted as collisions.
+ *
+ * The aging context emits a flow record when an entry has been idle for
+ * the idle timeout (the shorter FIN timeout once a FIN or RST was seen),
+ * and for long lived flows every active timeout, with the counts since
+ * the previous record.  Records are exported in batches of
+ * FR_BATCH_RECS: the ring slot of a batch is claimed once and its header
+ * is written when the batch is full or older than FR_FLUSH_TMO, so the
+ * host (tools/fr_collect.py) only sees complete batches.
+ *
+ * Requires CFG_AGE_WHEEL.
+ */
+
+#ifndef _FLOWREC_H_
+#define _FLOWREC_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include "age_wheel.h"
+
+#ifndef FR_BUCKETS
+#define FR_BUCKETS              4096
+#endif
+
+#if (FR_BUCKETS & (FR_BUCKETS - 1)) != 0
+#error "FR_BUCKETS must be a power of 2"
+#endif
+
+#define FR_BUCKET_SZ            16
+#define FR_ENTRIES              (FR_BUCKETS * FR_BUCKET_SZ)
+
+/*
+ * Record timestamps are the ME timestamp counter shifted right by
+ * FR_TS_SHF (about 20 us at 800 MHz), timeouts are in wheel units.
+ */
+#define FR_TS_SHF               10
+#define FR_TS_NOW()     ((uint32_t)(me_tsc_read() >> FR_TS_SHF))
+#define FR_TS_TO_AGE(_t)        ((_t) >> (AGE_TS_SHF - FR_TS_SHF))
+
+/*
+ * Default timeouts in wheel units (about 21 ms), used while the host
+ * configuration is zero: 15 s idle, 60 s active and 1 s after a FIN/RST
+ */
+#ifndef FR_IDLE_TMO
+#define FR_IDLE_TMO             715
+#endif
+
+#ifndef FR_ACTIVE_TMO
+#define FR_ACTIVE_TMO           2861
+#endif
+
+#ifndef FR_FIN_TMO
+#define FR_FIN_TMO              48
+#endif
+
+/* Export ring geometry, batches of records */
+#ifndef FR_EXPORT_ENTRIES
+#define FR_EXPORT_ENTRIES       1024
+#endif
+
+#define FR_BATCH_RECS           7
+
+/* Partially filled batches are written after this many wheel units */
+#ifndef FR_FLUSH_TMO
+#define FR_FLUSH_TMO            48
+#endif
+
+/**
+ * Reason a record was emitted, the IPFIX flowEndReason values
+ */
+enum fr_reason {
+    FR_END_IDLE     = 1,        /** Idle timeout */
+    FR_END_ACTIVE   = 2,        /** Active timeout, the flow continues */
+    FR_END_FIN      = 3,        /** Idle after a FIN or RST */
+};
+
+/**
+ * Flow cache entry, updated by the packet path
+ */
+struct fr_entry {
+    union {
+        struct {
+            uint32_t key[4];            /** Flow key, see flow_hash.h */
+            uint32_t gen;               /** Generation, low 8 bits used */
+            uint32_t first;             /** First packet, FR_TS units */
+            uint32_t last;              /** Last packet, FR_TS units */
+
+            unsigned int resv:16;       /** Reserved */
+            unsigned int port:8;        /** Ingress port */
+            unsigned int flags:8;       /** OR of the TCP flags */
+
+            uint64_t pkts;              /** Packets */
+            uint64_t bytes;             /** Bytes */
+            uint32_t resv1[4];          /** Reserved */
+        };
+        uint32_t __raw[16];
+    };
+};
+
+/**
+ * Export state of an entry, only written by the aging context after the
+ * entry is created
+ */
+struct fr_exp {
+    union {
+        struct {
+            uint32_t start;             /** Start of the next record */
+            uint32_t resv;              /** Reserved */
+            uint64_t pkts;              /** Packets already exported */
+            uint64_t bytes;             /** Bytes already exported */
+            uint32_t resv1[2];          /** Reserved */
+        };
+        uint32_t __raw[8];
+    };
+};
+
+/**
+ * Flow record, see tools/fr_collect.py
+ */
+struct fr_rec {
+    union {
+        struct {
+            uint32_t src;               /** IPv4 source address */
+            uint32_t dst;               /** IPv4 destination address */
+
+            unsigned int proto:8;       /** IP protocol */
+            unsigned int flags:8;       /** OR of the TCP flags */
+            unsigned int reason:8;      /** enum fr_reason */
+            unsigned int port:8;        /** Ingress port */
+
+            uint32_t ports;             /** Source and destination port */
+            uint64_t pkts;              /** Packets in the record */
+            uint64_t bytes;             /** Bytes in the record */
+            uint32_t start;             /** First packet, FR_TS units */
+            uint32_t end;               /** Last packet, FR_TS units */
+            uint32_t idx;               /** Flow cache entry */
+            uint32_t resv[5];           /** Reserved */
+        };
+        uint32_t __raw[16];
+    };
+};
+
+/**
+ * Header of a batch, written once the records are in place
+ */
+struct fr_batch_hdr {
+    union {
+        struct {
+            uint32_t seq;               /** Ring write counter of the slot */
+            uint32_t cnt;               /** Records in the batch */
+            uint32_t ts;                /** Time of the write, FR_TS units */
+            uint32_t resv[13];          /** Reserved */
+        };
+        uint32_t __raw[16];
+    };
+};
+
+struct fr_batch {
+    struct fr_batch_hdr hdr;
+    struct fr_rec rec[FR_BATCH_RECS];
+};
+
+/**
+ * Host configuration, timeouts in wheel units.  A zero timeout selects
+ * the build time default.
+ */
+struct fr_cfg {
+    union {
+        struct {
+            uint32_t idle_tmo;          /** Expire after this long idle */
+            uint32_t active_tmo;        /** Record interval of live flows */
+            uint32_t fin_tmo;           /** Idle timeout after FIN/RST */
+            uint32_t resv;              /** Reserved */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Counters
+ */
+struct fr_cntrs {
+    uint64_t created;           /** Entries created */
+    uint64_t full;              /** Packets not counted, bucket full */
+    uint64_t expired;           /** Entries expired */
+    uint64_t active;            /** Active timeout records */
+    uint64_t records;           /** Records exported */
+    uint64_t batches;           /** Batches exported */
+    uint64_t collision;         /** Packets not counted, signature clash */
+};
+
+/**
+ * Account a packet to its flow.
+ * @param buf       Local Memory copy of the start of the frame
+ * @param l4_off    Offset of the IPv4 payload in @buf (flow_key_frame())
+ * @param key       Flow key of the packet (flow_key_frame())
+ * @param len       Frame length in bytes
+ * @param port      Ingress port
+ */
+__intrinsic void fr_pkt(__lmem uint32_t *buf, int l4_off,
+                        __lmem uint32_t *key, unsigned int len,
+                        unsigned int port);
+
+/**
+ * Age a flow cache entry, called by the aging wheel.
+ * @param idx       Index of the entry
+ * @param gen       Generation of the link
+ * @param rec       Aging export record, data filled in on expiry
+ * @return          -1 for a stale link, 0 if the entry expired, otherwise
+ *                  the time left in wheel units
+ *
+ * Emits the flow records of the entry into the current batch.
+ */
+int fr_age(unsigned int idx, unsigned int gen, __lmem struct age_rec *rec);
+
+/**
+ * Write the current batch if it is older than FR_FLUSH_TMO, called by
+ * the aging wheel on every tick.
+ * @param now       Current time in wheel units
+ */
+void fr_flush_stale(uint32_t now);
+
+#endif /* _FLOWREC_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
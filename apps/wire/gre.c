@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/gre.c
+ * @brief         GRE/NVGRE tunnel termination
+ */
+
+#ifndef _GRE_C_
+#define _GRE_C_
+
+#include "config.h"
+
+#ifdef CFG_GRE
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <net/gre.h>
+#include <net/ip.h>
+#include <net/hdr_ext.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <std/reg_utils.h>
+
+#include "flow_hash.h"
+#include "gre.h"
+
+/* Per ingress port configuration */
+__export __emem struct gre_port_cfg gre_port_cfg[GRE_NUM_PORTS];
+
+__export __emem struct gre_vsid_cntrs gre_vsid_cntrs[GRE_NUM_VSID_CNTRS];
+__export __emem struct gre_cntrs gre_cntrs;
+
+/*
+ * Frames are read at a two byte offset so that the IP header is word
+ * aligned, see pkt_count.c
+ */
+#define GRE_START_OFF           2
+#define GRE_BUF_SZ              FLOW_HASH_BUF_SZ
+
+struct gre_hdrs {
+    union {
+        struct eth_hdr          eth;
+        struct vlan_hdr         vlan;
+        struct ip4_hdr          ip4;
+        struct gre_hdr          gre;
+        struct nvgre_ext_hdr    nvgre;
+    };
+};
+
+
+__intrinsic enum gre_res
+gre_pkt(__mem40 char *pbuf, unsigned int *l2_off, unsigned int *len,
+        unsigned int port, uint32_t *hash)
+{
+    __xread struct gre_port_cfg cfg;
+    __xread uint32_t pkt_buf[GRE_BUF_SZ / 4];
+    __xwrite uint32_t eth_out[4];
+    __lmem uint32_t buf[GRE_BUF_SZ / 4];
+    __gpr struct gre_hdrs h;
+    __gpr int off = GRE_START_OFF;
+    __gpr int res;
+    __gpr int next_proto;
+    __gpr unsigned int flags;
+    __gpr unsigned int key;
+    __gpr unsigned int outer_len;
+    __gpr unsigned int new_off;
+    __gpr unsigned int etype;
+    __mem40 struct gre_vsid_cntrs *cntrs;
+
+    mem_read32(&cfg, &gre_port_cfg[port & (GRE_NUM_PORTS - 1)], sizeof(cfg));
+    if (!cfg.term)
+        return GRE_RES_NONE;
+
+    mem_read64(pkt_buf, pbuf + *l2_off - GRE_START_OFF, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+
+    /*
+     * Outer headers
+     */
+    res = he_eth(buf, off, &h.eth);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto == HE_8021Q) {
+        res = he_vlan(buf, off, &h.vlan);
+        next_proto = HE_RES_PROTO_of(res);
+        off += HE_RES_LEN_of(res);
+    }
+
+    if (next_proto != HE_IP4)
+        return GRE_RES_NONE;
+
+    res = he_ip4(buf, off, &h.ip4);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto != HE_GRE)
+        return GRE_RES_NONE;
+
+    /* Fragments can not be terminated, leave them to the host */
+    if (NET_IP_IS_FRAG(h.ip4.frag) || !he_gre_fit(GRE_BUF_SZ, off))
+        goto bad_hdr;
+
+    res = he_gre(buf, off, &h.gre);
+    next_proto = HE_RES_PROTO_of(res);
+    flags = h.gre.flags;
+
+    if (h.gre.version != 0)
+        goto bad_hdr;
+
+    /* The optional fields are word aligned as the IP header is */
+    key = 0;
+    if (next_proto == HE_ETHER && NET_GRE_IS_NVGRE(flags)) {
+        he_gre_nvgre(buf, off, &h.nvgre);
+        key = h.nvgre.vsid;
+        mem_incr64(&gre_cntrs.nvgre);
+    } else if (cfg.nvgre_only) {
+        return GRE_RES_NONE;
+    } else if (flags & NET_GRE_FLAGS_KEY_PRESENT) {
+        if (flags & NET_GRE_FLAGS_CSUM_PRESENT)
+            key = buf[(off + 8) >> 2];
+        else
+            key = buf[(off + 4) >> 2];
+    }
+    off += HE_RES_LEN_of(res);
+
+    /*
+     * Remove the outer headers
+     */
+    outer_len = off - GRE_START_OFF;
+
+    if (next_proto == HE_ETHER) {
+        if (!NET_GRE_IS_NVGRE(flags))
+            mem_incr64(&gre_cntrs.gre_teb);
+
+        new_off = *l2_off + outer_len;
+        *len -= outer_len;
+    } else if (next_proto == HE_IP4 || next_proto == HE_IP6) {
+        mem_incr64(&gre_cntrs.gre_ip);
+
+        /*
+         * Re-use the outer MAC addresses in front of the inner IP header.
+         * The buffer holds them at GRE_START_OFF, so copy the two bytes
+         * before them as well and keep the write word sized.
+         */
+        etype = (next_proto == HE_IP4) ? NET_ETH_TYPE_IPV4 : NET_ETH_TYPE_IPV6;
+        eth_out[0] = buf[0];
+        eth_out[1] = buf[1];
+        eth_out[2] = buf[2];
+        eth_out[3] = (buf[3] & 0xffff0000) | etype;
+
+        new_off = *l2_off + outer_len - NET_ETH_LEN;
+        mem_write8(eth_out, pbuf + new_off - GRE_START_OFF, sizeof(eth_out));
+        *len -= outer_len - NET_ETH_LEN;
+    } else {
+        goto bad_hdr;
+    }
+
+    *l2_off = new_off;
+
+    cntrs = &gre_vsid_cntrs[key & (GRE_NUM_VSID_CNTRS - 1)];
+    mem_incr64(&cntrs->pkts);
+    mem_add64_imm(*len, &cntrs->bytes);
+
+    /*
+     * Hash the inner flow
+     */
+    mem_read64(pkt_buf, pbuf + new_off - GRE_START_OFF, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+    *hash = flow_hash_frame(buf, GRE_START_OFF);
+
+    return GRE_RES_DECAP;
+
+bad_hdr:
+    mem_incr64(&gre_cntrs.bad_hdr);
+    return GRE_RES_NONE;
+}
+
+#endif /* CFG_GRE */
+
+#endif /* _GRE_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/gre.h
+ * @brief         GRE/NVGRE tunnel termination
+ *
+ * GRE (RFC 2784/2890) and NVGRE tunnels over IPv4 are terminated on the
+ * ports configured for it.  The outer headers are removed by moving the
+ * start of the packet forward:
+ *  - Transparent Ethernet bridging payloads (NVGRE and GRE with protocol
+ *    0x6558) are forwarded as the inner Ethernet frame.
+ *  - IPv4/IPv6 payloads get the outer Ethernet addresses re-written in
+ *    front of the inner IP header.
+ *
+ * The inner flow is hashed so that TM queue selection spreads tenant
+ * flows instead of collapsing them onto the tunnel endpoints.  Packets
+ * are counted per VSID (NVGRE) or GRE key.
+ */
+
+#ifndef _GRE_H_
+#define _GRE_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#ifndef GRE_NUM_PORTS
+#define GRE_NUM_PORTS           64
+#endif
+
+/*
+ * Number of per VSID/key counters.  Counters are indexed by the low bits
+ * of the VSID/key, tunnels without a key use counter 0.
+ */
+#ifndef GRE_NUM_VSID_CNTRS
+#define GRE_NUM_VSID_CNTRS      4096
+#endif
+
+#if (GRE_NUM_VSID_CNTRS & (GRE_NUM_VSID_CNTRS - 1)) != 0
+#error "GRE_NUM_VSID_CNTRS must be a power of 2"
+#endif
+
+/**
+ * Per ingress port configuration
+ */
+struct gre_port_cfg {
+    union {
+        struct {
+            unsigned int term:1;        /** Terminate GRE on this port */
+            unsigned int nvgre_only:1;  /** Only terminate NVGRE */
+            unsigned int resv:30;       /** Reserved */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * Per VSID/key counters
+ */
+struct gre_vsid_cntrs {
+    uint64_t pkts;              /** Packets terminated */
+    uint64_t bytes;             /** Inner bytes terminated */
+};
+
+/**
+ * Global counters
+ */
+struct gre_cntrs {
+    uint64_t nvgre;             /** NVGRE packets terminated */
+    uint64_t gre_teb;           /** GRE Ethernet packets terminated */
+    uint64_t gre_ip;            /** GRE IPv4/IPv6 packets terminated */
+    uint64_t bad_hdr;           /** Passed, GRE headers not handled */
+};
+
+/**
+ * Return values of gre_pkt()
+ */
+enum gre_res {
+    GRE_RES_NONE  = 0,          /** Packet not modified */
+    GRE_RES_DECAP = 1,          /** Outer headers removed */
+};
+
+/**
+ * Terminate a GRE/NVGRE tunnel if configured for the ingress port.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header, updated on decap
+ * @param len       Length of the frame, updated on decap
+ * @param port      Ingress port
+ * @param hash      Set to the inner flow hash on decap
+ * @return          One of enum gre_res
+ */
+__intrinsic enum gre_res gre_pkt(__mem40 char *pbuf, unsigned int *l2_off,
+                                 unsigned int *len, unsigned int port,
+                                 uint32_t *hash);
+
+#endif /* _GRE_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/hll.c
+ * @brief         HyperLogLog distinct source and flow counting per port
+ */
+
+#ifndef _HLL_C_
+#define _HLL_C_
+
+#include "config.h"
+
+#ifdef CFG_HLL
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/cls.h>
+#include <nfp/me.h>
+#include <nfp/mem_bulk.h>
+#include <std/hash.h>
+#include <std/reg_utils.h>
+
+#include "flow_hash.h"
+#include "hll.h"
+
+#define HLL_BANK_WORDS          (HLL_NUM_PORTS * HLL_KINDS * HLL_REGS)
+
+/* Registers and the epoch each bank was cleared for, per island */
+__export __shared __cls __align64 uint32_t hll_regs[HLL_BANKS]
+                                                   [HLL_BANK_WORDS];
+__export __shared __cls uint32_t hll_bank_epoch[HLL_BANKS];
+
+/* Latest epoch seen by any ME, for the host */
+__export __emem uint32_t hll_epoch;
+
+/*
+ * Epoch and bank of this ME.  hll_pkt() stores the new epoch before the
+ * CLS accesses of hll_new_epoch(), so one context per ME starts it.
+ */
+__shared __lmem uint32_t hll_cur_epoch;
+__shared __lmem uint32_t hll_cur_bank;
+
+#define HLL_SRC_SEED            0x686c6c73
+#define HLL_FLOW_SEED           0x686c6c66
+
+/* Registers cleared per CLS write */
+#define HLL_CLR_WORDS           16
+
+/* Set in the tag of a bank while an ME clears it, epochs stay below it */
+#define HLL_TAG_CLEARING        (1 << 31)
+
+
+/*
+ * Make sure bank @bank is clear for epoch @epoch.
+ *
+ * The ME whose test and set of HLL_TAG_CLEARING finds the bit clear owns
+ * the bank until it writes the new tag, the other MEs of the island go on
+ * without clearing.  A bank cleared an epoch ahead is never written in
+ * between, so only the bank of the first or of an idle epoch can be
+ * cleared while other MEs update it.
+ */
+__intrinsic static void
+hll_bank_prepare(unsigned int bank, uint32_t epoch)
+{
+    __xread uint32_t tag_in;
+    __xrw uint32_t tag;
+    __xwrite uint32_t tag_out;
+    __xwrite uint32_t zero[HLL_CLR_WORDS];
+    __gpr unsigned int i;
+
+    cls_read(&tag_in, &hll_bank_epoch[bank], sizeof(tag_in));
+    if (tag_in == epoch)
+        return;
+
+    tag = HLL_TAG_CLEARING;
+    cls_test_set(&tag, &hll_bank_epoch[bank], sizeof(tag));
+    if (tag & HLL_TAG_CLEARING)
+        return;
+
+    /* A tag of @epoch was set by another ME since the read, then the
+     * bank is clear and only the bit is dropped again */
+    if (tag != epoch) {
+        reg_zero(zero, sizeof(zero));
+        for (i = 0; i < HLL_BANK_WORDS; i += HLL_CLR_WORDS)
+            cls_write(zero, &hll_regs[bank][i], sizeof(zero));
+    }
+
+    tag_out = epoch;
+    cls_write(&tag_out, &hll_bank_epoch[bank], sizeof(tag_out));
+}
+
+__intrinsic static void
+hll_new_epoch(uint32_t epoch)
+{
+    __xwrite uint32_t epoch_out;
+    __gpr unsigned int bank;
+
+    bank = epoch % HLL_BANKS;
+    hll_cur_bank = bank;
+
+    /*
+     * The current bank is stale if the island was idle, the next one is
+     * cleared ahead of time
+     */
+    hll_bank_prepare(bank, epoch);
+    hll_bank_prepare((bank + 1) % HLL_BANKS, epoch + 1);
+
+    epoch_out = epoch;
+    mem_write32(&epoch_out, &hll_epoch, sizeof(epoch_out));
+}
+
+/*
+ * Set the rank of a hash in its register
+ */
+__intrinsic static void
+hll_add(unsigned int bank, unsigned int port, unsigned int kind, uint32_t h)
+{
+    __xwrite uint32_t bit;
+    __gpr uint32_t rest;
+    __gpr unsigned int reg;
+
+    reg = h & (HLL_REGS - 1);
+    rest = h >> HLL_P;
+    if (rest == 0)
+        bit = 1 << (32 - HLL_P);
+    else
+        bit = 1 << ffs(rest);
+
+    cls_set(&bit, &hll_regs[bank][(port * HLL_KINDS + kind) * HLL_REGS + reg],
+            sizeof(bit));
+}
+
+__intrinsic void
+hll_pkt(__lmem uint32_t *key, unsigned int port)
+{
+    __gpr uint32_t epoch;
+    __gpr unsigned int bank;
+    __gpr uint32_t h;
+
+    epoch = me_tsc_read() >> HLL_EPOCH_SHF;
+    if (epoch != hll_cur_epoch) {
+        hll_cur_epoch = epoch;
+        hll_new_epoch(epoch);
+    }
+    bank = hll_cur_bank;
+    port &= HLL_NUM_PORTS - 1;
+
+    h = hash_me_crc32(&key[FLOW_KEY_SRC], sizeof(uint32_t), HLL_SRC_SEED);
+    hll_add(bank, port, HLL_SRC, h);
+
+    h = hash_me_crc32(key, FLOW_KEY_WORDS * 4, HLL_FLOW_SEED);
+    hll_add(bank, port, HLL_FLOW, h);
+}
+
+#endif /* CFG_HLL */
+
+#endif /* _HLL_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
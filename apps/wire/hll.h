@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/hll.h
+ * @brief         HyperLogLog distinct source and flow counting per port
+ *
+ * Each ingress port has two HyperLogLog sketches of HLL_REGS registers in
+ * CLS, one over the IPv4 source addresses and one over the flow keys.  The
+ * low HLL_P bits of a CRC32 of the item select a register and the number
+ * of trailing zeros of the remaining bits gives its rank.  A register
+ * records a rank by setting the corresponding bit with an atomic CLS set,
+ * so it holds a bitmap of all ranks seen and its value is the highest bit
+ * set.  Updates never read CLS and merging the registers of several
+ * islands is a bitwise OR.
+ *
+ * Time is divided into epochs of 2^HLL_EPOCH_SHF timestamp ticks and
+ * the registers rotate through HLL_BANKS banks: packets update the bank
+ * of the current epoch, the host reads the bank of the previous epoch,
+ * and the bank of the next epoch is cleared by the first ME of the island
+ * that claims it when the epoch changes.  Every bank is tagged with the
+ * epoch it was cleared for, so the host can ignore islands that saw no
+ * traffic.
+ *
+ * The relative standard error of an estimate is 1.04 / sqrt(HLL_REGS).
+ * tools/hll_read.py merges the islands and prints the estimates.
+ */
+
+#ifndef _HLL_H_
+#define _HLL_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* log2 of the registers per sketch, 7 gives a standard error of 9% */
+#ifndef HLL_P
+#define HLL_P                   7
+#endif
+
+#define HLL_REGS                (1 << HLL_P)
+
+/* Ports tracked, the ingress port is masked with HLL_NUM_PORTS - 1 */
+#ifndef HLL_NUM_PORTS
+#define HLL_NUM_PORTS           8
+#endif
+
+/* Epoch length, 2^26 ticks is about 1.3 s at 800 MHz */
+#ifndef HLL_EPOCH_SHF
+#define HLL_EPOCH_SHF           26
+#endif
+
+#define HLL_BANKS               3
+
+/**
+ * Sketches of a port
+ */
+enum hll_kind {
+    HLL_SRC     = 0,            /** Distinct source addresses */
+    HLL_FLOW    = 1,            /** Distinct flows */
+    HLL_KINDS   = 2,
+};
+
+/**
+ * Count the source address and flow of a packet.
+ * @param key       Flow key of the packet (flow_key_frame())
+ * @param port      Ingress port
+ */
+__intrinsic void hll_pkt(__lmem uint32_t *key, unsigned int port);
+
+#endif /* _HLL_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/host_ring.c
+ * @brief         Records exported to the host through EMEM
+ */
+
+#ifndef _HOST_RING_C_
+#define _HOST_RING_C_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+
+#include "host_ring.h"
+
+__intrinsic uint32_t
+host_ring_claim(__mem40 uint32_t *wptr)
+{
+    __xrw uint32_t ptr;
+
+    ptr = 1;
+    mem_test_add(&ptr, wptr, sizeof(ptr));
+
+    return ptr;
+}
+
+__intrinsic void
+host_ring_put(__xwrite void *rec, __mem40 void *ring,
+              __mem40 uint32_t *wptr, unsigned int entries, size_t size)
+{
+    __xwrite uint32_t seq_out;
+    __gpr uint32_t ptr;
+    __mem40 char *slot;
+
+    ptr = host_ring_claim(wptr);
+    slot = (__mem40 char *)ring + (ptr & (entries - 1)) * size;
+
+    /* The writes complete in order, the sequence number marks the record
+     * complete */
+    mem_write32(rec, slot, size - sizeof(uint32_t));
+    seq_out = ptr;
+    mem_write32(&seq_out, slot + size - sizeof(uint32_t), sizeof(seq_out));
+}
+
+#endif /* _HOST_RING_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
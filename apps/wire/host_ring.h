@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/host_ring.h
+ * @brief         Records exported to the host through EMEM
+ *
+ * A host ring is an exported EMEM array of fixed size records and a write
+ * counter.  Producers claim a slot by incrementing the counter atomically
+ * and write the record into it, there is no flow control: a host reader
+ * that falls more than the ring size behind loses the oldest records and
+ * can tell how many from the counter (see tools/host_ring.py).  The
+ * counter is incremented before the record is written, so every record
+ * carries its sequence number, the value of the counter that claimed the
+ * slot, written after the rest of the record.  Readers drop records whose
+ * sequence number does not match their slot.  host_ring_put() keeps it in
+ * the last word, records written in parts with host_ring_claim() place it
+ * themselves.
+ */
+
+#ifndef _HOST_RING_H_
+#define _HOST_RING_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/**
+ * Declare an exported host ring @_name of @_entries records of type
+ * @_type.  The write counter is exported as @_name_wptr.
+ */
+#define HOST_RING_DECLARE(_name, _type, _entries)                       \
+    __export __emem __align64 _type _name[_entries];                    \
+    __export __emem uint32_t _name##_wptr
+
+/**
+ * Claim the next slot of a host ring.
+ * @param wptr      Write counter of the ring
+ * @return          Previous value of the counter, the slot is the value
+ *                  modulo the number of records
+ *
+ * Used to write a record that does not fit in one transfer in parts.
+ */
+__intrinsic uint32_t host_ring_claim(__mem40 uint32_t *wptr);
+
+/**
+ * Append a record to a host ring.
+ * @param rec       Record in write transfer registers, its last word is
+ *                  set to the sequence number
+ * @param ring      First record of the ring
+ * @param wptr      Write counter of the ring
+ * @param entries   Number of records in the ring, a power of 2
+ * @param size      Size of a record in bytes, a multiple of 4
+ */
+__intrinsic void host_ring_put(__xwrite void *rec, __mem40 void *ring,
+                               __mem40 uint32_t *wptr, unsigned int entries,
+                               size_t size);
+
+#endif /* _HOST_RING_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
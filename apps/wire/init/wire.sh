@@ -24,6 +24,13 @@ export PATH=${NFP_SDK_DIR}/bin:$PATH
 export LD_LIBRARY_PATH=${NFP_SDK_DIR}/lib:$LD_LIBRARY_PATH
 
 CONFIG_DIR=$(dirname $0)
+# Firmware built with wire_BLQS=2 takes buffers from two BLQs
+WIRE_BLQS=${WIRE_BLQS:-1}
+if [ "$WIRE_BLQS" = "2" ]; then
+    DMA_CONFIG=nfp_nbi8_dma_i32_i33_2blq.json
+else
+    DMA_CONFIG=nfp_nbi8_dma_i32_i33.json
+fi
 #output=/dev/null
 
 OUTPUT="1"
@@ -57,7 +64,7 @@ case "$1" in
 
 
         echo -n " - Init DMA..."
-        nfp init dma 0 ${CONFIG_DIR}/nfp_nbi8_dma_i32_i33.json &> $OUTPUT || exit 1
+        nfp init dma 0 ${CONFIG_DIR}/${DMA_CONFIG} &> $OUTPUT || exit 1
         echo "done"
 
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/meter_fill.c
+ * @brief         Token refill of mem_meter() buckets
+ */
+
+#ifndef _METER_FILL_C_
+#define _METER_FILL_C_
+
+#include "config.h"
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/mem_atomic.h>
+
+#include "meter_fill.h"
+
+__intrinsic uint32_t
+meter_bucket_fill(__mem40 uint32_t *bucket, uint32_t tokens, uint32_t burst)
+{
+    __xrw uint32_t xval;
+    __xwrite uint32_t xsub;
+    __gpr uint32_t level;
+    __gpr uint32_t excess;
+
+    if (tokens == 0)
+        return 0;
+
+    xval = tokens;
+    mem_test_add(&xval, bucket, sizeof(xval));
+    level = xval + tokens;
+
+    if (level <= burst)
+        return 0;
+
+    excess = level - burst;
+    if (excess > tokens)
+        excess = tokens;
+
+    xsub = excess;
+    mem_sub32(&xsub, bucket, sizeof(xsub));
+
+    return excess;
+}
+
+#endif /* _METER_FILL_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/meter_fill.h
+ * @brief         Token refill of mem_meter() buckets
+ */
+
+#ifndef _METER_FILL_H_
+#define _METER_FILL_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/**
+ * Add tokens to a meter bucket, clipping the bucket at a burst size.
+ * @param bucket    Token count of a struct meter_bucket
+ * @param tokens    Tokens to add
+ * @param burst     Maximum number of tokens in the bucket
+ * @return          Number of tokens that did not fit
+ *
+ * The meter command may consume tokens concurrently, so the add is done
+ * atomically and the overflow is removed afterwards.  Never more than was
+ * just added is removed to avoid wrapping a bucket that was drained in
+ * between.
+ */
+__intrinsic uint32_t meter_bucket_fill(__mem40 uint32_t *bucket,
+                                       uint32_t tokens, uint32_t burst);
+
+#endif /* _METER_FILL_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
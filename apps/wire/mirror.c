@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/mirror.c
+ * @brief         Port mirroring (SPAN) with sampling and truncation
+ */
+
+#ifndef _MIRROR_C_
+#define _MIRROR_C_
+
+#include "config.h"
+
+#ifdef CFG_MIRROR
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <net/ip.h>
+#include <net/hdr_ext.h>
+#include <nfp/cls.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <pkt/pkt.h>
+#include <std/reg_utils.h>
+
+#include "mirror.h"
+
+__export __emem struct mirror_session mirror_sessions[MIRROR_NUM_SESSIONS];
+__export __emem struct mirror_port_cfg mirror_port_cfg[MIRROR_NUM_PORTS];
+
+/*
+ * Sampling countdown per session, a copy is sent when it reaches zero.
+ * The host sets it to 1 when configuring a session.
+ */
+__export __emem int32_t mirror_credit[MIRROR_NUM_SESSIONS];
+
+/* ACL rules, one copy per island */
+__export __shared __cls struct mirror_acl mirror_acl[MIRROR_NUM_ACL];
+
+__export __emem struct mirror_cntrs mirror_cntrs[MIRROR_NUM_SESSIONS];
+
+/*
+ * Frames are read at a two byte offset so that the IP header is word
+ * aligned, see pkt_count.c
+ */
+#define MIRROR_START_OFF        2
+#define MIRROR_BUF_SZ           64
+
+/* ACL rules read from CLS at a time */
+#define MIRROR_ACL_CHUNK        4
+
+#if (MIRROR_NUM_ACL % MIRROR_ACL_CHUNK) != 0
+#error "MIRROR_NUM_ACL must be a multiple of 4"
+#endif
+
+struct mirror_hdrs {
+    union {
+        struct eth_hdr  eth;
+        struct vlan_hdr vlan;
+        struct ip4_hdr  ip4;
+    };
+};
+
+
+/*
+ * Match a packet against the ACL rules.  Returns the session of the
+ * first matching rule or -1.
+ */
+__intrinsic static int
+mirror_acl_match(__mem40 char *pbuf, unsigned int l2_off)
+{
+    __xread uint32_t pkt_buf[MIRROR_BUF_SZ / 4];
+    __xread struct mirror_acl acl_in[MIRROR_ACL_CHUNK];
+    __lmem uint32_t buf[MIRROR_BUF_SZ / 4];
+    __lmem struct mirror_acl acl[MIRROR_ACL_CHUNK];
+    __gpr struct mirror_hdrs h;
+    __gpr int off = MIRROR_START_OFF;
+    __gpr int res;
+    __gpr int next_proto;
+    __gpr unsigned int proto;
+    __gpr unsigned int dst;
+    __gpr unsigned int dport = 0;
+    __gpr int i;
+    __gpr int j;
+
+    mem_read64(pkt_buf, pbuf + l2_off - MIRROR_START_OFF, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+
+    res = he_eth(buf, off, &h.eth);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto == HE_8021Q) {
+        res = he_vlan(buf, off, &h.vlan);
+        next_proto = HE_RES_PROTO_of(res);
+        off += HE_RES_LEN_of(res);
+    }
+
+    if (next_proto != HE_IP4)
+        return -1;
+
+    res = he_ip4(buf, off, &h.ip4);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+    proto = h.ip4.proto;
+    dst = h.ip4.dst;
+
+    if ((next_proto == HE_TCP || next_proto == HE_UDP) &&
+        !NET_IP_IS_FRAG(h.ip4.frag) && off + 4 <= MIRROR_BUF_SZ)
+        dport = buf[off >> 2] & 0xffff;
+
+    for (i = 0; i < MIRROR_NUM_ACL; i += MIRROR_ACL_CHUNK) {
+        cls_read(acl_in, &mirror_acl[i], sizeof(acl_in));
+        reg_cp(acl, acl_in, sizeof(acl));
+
+        for (j = 0; j < MIRROR_ACL_CHUNK; j++) {
+            if (!acl[j].valid)
+                continue;
+            if (acl[j].proto != 0 && acl[j].proto != proto)
+                continue;
+            if ((dst & acl[j].dst_mask) != acl[j].dst)
+                continue;
+            if (acl[j].dport != 0 && acl[j].dport != dport)
+                continue;
+            return acl[j].session;
+        }
+    }
+
+    return -1;
+}
+
+__intrinsic int
+mirror_pkt(__mem40 char *pbuf, unsigned int l2_off, unsigned int port)
+{
+    __xread struct mirror_port_cfg cfg;
+
+    mem_read32(&cfg, &mirror_port_cfg[port & (MIRROR_NUM_PORTS - 1)],
+               sizeof(cfg));
+
+    if (cfg.all)
+        return cfg.session;
+
+    if (cfg.acl)
+        return mirror_acl_match(pbuf, l2_off);
+
+    return -1;
+}
+
+__intrinsic void
+mirror_send(unsigned int session, __gpr struct rep_pkt *pkt)
+{
+    __xread struct mirror_session sess;
+    __xrw int32_t credit;
+    __xwrite uint32_t reload;
+    __gpr unsigned int len;
+
+    session &= (MIRROR_NUM_SESSIONS - 1);
+    mem_read32(&sess, &mirror_sessions[session], sizeof(sess));
+    if (!sess.enable || sess.qoff >= MIRROR_NUM_QOFF)
+        return;
+
+    mem_incr64(&mirror_cntrs[session].selected);
+
+    /* 1:N sampling, only the context taking the credit to zero mirrors */
+    credit = 1;
+    mem_test_sub(&credit, &mirror_credit[session], sizeof(credit));
+    if (credit != 1)
+        return;
+    reload = sess.rate;
+    mem_add32(&reload, &mirror_credit[session], sizeof(reload));
+
+    /* Truncate by sending less of the buffer, the MAC egress cmd included */
+    len = pkt->len;
+    if (sess.trunc != 0 && len > sess.trunc + 4)
+        len = sess.trunc + 4;
+
+    pkt_nbi_send_dont_free(pkt->isl, pkt->pnum, &pkt->msi, len, NBI,
+                           PORT_TO_TMQ(sess.port) + sess.qoff,
+                           pkt->seqr, pkt->seq, PKT_CTM_SIZE_256);
+
+    mem_incr64(&mirror_cntrs[session].mirrored);
+}
+
+#endif /* CFG_MIRROR */
+
+#endif /* _MIRROR_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
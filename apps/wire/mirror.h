@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/mirror.h
+ * @brief         Port mirroring (SPAN) with sampling and truncation
+ *
+ * A mirror session sends copies of the selected packets to an analyzer
+ * port.  Packets are selected per ingress port, either all of them or
+ * those matching an ACL rule, which names the session to use.  Each
+ * session samples one in N of the selected packets and truncates the
+ * copies to a maximum length.
+ *
+ * The copy is sent from the CTM buffer of the packet itself with
+ * pkt_nbi_send_dont_free() before the packet is sent, truncation only
+ * shortens the length given to the NBI.  Copies go to a dedicated TX
+ * queue of the analyzer port (MIRROR_DEF_QOFF by default), which the TM
+ * configuration should schedule below the production queues so that
+ * mirrored traffic can not starve them.
+ *
+ * Sessions, ports and ACL rules are configured with tools/mirror_ctl.py.
+ */
+
+#ifndef _MIRROR_H_
+#define _MIRROR_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include "rep.h"
+
+#ifndef MIRROR_NUM_PORTS
+#define MIRROR_NUM_PORTS        64
+#endif
+
+#ifndef MIRROR_NUM_SESSIONS
+#define MIRROR_NUM_SESSIONS     16
+#endif
+
+/* ACL rules, evaluated in order, in CLS on every island */
+#ifndef MIRROR_NUM_ACL
+#define MIRROR_NUM_ACL          8
+#endif
+
+/*
+ * TX queues of the analyzer port a session may use.  Traffic of a port is
+ * scheduled by the level 2 scheduler of its first NBI channel, whose
+ * inputs are the first TMQ_PER_PORT / MAC_CHAN_PER_PORT queues of the
+ * port.  The queues above belong to the schedulers of its other channels.
+ */
+#define MIRROR_NUM_QOFF         (TMQ_PER_PORT / MAC_CHAN_PER_PORT)
+
+/* TX queue used by default, the last input of that scheduler */
+#define MIRROR_DEF_QOFF         (MIRROR_NUM_QOFF - 1)
+
+/**
+ * Mirror session
+ */
+struct mirror_session {
+    union {
+        struct {
+            unsigned int enable:1;      /** Session in use */
+            unsigned int resv0:7;       /** Reserved */
+            unsigned int port:8;        /** Analyzer port */
+            unsigned int qoff:8;        /** TX queue, < MIRROR_NUM_QOFF */
+            unsigned int resv1:8;       /** Reserved */
+
+            uint32_t rate;              /** Mirror 1 in rate packets */
+            uint32_t trunc;             /** Maximum copy length, 0 is all */
+            uint32_t resv2;             /** Reserved */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Per ingress port configuration
+ */
+struct mirror_port_cfg {
+    union {
+        struct {
+            unsigned int all:1;         /** Mirror all packets to session */
+            unsigned int acl:1;         /** Evaluate the ACL rules */
+            unsigned int resv:22;       /** Reserved */
+            unsigned int session:8;     /** Session of all packets */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * ACL rule, matching IPv4 packets.  Zero fields match anything.
+ */
+struct mirror_acl {
+    union {
+        struct {
+            unsigned int valid:1;       /** Rule in use */
+            unsigned int resv0:7;       /** Reserved */
+            unsigned int session:8;     /** Session of matching packets */
+            unsigned int proto:8;       /** IP protocol */
+            unsigned int resv1:8;       /** Reserved */
+
+            uint32_t dst;               /** Destination address */
+            uint32_t dst_mask;          /** Destination address mask */
+
+            unsigned int resv2:16;      /** Reserved */
+            unsigned int dport:16;      /** TCP/UDP destination port */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Per session counters
+ */
+struct mirror_cntrs {
+    uint64_t selected;          /** Packets selected for the session */
+    uint64_t mirrored;          /** Copies sent */
+};
+
+/**
+ * Select the mirror session of a packet.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param port      Ingress port
+ * @return          Session to mirror the packet to, or -1
+ */
+__intrinsic int mirror_pkt(__mem40 char *pbuf, unsigned int l2_off,
+                           unsigned int port);
+
+/**
+ * Send a (sampled) copy of a packet to a session.  Must be called before
+ * the packet itself is sent.
+ * @param session   Session returned by mirror_pkt()
+ * @param pkt       Packet to mirror, the TX queue offset is ignored
+ */
+__intrinsic void mirror_send(unsigned int session, __gpr struct rep_pkt *pkt);
+
+#endif /* _MIRROR_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/mpls_lsr.c
+ * @brief         MPLS label switching
+ */
+
+#ifndef _MPLS_LSR_C_
+#define _MPLS_LSR_C_
+
+#include "config.h"
+
+#ifdef CFG_MPLS
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/csum.h>
+#include <net/eth.h>
+#include <net/mpls.h>
+#include <net/hdr_ext.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <std/cntrs.h>
+#include <std/reg_utils.h>
+
+#include "mpls_lsr.h"
+
+/* Label table, indexed by the top label */
+__export __emem struct mpls_lbl_entry mpls_lbl_tbl[MPLS_NUM_LABELS];
+
+/* Per label packet/byte counters, indexed by the entry cntr field */
+PKTS_CNTRS_DECLARE(mpls_lbl_cntrs, MPLS_NUM_CNTRS, __imem);
+
+__export __emem struct mpls_cntrs mpls_cntrs;
+
+/*
+ * Frames are read at a two byte offset so that the label stack is word
+ * aligned in the buffer, see pkt_count.c
+ */
+#define MPLS_START_OFF          2
+#define MPLS_BUF_SZ             64
+
+/* Label stack entry fields */
+#define MPLS_LBL_shf            12
+#define MPLS_TC_msk             0xe00
+#define MPLS_BOS                0x100
+#define MPLS_TTL_msk            0xff
+
+#define MPLS_LSE(_lbl, _tc, _ttl) \
+    (((_lbl) << MPLS_LBL_shf) | ((_tc) & MPLS_TC_msk) | (_ttl))
+
+/* Offsets in the IP headers of the fields updated by TTL propagation */
+#define MPLS_IP4_TTL_OFF        8
+#define MPLS_IP6_HLIM_OFF       4
+
+
+/*
+ * Write the first @nwords words of @hdr to the packet at @off, which is
+ * MPLS_START_OFF before the start of the moved Ethernet header.
+ */
+__intrinsic static void
+mpls_write_hdr(__mem40 char *pbuf, unsigned int off, __lmem uint32_t *hdr,
+               unsigned int nwords)
+{
+    __xwrite uint32_t out[7];
+    SIGNAL sig;
+
+    reg_cp(out, hdr, sizeof(out));
+    __mem_write8(out, pbuf + off, nwords * 4, sizeof(out), ctx_swap, &sig);
+}
+
+/*
+ * Propagate @ttl into the IP header following the bottom of stack label
+ * at word @w of @buf.  Returns the new Ethertype or 0 if the payload is
+ * not IP.
+ */
+__intrinsic static unsigned int
+mpls_php(__mem40 char *pbuf, unsigned int ip_off, __lmem uint32_t *buf,
+         unsigned int w, unsigned int ttl, unsigned int ttl_prop)
+{
+    __xwrite uint32_t out;
+    __gpr uint32_t word;
+    __gpr uint32_t old_val;
+    __gpr uint32_t new_val;
+    __gpr uint32_t csum;
+
+    word = buf[w + 1];
+
+    if ((word >> 28) == 4) {
+        /* TTL/protocol/checksum word */
+        word = buf[w + 3];
+        if (ttl_prop && ttl < (word >> 24)) {
+            old_val = word >> 16;
+            new_val = (ttl << 8) | (old_val & 0xff);
+            csum = net_csum_mod(word & 0xffff, old_val, new_val);
+            out = (new_val << 16) | csum;
+            mem_write8(&out, pbuf + ip_off + MPLS_IP4_TTL_OFF, sizeof(out));
+        }
+        return NET_ETH_TYPE_IPV4;
+    }
+
+    if ((word >> 28) == 6) {
+        /* Payload length/next header/hop limit word */
+        word = buf[w + 2];
+        if (ttl_prop && ttl < (word & 0xff)) {
+            out = (word & ~0xff) | ttl;
+            mem_write8(&out, pbuf + ip_off + MPLS_IP6_HLIM_OFF, sizeof(out));
+        }
+        return NET_ETH_TYPE_IPV6;
+    }
+
+    return 0;
+}
+
+__intrinsic enum mpls_res
+mpls_pkt(__mem40 char *pbuf, unsigned int *l2_off, unsigned int *len)
+{
+    __xread uint32_t pkt_buf[MPLS_BUF_SZ / 4];
+    __xread struct mpls_lbl_entry entry;
+    __xwrite uint32_t out;
+    __lmem uint32_t buf[MPLS_BUF_SZ / 4];
+    __lmem uint32_t hdr[7];
+    __gpr struct eth_hdr eth;
+    __gpr struct vlan_hdr vlan;
+    __gpr struct pkt_cntr_addr cntr_base;
+    __gpr int off = MPLS_START_OFF;
+    __gpr int res;
+    __gpr int next_proto;
+    __gpr unsigned int w;
+    __gpr unsigned int i;
+    __gpr uint32_t top;
+    __gpr uint32_t next;
+    __gpr unsigned int label;
+    __gpr unsigned int ttl;
+    __gpr unsigned int etype;
+    SIGNAL sig;
+
+    mem_read64(pkt_buf, pbuf + *l2_off - MPLS_START_OFF, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+
+    res = he_eth(buf, off, &eth);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto == HE_8021Q) {
+        res = he_vlan(buf, off, &vlan);
+        next_proto = HE_RES_PROTO_of(res);
+        off += HE_RES_LEN_of(res);
+    }
+
+    if (next_proto != HE_MPLS)
+        return MPLS_RES_NONE;
+
+    /* Word index of the top label, the Ethernet header is words 0..w-1 */
+    w = off >> 2;
+    top = buf[w];
+    label = top >> MPLS_LBL_shf;
+    ttl = top & MPLS_TTL_msk;
+
+    if (label >= MPLS_NUM_LABELS)
+        goto miss;
+
+    mem_read32(&entry, &mpls_lbl_tbl[label], sizeof(entry));
+    if (!entry.valid)
+        goto miss;
+
+    if (ttl <= 1) {
+        mem_incr64(&mpls_cntrs.ttl_exceeded);
+        return MPLS_RES_DROP;
+    }
+    ttl--;
+
+    cntr_base = pkt_cntr_get_addr(mpls_lbl_cntrs);
+    pkt_cntr_add(cntr_base, entry.cntr, 0, *len, ctx_swap, &sig);
+
+    if (entry.op == MPLS_OP_SWAP) {
+        out = MPLS_LSE(entry.out_label, top, ttl) | (top & MPLS_BOS);
+        mem_write8(&out, pbuf + *l2_off + off - MPLS_START_OFF, sizeof(out));
+        mem_incr64(&mpls_cntrs.swap);
+        return MPLS_RES_FWD;
+    }
+
+    for (i = 0; i < w; i++)
+        hdr[i] = buf[i];
+
+    if (entry.op == MPLS_OP_PUSH) {
+        /* Move the Ethernet header back to make room for the new label */
+        hdr[w] = MPLS_LSE(entry.push_label, top, ttl);
+        hdr[w + 1] = MPLS_LSE(entry.out_label, top, ttl) | (top & MPLS_BOS);
+        *l2_off -= sizeof(struct mpls_hdr);
+        *len += sizeof(struct mpls_hdr);
+        mpls_write_hdr(pbuf, *l2_off - MPLS_START_OFF, hdr, w + 2);
+        mem_incr64(&mpls_cntrs.push);
+        return MPLS_RES_FWD;
+    }
+
+    if (!(top & MPLS_BOS)) {
+        /* Expose the next label, copying the TTL if it is smaller */
+        next = buf[w + 1];
+        if (entry.ttl_prop && ttl < (next & MPLS_TTL_msk))
+            next = (next & ~MPLS_TTL_msk) | ttl;
+        hdr[w] = next;
+        *l2_off += sizeof(struct mpls_hdr);
+        *len -= sizeof(struct mpls_hdr);
+        mpls_write_hdr(pbuf, *l2_off - MPLS_START_OFF, hdr, w + 1);
+        mem_incr64(&mpls_cntrs.pop);
+        return MPLS_RES_FWD;
+    }
+
+    /* Bottom of stack, expose the IP payload */
+    etype = mpls_php(pbuf, *l2_off + off - MPLS_START_OFF + 4, buf, w, ttl,
+                     entry.ttl_prop);
+    if (etype == 0) {
+        mem_incr64(&mpls_cntrs.bad_hdr);
+        return MPLS_RES_DROP;
+    }
+    hdr[w - 1] = (hdr[w - 1] & 0xffff0000) | etype;
+    *l2_off += sizeof(struct mpls_hdr);
+    *len -= sizeof(struct mpls_hdr);
+    mpls_write_hdr(pbuf, *l2_off - MPLS_START_OFF, hdr, w);
+    mem_incr64(&mpls_cntrs.php);
+    return MPLS_RES_FWD;
+
+miss:
+    mem_incr64(&mpls_cntrs.miss);
+    return MPLS_RES_DROP;
+}
+
+#endif /* CFG_MPLS */
+
+#endif /* _MPLS_LSR_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/mpls_lsr.h
+ * @brief         MPLS label switching
+ *
+ * Label switching of MPLS unicast frames (optionally VLAN tagged).  The
+ * top label indexes a direct mapped label table in EMEM, which gives the
+ * operation to apply:
+ *  - SWAP: replace the top label.
+ *  - PUSH: replace the top label and push a new label on top of it.  The
+ *    Ethernet header moves 4 bytes back into the headroom.
+ *  - POP:  remove the top label.  The Ethernet header moves 4 bytes
+ *    forward.  Popping the bottom of stack label (penultimate hop
+ *    popping, or the egress LER) exposes the IPv4/IPv6 payload and
+ *    changes the Ethertype accordingly.
+ *
+ * The TTL is decremented on every operation, frames with an expired TTL
+ * are dropped.  With TTL propagation (uniform model, RFC 3443) a popped
+ * TTL is copied to the exposed label or IP header if it is smaller.
+ *
+ * Per label packet and byte counts are kept by the IMEM stats engine.
+ */
+
+#ifndef _MPLS_LSR_H_
+#define _MPLS_LSR_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* Size of the label table, labels outside of it are dropped as misses */
+#ifndef MPLS_NUM_LABELS
+#define MPLS_NUM_LABELS         (1 << 20)
+#endif
+
+/* Number of stats engine packet/byte counters */
+#ifndef MPLS_NUM_CNTRS
+#define MPLS_NUM_CNTRS          4096
+#endif
+
+/**
+ * Label operations
+ */
+enum mpls_op {
+    MPLS_OP_SWAP = 0,
+    MPLS_OP_PUSH = 1,
+    MPLS_OP_POP  = 2,
+};
+
+/**
+ * Label table entry
+ */
+struct mpls_lbl_entry {
+    union {
+        struct {
+            unsigned int valid:1;       /** Entry in use */
+            unsigned int op:2;          /** enum mpls_op */
+            unsigned int ttl_prop:1;    /** Propagate TTL on pop */
+            unsigned int resv0:8;       /** Reserved */
+            unsigned int out_label:20;  /** Label replacing the top label */
+
+            unsigned int cntr:12;       /** Stats counter index */
+            unsigned int push_label:20; /** Label pushed (MPLS_OP_PUSH) */
+        };
+        uint32_t __raw[2];
+    };
+};
+
+/**
+ * Global counters
+ */
+struct mpls_cntrs {
+    uint64_t swap;              /** Labels swapped */
+    uint64_t push;              /** Labels pushed */
+    uint64_t pop;               /** Labels popped, stack not empty */
+    uint64_t php;               /** Bottom labels popped */
+    uint64_t miss;              /** Dropped, no label table entry */
+    uint64_t ttl_exceeded;      /** Dropped, TTL expired */
+    uint64_t bad_hdr;           /** Dropped, payload not handled */
+};
+
+/**
+ * Return values of mpls_pkt()
+ */
+enum mpls_res {
+    MPLS_RES_NONE = 0,          /** Not an MPLS frame */
+    MPLS_RES_FWD  = 1,          /** Label operation applied */
+    MPLS_RES_DROP = 2,          /** Frame must be dropped */
+};
+
+/**
+ * Label switch an MPLS frame.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header, updated on push/pop
+ * @param len       Length of the frame, updated on push/pop
+ * @return          One of enum mpls_res
+ */
+__intrinsic enum mpls_res mpls_pkt(__mem40 char *pbuf, unsigned int *l2_off,
+                                   unsigned int *len);
+
+#endif /* _MPLS_LSR_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/policer.c
+ * @brief         Two-rate/single-rate three color policer
+ */
+
+#ifndef _POLICER_C_
+#define _POLICER_C_
+
+#include "config.h"
+
+#ifdef CFG_POLICER
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/csum.h>
+#include <net/eth.h>
+#include <net/ip.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <std/hash.h>
+
+#include "meter_fill.h"
+#include "policer.h"
+
+/* Meter token buckets, must be 8 byte aligned for the meter command */
+__export POLICER_MEM __align8 struct meter_bucket
+    policer_meters[POLICER_NUM_METERS];
+
+/* Host written meter configuration */
+__export POLICER_MEM struct policer_cfg policer_cfg[POLICER_NUM_METERS];
+
+/* Per meter counters */
+__export POLICER_MEM struct policer_cntrs policer_cntrs[POLICER_NUM_METERS];
+
+/* Fractional token accumulators, only touched by the refill contexts */
+struct policer_frac {
+    uint32_t committed;
+    uint32_t peak;
+};
+
+POLICER_MEM struct policer_frac policer_frac[POLICER_NUM_METERS];
+
+#define POLICER_ETYPE_OFF       (2 * NET_ETH_ALEN)
+#define POLICER_IP4_TOS_OFF     0
+#define POLICER_IP4_CSUM_OFF    10
+#define POLICER_IP6_TC_shf      20
+
+/* Sleep granularity of the refill contexts while waiting for the next
+ * refill interval, in ME cycles */
+#define POLICER_REFILL_SLEEP    4096
+
+
+/*
+ * Find the L3 header following the Ethernet header at @l2_off, skipping
+ * an optional single VLAN tag.  Returns the Ethertype and sets @l3_off.
+ */
+__intrinsic static unsigned int
+policer_l3(__mem40 char *pbuf, unsigned int l2_off, unsigned int *l3_off)
+{
+    __xread uint32_t rd;
+    __gpr unsigned int etype;
+    __gpr unsigned int off;
+
+    off = l2_off + POLICER_ETYPE_OFF;
+    mem_read32(&rd, pbuf + off, sizeof(rd));
+    etype = rd >> 16;
+    off += sizeof(uint16_t);
+
+    if (etype == NET_ETH_TYPE_TPID) {
+        mem_read32(&rd, pbuf + off + NET_8021Q_LEN - sizeof(uint16_t),
+                   sizeof(rd));
+        etype = rd >> 16;
+        off += NET_8021Q_LEN;
+    }
+
+    *l3_off = off;
+    return etype;
+}
+
+/*
+ * Rewrite the DSCP of the IP header following the Ethernet header at
+ * @l2_off.  Returns 0 on success, -1 if the packet is not IP.
+ */
+__intrinsic static int
+policer_remark(__mem40 char *pbuf, unsigned int l2_off, unsigned int dscp)
+{
+    __xread uint32_t rd[3];
+    __xwrite uint32_t wr;
+    __gpr unsigned int etype;
+    __gpr unsigned int ip_off;
+    __gpr uint32_t old_val;
+    __gpr uint32_t new_val;
+    __gpr uint32_t csum;
+
+    etype = policer_l3(pbuf, l2_off, &ip_off);
+    mem_read32(rd, pbuf + ip_off, sizeof(rd));
+
+    if (etype == NET_ETH_TYPE_IPV4) {
+        /* The DSCP shares a 16 bit checksum word with version/IHL */
+        old_val = rd[0] >> 16;
+        new_val = (old_val & 0xff03) | (dscp << 2);
+        csum = net_csum_mod(rd[2] & 0xffff, old_val, new_val);
+
+        wr = new_val << 16;
+        mem_write8(&wr, pbuf + ip_off + POLICER_IP4_TOS_OFF, sizeof(uint16_t));
+        wr = csum << 16;
+        mem_write8(&wr, pbuf + ip_off + POLICER_IP4_CSUM_OFF,
+                   sizeof(uint16_t));
+        return 0;
+    }
+
+    if (etype == NET_ETH_TYPE_IPV6) {
+        /* No header checksum, DSCP is the top 6 bits of the traffic class */
+        wr = (rd[0] & ~(0xfc << POLICER_IP6_TC_shf)) |
+            (dscp << (POLICER_IP6_TC_shf + 2));
+        mem_write32(&wr, pbuf + ip_off, sizeof(wr));
+        return 0;
+    }
+
+    return -1;
+}
+
+__intrinsic unsigned int
+policer_flow_meter(__mem40 char *pbuf, unsigned int l2_off, unsigned int port)
+{
+    __xread struct ip4_hdr ip;
+    __xread uint32_t ports;
+    __gpr uint32_t key[4];
+    __gpr unsigned int etype;
+    __gpr unsigned int ip_off;
+
+    etype = policer_l3(pbuf, l2_off, &ip_off);
+    if (etype != NET_ETH_TYPE_IPV4)
+        return POLICER_PORT_METER(port);
+
+    mem_read32(&ip, pbuf + ip_off, sizeof(ip));
+    key[0] = ip.src;
+    key[1] = ip.dst;
+    key[2] = ip.proto;
+    key[3] = 0;
+
+    /* Fragments other than the first carry no L4 header */
+    if ((ip.proto == NET_IP_PROTO_TCP || ip.proto == NET_IP_PROTO_UDP) &&
+        (ip.frag & NET_IP_FRAG_OFF_MASK) == 0) {
+        mem_read32(&ports, pbuf + ip_off + (ip.hl << 2), sizeof(ports));
+        key[3] = ports;
+    }
+
+    return POLICER_FLOW_METER(hash_me_crc32(key, sizeof(key), 0));
+}
+
+__intrinsic int
+policer_pkt(unsigned int meter, __mem40 char *pbuf, unsigned int l2_off,
+            unsigned int len)
+{
+    __xread struct policer_act act_xfer;
+    __gpr struct policer_act act;
+    __gpr enum meter_color color;
+    __gpr unsigned int action;
+    __gpr unsigned int dscp;
+    __mem40 struct policer_cntrs *cntrs = &policer_cntrs[meter];
+
+    mem_read32(&act_xfer, &policer_cfg[meter].act, sizeof(act_xfer));
+    act = act_xfer;
+
+    if (!act.enable)
+        return 0;
+
+    color = mem_meter(len, &policer_meters[meter], act.mode,
+                      METER_COLOR_NO_COLOR);
+
+    if (color == METER_COLOR_GREEN) {
+        mem_incr64(&cntrs->green);
+        return 0;
+    } else if (color == METER_COLOR_YELLOW) {
+        mem_incr64(&cntrs->yellow);
+        action = act.yellow_act;
+        dscp = act.yellow_dscp;
+    } else {
+        mem_incr64(&cntrs->red);
+        action = act.red_act;
+        dscp = act.red_dscp;
+    }
+
+    if (action == POLICER_ACT_DROP) {
+        mem_incr64(&cntrs->dropped);
+        return 1;
+    }
+
+    if (action == POLICER_ACT_REMARK) {
+        if (policer_remark(pbuf, l2_off, dscp) == 0)
+            mem_incr64(&cntrs->remarked);
+        else
+            mem_incr64(&cntrs->remark_err);
+    }
+
+    return 0;
+}
+
+
+/*
+ * Refill the token buckets of a single meter for one refill interval.
+ */
+__intrinsic static void
+policer_refill(unsigned int meter)
+{
+    __xread struct policer_cfg cfg_xfer;
+    __xread struct policer_frac frac_in;
+    __xwrite struct policer_frac frac_out;
+    __gpr struct policer_frac frac;
+    __gpr uint32_t c_tokens;
+    __gpr uint32_t p_tokens;
+    __gpr uint32_t overflow;
+    __mem40 struct meter_bucket *bkt = &policer_meters[meter];
+    SIGNAL cfg_sig, frac_sig;
+
+    __mem_read32(&cfg_xfer, &policer_cfg[meter], sizeof(cfg_xfer),
+                 sizeof(cfg_xfer), sig_done, &cfg_sig);
+    __mem_read32(&frac_in, &policer_frac[meter], sizeof(frac_in),
+                 sizeof(frac_in), sig_done, &frac_sig);
+    wait_for_all(&cfg_sig, &frac_sig);
+
+    if (!cfg_xfer.act.enable)
+        return;
+
+    /* Integer increment plus the carry out of the fractional part */
+    frac.committed = frac_in.committed + cfg_xfer.cir_frac;
+    c_tokens = cfg_xfer.cir_inc;
+    if (frac.committed < cfg_xfer.cir_frac)
+        c_tokens++;
+
+    frac.peak = frac_in.peak + cfg_xfer.pir_frac;
+    p_tokens = cfg_xfer.pir_inc;
+    if (frac.peak < cfg_xfer.pir_frac)
+        p_tokens++;
+
+    overflow = meter_bucket_fill(&bkt->committed_tokens, c_tokens,
+                                 cfg_xfer.cbs);
+
+    if (cfg_xfer.act.mode == METER_MODE_PEAK)
+        meter_bucket_fill(&bkt->peak_tokens, p_tokens, cfg_xfer.pbs);
+    else
+        meter_bucket_fill(&bkt->excess_tokens, overflow, cfg_xfer.pbs);
+
+    frac_out = frac;
+    mem_write32(&frac_out, &policer_frac[meter], sizeof(frac_out));
+}
+
+void
+policer_refill_loop(void)
+{
+    __gpr unsigned int meter;
+    __gpr uint64_t next;
+
+    next = me_tsc_read();
+
+    for (;;) {
+        /* Pace on the timestamp so late intervals are caught up on */
+        next += POLICER_REFILL_TICKS;
+        while (me_tsc_read() < next)
+            sleep(POLICER_REFILL_SLEEP);
+
+        for (meter = ctx() - POLICER_REFILL_CTX_BASE;
+             meter < POLICER_NUM_METERS;
+             meter += POLICER_REFILL_CTXS)
+            policer_refill(meter);
+    }
+}
+
+#endif /* CFG_POLICER */
+
+#endif /* _POLICER_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
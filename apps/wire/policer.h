@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/policer.h
+ * @brief         Two-rate/single-rate three color policer
+ *
+ * Per port or per flow policing built on the MU atomic engine meter
+ * command (see mem_meter() in nfp/mem_atomic.h).  The meter command only
+ * consumes tokens, so the token buckets are refilled by a background
+ * context on the service ME according to a host supplied configuration
+ * (see tools/policer_calc.py).
+ *
+ * Two modes are supported per meter:
+ *  - RFC 2698 trTCM: committed bucket filled at CIR up to CBS, peak
+ *    bucket filled at PIR up to PBS (METER_MODE_PEAK).
+ *  - RFC 2697 srTCM: committed bucket filled at CIR up to CBS, tokens
+ *    overflowing the committed bucket fill the excess bucket up to EBS
+ *    (METER_MODE_EXCESS).
+ */
+
+#ifndef _POLICER_H_
+#define _POLICER_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/mem_atomic.h>
+
+/*
+ * Meter table memory and size.  Meters [0, POLICER_NUM_PORTS) are the per
+ * port meters, the remainder are hashed per flow meters.
+ */
+#ifndef POLICER_MEM
+#define POLICER_MEM             __emem
+#endif
+
+#ifndef POLICER_NUM_METERS
+#define POLICER_NUM_METERS      256
+#endif
+
+#ifndef POLICER_NUM_PORTS
+#define POLICER_NUM_PORTS       64
+#endif
+
+#define POLICER_NUM_FLOW_METERS (POLICER_NUM_METERS - POLICER_NUM_PORTS)
+
+#if (POLICER_NUM_FLOW_METERS & (POLICER_NUM_FLOW_METERS - 1)) != 0
+#error "POLICER_NUM_METERS - POLICER_NUM_PORTS must be a power of 2"
+#endif
+
+/*
+ * Refill interval in ME timestamp ticks (16 ME cycles each) and the
+ * service ME contexts sharing the refill work.  The host calculator must
+ * be told the same interval to compute the per refill token increments.
+ */
+#ifndef POLICER_REFILL_TICKS
+#define POLICER_REFILL_TICKS    5000
+#endif
+
+#ifndef POLICER_REFILL_CTX_BASE
+#define POLICER_REFILL_CTX_BASE 0
+#endif
+
+#ifndef POLICER_REFILL_CTXS
+#define POLICER_REFILL_CTXS     2
+#endif
+
+/**
+ * Action applied to a packet of a given color
+ */
+enum policer_action {
+    POLICER_ACT_PASS   = 0,     /** Forward unmodified */
+    POLICER_ACT_DROP   = 1,     /** Drop the packet */
+    POLICER_ACT_REMARK = 2,     /** Rewrite the IP DSCP and forward */
+};
+
+/**
+ * Per meter mode and actions, the part of the configuration that the
+ * fast path reads.
+ */
+struct policer_act {
+    union {
+        struct {
+            unsigned int enable:1;      /** Meter in use */
+            unsigned int mode:1;        /** enum meter_mode */
+            unsigned int yellow_act:2;  /** enum policer_action for yellow */
+            unsigned int red_act:2;     /** enum policer_action for red */
+            unsigned int yellow_dscp:6; /** DSCP used to remark yellow */
+            unsigned int red_dscp:6;    /** DSCP used to remark red */
+            unsigned int resv0:14;      /** Reserved */
+
+            uint32_t resv1;             /** Reserved */
+        };
+        uint32_t __raw[2];
+    };
+};
+
+/**
+ * Per meter configuration, written by the host.
+ *
+ * Token increments are the bytes added per refill interval, split in an
+ * integer part and a 32 bit binary fraction so that both very low and
+ * very high rates are represented accurately.  For srTCM the peak
+ * increment is unused (the excess bucket only receives overflow from the
+ * committed bucket).
+ */
+struct policer_cfg {
+    union {
+        struct {
+            uint32_t cir_inc;           /** Committed bytes per refill */
+            uint32_t cir_frac;          /** Committed fraction (/2^32) */
+            uint32_t cbs;               /** Committed burst size (bytes) */
+            uint32_t pir_inc;           /** Peak bytes per refill (trTCM) */
+            uint32_t pir_frac;          /** Peak fraction (/2^32) */
+            uint32_t pbs;               /** Peak/excess burst size (bytes) */
+            struct policer_act act;     /** Mode and actions */
+        };
+        uint32_t __raw[8];
+    };
+};
+
+/**
+ * Per meter counters
+ */
+struct policer_cntrs {
+    uint64_t green;             /** Packets marked green */
+    uint64_t yellow;            /** Packets marked yellow */
+    uint64_t red;               /** Packets marked red */
+    uint64_t dropped;           /** Packets dropped by the policer */
+    uint64_t remarked;          /** Packets with the DSCP rewritten */
+    uint64_t remark_err;        /** Remark requested on a non IP packet */
+};
+
+/**
+ * Get the meter index used for an ingress port.
+ * @param port      Ingress port
+ */
+#define POLICER_PORT_METER(_port)   ((_port) & (POLICER_NUM_PORTS - 1))
+
+/**
+ * Get the meter index used for a flow.
+ * @param _hash     Hash over the flow key
+ */
+#define POLICER_FLOW_METER(_hash) \
+    (POLICER_NUM_PORTS + ((_hash) & (POLICER_NUM_FLOW_METERS - 1)))
+
+/**
+ * Select a per flow meter for a packet.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param port      Ingress port, used for packets without a flow key
+ * @return          Meter index
+ *
+ * IPv4 packets are hashed on the addresses, protocol and TCP/UDP ports.
+ * Other packets fall back to the per port meter of @port.
+ */
+__intrinsic unsigned int policer_flow_meter(__mem40 char *pbuf,
+                                            unsigned int l2_off,
+                                            unsigned int port);
+
+/**
+ * Meter a packet and apply the configured action.
+ * @param meter     Meter index
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param len       Number of bytes to meter
+ * @return          Non-zero if the packet must be dropped
+ *
+ * Packets metered against a disabled meter are passed as green without
+ * touching the meter.  Remarking rewrites the DSCP of an IPv4 (with an
+ * incremental header checksum update) or IPv6 header following an
+ * optional single VLAN tag.
+ */
+__intrinsic int policer_pkt(unsigned int meter, __mem40 char *pbuf,
+                            unsigned int l2_off, unsigned int len);
+
+/**
+ * Token bucket refill loop
+ *
+ * Never returns.  Meant to be run by POLICER_REFILL_CTXS contexts on the
+ * service ME starting at POLICER_REFILL_CTX_BASE, each context refilling
+ * every POLICER_REFILL_CTXS'th meter.
+ */
+void policer_refill_loop(void);
+
+#endif /* _POLICER_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
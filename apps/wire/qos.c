@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/qos.c
+ * @brief         PCP/DSCP classification to the TM queues of a port
+ */
+
+#ifndef _QOS_C_
+#define _QOS_C_
+
+#include "config.h"
+
+#ifdef CFG_QOS
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+
+#include "qos.h"
+
+/* Host written tables */
+__export QOS_MEM struct qos_port_cfg qos_port_cfg[QOS_NUM_PORTS];
+__export QOS_MEM uint32_t qos_dscp_map[QOS_DSCP_WORDS];
+
+__export QOS_MEM struct qos_cntrs qos_cntrs[QOS_NUM_PORTS * QOS_QUEUES];
+
+#define QOS_ETYPE_OFF           (2 * NET_ETH_ALEN)
+
+
+__intrinsic unsigned int
+qos_pkt(__mem40 char *pbuf, unsigned int l2_off, unsigned int len,
+        unsigned int in_port, unsigned int out_port)
+{
+    __xread struct qos_port_cfg cfg;
+    __xread uint32_t hdr[2];
+    __xread uint32_t map;
+    __gpr unsigned int etype;
+    __gpr unsigned int l3_w0;
+    __gpr unsigned int tci;
+    __gpr unsigned int tos;
+    __gpr unsigned int dscp;
+    __gpr unsigned int queue;
+    __gpr unsigned int idx;
+    __gpr int tagged;
+    __gpr int ip;
+
+    mem_read32(&cfg, &qos_port_cfg[in_port & (QOS_NUM_PORTS - 1)],
+               sizeof(cfg));
+    queue = cfg.dflt;
+
+    if (cfg.trust != QOS_TRUST_NONE) {
+        /* Ethertype and the first 16 bits of the L3 header, after an
+         * optional single VLAN tag */
+        mem_read32(hdr, pbuf + l2_off + QOS_ETYPE_OFF, sizeof(hdr));
+        etype = hdr[0] >> 16;
+        l3_w0 = hdr[0] & 0xffff;
+        tci = 0;
+        tagged = 0;
+        if (etype == NET_ETH_TYPE_TPID) {
+            tci = hdr[0] & 0xffff;
+            tagged = 1;
+            etype = hdr[1] >> 16;
+            l3_w0 = hdr[1] & 0xffff;
+        }
+
+        ip = 1;
+        if (etype == NET_ETH_TYPE_IPV4)
+            tos = l3_w0 & 0xff;
+        else if (etype == NET_ETH_TYPE_IPV6)
+            tos = (l3_w0 >> 4) & 0xff;
+        else
+            ip = 0;
+
+        if (ip && (cfg.trust & QOS_TRUST_DSCP)) {
+            dscp = tos >> 2;
+            mem_read32(&map, &qos_dscp_map[dscp >> 3], sizeof(map));
+            queue = (map >> ((dscp & 7) << QOS_MAP_SHF)) & (QOS_QUEUES - 1);
+        } else if (tagged && (cfg.trust & QOS_TRUST_PCP)) {
+            queue = (cfg.pcp_map >>
+                     (NET_ETH_TCI_PCP_of(tci) << QOS_MAP_SHF)) &
+                (QOS_QUEUES - 1);
+        }
+    }
+
+    idx = (out_port & (QOS_NUM_PORTS - 1)) * QOS_QUEUES + queue;
+    mem_incr64(&qos_cntrs[idx].pkts);
+    mem_add64_imm(len, &qos_cntrs[idx].bytes);
+
+    return queue;
+}
+
+#endif /* CFG_QOS */
+
+#endif /* _QOS_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
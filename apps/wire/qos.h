@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/qos.h
+ * @brief         PCP/DSCP classification to the TM queues of a port
+ *
+ * Each ingress port trusts the VLAN PCP, the IP DSCP, both or neither,
+ * and a host written table maps the trusted field to one of the first
+ * QOS_QUEUES TM queues of the egress port (see tools/qos_ctl.py).  The
+ * queues of a port are the inputs of its level 2 scheduler, which is set
+ * up with tools/tm_gen.py or tools/tm_ctl.py to serve the first one or
+ * two in strict priority and the others by DWRR, so the highest classes
+ * are mapped to the lowest queues.
+ *
+ * Packets and bytes are counted per egress port and queue.  Flooded
+ * frames are counted once, against the egress port picked by the
+ * forwarding stages.
+ */
+
+#ifndef _QOS_H_
+#define _QOS_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#ifndef QOS_MEM
+#define QOS_MEM                 __emem
+#endif
+
+#ifndef QOS_NUM_PORTS
+#define QOS_NUM_PORTS           64
+#endif
+
+/* Queues per port, the inputs of a level 2 scheduler */
+#define QOS_QUEUES              8
+
+/* Table entries are 4 bit queue numbers, 8 to a word */
+#define QOS_MAP_SHF             2
+#define QOS_DSCP_WORDS          (64 / 8)
+
+/**
+ * Fields an ingress port trusts.  With QOS_TRUST_ALL IP packets are
+ * mapped by their DSCP and other tagged frames by their PCP.
+ */
+enum qos_trust {
+    QOS_TRUST_NONE  = 0,        /** All packets to the default queue */
+    QOS_TRUST_PCP   = 1,        /** PCP of tagged frames */
+    QOS_TRUST_DSCP  = 2,        /** DSCP of IPv4 and IPv6 packets */
+    QOS_TRUST_ALL   = 3,        /** DSCP, then PCP */
+};
+
+/**
+ * Per ingress port configuration, written by the host
+ */
+struct qos_port_cfg {
+    union {
+        struct {
+            unsigned int trust:2;       /** enum qos_trust */
+            unsigned int resv:27;       /** Reserved */
+            unsigned int dflt:3;        /** Queue of untrusted packets */
+
+            uint32_t pcp_map;           /** Queue of PCP n in bits 4n+2:4n */
+        };
+        uint32_t __raw[2];
+    };
+};
+
+/**
+ * Per (egress port, queue) counters
+ */
+struct qos_cntrs {
+    uint64_t pkts;              /** Packets classified to the queue */
+    uint64_t bytes;             /** Their bytes */
+};
+
+/**
+ * Classify a packet to a TM queue of its egress port.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param len       Frame length in bytes
+ * @param in_port   Ingress port, selects the trusted fields
+ * @param out_port  Egress port, selects the counters
+ * @return          Offset of the TM queue in the queues of @out_port
+ */
+__intrinsic unsigned int qos_pkt(__mem40 char *pbuf, unsigned int l2_off,
+                                 unsigned int len, unsigned int in_port,
+                                 unsigned int out_port);
+
+#endif /* _QOS_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/rep.c
+ * @brief         Packet replication to a set of egress ports
+ */
+
+#ifndef _REP_C_
+#define _REP_C_
+
+#include "config.h"
+
+#ifdef CFG_REPLICATION
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_ring.h>
+#include <pkt/pkt.h>
+
+#include "rep.h"
+
+__export __emem struct rep_cntrs rep_cntrs;
+
+/* Replication work handed to the service ME */
+MEM_RING_INIT(rep_workq, REP_WORKQ_SZ * 4);
+
+/**
+ * Work queue entry, a packet and the ports it still has to be sent to
+ */
+struct rep_work {
+    union {
+        struct {
+            struct rep_pkt pkt;
+            uint32_t ports_hi;
+            uint32_t ports_lo;
+            uint32_t resv[2];
+        };
+        uint32_t __raw[8];
+    };
+};
+
+
+/*
+ * Send the copies of @ports, at most @max of them before handing the rest
+ * to the workers.  Returns the number of copies sent.
+ */
+__intrinsic static unsigned int
+rep_send_copies(__gpr struct rep_pkt *pkt, uint64_t ports, unsigned int max)
+{
+    __xwrite struct rep_work work;
+    __gpr unsigned int n = 0;
+    __gpr int port;
+
+    for (;;) {
+        port = ffs64(ports);
+        ports &= ~(1ull << port);
+
+        if (ports == 0) {
+            pkt_nbi_send(pkt->isl, pkt->pnum, &pkt->msi, pkt->len, NBI,
+                         PORT_TO_TMQ(port) + pkt->qoff,
+                         pkt->seqr, pkt->seq, PKT_CTM_SIZE_256);
+            return n + 1;
+        }
+
+        if (n == max) {
+            ports |= 1ull << port;
+            work.pkt = *pkt;
+            work.ports_hi = ports >> 32;
+            work.ports_lo = ports;
+            work.resv[0] = 0;
+            work.resv[1] = 0;
+            mem_workq_add_work(MEM_RING_GET_NUM(rep_workq),
+                               MEM_RING_GET_MEMADDR(rep_workq),
+                               &work, sizeof(work));
+            mem_incr64(&rep_cntrs.deferred);
+            return n;
+        }
+
+        pkt_nbi_send_dont_free(pkt->isl, pkt->pnum, &pkt->msi, pkt->len, NBI,
+                               PORT_TO_TMQ(port) + pkt->qoff,
+                               pkt->seqr, pkt->seq, PKT_CTM_SIZE_256);
+        n++;
+    }
+}
+
+__intrinsic void
+rep_send(__gpr struct rep_pkt *pkt, uint64_t ports)
+{
+    __gpr unsigned int n;
+
+    n = rep_send_copies(pkt, ports, REP_INLINE_COPIES);
+
+    mem_incr64(&rep_cntrs.pkts);
+    mem_add64_imm(n, &rep_cntrs.copies);
+}
+
+void
+rep_worker_loop(void)
+{
+    __xread struct rep_work work;
+    __gpr struct rep_pkt pkt;
+    __gpr uint64_t ports;
+    __gpr unsigned int n;
+
+    for (;;) {
+        /* Wait for work */
+        mem_workq_add_thread(MEM_RING_GET_NUM(rep_workq),
+                             MEM_RING_GET_MEMADDR(rep_workq),
+                             &work, sizeof(work));
+
+        pkt = work.pkt;
+        ports = ((uint64_t)work.ports_hi << 32) | work.ports_lo;
+        n = rep_send_copies(&pkt, ports, 64);
+        mem_add64_imm(n, &rep_cntrs.copies);
+    }
+}
+
+#endif /* CFG_REPLICATION */
+
+#endif /* _REP_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/rep.h
+ * @brief         Packet replication to a set of egress ports
+ *
+ * A packet is sent to every port of a bitmap from its single CTM buffer.
+ * All copies but the last are sent with pkt_nbi_send_dont_free(), the
+ * last copy is sent with pkt_nbi_send(), which frees the buffer and
+ * releases the sequence number of the packet.
+ *
+ * The receiving context sends up to REP_INLINE_COPIES copies itself.  The
+ * copies of larger groups are handed over on a work queue to the worker
+ * contexts of the service ME, so a single context never spends more than
+ * a bounded time on one packet.  Packets of other flows on the same
+ * sequencer are held back by the NBI until the last copy is sent.
+ *
+ * The MAC egress command and modification script are part of the packet
+ * data and are read by the NBI when each copy is transmitted, so they are
+ * shared by all copies.  The TX queue is selected per copy.
+ */
+
+#ifndef _REP_H_
+#define _REP_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <pkt/pkt.h>
+
+/* Copies sent by the receiving context before deferring to the workers */
+#ifndef REP_INLINE_COPIES
+#define REP_INLINE_COPIES       4
+#endif
+
+/* Work queue size in 32 bit words */
+#ifndef REP_WORKQ_SZ
+#define REP_WORKQ_SZ            4096
+#endif
+
+/* Service ME contexts running rep_worker_loop(), see wire_svc.c for the
+ * contexts of the other stages */
+#ifndef REP_WORKER_CTX_BASE
+#define REP_WORKER_CTX_BASE     4
+#endif
+
+#ifndef REP_WORKER_CTXS
+#define REP_WORKER_CTXS         1
+#endif
+
+/**
+ * Everything needed to send a copy of a received packet
+ */
+struct rep_pkt {
+    union {
+        struct {
+            unsigned int isl:8;         /** Island of the CTM packet */
+            unsigned int seqr:8;        /** NBI sequencer */
+            unsigned int pnum:16;       /** CTM packet number */
+
+            unsigned int seq:16;        /** NBI sequence number */
+            unsigned int len:16;        /** Length incl. MAC egress cmd */
+
+            struct pkt_ms_info msi;     /** From pkt_msd_write() */
+
+            unsigned int resv:24;       /** Reserved */
+            unsigned int qoff:8;        /** TX queue offset in the port */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Global counters
+ */
+struct rep_cntrs {
+    uint64_t pkts;              /** Packets replicated */
+    uint64_t copies;            /** Copies sent */
+    uint64_t deferred;          /** Packets handed to the workers */
+};
+
+/**
+ * Send a packet to a set of ports and free it.
+ * @param pkt       Packet to send
+ * @param ports     Bitmap of egress ports, must not be empty
+ */
+__intrinsic void rep_send(__gpr struct rep_pkt *pkt, uint64_t ports);
+
+/**
+ * Worker loop, never returns.  Meant to be run by REP_WORKER_CTXS
+ * contexts on the service ME.
+ */
+void rep_worker_loop(void);
+
+#endif /* _REP_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/sflow.c
+ * @brief         sFlow style 1:N packet sampling
+ */
+
+#ifndef _SFLOW_C_
+#define _SFLOW_C_
+
+#include "config.h"
+
+#ifdef CFG_SFLOW
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/cls.h>
+#include <nfp/me.h>
+#include <nfp/mem_bulk.h>
+#include <std/reg_utils.h>
+
+#include "host_ring.h"
+#include "sflow.h"
+
+/* Host written sampling rates */
+__export __shared __cls struct sflow_port_cfg sflow_port_cfg[SFLOW_NUM_PORTS];
+
+HOST_RING_DECLARE(sflow_ring, struct sflow_rec, SFLOW_RING_ENTRIES);
+
+/* Frame data is copied in chunks through the transfer registers */
+#define SFLOW_CHUNK             64
+
+
+__intrinsic void
+sflow_pkt(__mem40 char *pbuf, unsigned int l2_off, unsigned int len,
+          unsigned int port)
+{
+    __xread struct sflow_port_cfg cfg;
+    __xread uint32_t data_in[SFLOW_CHUNK / 4];
+    __xwrite uint32_t data_out[SFLOW_CHUNK / 4];
+    __xwrite struct sflow_meta meta_out;
+    __gpr struct sflow_meta meta;
+    __gpr uint32_t rnd;
+    __gpr uint32_t seq;
+    __gpr unsigned int off;
+    __gpr uint64_t ts;
+    __mem40 struct sflow_rec *rec;
+
+    rnd = local_csr_read(local_csr_pseudo_random_number);
+    cls_read(&cfg, &sflow_port_cfg[port & (SFLOW_NUM_PORTS - 1)],
+             sizeof(cfg));
+    if (rnd >= cfg.thresh)
+        return;
+
+    ts = me_tsc_read();
+    seq = host_ring_claim(&sflow_ring_wptr);
+    rec = &sflow_ring[seq & (SFLOW_RING_ENTRIES - 1)];
+
+    for (off = 0; off < SFLOW_HDR_LEN; off += SFLOW_CHUNK) {
+        mem_read64(data_in, pbuf + l2_off + off, sizeof(data_in));
+        reg_cp(data_out, data_in, sizeof(data_out));
+        mem_write32(data_out, (__mem40 char *)rec->data + off,
+                    sizeof(data_out));
+    }
+
+    /* The metadata is written last, the host checks its sequence */
+    reg_zero(&meta, sizeof(meta));
+    meta.seq = seq;
+    meta.isl = __ISLAND;
+    meta.port = port;
+    meta.len = len;
+    meta.cap = (len < SFLOW_HDR_LEN) ? len : SFLOW_HDR_LEN;
+    meta.rate = cfg.rate;
+    meta.ts_hi = ts >> 32;
+    meta.ts_lo = ts;
+    reg_cp(&meta_out, &meta, sizeof(meta_out));
+    mem_write32(&meta_out, &rec->meta, sizeof(meta_out));
+}
+
+#endif /* CFG_SFLOW */
+
+#endif /* _SFLOW_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/sflow.h
+ * @brief         sFlow style 1:N packet sampling
+ *
+ * Packets are sampled on receive, before any other stage, with a per
+ * ingress port probability of 1/N.  A sample is taken when the ME pseudo
+ * random number is below a host computed threshold (2^32 / N), so a packet
+ * that is not sampled costs a CSR read, a CLS read and a compare.
+ *
+ * The first SFLOW_HDR_LEN bytes of a sampled frame and its metadata are
+ * written to the sflow_ring host ring (see host_ring.h), which
+ * tools/sflow_read.py turns into sFlow flow sample records.
+ */
+
+#ifndef _SFLOW_H_
+#define _SFLOW_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#ifndef SFLOW_NUM_PORTS
+#define SFLOW_NUM_PORTS         64
+#endif
+
+#ifndef SFLOW_RING_ENTRIES
+#define SFLOW_RING_ENTRIES      4096
+#endif
+
+/* Bytes of the frame copied per sample, a multiple of 64 */
+#define SFLOW_HDR_LEN           128
+
+/**
+ * Per ingress port sampling rate, one copy per island in CLS
+ */
+struct sflow_port_cfg {
+    union {
+        struct {
+            uint32_t thresh;            /** Sample if random < thresh */
+            uint32_t rate;              /** N, reported in the records */
+        };
+        uint32_t __raw[2];
+    };
+};
+
+/**
+ * Metadata of a sample, written after the frame data
+ */
+struct sflow_meta {
+    union {
+        struct {
+            uint32_t seq;               /** Ring write counter of the slot */
+
+            unsigned int isl:8;         /** Island that took the sample */
+            unsigned int port:8;        /** Ingress port */
+            unsigned int len:16;        /** Frame length */
+
+            unsigned int resv0:16;      /** Reserved */
+            unsigned int cap:16;        /** Bytes of the frame captured */
+
+            uint32_t rate;              /** Sampling rate N */
+            uint32_t ts_hi;             /** ME timestamp, 16 cycle ticks */
+            uint32_t ts_lo;
+            uint32_t resv1[2];          /** Reserved */
+        };
+        uint32_t __raw[8];
+    };
+};
+
+/**
+ * Host ring record
+ */
+struct sflow_rec {
+    uint32_t data[SFLOW_HDR_LEN / 4];   /** Start of the Ethernet frame */
+    struct sflow_meta meta;
+};
+
+/**
+ * Sample a received frame.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header, 8 byte aligned
+ * @param len       Frame length in bytes
+ * @param port      Ingress port
+ */
+__intrinsic void sflow_pkt(__mem40 char *pbuf, unsigned int l2_off,
+                           unsigned int len, unsigned int port);
+
+#endif /* _SFLOW_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
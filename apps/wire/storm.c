@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/storm.c
+ * @brief         Broadcast/multicast/unknown unicast storm control
+ */
+
+#ifndef _STORM_C_
+#define _STORM_C_
+
+#include "config.h"
+
+#ifdef CFG_STORM_CTRL
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/eth.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+
+#include "meter_fill.h"
+#include "storm.h"
+
+/*
+ * Token buckets.  Only the peak bucket is used as the limiter, the
+ * committed bucket stays empty so conforming frames are marked yellow and
+ * frames exceeding the limit red.
+ */
+__export STORM_MEM __align8 struct meter_bucket
+    storm_meters[STORM_NUM_ENTRIES];
+
+/* Host written limits */
+__export STORM_MEM struct storm_cfg storm_cfg[STORM_NUM_ENTRIES];
+
+/* Pass/drop counters */
+__export STORM_MEM struct storm_cntrs storm_cntrs[STORM_NUM_ENTRIES];
+
+/* Fractional token accumulators, only touched by the refill context */
+STORM_MEM uint32_t storm_frac[STORM_NUM_ENTRIES];
+
+/* Sleep granularity of the refill context, in ME cycles */
+#define STORM_REFILL_SLEEP      4096
+
+
+__intrinsic enum storm_class
+storm_classify(__mem40 char *pbuf, unsigned int l2_off)
+{
+    __xread uint32_t da[2];
+
+    mem_read8(da, pbuf + l2_off, NET_ETH_ALEN);
+
+    if ((da[0] >> 24) & NET_ETH_GROUP_ADDR) {
+        if (da[0] == 0xffffffff && (da[1] >> 16) == 0xffff)
+            return STORM_CLS_BC;
+        return STORM_CLS_MC;
+    }
+
+    return STORM_CLS_NONE;
+}
+
+__intrinsic int
+storm_pkt(unsigned int port, enum storm_class cls, unsigned int len)
+{
+    __xread struct storm_cfg cfg;
+    __gpr unsigned int idx;
+    __gpr enum meter_color color;
+
+    if (cls == STORM_CLS_NONE)
+        return 0;
+
+    idx = STORM_IDX(port, cls);
+    mem_read32(&cfg.__raw[3], &storm_cfg[idx].__raw[3], sizeof(uint32_t));
+
+    if (!cfg.enable)
+        return 0;
+
+    if (cfg.pkts)
+        len = 1;
+
+    color = mem_meter(len, &storm_meters[idx], METER_MODE_PEAK,
+                      METER_COLOR_NO_COLOR);
+
+    if (color == METER_COLOR_RED) {
+        mem_incr64(&storm_cntrs[idx].drop);
+        return 1;
+    }
+
+    mem_incr64(&storm_cntrs[idx].pass);
+    return 0;
+}
+
+/*
+ * Refill the bucket of a single (port, class) for one refill interval.
+ */
+__intrinsic static void
+storm_refill(unsigned int idx)
+{
+    __xread struct storm_cfg cfg;
+    __xread uint32_t frac_in;
+    __xwrite uint32_t frac_out;
+    __gpr uint32_t frac;
+    __gpr uint32_t tokens;
+    SIGNAL cfg_sig, frac_sig;
+
+    __mem_read32(&cfg, &storm_cfg[idx], sizeof(cfg), sizeof(cfg),
+                 sig_done, &cfg_sig);
+    __mem_read32(&frac_in, &storm_frac[idx], sizeof(frac_in),
+                 sizeof(frac_in), sig_done, &frac_sig);
+    wait_for_all(&cfg_sig, &frac_sig);
+
+    if (!cfg.enable)
+        return;
+
+    frac = frac_in + cfg.frac;
+    tokens = cfg.inc;
+    if (frac < cfg.frac)
+        tokens++;
+
+    frac_out = frac;
+    mem_write32(&frac_out, &storm_frac[idx], sizeof(frac_out));
+
+    meter_bucket_fill(&storm_meters[idx].peak_tokens, tokens, cfg.burst);
+}
+
+void
+storm_refill_loop(void)
+{
+    __gpr unsigned int port;
+    __gpr unsigned int cls;
+    __gpr uint64_t next;
+
+    next = me_tsc_read();
+
+    for (;;) {
+        next += STORM_REFILL_TICKS;
+        while (me_tsc_read() < next)
+            sleep(STORM_REFILL_SLEEP);
+
+        for (port = 0; port < STORM_NUM_PORTS; port++) {
+            for (cls = 0; cls < STORM_CLS_NUM; cls++)
+                storm_refill(STORM_IDX(port, cls));
+        }
+    }
+}
+
+#endif /* CFG_STORM_CTRL */
+
+#endif /* _STORM_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
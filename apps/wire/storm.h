@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/storm.h
+ * @brief         Broadcast/multicast/unknown unicast storm control
+ *
+ * Per ingress port and per traffic class rate limiting of flooded
+ * traffic.  Each (port, class) pair has a single token bucket in EMEM
+ * which is consumed with the MU meter command and refilled by a context
+ * on the service ME.  A limit is expressed either in bytes or in packets
+ * per refill interval (see tools/storm_ctl.py).
+ *
+ * Frames exceeding the limit should be dropped with pkt_nbi_drop_seq()
+ * before they reach a TM queue.
+ */
+
+#ifndef _STORM_H_
+#define _STORM_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#ifndef STORM_MEM
+#define STORM_MEM               __emem
+#endif
+
+#ifndef STORM_NUM_PORTS
+#define STORM_NUM_PORTS         64
+#endif
+
+/* Refill interval in ME timestamp ticks and the service ME context */
+#ifndef STORM_REFILL_TICKS
+#define STORM_REFILL_TICKS      5000
+#endif
+
+#ifndef STORM_REFILL_CTX
+#define STORM_REFILL_CTX        2
+#endif
+
+/**
+ * Storm control traffic classes
+ *
+ * Known unicast frames are never limited.  Unknown unicast is only
+ * reported by stages that perform a destination lookup (the bridge).
+ */
+enum storm_class {
+    STORM_CLS_BC    = 0,        /** Broadcast */
+    STORM_CLS_MC    = 1,        /** Multicast */
+    STORM_CLS_UUC   = 2,        /** Unknown unicast */
+    STORM_CLS_NUM   = 3,
+    STORM_CLS_NONE  = 3,        /** Not subject to storm control */
+};
+
+/* Per port stride of the tables, a power of 2 */
+#define STORM_CLS_STRIDE        4
+
+#define STORM_IDX(_port, _cls) \
+    ((((_port) & (STORM_NUM_PORTS - 1)) * STORM_CLS_STRIDE) + (_cls))
+
+#define STORM_NUM_ENTRIES       (STORM_NUM_PORTS * STORM_CLS_STRIDE)
+
+/**
+ * Per (port, class) limit, written by the host.
+ *
+ * The increment is the number of tokens (bytes or packets) added per
+ * refill interval as an integer part and a 32 bit binary fraction.
+ */
+struct storm_cfg {
+    union {
+        struct {
+            uint32_t inc;               /** Tokens per refill */
+            uint32_t frac;              /** Fraction of a token (/2^32) */
+            uint32_t burst;             /** Bucket depth in tokens */
+
+            unsigned int enable:1;      /** Limit in use */
+            unsigned int pkts:1;        /** Tokens are packets, not bytes */
+            unsigned int resv:30;       /** Reserved */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Per (port, class) counters
+ */
+struct storm_cntrs {
+    uint64_t pass;              /** Frames within the limit */
+    uint64_t drop;              /** Frames dropped by storm control */
+};
+
+/**
+ * Classify a frame by its destination MAC address.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @return          STORM_CLS_BC, STORM_CLS_MC or STORM_CLS_NONE
+ */
+__intrinsic enum storm_class storm_classify(__mem40 char *pbuf,
+                                            unsigned int l2_off);
+
+/**
+ * Charge a frame against the storm control limit of a port and class.
+ * @param port      Ingress port
+ * @param cls       Traffic class, STORM_CLS_NONE is always passed
+ * @param len       Frame length in bytes
+ * @return          Non-zero if the frame must be dropped
+ *
+ * Frames of a class without a configured limit are passed without being
+ * counted.
+ */
+__intrinsic int storm_pkt(unsigned int port, enum storm_class cls,
+                          unsigned int len);
+
+/**
+ * Token bucket refill loop, never returns.  Meant to be run by a single
+ * context on the service ME.
+ */
+void storm_refill_loop(void);
+
+#endif /* _STORM_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
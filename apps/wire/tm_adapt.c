@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/tm_adapt.c
+ * @brief         Shaper rates following the occupancy of TM queues
+ */
+
+#ifndef _TM_ADAPT_C_
+#define _TM_ADAPT_C_
+
+#include "config.h"
+
+#ifdef CFG_TM_ADAPT
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/tm_config.h>
+#include <nfp/tmq.h>
+#include <std/reg_utils.h>
+
+#include "tm_ctl.h"
+#include "tm_adapt.h"
+
+__export __emem struct tm_adapt_cfg tm_adapt_cfg[TM_ADAPT_LOOPS];
+__export __emem struct tm_adapt_state tm_adapt_state[TM_ADAPT_LOOPS];
+
+/* Loops that ran at the last sample, a newly enabled loop first takes a
+ * reference of the drop counters */
+__shared __lmem uint32_t tm_adapt_active;
+__shared __lmem uint32_t tm_adapt_drops[TM_ADAPT_LOOPS];
+
+
+/*
+ * Read the rate register of a shaper, 0 if there is no such shaper
+ */
+static uint32_t
+tm_adapt_rate_read(unsigned int nbi, unsigned int level, unsigned int node)
+{
+    __xread struct nfp_nbi_tm_shaper_rate rate_rd;
+    __xread struct nfp_nbi_tm_shaper_threshold thresh_rd;
+    __xread struct nfp_nbi_tm_shaper_max_overshoot over_rd;
+    __xread struct nfp_nbi_tm_shaper_rate_adjust adj_rd;
+
+    if (level == 0 && node == 0)
+        tm_config_l0_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi);
+    else if (level == 1 && node < TM_CTL_NUM_L1)
+        tm_config_l1_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi, node, 1);
+    else if (level == 2 && node < TM_CTL_NUM_L2)
+        tm_config_l2_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi, node, 1);
+    else
+        return 0;
+
+    return rate_rd.rate;
+}
+
+/*
+ * Change the rate of a shaper, keeping its threshold, overshoot and
+ * adjust.  The node has been checked by tm_adapt_rate_read().
+ */
+static void
+tm_adapt_rate_write(unsigned int nbi, unsigned int level, unsigned int node,
+                    uint32_t reg)
+{
+    __xread struct nfp_nbi_tm_shaper_rate rate_rd;
+    __xread struct nfp_nbi_tm_shaper_threshold thresh_rd;
+    __xread struct nfp_nbi_tm_shaper_max_overshoot over_rd;
+    __xread struct nfp_nbi_tm_shaper_rate_adjust adj_rd;
+    __xwrite struct nfp_nbi_tm_shaper_rate rate_wr;
+    __xwrite struct nfp_nbi_tm_shaper_threshold thresh_wr;
+    __xwrite struct nfp_nbi_tm_shaper_max_overshoot over_wr;
+    __xwrite struct nfp_nbi_tm_shaper_rate_adjust adj_wr;
+
+    if (level == 0)
+        tm_config_l0_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi);
+    else if (level == 1)
+        tm_config_l1_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi, node, 1);
+    else
+        tm_config_l2_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi, node, 1);
+
+    rate_wr.__raw = reg;
+    thresh_wr.__raw = thresh_rd.__raw;
+    over_wr.__raw = over_rd.__raw;
+    adj_wr.__raw = adj_rd.__raw;
+
+    if (level == 0)
+        tm_config_l0_shaper_write(&rate_wr, &thresh_wr, &over_wr, &adj_wr,
+                                  nbi);
+    else if (level == 1)
+        tm_config_l1_shaper_write(&rate_wr, &thresh_wr, &over_wr, &adj_wr,
+                                  nbi, node, 1);
+    else
+        tm_config_l2_shaper_write(&rate_wr, &thresh_wr, &over_wr, &adj_wr,
+                                  nbi, node, 1);
+}
+
+/*
+ * Stop a loop that cannot run and report why
+ */
+static void
+tm_adapt_stop(unsigned int loop, unsigned int status)
+{
+    __xwrite uint32_t status_out;
+
+    tm_adapt_active &= ~(1 << loop);
+
+    status_out = status;
+    mem_write32(&status_out, &tm_adapt_state[loop].status,
+                sizeof(status_out));
+}
+
+static void
+tm_adapt_loop(unsigned int loop)
+{
+    __xread struct tm_adapt_cfg cfg_in;
+    __lmem struct tm_adapt_cfg cfg;
+    __xread struct nfp_nbi_tm_queue_status qs_in[TM_ADAPT_STATUS_QUEUES];
+    __xwrite uint32_t state_out[4];
+    __gpr uint32_t bit = 1 << loop;
+    __gpr uint32_t depth;
+    __gpr uint32_t drops;
+    __gpr uint32_t cnt;
+    __gpr uint32_t rate;
+    __gpr uint32_t min_reg;
+    __gpr uint32_t max_reg;
+    __gpr uint32_t step_reg;
+    __gpr uint32_t cut;
+    __gpr unsigned int i;
+    __gpr unsigned int j;
+    __gpr unsigned int n;
+
+    mem_read32(&cfg_in, &tm_adapt_cfg[loop], sizeof(cfg_in));
+    reg_cp(&cfg, &cfg_in, sizeof(cfg));
+
+    if (!cfg.enable) {
+        tm_adapt_stop(loop, TM_ADAPT_ST_OFF);
+        return;
+    }
+    /* tmq_status_read() only reaches the queues of NBI 0 */
+    if (cfg.nbi != 0 || cfg.nq == 0 || cfg.nq > TM_ADAPT_MAX_QUEUES ||
+        cfg.qbase + cfg.nq > TM_CTL_NUM_L2 * TM_CTL_SCHED_INPUTS) {
+        tm_adapt_stop(loop, TM_ADAPT_ST_BAD_QUEUES);
+        return;
+    }
+
+    rate = tm_adapt_rate_read(cfg.nbi, cfg.level, cfg.node);
+    if (rate == 0) {
+        tm_adapt_stop(loop, TM_ADAPT_ST_BAD_NODE);
+        return;
+    }
+
+    /* A bound or step below one register unit truncates to 0 */
+    min_reg = tm_ctl_rate_reg(cfg.min_rate);
+    max_reg = tm_ctl_rate_reg(cfg.max_rate);
+    if (min_reg == 0 || max_reg < min_reg) {
+        tm_adapt_stop(loop, TM_ADAPT_ST_BAD_RATE);
+        return;
+    }
+    step_reg = tm_ctl_rate_reg(cfg.step);
+    if (step_reg == 0) {
+        tm_adapt_stop(loop, TM_ADAPT_ST_BAD_STEP);
+        return;
+    }
+
+    depth = 0;
+    for (i = 0; i < cfg.nq; i += TM_ADAPT_STATUS_QUEUES) {
+        n = cfg.nq - i;
+        if (n > TM_ADAPT_STATUS_QUEUES)
+            n = TM_ADAPT_STATUS_QUEUES;
+        tmq_status_read(qs_in, cfg.nbi, cfg.qbase + i, n);
+        /* Constant bound, the transfer registers need static indices */
+        for (j = 0; j < TM_ADAPT_STATUS_QUEUES; j++) {
+            if (j < n && qs_in[j].queuelevel > depth)
+                depth = qs_in[j].queuelevel;
+        }
+    }
+
+    drops = 0;
+    for (i = 0; i < cfg.nq; i++) {
+        tmq_cnt_read(cfg.nbi, &cnt, cfg.qbase + i, 0);
+        drops += cnt;
+    }
+
+    if (tm_adapt_active & bit) {
+        if (depth > cfg.target || drops != tm_adapt_drops[loop]) {
+            cut = (rate * cfg.md) >> 8;
+            rate = (rate - cut < min_reg) ? min_reg : rate - cut;
+            mem_incr64(&tm_adapt_state[loop].decr);
+        } else {
+            rate = (rate + step_reg > max_reg) ? max_reg : rate + step_reg;
+            mem_incr64(&tm_adapt_state[loop].incr);
+        }
+        tm_adapt_rate_write(cfg.nbi, cfg.level, cfg.node, rate);
+    }
+    tm_adapt_active |= bit;
+    tm_adapt_drops[loop] = drops;
+
+    state_out[0] = rate;
+    state_out[1] = depth;
+    state_out[2] = drops;
+    state_out[3] = TM_ADAPT_ST_RUN;
+    mem_write32(state_out, &tm_adapt_state[loop], sizeof(state_out));
+}
+
+void
+tm_adapt_run(void)
+{
+    __gpr unsigned int loop;
+
+    for (loop = 0; loop < TM_ADAPT_LOOPS; loop++)
+        tm_adapt_loop(loop);
+}
+
+#endif /* CFG_TM_ADAPT */
+
+#endif /* _TM_ADAPT_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
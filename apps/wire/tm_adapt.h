@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/tm_adapt.h
+ * @brief         Shaper rates following the occupancy of TM queues
+ *
+ * A control loop watches a group of TM queues, typically those of a
+ * latency sensitive class, and steers the rate of one shaper, typically
+ * that of the bulk traffic sharing the port with them.  Every
+ * TM_ADAPT_TICKS the deepest watched queue and the drop counters of the
+ * group are sampled.  When the depth is above the target or the group
+ * dropped packets since the last sample the shaper rate is cut by a
+ * fraction (multiplicative decrease), otherwise it grows by a fixed step
+ * (additive increase), always within [min_rate, max_rate].
+ *
+ * The loops run on the tm_ctl context, which stays the only writer of the
+ * shaper registers.  A loop starts from the rate the shaper has, so a
+ * rate set with tools/tm_ctl.py is where the controller picks up.  The
+ * target depth is in packets, tools/tm_adapt.py derives it from a latency
+ * target.  A loop whose configuration cannot run reports why in its state
+ * instead of touching the shaper.
+ */
+
+#ifndef _TM_ADAPT_H_
+#define _TM_ADAPT_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* Number of control loops, at most 32 */
+#ifndef TM_ADAPT_LOOPS
+#define TM_ADAPT_LOOPS          8
+#endif
+#if TM_ADAPT_LOOPS > 32
+#error "TM_ADAPT_LOOPS is limited to 32, one bit each in tm_adapt_active"
+#endif
+
+/* Sample interval in ME timestamp ticks (16 ME cycles), 100 us at 800 MHz */
+#ifndef TM_ADAPT_TICKS
+#define TM_ADAPT_TICKS          5000
+#endif
+
+/* Queues watched by a loop */
+#define TM_ADAPT_MAX_QUEUES     16
+
+/* Queues per status read, tmq_status_read() bursts at most 16 bytes */
+#define TM_ADAPT_STATUS_QUEUES  4
+
+/**
+ * Control loop configuration, written by the host.  Rates are in Mbps.
+ * Clear @enable before changing the other fields.
+ */
+struct tm_adapt_cfg {
+    union {
+        struct {
+            unsigned int enable:1;      /** Loop is running */
+            unsigned int nbi:1;         /** NBI of the queues and shaper, 0 */
+            unsigned int level:2;       /** TM level of the shaper */
+            unsigned int resv:12;       /** Reserved */
+            unsigned int md:8;          /** Decrease in 1/256 of the rate */
+            unsigned int node:8;        /** Shaper, as in tm_ctl */
+
+            unsigned int qbase:16;      /** First watched queue */
+            unsigned int nq:16;         /** Watched queues, 1-16 */
+
+            uint32_t target;            /** Depth target in packets */
+            uint32_t min_rate;          /** Lower bound */
+            uint32_t max_rate;          /** Upper bound */
+            uint32_t step;              /** Increase per sample */
+            uint32_t resv2[2];          /** Reserved */
+        };
+        uint32_t __raw[8];
+    };
+};
+
+/**
+ * Status of a control loop
+ */
+enum tm_adapt_status {
+    TM_ADAPT_ST_OFF         = 0,    /** Not enabled */
+    TM_ADAPT_ST_RUN         = 1,    /** Steering the shaper */
+    TM_ADAPT_ST_BAD_QUEUES  = 2,    /** No such watched queues */
+    TM_ADAPT_ST_BAD_NODE    = 3,    /** No such shaper */
+    TM_ADAPT_ST_BAD_RATE    = 4,    /** Bounds out of the register range */
+    TM_ADAPT_ST_BAD_STEP    = 5,    /** Step out of the register range */
+};
+
+/**
+ * Control loop state, read by the host.  Only @status is written while
+ * the loop does not run.
+ */
+struct tm_adapt_state {
+    uint32_t rate;              /** Shaper rate register value */
+    uint32_t depth;             /** Deepest watched queue, packets */
+    uint32_t drops;             /** Sum of the watched queue drop counters */
+    uint32_t status;            /** enum tm_adapt_status */
+    uint64_t decr;              /** Samples that cut the rate */
+    uint64_t incr;              /** Samples that raised the rate */
+};
+
+/**
+ * Run one sample of every enabled loop.  Called by tm_ctl_loop() every
+ * TM_ADAPT_TICKS.
+ */
+void tm_adapt_run(void);
+
+#endif /* _TM_ADAPT_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
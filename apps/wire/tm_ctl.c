@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/tm_ctl.c
+ * @brief         Run time reconfiguration of the NBI traffic manager
+ */
+
+#ifndef _TM_CTL_C_
+#define _TM_CTL_C_
+
+#include "config.h"
+
+#ifdef CFG_TM_CTL
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/tm_config.h>
+#include <std/reg_utils.h>
+
+#include "host_ring.h"
+#include "tm_ctl.h"
+#ifdef CFG_TM_ADAPT
+#include "tm_adapt.h"
+#endif
+
+/* Requests, the host advances the write and the context the read pointer */
+__export __emem __align64 struct tm_ctl_req tm_ctl_mbox[TM_CTL_MBOX_ENTRIES];
+__export __emem uint32_t tm_ctl_mbox_wptr;
+__export __emem uint32_t tm_ctl_mbox_rptr;
+
+HOST_RING_DECLARE(tm_ctl_done, struct tm_ctl_rep, TM_CTL_DONE_ENTRIES);
+
+__export __emem struct tm_ctl_cntrs tm_ctl_cntrs;
+
+/* Shaper threshold and overshoot codes step by 8 kB */
+#define TM_CTL_SIZE_SHF         13
+#define TM_CTL_THRESH_MAX       65536
+#define TM_CTL_OVER_MAX         131072
+
+
+uint32_t
+tm_ctl_rate_reg(uint32_t rate)
+{
+    __gpr uint32_t reg;
+
+    /* Also keeps the product in 32 bits */
+    if (rate > TM_CTL_RATE_MAX * 10000 / TM_CTL_PCLK_MHZ)
+        return 0;
+
+    reg = rate * TM_CTL_PCLK_MHZ / 10000;
+    if (reg > TM_CTL_RATE_MAX)
+        return 0;
+
+    return reg;
+}
+
+/*
+ * Smallest size code of @bytes, the code of @base bytes being 0
+ */
+__intrinsic static uint32_t
+tm_ctl_size_code(uint32_t bytes, unsigned int base)
+{
+    __gpr uint32_t units;
+
+    units = (bytes + (1 << TM_CTL_SIZE_SHF) - 1) >> TM_CTL_SIZE_SHF;
+    if (units <= base)
+        return 0;
+    units -= base;
+
+    return (units > 7) ? 7 : units;
+}
+
+static unsigned int
+tm_ctl_shaper(unsigned int nbi, unsigned int level, unsigned int node,
+              uint32_t reg, uint32_t burst, uint32_t over, int32_t adjust)
+{
+    __xwrite struct nfp_nbi_tm_shaper_rate rate_wr;
+    __xwrite struct nfp_nbi_tm_shaper_threshold thresh_wr;
+    __xwrite struct nfp_nbi_tm_shaper_max_overshoot over_wr;
+    __xwrite struct nfp_nbi_tm_shaper_rate_adjust adj_wr;
+    __xread struct nfp_nbi_tm_shaper_rate rate_rd;
+    __xread struct nfp_nbi_tm_shaper_threshold thresh_rd;
+    __xread struct nfp_nbi_tm_shaper_max_overshoot over_rd;
+    __xread struct nfp_nbi_tm_shaper_rate_adjust adj_rd;
+    __gpr uint32_t thresh;
+    __gpr uint32_t max_over;
+    __gpr uint32_t adj;
+
+    if ((level == 0 && node != 0) ||
+        (level == 1 && node >= TM_CTL_NUM_L1) ||
+        (level == 2 && node >= TM_CTL_NUM_L2) || level > 2)
+        return TM_CTL_ST_BAD_NODE;
+
+    if (reg == 0 || burst > TM_CTL_THRESH_MAX || over > TM_CTL_OVER_MAX ||
+        adjust < -512 || adjust > 1023)
+        return TM_CTL_ST_BAD_ARG;
+
+    thresh = tm_ctl_size_code(burst, 1);
+    max_over = (over == 0) ? thresh : tm_ctl_size_code(over, 2);
+    adj = adjust & 0x3ff;
+
+    rate_wr.__raw = reg;
+    thresh_wr.__raw = thresh;
+    over_wr.__raw = max_over;
+    adj_wr.__raw = adj;
+
+    /* All four registers go out together */
+    if (level == 0) {
+        tm_config_l0_shaper_write(&rate_wr, &thresh_wr, &over_wr, &adj_wr,
+                                  nbi);
+        tm_config_l0_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi);
+    } else if (level == 1) {
+        tm_config_l1_shaper_write(&rate_wr, &thresh_wr, &over_wr, &adj_wr,
+                                  nbi, node, 1);
+        tm_config_l1_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi, node, 1);
+    } else {
+        tm_config_l2_shaper_write(&rate_wr, &thresh_wr, &over_wr, &adj_wr,
+                                  nbi, node, 1);
+        tm_config_l2_shaper_read(&rate_rd, &thresh_rd, &over_rd, &adj_rd,
+                                 nbi, node, 1);
+    }
+
+    if (rate_rd.rate != reg || thresh_rd.threshold != thresh ||
+        over_rd.maxovershoot != max_over || adj_rd.rate != adj)
+        return TM_CTL_ST_VERIFY;
+
+    return TM_CTL_ST_OK;
+}
+
+static unsigned int
+tm_ctl_sched(unsigned int nbi, unsigned int level, unsigned int node,
+             unsigned int sp, unsigned int dwrr, __lmem uint32_t *weight)
+{
+    __xwrite struct nfp_nbi_tm_scheduler_weight wt_wr[TM_CTL_SCHED_INPUTS];
+    __xwrite struct nfp_nbi_tm_scheduler_config cfg_wr;
+    __xread struct nfp_nbi_tm_scheduler_weight wt_rd[TM_CTL_SCHED_INPUTS];
+    __xread struct nfp_nbi_tm_scheduler_config cfg_rd;
+    __gpr uint32_t cfg;
+    __gpr unsigned int i;
+
+    if ((level == 1 && node >= TM_CTL_NUM_L1) ||
+        (level == 2 && node >= TM_CTL_NUM_L2) || level == 0 || level > 2)
+        return TM_CTL_ST_BAD_NODE;
+
+    if (sp > 2)
+        return TM_CTL_ST_BAD_ARG;
+    for (i = 0; i < TM_CTL_SCHED_INPUTS; i++) {
+        if (weight[i] > TM_CTL_WEIGHT_MAX)
+            return TM_CTL_ST_BAD_ARG;
+    }
+
+    cfg = 0;
+    if (dwrr)
+        cfg |= NFP_NBI_TM_SCHEDULER_CONFIG_DWRRENABLE;
+    if (sp >= 1)
+        cfg |= NFP_NBI_TM_SCHEDULER_CONFIG_SP0ENABLE;
+    if (sp >= 2)
+        cfg |= NFP_NBI_TM_SCHEDULER_CONFIG_SP1ENABLE;
+
+    reg_cp(wt_wr, weight, sizeof(wt_wr));
+    cfg_wr.__raw = cfg;
+
+    /*
+     * All weights in one command, then the mode so that a scheduler
+     * switched to DWRR starts with the new weights.
+     */
+    if (level == 1) {
+        tm_config_l1_dwrr_weight_write(wt_wr, nbi, node, 0,
+                                       TM_CTL_SCHED_INPUTS);
+        tm_config_l1_sched_write(&cfg_wr, nbi, node, 1);
+        tm_config_l1_dwrr_weight_read(wt_rd, nbi, node, 0,
+                                      TM_CTL_SCHED_INPUTS);
+        tm_config_l1_sched_read(&cfg_rd, nbi, node, 1);
+    } else {
+        tm_config_l2_dwrr_weight_write(wt_wr, nbi, node, 0,
+                                       TM_CTL_SCHED_INPUTS);
+        tm_config_l2_sched_write(&cfg_wr, nbi, node, 1);
+        tm_config_l2_dwrr_weight_read(wt_rd, nbi, node, 0,
+                                      TM_CTL_SCHED_INPUTS);
+        tm_config_l2_sched_read(&cfg_rd, nbi, node, 1);
+    }
+
+    if ((cfg_rd.__raw & (NFP_NBI_TM_SCHEDULER_CONFIG_DWRRENABLE |
+                         NFP_NBI_TM_SCHEDULER_CONFIG_SP0ENABLE |
+                         NFP_NBI_TM_SCHEDULER_CONFIG_SP1ENABLE)) != cfg)
+        return TM_CTL_ST_VERIFY;
+    for (i = 0; i < TM_CTL_SCHED_INPUTS; i++) {
+        if (wt_rd[i].weight != weight[i])
+            return TM_CTL_ST_VERIFY;
+    }
+
+    return TM_CTL_ST_OK;
+}
+
+void
+tm_ctl_loop(void)
+{
+    __xread uint32_t wptr_in;
+    __xwrite uint32_t rptr_out;
+    __xread struct tm_ctl_req req_in;
+    __lmem struct tm_ctl_req req;
+    __lmem struct tm_ctl_rep rep;
+    __xwrite struct tm_ctl_rep rep_out;
+    __gpr uint32_t rptr;
+    __gpr uint32_t reg;
+    __gpr unsigned int status;
+    __gpr uint64_t ts;
+#ifdef CFG_TM_ADAPT
+    __gpr uint64_t next_adapt;
+#endif
+
+    /* Requests posted before the firmware started are applied */
+    rptr = 0;
+    rptr_out = rptr;
+    mem_write32(&rptr_out, &tm_ctl_mbox_rptr, sizeof(rptr_out));
+
+#ifdef CFG_TM_ADAPT
+    next_adapt = me_tsc_read() + TM_ADAPT_TICKS;
+#endif
+
+    for (;;) {
+#ifdef CFG_TM_ADAPT
+        /* Samples do not catch up, the interval is the one of the loops */
+        if (me_tsc_read() >= next_adapt) {
+            tm_adapt_run();
+            next_adapt = me_tsc_read() + TM_ADAPT_TICKS;
+        }
+#endif
+
+        mem_read32(&wptr_in, &tm_ctl_mbox_wptr, sizeof(wptr_in));
+        if (wptr_in == rptr) {
+            sleep(TM_CTL_POLL);
+            continue;
+        }
+
+        mem_read32(&req_in, &tm_ctl_mbox[rptr & (TM_CTL_MBOX_ENTRIES - 1)],
+                   sizeof(req_in));
+        reg_cp(&req, &req_in, sizeof(req));
+
+        reg = 0;
+        switch (req.op) {
+        case TM_CTL_OP_SHAPER:
+            reg = tm_ctl_rate_reg(req.shaper.rate);
+            status = tm_ctl_shaper(req.nbi, req.level, req.node, reg,
+                                   req.shaper.burst, req.shaper.overshoot,
+                                   req.shaper.adjust);
+            break;
+        case TM_CTL_OP_SCHED:
+            status = tm_ctl_sched(req.nbi, req.level, req.node, req.sp,
+                                  req.dwrr, req.weight);
+            break;
+        default:
+            status = TM_CTL_ST_BAD_OP;
+            break;
+        }
+        ts = me_tsc_read();
+
+        if (status == TM_CTL_ST_OK)
+            mem_incr64(&tm_ctl_cntrs.applied);
+        else if (status == TM_CTL_ST_VERIFY)
+            mem_incr64(&tm_ctl_cntrs.verify);
+        else
+            mem_incr64(&tm_ctl_cntrs.rejected);
+
+        reg_zero(&rep, sizeof(rep));
+        rep.op = req.op;
+        rep.nbi = req.nbi;
+        rep.level = req.level;
+        rep.status = status;
+        rep.node = req.node;
+        rep.seq = req.seq;
+        rep.ts_hi = ts >> 32;
+        rep.ts_lo = ts;
+        rep.reg = reg;
+        reg_cp(&rep_out, &rep, sizeof(rep_out));
+        host_ring_put(&rep_out, tm_ctl_done, &tm_ctl_done_wptr,
+                      TM_CTL_DONE_ENTRIES, sizeof(rep_out));
+
+        /* The slot is free once the report is out */
+        rptr++;
+        rptr_out = rptr;
+        mem_write32(&rptr_out, &tm_ctl_mbox_rptr, sizeof(rptr_out));
+    }
+}
+
+#endif /* CFG_TM_CTL */
+
+#endif /* _TM_CTL_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
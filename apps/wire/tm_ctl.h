@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/tm_ctl.h
+ * @brief         Run time reconfiguration of the NBI traffic manager
+ *
+ * Shaper rates and scheduler weights are changed while traffic flows by
+ * a single context on the service ME, the only writer of these TM
+ * registers once the NBI is initialised.  The host posts requests in a
+ * mailbox ring: it writes a request into slot wptr % TM_CTL_MBOX_ENTRIES
+ * and then increments tm_ctl_mbox_wptr, the context applies the requests
+ * in order and advances tm_ctl_mbox_rptr.  The host must not get more
+ * than TM_CTL_MBOX_ENTRIES requests ahead of the read pointer.
+ *
+ * Rates are given in Mbps and bursts in bytes, the context converts them
+ * to the register encodings.  A request touches a single shaper or
+ * scheduler and is checked in full before any register is written, the
+ * weights of all inputs of a scheduler go out in one command.  The
+ * registers are read back and a report with the sequence number of the
+ * request, the outcome and the time it took effect is appended to the
+ * tm_ctl_done host ring (see tools/tm_ctl.py).
+ */
+
+#ifndef _TM_CTL_H_
+#define _TM_CTL_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* Requests in the mailbox ring and reports in the done ring, powers of 2 */
+#ifndef TM_CTL_MBOX_ENTRIES
+#define TM_CTL_MBOX_ENTRIES     64
+#endif
+
+#ifndef TM_CTL_DONE_ENTRIES
+#define TM_CTL_DONE_ENTRIES     256
+#endif
+
+/* PClk frequency in MHz, the shaper rate unit is 10 Mbps at 1 GHz */
+#ifndef TM_CTL_PCLK_MHZ
+#define TM_CTL_PCLK_MHZ         1000
+#endif
+
+/* Mailbox poll interval in ME cycles */
+#ifndef TM_CTL_POLL
+#define TM_CTL_POLL             8192
+#endif
+
+/* Service ME context running tm_ctl_loop() */
+#ifndef TM_CTL_CTX
+#define TM_CTL_CTX              6
+#endif
+
+/**
+ * Request types
+ */
+enum tm_ctl_op {
+    TM_CTL_OP_SHAPER    = 1,    /** Set the rate of a shaper */
+    TM_CTL_OP_SCHED     = 2,    /** Set the mode and weights of a scheduler */
+};
+
+/**
+ * Outcome of a request
+ */
+enum tm_ctl_status {
+    TM_CTL_ST_OK        = 0,    /** Applied and read back */
+    TM_CTL_ST_BAD_OP    = 1,    /** Unknown request type */
+    TM_CTL_ST_BAD_NODE  = 2,    /** No such NBI, level or node */
+    TM_CTL_ST_BAD_ARG   = 3,    /** Rate, burst or weight out of range */
+    TM_CTL_ST_VERIFY    = 4,    /** Read back differs from the request */
+};
+
+#define TM_CTL_NUM_L2           128
+#define TM_CTL_NUM_L1           16
+#define TM_CTL_SCHED_INPUTS     8
+
+#define TM_CTL_RATE_MAX         12000
+#define TM_CTL_WEIGHT_MAX       0xffffff
+
+/**
+ * Mailbox request, written by the host.
+ *
+ * A TM_CTL_OP_SHAPER request sets shaper @node of @level (0 is the NBI
+ * shaper, 1 and 2 the shaper of level 1 or level 2 scheduler @node).
+ * The rate is rounded down to the register unit, the threshold and the
+ * maximum overshoot up to the next register code.  A zero overshoot
+ * picks the code of the threshold.
+ *
+ * A TM_CTL_OP_SCHED request sets the weights of all inputs of level 1 or
+ * 2 scheduler @node and its mode: @sp inputs (0-2) in strict priority,
+ * the others in DWRR if @dwrr is set.  The weights of strict priority
+ * inputs are ignored.
+ */
+struct tm_ctl_req {
+    union {
+        struct {
+            unsigned int op:4;          /** enum tm_ctl_op */
+            unsigned int nbi:1;         /** NBI */
+            unsigned int level:2;       /** TM level of the node */
+            unsigned int sp:2;          /** SCHED: strict priority inputs */
+            unsigned int dwrr:1;        /** SCHED: DWRR on the others */
+            unsigned int resv:14;       /** Reserved */
+            unsigned int node:8;        /** Scheduler or shaper */
+
+            uint32_t seq;               /** Host tag, echoed in the report */
+
+            union {
+                struct {
+                    uint32_t rate;      /** Mbps */
+                    uint32_t burst;     /** Threshold in bytes */
+                    uint32_t overshoot; /** Maximum overshoot in bytes */
+                    int32_t adjust;     /** Bytes ignored per packet */
+                } shaper;
+                uint32_t weight[TM_CTL_SCHED_INPUTS];
+            };
+
+            uint32_t resv2[2];          /** Reserved */
+        };
+        uint32_t __raw[12];
+    };
+};
+
+/**
+ * Report of an applied request in the done ring
+ */
+struct tm_ctl_rep {
+    union {
+        struct {
+            unsigned int op:4;          /** enum tm_ctl_op */
+            unsigned int nbi:1;         /** NBI */
+            unsigned int level:2;       /** TM level of the node */
+            unsigned int resv:13;       /** Reserved */
+            unsigned int status:4;      /** enum tm_ctl_status */
+            unsigned int node:8;        /** Scheduler or shaper */
+
+            uint32_t seq;               /** Tag of the request */
+            uint32_t ts_hi;             /** ME timestamp when applied */
+            uint32_t ts_lo;
+            uint32_t reg;               /** SHAPER: rate register value */
+            uint32_t resv2[2];          /** Reserved */
+            uint32_t ring_seq;          /** Ring sequence number */
+        };
+        uint32_t __raw[8];
+    };
+};
+
+/**
+ * Counters
+ */
+struct tm_ctl_cntrs {
+    uint64_t applied;           /** Requests applied */
+    uint64_t rejected;          /** Requests with bad arguments */
+    uint64_t verify;            /** Requests not read back as written */
+};
+
+/**
+ * Shaper rate register value of @rate Mbps, rounded down, 0 if out of range
+ */
+uint32_t tm_ctl_rate_reg(uint32_t rate);
+
+/**
+ * Mailbox loop, never returns.  Meant to be run by a single context on
+ * the service ME.
+ */
+void tm_ctl_loop(void);
+
+#endif /* _TM_CTL_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
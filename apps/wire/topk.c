@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/topk.c
+ * @brief         Space-saving top-K flow tracking
+ */
+
+#ifndef _TOPK_C_
+#define _TOPK_C_
+
+#include "config.h"
+
+#ifdef CFG_TOPK
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/mem_cam.h>
+#include <std/hash.h>
+#include <std/reg_utils.h>
+
+#include "flow_hash.h"
+#include "topk.h"
+
+__export __emem __align64 struct topk_bucket topk_tbl[TOPK_BANKS]
+                                                     [TOPK_NUM_ISL]
+                                                     [TOPK_BUCKETS];
+
+/* Epoch each bank of an island was cleared for */
+__export __emem uint32_t topk_bank_epoch[TOPK_NUM_ISL][TOPK_BANKS];
+
+/* Latest epoch seen by any ME, for the host */
+__export __emem uint32_t topk_epoch;
+
+/*
+ * Epoch and bank of this ME, the bank is only read by topk_pkt() after
+ * the epoch check.  The context that finds a new epoch stores both before
+ * the first EMEM access of topk_new_epoch().
+ */
+__shared __lmem uint32_t topk_cur_epoch;
+__shared __lmem uint32_t topk_cur_bank;
+
+#define TOPK_HASH_SEED          0x746f706b
+
+#define TOPK_ISL_IDX            ((__ISLAND - TOPK_ISL_BASE) & \
+                                 (TOPK_NUM_ISL - 1))
+
+
+/*
+ * Make sure bank @bank of this island is clear for epoch @epoch.  Only
+ * the signatures and counts are cleared, keys are written on insert.
+ *
+ * The first ME to swap the new epoch into the tag clears the bank, the
+ * others see the tag already set and go on.  The next bank is cleared an
+ * epoch ahead, so only a bank that missed that (the first epoch, or after
+ * an idle epoch) can still be cleared while other MEs count into it.
+ */
+__intrinsic static void
+topk_bank_prepare(unsigned int bank, uint32_t epoch)
+{
+    __xread uint32_t tag_in;
+    __xrw uint32_t tag;
+    __xwrite uint32_t zero[8];
+    __gpr unsigned int b;
+    __gpr unsigned int i;
+    __mem40 struct topk_bucket *bkt;
+
+    mem_read32(&tag_in, &topk_bank_epoch[TOPK_ISL_IDX][bank], sizeof(tag_in));
+    if (tag_in == epoch)
+        return;
+
+    tag = epoch;
+    mem_swap(&tag, &topk_bank_epoch[TOPK_ISL_IDX][bank], sizeof(tag));
+    if (tag == epoch)
+        return;
+
+    reg_zero(zero, sizeof(zero));
+    for (b = 0; b < TOPK_BUCKETS; b++) {
+        bkt = &topk_tbl[bank][TOPK_ISL_IDX][b];
+        for (i = 0; i < 4 * TOPK_BUCKET_SZ; i += 8)
+            mem_write32(zero, &bkt->sig[i], sizeof(zero));
+    }
+}
+
+__intrinsic static void
+topk_new_epoch(uint32_t epoch)
+{
+    __xwrite uint32_t epoch_out;
+    __gpr unsigned int bank;
+
+    bank = epoch % TOPK_BANKS;
+    topk_cur_bank = bank;
+
+    topk_bank_prepare(bank, epoch);
+    topk_bank_prepare((bank + 1) % TOPK_BANKS, epoch + 1);
+
+    epoch_out = epoch;
+    mem_write32(&epoch_out, &topk_epoch, sizeof(epoch_out));
+}
+
+/*
+ * Replace the smallest counter of a bucket with a new flow
+ */
+__intrinsic static void
+topk_replace(__mem40 struct topk_bucket *bkt, __lmem uint32_t *key,
+             uint32_t sig, unsigned int len)
+{
+    __xread uint32_t bytes_in[TOPK_BUCKET_SZ];
+    __xwrite uint32_t key_out[4];
+    __xwrite uint32_t val;
+    __lmem uint32_t bytes[TOPK_BUCKET_SZ];
+    __gpr unsigned int i;
+    __gpr unsigned int slot;
+    __gpr uint32_t min;
+
+    mem_read32(bytes_in, bkt->bytes, sizeof(bytes_in));
+    reg_cp(bytes, bytes_in, sizeof(bytes));
+
+    slot = 0;
+    min = bytes[0];
+    for (i = 1; i < TOPK_BUCKET_SZ; i++) {
+        if (bytes[i] < min) {
+            min = bytes[i];
+            slot = i;
+        }
+    }
+
+    reg_cp(key_out, key, sizeof(key_out));
+    mem_write32(key_out, bkt->key[slot], sizeof(key_out));
+    val = min;
+    mem_write32(&val, &bkt->err[slot], sizeof(val));
+    val = min + len;
+    mem_write32(&val, &bkt->bytes[slot], sizeof(val));
+    val = 1;
+    mem_write32(&val, &bkt->pkts[slot], sizeof(val));
+
+    /* The flow becomes visible to lookups last */
+    val = sig;
+    mem_write32(&val, &bkt->sig[slot], sizeof(val));
+}
+
+__intrinsic void
+topk_pkt(__lmem uint32_t *key, unsigned int len)
+{
+    __xrw struct mem_cam_32bit cam;
+    __gpr uint32_t epoch;
+    __gpr uint32_t sig;
+    __gpr unsigned int slot;
+    __mem40 struct topk_bucket *bkt;
+
+    if (local_csr_read(local_csr_pseudo_random_number) &
+        ((1 << TOPK_SAMPLE_SHF) - 1))
+        return;
+
+    epoch = me_tsc_read() >> TOPK_EPOCH_SHF;
+    if (epoch != topk_cur_epoch) {
+        topk_cur_epoch = epoch;
+        topk_new_epoch(epoch);
+    }
+
+    sig = hash_me_crc32(key, FLOW_KEY_WORDS * 4, TOPK_HASH_SEED);
+    if (sig == 0)
+        sig = 1;
+    bkt = &topk_tbl[topk_cur_bank][TOPK_ISL_IDX][sig & (TOPK_BUCKETS - 1)];
+
+    cam.search.value = sig;
+    mem_cam_lookup(&cam, bkt->sig, 512, 32);
+    if (!mem_cam_lookup_hit(cam)) {
+        topk_replace(bkt, key, sig, len);
+        return;
+    }
+
+    slot = cam.result.match;
+    mem_add32_imm(len, &bkt->bytes[slot]);
+    mem_add32_imm(1, &bkt->pkts[slot]);
+}
+
+#endif /* CFG_TOPK */
+
+#endif /* _TOPK_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/topk.h
+ * @brief         Space-saving top-K flow tracking
+ *
+ * Each island tracks the largest IPv4 flows (by bytes) of a sample of its
+ * packets in a space-saving table of TOPK_K counters.  A packet is
+ * sampled with probability 2^-TOPK_SAMPLE_SHF using the ME pseudo random
+ * number CSR, packets that are not sampled cost a CSR read and a test.
+ *
+ * The table is split into buckets of 16 counters by flow hash and the
+ * flow signatures of a bucket are looked up with the MU CAM.  A flow that
+ * is not in its bucket replaces the smallest counter of the bucket, which
+ * it inherits as its error bound (space-saving per bucket).  Estimates
+ * never undercount the sampled bytes of a flow that stays in the table.
+ *
+ * Like the HyperLogLog registers (hll.h), the tables rotate through
+ * TOPK_BANKS banks on a fixed epoch: the bank of the previous epoch is a
+ * complete snapshot for the host (tools/topk_read.py) and the bank of the
+ * next epoch is cleared ahead of time by the first ME of the island to
+ * see the epoch change, the others find it claimed and do not clear it
+ * again.
+ */
+
+#ifndef _TOPK_H_
+#define _TOPK_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+/* log2 of the counters per island, from 64 (6) to 1024 (10) */
+#ifndef TOPK_K_SHF
+#define TOPK_K_SHF              8
+#endif
+
+#if TOPK_K_SHF < 6 || TOPK_K_SHF > 10
+#error "TOPK_K_SHF must be between 6 and 10"
+#endif
+
+#define TOPK_K                  (1 << TOPK_K_SHF)
+#define TOPK_BUCKET_SZ          16
+#define TOPK_BUCKETS            (TOPK_K / TOPK_BUCKET_SZ)
+
+/* One in 2^TOPK_SAMPLE_SHF packets updates the table */
+#ifndef TOPK_SAMPLE_SHF
+#define TOPK_SAMPLE_SHF         6
+#endif
+
+/* Epoch length, 2^28 ticks is about 5.4 s at 800 MHz */
+#ifndef TOPK_EPOCH_SHF
+#define TOPK_EPOCH_SHF          28
+#endif
+
+#define TOPK_BANKS              3
+
+/* Islands running the packet path */
+#ifndef TOPK_ISL_BASE
+#define TOPK_ISL_BASE           32
+#endif
+
+#ifndef TOPK_NUM_ISL
+#define TOPK_NUM_ISL            8
+#endif
+
+/**
+ * Bucket of the space-saving table.  Counts are of sampled packets.
+ */
+struct topk_bucket {
+    uint32_t sig[TOPK_BUCKET_SZ];       /** CAM of flow hashes, 0 is free */
+    uint32_t bytes[TOPK_BUCKET_SZ];     /** Sampled bytes */
+    uint32_t err[TOPK_BUCKET_SZ];       /** Bytes inherited on replace */
+    uint32_t pkts[TOPK_BUCKET_SZ];      /** Sampled packets */
+    uint32_t key[TOPK_BUCKET_SZ][4];    /** Flow keys, see flow_hash.h */
+};
+
+/**
+ * Add a packet to the top-K table of the island, if sampled.
+ * @param key       Flow key of the packet (flow_key_frame())
+ * @param len       Frame length in bytes
+ */
+__intrinsic void topk_pkt(__lmem uint32_t *key, unsigned int len);
+
+#endif /* _TOPK_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/vxlan.c
+ * @brief         VXLAN tunnel termination and origination
+ */
+
+#ifndef _VXLAN_C_
+#define _VXLAN_C_
+
+#include "config.h"
+
+#ifdef CFG_VXLAN
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/csum.h>
+#include <net/eth.h>
+#include <net/ip.h>
+#include <net/udp.h>
+#include <net/vxlan.h>
+#include <net/hdr_ext.h>
+#include <nfp/cls.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/mem_cam.h>
+#include <std/reg_utils.h>
+
+#include "flow_hash.h"
+#include "vxlan.h"
+
+/* Per ingress port configuration */
+__export __emem struct vxlan_port_cfg vxlan_port_cfg[VXLAN_NUM_PORTS];
+
+/* VNI CAM buckets and the entries matching the CAM slots */
+__export __emem __align64 uint32_t vxlan_vni_cam[VXLAN_VNI_BUCKETS]
+                                                [VXLAN_VNI_BUCKET_SZ];
+__export __emem struct vxlan_vni_entry vxlan_vni_tbl[VXLAN_NUM_VNI];
+
+/* Outer header templates, one copy per island */
+__export __shared __cls __align64 struct vxlan_tmpl vxlan_tmpl[VXLAN_NUM_TMPL];
+
+__export __emem struct vxlan_vni_cntrs vxlan_vni_cntrs[VXLAN_NUM_VNI];
+__export __emem struct vxlan_cntrs vxlan_cntrs;
+
+/*
+ * Frames are read at a two byte offset so that the IP header is word
+ * aligned, see pkt_count.c
+ */
+#define VXLAN_START_OFF         2
+#define VXLAN_BUF_SZ            FLOW_HASH_BUF_SZ
+
+/* Bucket of a VNI in the CAM, must match tools/vxlan_ctl.py */
+#define VXLAN_VNI_BUCKET(_vni) \
+    (((_vni) ^ ((_vni) >> 8) ^ ((_vni) >> 16)) & (VXLAN_VNI_BUCKETS - 1))
+
+struct vxlan_hdrs {
+    union {
+        struct eth_hdr   eth;
+        struct vlan_hdr  vlan;
+        struct ip4_hdr   ip4;
+        struct udp_hdr   udp;
+        struct vxlan_hdr vxlan;
+    };
+};
+
+
+/*
+ * Look up a VNI.  Returns the index of its entry or -1 if not found.
+ */
+__intrinsic static int
+vxlan_vni_lookup(unsigned int vni)
+{
+    __xrw struct mem_cam_24bit cam;
+    __xread struct vxlan_vni_entry entry;
+    __gpr unsigned int bucket;
+    __gpr int idx;
+
+    bucket = VXLAN_VNI_BUCKET(vni);
+    cam.search.value = vni;
+    mem_cam_lookup(&cam, vxlan_vni_cam[bucket], 512, 24);
+    if (!mem_cam_lookup_hit(cam))
+        return -1;
+
+    idx = bucket * VXLAN_VNI_BUCKET_SZ + cam.result.match;
+    mem_read32(&entry, &vxlan_vni_tbl[idx], sizeof(entry));
+    if (!entry.valid || entry.vni != vni)
+        return -1;
+
+    return idx;
+}
+
+/*
+ * Strip the outer headers of a VXLAN frame held in @buf (read from
+ * @l2_off - VXLAN_START_OFF).
+ */
+__intrinsic static enum vxlan_res
+vxlan_decap(__lmem uint32_t *buf, unsigned int *l2_off, unsigned int *len)
+{
+    __gpr struct vxlan_hdrs h;
+    __gpr int off = VXLAN_START_OFF;
+    __gpr int res;
+    __gpr int next_proto;
+    __gpr int idx;
+    __gpr unsigned int outer_len;
+    __mem40 struct vxlan_vni_cntrs *cntrs;
+
+    res = he_eth(buf, off, &h.eth);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto == HE_8021Q) {
+        res = he_vlan(buf, off, &h.vlan);
+        next_proto = HE_RES_PROTO_of(res);
+        off += HE_RES_LEN_of(res);
+    }
+
+    if (next_proto != HE_IP4)
+        return VXLAN_RES_NONE;
+
+    res = he_ip4(buf, off, &h.ip4);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto != HE_UDP)
+        return VXLAN_RES_NONE;
+
+    /* Fragments can not be terminated, leave them to the host */
+    if (NET_IP_IS_FRAG(h.ip4.frag) || !he_udp_fit(VXLAN_BUF_SZ, off))
+        goto bad_hdr;
+
+    res = he_udp(buf, off, &h.udp, VXLAN_UDP_PORT);
+    next_proto = HE_RES_PROTO_of(res);
+    off += HE_RES_LEN_of(res);
+
+    if (next_proto != HE_VXLAN)
+        return VXLAN_RES_NONE;
+
+    if (!he_vxlan_fit(VXLAN_BUF_SZ, off))
+        goto bad_hdr;
+
+    res = he_vxlan(buf, off, &h.vxlan);
+    off += HE_RES_LEN_of(res);
+
+    if (!h.vxlan.i)
+        goto bad_hdr;
+
+    idx = vxlan_vni_lookup(h.vxlan.vni);
+    if (idx < 0) {
+        mem_incr64(&vxlan_cntrs.unknown_vni);
+        return VXLAN_RES_DROP;
+    }
+
+    outer_len = off - VXLAN_START_OFF;
+    *l2_off += outer_len;
+    *len -= outer_len;
+
+    cntrs = &vxlan_vni_cntrs[idx];
+    mem_incr64(&cntrs->decap_pkts);
+    mem_add64_imm(*len, &cntrs->decap_bytes);
+
+    return VXLAN_RES_DECAP;
+
+bad_hdr:
+    mem_incr64(&vxlan_cntrs.bad_hdr);
+    return VXLAN_RES_NONE;
+}
+
+/*
+ * Write the outer headers of VNI entry @idx in front of the frame.
+ */
+__intrinsic static enum vxlan_res
+vxlan_encap(__mem40 char *pbuf, __lmem uint32_t *buf, unsigned int idx,
+            unsigned int *l2_off, unsigned int *len)
+{
+    __xread struct vxlan_vni_entry entry;
+    __xread uint32_t tmpl_in[VXLAN_TMPL_WORDS];
+    __xwrite uint32_t tmpl_out[VXLAN_TMPL_WORDS];
+    __gpr uint32_t tmpl[VXLAN_TMPL_WORDS];
+    __gpr unsigned int ip_len;
+    __gpr unsigned int csum;
+    __gpr unsigned int sport;
+    __mem40 struct vxlan_vni_cntrs *cntrs;
+
+    mem_read32(&entry, &vxlan_vni_tbl[idx], sizeof(entry));
+    if (!entry.valid || entry.tmpl >= VXLAN_NUM_TMPL) {
+        mem_incr64(&vxlan_cntrs.bad_encap);
+        return VXLAN_RES_NONE;
+    }
+
+    cls_read(tmpl_in, &vxlan_tmpl[entry.tmpl], sizeof(tmpl_in));
+    reg_cp(tmpl, tmpl_in, sizeof(tmpl));
+
+    /* Patch the per packet fields */
+    ip_len = *len + VXLAN_ENCAP_LEN - NET_ETH_LEN;
+    tmpl[VXLAN_TMPL_IP_LEN_W] |= ip_len;
+    csum = net_csum_mod(tmpl[VXLAN_TMPL_IP_CSUM_W] & 0xffff, 0, ip_len);
+    tmpl[VXLAN_TMPL_IP_CSUM_W] =
+        (tmpl[VXLAN_TMPL_IP_CSUM_W] & 0xffff0000) | csum;
+    sport = VXLAN_SPORT_BASE +
+        (flow_hash_frame(buf, VXLAN_START_OFF) & VXLAN_SPORT_MASK);
+    tmpl[VXLAN_TMPL_UDP_PORT_W] |= sport << 16;
+    tmpl[VXLAN_TMPL_UDP_LEN_W] = (ip_len - sizeof(struct ip4_hdr)) << 16;
+
+    reg_cp(tmpl_out, tmpl, sizeof(tmpl));
+    mem_write32(tmpl_out,
+                pbuf + *l2_off - VXLAN_ENCAP_LEN - VXLAN_TMPL_PAD,
+                sizeof(tmpl_out));
+
+    cntrs = &vxlan_vni_cntrs[idx];
+    mem_incr64(&cntrs->encap_pkts);
+    mem_add64_imm(*len, &cntrs->encap_bytes);
+
+    *l2_off -= VXLAN_ENCAP_LEN;
+    *len += VXLAN_ENCAP_LEN;
+
+    return VXLAN_RES_ENCAP;
+}
+
+__intrinsic enum vxlan_res
+vxlan_pkt(__mem40 char *pbuf, unsigned int *l2_off, unsigned int *len,
+          unsigned int port)
+{
+    __xread struct vxlan_port_cfg cfg;
+    __xread uint32_t pkt_buf[VXLAN_BUF_SZ / 4];
+    __lmem uint32_t buf[VXLAN_BUF_SZ / 4];
+
+    mem_read32(&cfg, &vxlan_port_cfg[port & (VXLAN_NUM_PORTS - 1)],
+               sizeof(cfg));
+    if (!cfg.decap && !cfg.encap)
+        return VXLAN_RES_NONE;
+
+    mem_read64(pkt_buf, pbuf + *l2_off - VXLAN_START_OFF, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+
+    if (cfg.decap)
+        return vxlan_decap(buf, l2_off, len);
+
+    return vxlan_encap(pbuf, buf, cfg.vni_idx, l2_off, len);
+}
+
+#endif /* CFG_VXLAN */
+
+#endif /* _VXLAN_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/vxlan.h
+ * @brief         VXLAN tunnel termination and origination
+ *
+ * Decapsulation strips the outer Ethernet/IPv4/UDP/VXLAN headers by
+ * moving the start of the packet forward, the packet data is not copied.
+ * The VNI must be present in the VNI table, packets for unknown VNIs are
+ * dropped.
+ *
+ * Encapsulation writes a precomputed outer header template from CLS into
+ * the headroom in front of the frame and moves the start of the packet
+ * back.  Only the IP total length, IP header checksum, UDP length and UDP
+ * source port (a hash of the inner flow) are patched per packet.  The UDP
+ * checksum is left at zero.
+ *
+ * Tunnel behaviour is configured per ingress port (see tools/vxlan_ctl.py).
+ */
+
+#ifndef _VXLAN_H_
+#define _VXLAN_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/vxlan.h>
+
+#ifndef VXLAN_UDP_PORT
+#define VXLAN_UDP_PORT          NET_VXLAN_PORT
+#endif
+
+#ifndef VXLAN_NUM_PORTS
+#define VXLAN_NUM_PORTS         64
+#endif
+
+/*
+ * The VNI table is a hash of 512 bit CAM buckets holding 16 VNIs each.
+ * VNI 0 is reserved to mark empty CAM slots.
+ */
+#ifndef VXLAN_VNI_BUCKETS
+#define VXLAN_VNI_BUCKETS       256
+#endif
+
+#define VXLAN_VNI_BUCKET_SZ     16
+#define VXLAN_NUM_VNI           (VXLAN_VNI_BUCKETS * VXLAN_VNI_BUCKET_SZ)
+
+#if (VXLAN_VNI_BUCKETS & (VXLAN_VNI_BUCKETS - 1)) != 0
+#error "VXLAN_VNI_BUCKETS must be a power of 2"
+#endif
+
+/* Number of outer header templates per island (in CLS) */
+#ifndef VXLAN_NUM_TMPL
+#define VXLAN_NUM_TMPL          64
+#endif
+
+/*
+ * Outer header template: 2 bytes of padding followed by the outer
+ * Ethernet (no VLAN), IPv4 (no options), UDP and VXLAN headers.  The
+ * padding keeps the IPv4 header word aligned.  The IP total length and
+ * the UDP length, source port and checksum must be zero in the template,
+ * the IP header checksum must be computed over the template.
+ */
+#define VXLAN_ENCAP_LEN         (14 + 20 + 8 + 8)
+#define VXLAN_TMPL_PAD          2
+#define VXLAN_TMPL_WORDS        ((VXLAN_TMPL_PAD + VXLAN_ENCAP_LEN) / 4)
+
+/* Word index of the patched fields in a template */
+#define VXLAN_TMPL_IP_LEN_W     4       /* ver/hl/tos/len */
+#define VXLAN_TMPL_IP_CSUM_W    6       /* ttl/proto/csum */
+#define VXLAN_TMPL_UDP_PORT_W   9       /* sport/dport */
+#define VXLAN_TMPL_UDP_LEN_W    10      /* len/csum */
+
+/* UDP source port range used for the inner flow entropy (RFC 7348) */
+#define VXLAN_SPORT_BASE        0xc000
+#define VXLAN_SPORT_MASK        0x3fff
+
+struct vxlan_tmpl {
+    uint32_t __raw[16];
+};
+
+/**
+ * Per VNI entry, indexed by the CAM bucket and slot of the VNI.
+ */
+struct vxlan_vni_entry {
+    union {
+        struct {
+            unsigned int valid:1;       /** Entry in use */
+            unsigned int resv0:7;       /** Reserved */
+            unsigned int vni:24;        /** VNI of the entry */
+
+            unsigned int tenant:16;     /** Tenant identifier */
+            unsigned int tmpl:16;       /** Encap template index */
+        };
+        uint32_t __raw[2];
+    };
+};
+
+/**
+ * Per ingress port tunnel configuration
+ */
+struct vxlan_port_cfg {
+    union {
+        struct {
+            unsigned int decap:1;       /** Terminate VXLAN on this port */
+            unsigned int encap:1;       /** Encapsulate frames from port */
+            unsigned int resv:14;       /** Reserved */
+            unsigned int vni_idx:16;    /** VNI entry used for encap */
+        };
+        uint32_t __raw;
+    };
+};
+
+/**
+ * Per VNI entry counters
+ */
+struct vxlan_vni_cntrs {
+    uint64_t decap_pkts;        /** Packets decapsulated */
+    uint64_t decap_bytes;       /** Inner bytes decapsulated */
+    uint64_t encap_pkts;        /** Packets encapsulated */
+    uint64_t encap_bytes;       /** Inner bytes encapsulated */
+};
+
+/**
+ * Global counters
+ */
+struct vxlan_cntrs {
+    uint64_t unknown_vni;       /** Dropped, VNI not in the table */
+    uint64_t bad_hdr;           /** Passed, outer headers not handled */
+    uint64_t bad_encap;         /** Passed, invalid encap configuration */
+};
+
+/**
+ * Return values of vxlan_pkt()
+ */
+enum vxlan_res {
+    VXLAN_RES_NONE  = 0,        /** Packet not modified */
+    VXLAN_RES_DECAP = 1,        /** Outer headers removed */
+    VXLAN_RES_ENCAP = 2,        /** Outer headers added */
+    VXLAN_RES_DROP  = 3,        /** Packet must be dropped */
+};
+
+/**
+ * Apply the VXLAN configuration of the ingress port to a frame.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header, updated on decap/encap
+ * @param len       Length of the frame, updated on decap/encap
+ * @param port      Ingress port
+ * @return          One of enum vxlan_res
+ *
+ * On encapsulation @l2_off must be word aligned and leave room for
+ * VXLAN_ENCAP_LEN bytes of headers plus the MAC egress command and
+ * modification script in front of the frame.
+ */
+__intrinsic enum vxlan_res vxlan_pkt(__mem40 char *pbuf, unsigned int *l2_off,
+                                     unsigned int *len, unsigned int port);
+
+#endif /* _VXLAN_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #include <nfp/me.h>
+#include <nfp/mem_bulk.h>
 #include <nfp6000/nfp_me.h>
 #include <pkt/pkt.h>
 #include <std/reg_utils.h>
@@ -38,6 +39,84 @@
 
 #include "config.h"
 
+#ifdef CFG_POLICER
+#include "policer.h"
+#endif
+
+#ifdef CFG_STORM_CTRL
+#include "storm.h"
+#endif
+
+#ifdef CFG_VXLAN
+#include "vxlan.h"
+#endif
+
+#ifdef CFG_GRE
+#include "gre.h"
+#endif
+
+#ifdef CFG_MPLS
+#include "mpls_lsr.h"
+#endif
+
+#ifdef CFG_BRIDGE
+#include "bridge.h"
+#endif
+
+#ifdef CFG_REPLICATION
+#include "rep.h"
+#endif
+
+#ifdef CFG_MIRROR
+#include "mirror.h"
+#endif
+
+#ifdef CFG_CONNTRACK
+#include "conntrack.h"
+#endif
+
+#ifdef CFG_CMS
+#include "cms.h"
+#endif
+
+#ifdef CFG_HLL
+#include "hll.h"
+#endif
+
+#ifdef CFG_TOPK
+#include "topk.h"
+#endif
+
+#ifdef CFG_SFLOW
+#include "sflow.h"
+#endif
+
+#ifdef CFG_FLOWREC
+#include "flowrec.h"
+#endif
+
+#ifdef CFG_WRED
+#include "wred.h"
+#endif
+
+#ifdef CFG_QOS
+#include "qos.h"
+
+#if TMQ_HASH_QUEUES > 1
+#error "CFG_QOS picks the queue of a port, TMQ_HASH_QUEUES must be 1"
+#endif
+#endif
+
+#if defined(CFG_REPLICATION) || defined(CFG_MIRROR)
+#define CFG_TX_DESC
+#endif
+
+#if defined(CFG_CMS) || defined(CFG_HLL) || defined(CFG_TOPK) || \
+    defined(CFG_FLOWREC)
+#define CFG_MONITOR
+#include "flow_hash.h"
+#endif
+
 
 /* Counters */
 __export __emem struct pkt_cnt_if cntrs_if0;
@@ -56,6 +135,150 @@ proc_rx(__mem40 char *pbuf, int pkt_off, int port)
     pkt_count_rx(pbuf, pkt_off, cntrs);
 }
 
+/*
+ * Run the optional tunnel stages on a packet.  @l2_off and @len are the
+ * offset and length of the Ethernet frame and are updated if headers are
+ * added or removed.  @hash is set to the inner flow hash of terminated
+ * tunnels.  Returns non-zero if the packet must be dropped.
+ */
+__intrinsic int
+proc_tunnel(__mem40 char *pbuf, unsigned int *l2_off, unsigned int *len,
+            int port, uint32_t *hash)
+{
+#ifdef CFG_GRE
+    if (gre_pkt(pbuf, l2_off, len, port, hash) == GRE_RES_DECAP)
+        return 0;
+#endif
+
+#ifdef CFG_VXLAN
+    if (vxlan_pkt(pbuf, l2_off, len, port) == VXLAN_RES_DROP)
+        return 1;
+#endif
+
+#ifdef CFG_MPLS
+    if (mpls_pkt(pbuf, l2_off, len) == MPLS_RES_DROP)
+        return 1;
+#endif
+
+    return 0;
+}
+
+#ifdef CFG_MONITOR
+/*
+ * Run the optional monitoring stages on a packet.  The start of the frame
+ * is read once and the flow key extracted for all stages.
+ */
+__intrinsic void
+proc_monitor(__mem40 char *pbuf, int l2_off, int len, int port)
+{
+    __xread uint32_t pkt_buf[FLOW_HASH_BUF_SZ / 4];
+    __lmem uint32_t buf[FLOW_HASH_BUF_SZ / 4];
+    __lmem uint32_t key[FLOW_KEY_WORDS];
+    __gpr int l4_off;
+
+    /* Read at a two byte offset to word align the IP header */
+    mem_read64(pkt_buf, pbuf + l2_off - 2, sizeof(pkt_buf));
+    reg_cp(buf, pkt_buf, sizeof(buf));
+    l4_off = flow_key_frame(buf, 2, key);
+
+#ifdef CFG_CMS
+    if (l4_off)
+        cms_pkt(key, len, port);
+#endif
+
+#ifdef CFG_HLL
+    if (l4_off)
+        hll_pkt(key, port);
+#endif
+
+#ifdef CFG_TOPK
+    if (l4_off)
+        topk_pkt(key, len);
+#endif
+
+#ifdef CFG_FLOWREC
+    if (l4_off)
+        fr_pkt(buf, l4_off, key, len, port);
+#endif
+}
+#endif
+
+/*
+ * Run the optional filtering stages on a packet.  @l2_off and @len are
+ * the offset and length of the Ethernet frame.  Returns non-zero if the
+ * packet must be dropped.
+ */
+__intrinsic int
+proc_filter(__mem40 char *pbuf, int l2_off, int len, int port)
+{
+#ifdef CFG_POLICER
+    __gpr unsigned int meter;
+#endif
+
+#ifdef CFG_STORM_CTRL
+    if (storm_pkt(port, storm_classify(pbuf, l2_off), len))
+        return 1;
+#endif
+
+#ifdef CFG_CONNTRACK
+    if (ct_pkt(pbuf, l2_off, port) == CT_RES_DROP)
+        return 1;
+#endif
+
+#ifdef CFG_POLICER
+#ifdef CFG_POLICER_PER_FLOW
+    meter = policer_flow_meter(pbuf, l2_off, port);
+#else
+    meter = POLICER_PORT_METER(port);
+#endif
+    if (policer_pkt(meter, pbuf, l2_off, len))
+        return 1;
+#endif
+
+    return 0;
+}
+
+/*
+ * Run the optional forwarding stages on a packet, which may replace the
+ * default egress port in @out_port or set the ports the packet must be
+ * replicated to in @rep_ports.  Returns non-zero if the packet must be
+ * dropped.
+ */
+__intrinsic int
+proc_fwd(__mem40 char *pbuf, int l2_off, int len, int port, int *out_port,
+         uint64_t *rep_ports)
+{
+#ifdef CFG_BRIDGE
+    __gpr enum bridge_res res;
+    __gpr uint64_t ports;
+#endif
+
+#ifdef CFG_BRIDGE
+    res = bridge_pkt(pbuf, l2_off, port, &ports);
+    if (res == BRIDGE_RES_NONE)
+        return 0;
+    if (res == BRIDGE_RES_DROP)
+        return 1;
+
+#ifdef CFG_STORM_CTRL
+    if (res == BRIDGE_RES_FLOOD_UUC &&
+        storm_pkt(port, STORM_CLS_UUC, len))
+        return 1;
+#endif
+
+#ifdef CFG_REPLICATION
+    /* Flooded frames are copied to all ports of the VLAN */
+    if (res != BRIDGE_RES_FWD)
+        *rep_ports = ports;
+#endif
+
+    /* Without replication only the lowest port of the VLAN is flooded */
+    *out_port = ffs64(ports);
+#endif
+
+    return 0;
+}
+
 int
 main(void)
 {
@@ -67,13 +290,31 @@ main(void)
     __gpr enum PKT_CTM_SIZE ctm_buf_size;
     __xread pkt_status_t pkt_status;
     __gpr int in_port, out_port, pkt_off;
+    __gpr unsigned int l2_off, len;
+    __gpr uint32_t hash;
+    __gpr unsigned int qoff;
+    __gpr uint64_t rep_ports;
+    __gpr int drop;
+#ifdef CFG_TX_DESC
+    __gpr struct rep_pkt tx;
+#endif
+#ifdef CFG_MIRROR
+    __gpr int mirror;
+#endif
 
     /*
      * Endless loop
      *
      * 1. Get a packet from the wire (NBI)
-     * 2. Process the packet incrementing counters
-     * 4. Send the packet back to the wire (NBI)
+     * 2. Process the packet incrementing counters, optionally sampling it
+     * 3. Run the optional tunnel (GRE, VXLAN, MPLS), monitoring (count-min
+     *    sketch, HyperLogLog, top-K, flow records) and filtering (storm
+     *    control, conntrack, policer) stages
+     * 4. Select the egress port, optionally with the learning bridge, and
+     *    the TM queue, optionally by PCP/DSCP, then optionally apply
+     *    WRED/ECN marking for that queue
+     * 5. Send the packet back to the wire (NBI), optionally mirroring and
+     *    replicating it, or drop it
      */
     for (;;) {
         /* Receive a packet */
@@ -85,22 +326,96 @@ main(void)
         pkt_off = PKT_NBI_OFFSET;
         proc_rx(pbuf, pkt_off, in_port);
 
+        /* Offset and length of the Ethernet frame, stages may move it */
+        l2_off = pkt_off + MAC_PREPEND_BYTES;
+        len = pi->len - MAC_PREPEND_BYTES;
+
+        /* Default to the other port of the wire */
+        out_port = (in_port == WIRE_PORT_A) ? WIRE_PORT_B : WIRE_PORT_A;
+        rep_ports = 0;
+
+#ifdef CFG_SFLOW
+        /* Sample the frame as received */
+        sflow_pkt(pbuf, l2_off, len, in_port);
+#endif
+
+        hash = 0;
+        drop = proc_tunnel(pbuf, &l2_off, &len, in_port, &hash);
+#ifdef CFG_MONITOR
+        /* Monitor before filtering, so dropped traffic is seen as well */
+        if (!drop)
+            proc_monitor(pbuf, l2_off, len, in_port);
+#endif
+        if (!drop)
+            drop = proc_filter(pbuf, l2_off, len, in_port);
+        if (!drop)
+            drop = proc_fwd(pbuf, l2_off, len, in_port, &out_port,
+                            &rep_ports);
+
+        /* Egress TM queue within the queues of the port */
+#ifdef CFG_QOS
+        qoff = 0;
+        if (!drop)
+            qoff = qos_pkt(pbuf, l2_off, len, in_port, out_port);
+#else
+        qoff = hash & (TMQ_HASH_QUEUES - 1);
+#endif
+
+#ifdef CFG_WRED
+        /* Flooded frames go to many queues, only unicast is subject to it */
+        if (!drop && rep_ports == 0)
+            drop = wred_pkt(pbuf, l2_off, out_port, qoff);
+#endif
+
         /* Send the packet */
 
         /* Write the MAC egress CMD and adjust offset and len accordingly */
-        pkt_off += MAC_PREPEND_BYTES;
-        pkt_mac_egress_cmd_write(pbuf, pkt_off, 1, 1);
+        pkt_mac_egress_cmd_write(pbuf, l2_off, 1, 1);
 
-        pkt_off -= 4;
+        pkt_off = l2_off - 4;
         msi = pkt_msd_write(pbuf, pkt_off);
-        out_port = (in_port) ? 0 : 4;
-        pkt_nbi_send(pi->isl,
-                     pi->pnum,
-                     &msi,
-                     pi->len - MAC_PREPEND_BYTES + 4,
-                     NBI,
-                     PORT_TO_TMQ(out_port),
-                     nbi_meta.seqr, nbi_meta.seq, PKT_CTM_SIZE_256);
+        if (drop) {
+            /* Let the TM free the packet and release the sequence number */
+            pkt_nbi_drop_seq(pi->isl,
+                             pi->pnum,
+                             &msi,
+                             len + 4,
+                             NBI,
+                             PORT_TO_TMQ(out_port),
+                             nbi_meta.seqr, nbi_meta.seq, PKT_CTM_SIZE_256);
+        } else {
+#ifdef CFG_TX_DESC
+            tx.__raw[3] = 0;
+            tx.isl = pi->isl;
+            tx.pnum = pi->pnum;
+            tx.seqr = nbi_meta.seqr;
+            tx.seq = nbi_meta.seq;
+            tx.len = len + 4;
+            tx.msi = msi;
+            tx.qoff = qoff;
+#endif
+
+#ifdef CFG_MIRROR
+            /* The copy must be sent before the packet is freed */
+            mirror = mirror_pkt(pbuf, l2_off, in_port);
+            if (mirror >= 0)
+                mirror_send(mirror, &tx);
+#endif
+
+#ifdef CFG_REPLICATION
+            if (rep_ports != 0) {
+                rep_send(&tx, rep_ports);
+                continue;
+            }
+#endif
+            pkt_nbi_send(pi->isl,
+                         pi->pnum,
+                         &msi,
+                         len + 4,
+                         NBI,
+                         PORT_TO_TMQ(out_port) + qoff,
+                         nbi_meta.seqr, nbi_meta.seq, PKT_CTM_SIZE_256);
+        }
     }
 
     return 0;
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/wire_svc.c
+ * @brief         Service ME for the wire app
+ *
+ * Background work of the optional processing stages that must not run on
+ * the packet processing MEs.  Each context is assigned a single task, any
+ * context without a task is killed.  The default contexts do not overlap:
+ *
+ *   0-1  policer refill            4    replication worker
+ *   2    storm control refill      5    WRED depth poll
+ *   3    bridge learning           6    TM control
+ *                                  7    age wheel
+ */
+
+/* Flowenv */
+#include <nfp.h>
+#include <stdint.h>
+
+#include <nfp/me.h>
+
+#include "config.h"
+
+#ifdef CFG_POLICER
+#include "policer.h"
+#endif
+
+#ifdef CFG_STORM_CTRL
+#include "storm.h"
+#endif
+
+#ifdef CFG_BRIDGE
+#include "bridge.h"
+#endif
+
+#ifdef CFG_REPLICATION
+#include "rep.h"
+#endif
+
+#ifdef CFG_AGE_WHEEL
+#include "age_wheel.h"
+#endif
+
+#ifdef CFG_TM_CTL
+#include "tm_ctl.h"
+
+#if defined(CFG_REPLICATION) && (TM_CTL_CTX >= REP_WORKER_CTX_BASE) && \
+    (TM_CTL_CTX < REP_WORKER_CTX_BASE + REP_WORKER_CTXS)
+#error "TM_CTL_CTX is a replication worker, lower REP_WORKER_CTXS"
+#endif
+#endif
+
+#ifdef CFG_WRED
+#include "wred.h"
+
+#if defined(CFG_REPLICATION) && (WRED_POLL_CTX >= REP_WORKER_CTX_BASE) && \
+    (WRED_POLL_CTX < REP_WORKER_CTX_BASE + REP_WORKER_CTXS)
+#error "WRED_POLL_CTX is a replication worker, lower REP_WORKER_CTXS"
+#endif
+#if defined(CFG_TM_CTL) && (WRED_POLL_CTX == TM_CTL_CTX)
+#error "WRED_POLL_CTX is the tm_ctl context, build with another WRED_POLL_CTX"
+#endif
+#endif
+
+#if defined(CFG_TM_ADAPT) && !defined(CFG_TM_CTL)
+#error "CFG_TM_ADAPT runs on the tm_ctl context and requires CFG_TM_CTL"
+#endif
+
+
+int
+main(void)
+{
+    __gpr unsigned int ctxnum = ctx();
+
+#ifdef CFG_POLICER
+    if (ctxnum >= POLICER_REFILL_CTX_BASE &&
+        ctxnum < POLICER_REFILL_CTX_BASE + POLICER_REFILL_CTXS)
+        policer_refill_loop();
+#endif
+
+#ifdef CFG_STORM_CTRL
+    if (ctxnum == STORM_REFILL_CTX)
+        storm_refill_loop();
+#endif
+
+#ifdef CFG_BRIDGE
+    if (ctxnum == BRIDGE_LEARN_CTX)
+        bridge_learn_loop();
+#endif
+
+#ifdef CFG_REPLICATION
+    if (ctxnum >= REP_WORKER_CTX_BASE &&
+        ctxnum < REP_WORKER_CTX_BASE + REP_WORKER_CTXS)
+        rep_worker_loop();
+#endif
+
+#ifdef CFG_AGE_WHEEL
+    if (ctxnum == AGE_WHEEL_CTX)
+        age_wheel_loop();
+#endif
+
+#ifdef CFG_TM_CTL
+    if (ctxnum == TM_CTL_CTX)
+        tm_ctl_loop();
+#endif
+
+#ifdef CFG_WRED
+    if (ctxnum == WRED_POLL_CTX)
+        wred_poll_loop();
+#endif
+
+    /* Nothing to do on this context */
+    ctx_wait(kill);
+
+    return 0;
+}
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/wred.c
+ * @brief         Weighted RED with ECN marking ahead of the TM queues
+ */
+
+#ifndef _WRED_C_
+#define _WRED_C_
+
+#include "config.h"
+
+#ifdef CFG_WRED
+
+#include <nfp.h>
+#include <stdint.h>
+
+#include <net/csum.h>
+#include <net/eth.h>
+#include <nfp/me.h>
+#include <nfp/mem_atomic.h>
+#include <nfp/mem_bulk.h>
+#include <nfp/tmq.h>
+#include <nfp6000/nfp_me.h>
+#include <nfp6000/nfp_nbi_tm.h>
+#include <std/reg_utils.h>
+
+#include "wred.h"
+
+/* Host written profiles */
+__export WRED_MEM struct wred_profile wred_profile[WRED_CLASSES];
+
+__export WRED_MEM struct wred_cntrs wred_cntrs[WRED_CLASSES];
+
+/* Average depths, written by the poll context of the service ME */
+__export WRED_MEM uint32_t wred_avg_cache[WRED_PORTS * WRED_CLASSES];
+
+/* Per ME copies, only written at a refresh.  The poll context keeps its
+ * averages in wred_avg of the service ME. */
+__shared __lmem uint32_t wred_avg[WRED_PORTS * WRED_CLASSES];
+__shared __lmem struct wred_profile wred_prof[WRED_CLASSES];
+__shared __lmem uint32_t wred_refresh_ts;
+
+#define WRED_ETYPE_OFF          (2 * NET_ETH_ALEN)
+#define WRED_IP4_TOS_OFF        0
+#define WRED_IP4_CSUM_OFF       10
+#define WRED_IP6_TC_shf         20
+
+/* ECN field of the IP header */
+#define WRED_ECN_NOT_ECT        0
+#define WRED_ECN_CE             3
+
+/* Cycles a waiting poll context sleeps for */
+#define WRED_POLL_SLEEP         1024
+
+/* Queues per status read, tmq_status_read() bursts at most 16 bytes */
+#define WRED_STATUS_QUEUES      4
+
+/* Probability of 1 in the units of the profile slope */
+#define WRED_PROB_ONE           (1 << 16)
+
+
+/*
+ * Copy the averages of the poll context and the profiles to local memory.
+ * A profile whose ramp ends above a probability of 1 would overflow the
+ * probability in wred_pkt(), it is copied disabled.
+ */
+static void
+wred_refresh(void)
+{
+    __xread uint32_t avg_in[WRED_CLASSES];
+    __xread struct wred_profile prof_in;
+    __gpr unsigned int port;
+    __gpr unsigned int cls;
+
+    for (port = 0; port < WRED_PORTS; port++) {
+        mem_read32(avg_in, &wred_avg_cache[port * WRED_CLASSES],
+                   sizeof(avg_in));
+        reg_cp(&wred_avg[port * WRED_CLASSES], avg_in, sizeof(avg_in));
+    }
+
+    for (cls = 0; cls < WRED_CLASSES; cls++) {
+        mem_read32(&prof_in, &wred_profile[cls], sizeof(prof_in));
+        reg_cp(&wred_prof[cls], &prof_in, sizeof(prof_in));
+
+        /* Check the slope alone first so the product fits 32 bits */
+        if (wred_prof[cls].max_th > wred_prof[cls].min_th &&
+            (wred_prof[cls].slope > WRED_PROB_ONE ||
+             wred_prof[cls].slope *
+             (wred_prof[cls].max_th - wred_prof[cls].min_th) >
+             WRED_PROB_ONE))
+            wred_prof[cls].enable = 0;
+    }
+}
+
+/*
+ * Set the ECN field of the IP header following the Ethernet header at
+ * @l2_off to Congestion Experienced.  Returns 0 on success, -1 if the
+ * packet is not IP or not from an ECN capable transport.
+ */
+__intrinsic static int
+wred_mark(__mem40 char *pbuf, unsigned int l2_off)
+{
+    __xread uint32_t rd[3];
+    __xwrite uint32_t wr;
+    __gpr unsigned int etype;
+    __gpr unsigned int ip_off;
+    __gpr uint32_t old_val;
+    __gpr uint32_t new_val;
+    __gpr uint32_t csum;
+
+    /* Skip an optional single VLAN tag */
+    ip_off = l2_off + WRED_ETYPE_OFF;
+    mem_read32(rd, pbuf + ip_off, sizeof(uint32_t));
+    etype = rd[0] >> 16;
+    ip_off += sizeof(uint16_t);
+    if (etype == NET_ETH_TYPE_TPID) {
+        mem_read32(rd, pbuf + ip_off + NET_8021Q_LEN - sizeof(uint16_t),
+                   sizeof(uint32_t));
+        etype = rd[0] >> 16;
+        ip_off += NET_8021Q_LEN;
+    }
+
+    mem_read32(rd, pbuf + ip_off, sizeof(rd));
+
+    if (etype == NET_ETH_TYPE_IPV4) {
+        /* The ECN field shares a 16 bit checksum word with version/IHL */
+        old_val = rd[0] >> 16;
+        if ((old_val & 3) == WRED_ECN_NOT_ECT)
+            return -1;
+        if ((old_val & 3) == WRED_ECN_CE)
+            return 0;
+        new_val = old_val | WRED_ECN_CE;
+        csum = net_csum_mod(rd[2] & 0xffff, old_val, new_val);
+
+        wr = new_val << 16;
+        mem_write8(&wr, pbuf + ip_off + WRED_IP4_TOS_OFF, sizeof(uint16_t));
+        wr = csum << 16;
+        mem_write8(&wr, pbuf + ip_off + WRED_IP4_CSUM_OFF, sizeof(uint16_t));
+        return 0;
+    }
+
+    if (etype == NET_ETH_TYPE_IPV6) {
+        /* No header checksum, ECN is the bottom 2 bits of the traffic class */
+        if (((rd[0] >> WRED_IP6_TC_shf) & 3) == WRED_ECN_NOT_ECT)
+            return -1;
+        wr = rd[0] | (WRED_ECN_CE << WRED_IP6_TC_shf);
+        mem_write32(&wr, pbuf + ip_off, sizeof(wr));
+        return 0;
+    }
+
+    return -1;
+}
+
+__intrinsic int
+wred_pkt(__mem40 char *pbuf, unsigned int l2_off, unsigned int port,
+         unsigned int qoff)
+{
+    __gpr uint32_t now;
+    __gpr uint32_t avg;
+    __gpr uint32_t min_th;
+    __gpr uint32_t max_th;
+    __gpr uint32_t prob;
+
+    /* Contexts do not swap in between, so only one of them refreshes */
+    now = local_csr_read(local_csr_timestamp_low);
+    if (now - wred_refresh_ts >= WRED_REFRESH_TICKS) {
+        wred_refresh_ts = now;
+        wred_refresh();
+    }
+
+    if (port >= WRED_PORTS || qoff >= WRED_CLASSES ||
+        !wred_prof[qoff].enable)
+        return 0;
+
+    avg = wred_avg[port * WRED_CLASSES + qoff];
+    min_th = wred_prof[qoff].min_th << WRED_AVG_SHF;
+    max_th = wred_prof[qoff].max_th << WRED_AVG_SHF;
+
+    if (avg <= min_th)
+        return 0;
+
+    if (avg >= max_th) {
+        mem_incr64(&wred_cntrs[qoff].forced);
+        return 1;
+    }
+
+    /* wred_refresh() keeps slope * (max_th - min_th) within 2^16, so
+     * below max_th the product stays within 16 + WRED_AVG_SHF bits */
+    prob = ((avg - min_th) * wred_prof[qoff].slope) >> WRED_AVG_SHF;
+    if ((local_csr_read(local_csr_pseudo_random_number) & 0xffff) >= prob)
+        return 0;
+
+    if (wred_prof[qoff].ecn && wred_mark(pbuf, l2_off) == 0) {
+        mem_incr64(&wred_cntrs[qoff].mark);
+        return 0;
+    }
+
+    mem_incr64(&wred_cntrs[qoff].drop);
+    return 1;
+}
+
+void
+wred_poll_loop(void)
+{
+    __xread struct nfp_nbi_tm_queue_status qs_in[WRED_STATUS_QUEUES];
+    __xwrite uint32_t avg_out[WRED_CLASSES];
+    __gpr uint32_t depth;
+    __gpr uint32_t avg;
+    __gpr unsigned int port;
+    __gpr unsigned int base;
+    __gpr unsigned int cls;
+    __gpr unsigned int idx;
+    __gpr uint64_t next;
+
+    next = me_tsc_read();
+
+    for (;;) {
+        next += WRED_REFRESH_TICKS;
+        while (me_tsc_read() < next)
+            sleep(WRED_POLL_SLEEP);
+
+        idx = 0;
+        for (port = 0; port < WRED_PORTS; port++) {
+            for (base = 0; base < WRED_CLASSES; base += WRED_STATUS_QUEUES) {
+                tmq_status_read(qs_in, NBI, PORT_TO_TMQ(port) + base,
+                                WRED_STATUS_QUEUES);
+
+                for (cls = 0; cls < WRED_STATUS_QUEUES; cls++) {
+                    depth = qs_in[cls].queuelevel << WRED_AVG_SHF;
+                    avg = wred_avg[idx];
+                    if (depth > avg)
+                        avg += (depth - avg) >> WRED_EWMA_SHF;
+                    else
+                        avg -= (avg - depth) >> WRED_EWMA_SHF;
+                    wred_avg[idx] = avg;
+                    avg_out[base + cls] = avg;
+                    idx++;
+                }
+            }
+
+            mem_write32(avg_out, &wred_avg_cache[port * WRED_CLASSES],
+                        sizeof(avg_out));
+        }
+    }
+}
+
+#endif /* CFG_WRED */
+
+#endif /* _WRED_C_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
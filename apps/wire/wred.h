@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file          apps/wire/wred.h
+ * @brief         Weighted RED with ECN marking ahead of the TM queues
+ *
+ * Packets are marked Congestion Experienced or dropped before they are
+ * sent to an egress TM queue, with a probability growing with the
+ * average depth of that queue.  The class of a packet is the offset of
+ * its queue within the TMQ_PER_PORT queues of the egress port, each of
+ * the WRED_CLASSES classes has its own profile (see tools/wred_ctl.py).
+ *
+ * The depth of the first WRED_CLASSES queues of WRED_PORTS ports is read
+ * from the TM every WRED_REFRESH_TICKS by a single context of the service
+ * ME (WRED_POLL_CTX), folded into an average and written to an EMEM
+ * cache.  The packet MEs never access the TM: whichever context of an
+ * ME finds its copy stale reloads the averages and the profiles into
+ * local memory with a few bulk reads.  Between refreshes a packet costs
+ * a few local memory reads and a pseudo random number; the IP header is
+ * only read for packets that are marked.
+ *
+ * Above the minimum threshold a packet of an ECN capable transport is
+ * marked, other packets are dropped.  Above the maximum threshold all
+ * packets are dropped.  Profiles without the ECN flag always drop.
+ */
+
+#ifndef _WRED_H_
+#define _WRED_H_
+
+#include <nfp.h>
+#include <stdint.h>
+
+#ifndef WRED_MEM
+#define WRED_MEM                __emem
+#endif
+
+/* Egress ports with a depth cache, queues of other ports always pass */
+#ifndef WRED_PORTS
+#define WRED_PORTS              8
+#endif
+
+/* Classes, the first queues of each port */
+#define WRED_CLASSES            8
+
+/* Depth refresh interval in ME timestamp ticks, 10 us at 800 MHz, and
+ * the service ME context polling the depths */
+#ifndef WRED_REFRESH_TICKS
+#define WRED_REFRESH_TICKS      500
+#endif
+
+#ifndef WRED_POLL_CTX
+#define WRED_POLL_CTX           5
+#endif
+
+/* Weight of a new sample in the average depth is 1/2^WRED_EWMA_SHF */
+#ifndef WRED_EWMA_SHF
+#define WRED_EWMA_SHF           2
+#endif
+
+/* Fraction bits of the cached average depth */
+#define WRED_AVG_SHF            4
+
+/**
+ * Per class profile, written by the host.
+ *
+ * Between @min_th and @max_th packets of average depth the probability
+ * grows by @slope/2^16 per packet of depth.  A profile is picked up by
+ * the MEs at their next refresh, a profile with @slope * (@max_th -
+ * @min_th) above 2^16 is ignored.
+ */
+struct wred_profile {
+    union {
+        struct {
+            unsigned int enable:1;      /** Profile in use */
+            unsigned int ecn:1;         /** Mark ECN capable packets */
+            unsigned int resv:30;       /** Reserved */
+
+            unsigned int min_th:16;     /** Packets, start of the ramp */
+            unsigned int max_th:16;     /** Packets, drop all above */
+
+            uint32_t slope;             /** Probability per packet /2^16 */
+            uint32_t resv2;             /** Reserved */
+        };
+        uint32_t __raw[4];
+    };
+};
+
+/**
+ * Per class counters
+ */
+struct wred_cntrs {
+    uint64_t mark;              /** Packets marked CE */
+    uint64_t drop;              /** Packets dropped on the ramp */
+    uint64_t forced;            /** Packets dropped above @max_th */
+};
+
+/**
+ * Apply WRED to a packet about to be sent to a TM queue.
+ * @param pbuf      Pointer to the start of the CTM packet buffer
+ * @param l2_off    Offset of the Ethernet header in the packet buffer
+ * @param port      Egress port
+ * @param qoff      Offset of the TM queue in the queues of @port
+ * @return          Non-zero if the packet must be dropped
+ */
+__intrinsic int wred_pkt(__mem40 char *pbuf, unsigned int l2_off,
+                         unsigned int port, unsigned int qoff);
+
+/**
+ * Queue depth poll loop, never returns.  Meant to be run by a single
+ * context on the service ME.
+ */
+void wred_poll_loop(void);
+
+#endif /* _WRED_H_ */
+
+/* -*-  Mode:C; c-basic-offset:4; tab-width:4 -*- */
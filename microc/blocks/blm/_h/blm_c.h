@@ -73,6 +73,33 @@
 #endif
 
 #ifdef SPLIT_EMU_RINGS
+#ifdef BLM_EMU_RING_SPREAD
+/* Each ring ID comes from the queues of the EMU holding the ring */
+#define BLM_EMU_QUEUES_24   emem0_queues
+#define BLM_EMU_QUEUES_25   emem1_queues
+#define BLM_EMU_QUEUES_26   emem2_queues
+#define _BLM_EMU_QUEUES(_isl) BLM_EMU_QUEUES_##_isl
+#define BLM_EMU_QUEUES(_isl) _BLM_EMU_QUEUES(_isl)
+
+__asm {
+    .alloc_resource BLM_NBI8_BLQ0_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI8_BLQ0_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI8_BLQ1_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI8_BLQ1_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI8_BLQ2_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI8_BLQ2_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI8_BLQ3_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI8_BLQ3_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI9_BLQ0_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI9_BLQ0_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI9_BLQ1_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI9_BLQ1_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI9_BLQ2_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI9_BLQ2_EMU_Q_ISLAND) global 1
+    .alloc_resource BLM_NBI9_BLQ3_EMU_QID \
+        BLM_EMU_QUEUES(BLM_NBI9_BLQ3_EMU_Q_ISLAND) global 1
+}
+#else
 __asm {
     .declare_resource BLQ_EMU_RINGS global 8 emem0_queues+8
     .alloc_resource BLM_NBI8_BLQ0_EMU_QID BLQ_EMU_RINGS+0 global 1
@@ -84,6 +111,7 @@ __asm {
     .alloc_resource BLM_NBI9_BLQ2_EMU_QID BLQ_EMU_RINGS+6 global 1
     .alloc_resource BLM_NBI9_BLQ3_EMU_QID BLQ_EMU_RINGS+7 global 1
 }
+#endif /* BLM_EMU_RING_SPREAD */
 
 /* Get a BLM ring number for a given NBI (8/9) and BLQ (0-3) */
 #define BLM_EMU_RING_ID(_NBI_,_BLQ_)                            \
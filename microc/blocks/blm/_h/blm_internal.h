@@ -55,11 +55,34 @@
 */
 .declare_resource BLM_EMU_RING_INIT_CNT global 1
 
+/* A BLQ of an NBI is owned by a single BLM instance, see blm_linker_check */
+#for _nbi [8,9]
+    #for _blq [0,1,2,3]
+        .declare_resource BLM_NBI/**/_nbi/**/_BLQ/**/_blq/**/_OWNER global 1
+    #endloop
+#endloop
+#undef _nbi
+#undef _blq
+
 #define BLM_LM_BLQ_CACHE_ADDR_OFFSET            0
 #define BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET       1
 #define BLM_LM_BLQ_DMA_EVNT_PEND_CNT_OFFSET     2
 #define BLM_LM_BLQ_NULL_RECYCLE_OFFSET          3
 #define BLM_LM_BLQ_CACHE_RDWR_BUSY_OFFSET       4
+#define BLM_LM_BLQ_TELEM_SEQ_OFFSET             5
+#define BLM_LM_BLQ_CACHE_LWM_HITS_OFFSET        6
+#define BLM_LM_BLQ_ADAPT_TIER_OFFSET            7
+#define BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET        8
+#define BLM_LM_BLQ_ADAPT_WIN_END_OFFSET         9
+#define BLM_LM_BLQ_ADAPT_WIN_EVNTS_OFFSET       10
+#define BLM_LM_BLQ_REBAL_NEXT_OFFSET            11
+#define BLM_LM_BLQ_REBAL_DONATE_OFFSET          12
+
+/* Adaptive refill (BLM_ADAPTIVE_REFILL) event rate tiers */
+#define BLM_ADAPT_TIER_IDLE                     0
+#define BLM_ADAPT_TIER_NORMAL                   1
+#define BLM_ADAPT_TIER_BURST                    2
+#define BLM_ADAPT_FILL_ALL                      0xff
 
 #define BLM_MAX_DMA_PENDING_EVNTS               5
 #define BLM_NBI_BLQ_CACHE_DEFICIT               47
@@ -80,11 +103,36 @@
 .alloc_resource BLM_STATS_DMA_NULL_RECYCLE            BLQ_STATS_OFFSETS           island 8 /* Offset-9  */
 .alloc_resource BLM_STATS_TM_NULL_RECYCLE             BLQ_STATS_OFFSETS           island 8 /* Offset-10 */
 .alloc_resource BLM_STATS_NUM_ALARMS                  BLQ_STATS_OFFSETS           island 8 /* Offset-11 */
-.alloc_resource BLM_STATS_OFFSET_RFU1                 BLQ_STATS_OFFSETS           island 8 /* Offset-12 */
+.alloc_resource BLM_STATS_REBALANCE_DONATED          BLQ_STATS_OFFSETS           island 8 /* Offset-12 */
 .alloc_resource BLM_STATS_OFFSET_RFU2                 BLQ_STATS_OFFSETS           island 8 /* Offset-13 */
 .alloc_resource BLM_STATS_OFFSET_RFU3                 BLQ_STATS_OFFSETS           island 8 /* Offset-14 */
 .alloc_resource BLM_STATS_OFFSET_RFU4                 BLQ_STATS_OFFSETS           island 8 /* Offset-15 */
 
+/*
+ * BLM Telemetry (BLM_TELEMETRY)
+ *
+ * Exported in EMEM as BLM_TELEM_BASE_<BLM_INSTANCE_ID>, one block per BLQ.
+ * The ingress context of a BLQ rewrites its block every BLM_TELEM_TICKS
+ * timestamp ticks. tools/blm_telem.py decodes this layout.
+ *
+ * Word  0      Sample sequence number, written last
+ * Word  1      TIMESTAMP_LOW at the time of the sample
+ * Word  2      CTM cache fill level (buffers)
+ * Word  3      Pending DMA BLQ events
+ * Word  4      EMU ring depth (buffers), from the ring queue descriptor
+ * Word  5      Cache low watermark hits (cache < BLM_TELEM_CACHE_LWM after
+ *              servicing a DMA event)
+ * Word  6-7    DMA BLQueCtrl, read with blm_blq_status
+ * Word  8-9    TM BLQueCtrl, read with blm_blq_status
+ * Word 10      Cache high watermark
+ * Word 11      Cache size
+ * Word 12-15   Reserved
+ * Word 16-31   Copy of the first 8 BLQ stats counters (64 bit) above
+ */
+#define BLM_TELEM_BLQ_SIZE                128
+#define BLM_TELEM_SIZE                    (BLM_TELEM_BLQ_SIZE * 4)
+#define BLM_TELEM_CNTRS                   64
+
 /* BLM CLS Autopush filters */
 .declare_resource BLM_AP_FILTERS island 8 cls_apfilters
 .alloc_resource BLM_BLQ0_AP_FILTER_NUM BLM_AP_FILTERS island 1
@@ -124,15 +172,36 @@
     #endif
 
     #ifndef BLM_INSTANCE_ID
-        #error 4 "Define BLM_INSTANCE_ID. Valid values=[0,1]"
+        #error 4 "Define BLM_INSTANCE_ID. Valid values=[0,1,2,3]"
+    #endif
+
+    /*
+     * Instances 0 and 1 are the primary instances of NBI-8 and NBI-9.
+     * Instances 2 and 3 take a share of the BLQs of NBI-8 and NBI-9 off
+     * the primary instance, see BLM_BLQ_ENABLE_MASK.
+     */
+    #if ((BLM_INSTANCE_ID < 0) || (BLM_INSTANCE_ID > 3))
+        #error 4 "BLM Instance ID should be 0 to 3:"BLM_INSTANCE_ID
     #endif
 
-    #if ((BLM_INSTANCE_ID < 0) || (BLM_INSTANCE_ID > 1))
-        #error 4 "BLM Instance ID should 0 or 1:"BLM_INSTANCE_ID
+    #if (((BLM_INSTANCE_ID & 1) ^ (NBII & 1)) != 0)
+        #error 4 "NBII should be 8 for BLM_INSTANCE_ID=0,2 AND NBII should be 9 for BLM_INSTANCE_ID=1,3."
     #endif
 
-    #if (((BLM_INSTANCE_ID) ^ (NBII & 1)) != 0)
-        #error 4 "NBII should be 8 for BLM_INSTACE-ID=0 AND NBII should be 9 for BLM_INSTANCE_ID=1."
+    #if (BLM_INSTANCE_ID > 1)
+        /* The primary instance sets up the BLQs and the EMU rings of the NBI */
+        #ifdef BLM_INIT_EMU_RINGS
+            #error 4 "BLM_INIT_EMU_RINGS is only valid for BLM instance 0 or 1."
+        #endif
+        #ifndef BLM_SKIP_DMA_INIT
+            #error 4 "BLM_SKIP_DMA_INIT is required for BLM instance 2 or 3."
+        #endif
+    #endif
+
+    #ifdef BLM_REBALANCE
+        #ifndef SPLIT_EMU_RINGS
+            #error 4 "BLM_REBALANCE requires SPLIT_EMU_RINGS, shared EMU rings are already pooled."
+        #endif
     #endif
 #endm /* blm_preproc_check */
 
@@ -142,6 +211,14 @@
 #macro blm_linker_check()
     /* --------- Link time error checks --------- */
 
+/* Two BLM instances servicing the same BLQ fail to allocate its owner */
+#for _blq [0,1,2,3]
+    #if (BLM_BLQ_ENABLE_MASK & ((1 << _blq) | (1 << (_blq + 4))))
+        .alloc_resource BLM_NBI/**/NBII/**/_BLQ/**/_blq/**/_OWNER_/**/BLM_INSTANCE_ID BLM_NBI/**/NBII/**/_BLQ/**/_blq/**/_OWNER global 1
+    #endif
+#endloop
+#undef _blq
+
 .alloc_mem BLM_/**/BLM_INSTANCE_ID/**/_ISLAND_ID   i0.ctm  global  8
 /* BLM Instance-0 must run on Island-33: adjacent to NBI-8 */
 #if BLM_INSTANCE_ID == 0
@@ -168,6 +245,11 @@
     .assert((__ISLAND == 49)) "BLM Instance-1 should run on Island-49!"
 #endif /* BLM_FORCE_EVENT_ROUTING */
 #endif
+
+/*
+ * BLM Instance-2/3 may run on any other island the events of NBI-8/NBI-9
+ * are routed through, each on its own island.
+ */
 #endm /* blm_linker_check */
 
 /*
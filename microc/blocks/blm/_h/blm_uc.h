@@ -62,6 +62,16 @@
     #error "NBI9_BLQ_EMU_3_PKTBUF_SIZE must be a multiple of 2048"
 #endif
 
+/* Buffers donated to the other NBI must fit its packets */
+#ifdef BLM_REBALANCE
+    #if ((NBI8_BLQ_EMU_0_PKTBUF_SIZE != NBI9_BLQ_EMU_0_PKTBUF_SIZE) || \
+         (NBI8_BLQ_EMU_1_PKTBUF_SIZE != NBI9_BLQ_EMU_1_PKTBUF_SIZE) || \
+         (NBI8_BLQ_EMU_2_PKTBUF_SIZE != NBI9_BLQ_EMU_2_PKTBUF_SIZE) || \
+         (NBI8_BLQ_EMU_3_PKTBUF_SIZE != NBI9_BLQ_EMU_3_PKTBUF_SIZE))
+        #error "BLM_REBALANCE requires the same PKTBUF_SIZE for a BLQ on NBI8 and NBI9"
+    #endif
+#endif
+
 
 #ifdef SPLIT_EMU_RINGS
     /* resource declaration */
@@ -69,6 +79,18 @@
      * If two NBI's do not share same EMU rings for packet buffers
      * grab 8 rings, 4 for each NBI.
      */
+    #ifdef BLM_EMU_RING_SPREAD
+    /* Each ring ID comes from the queues of the EMU holding the ring */
+    #for _nbi [8,9]
+        #for _blq [0,1,2,3]
+            #define_eval _EMU_  (BLM_NBI/**/_nbi/**/_BLQ/**/_blq/**/_EMU_Q_ISLAND - 24)
+            .alloc_resource BLM_NBI/**/_nbi/**/_BLQ/**/_blq/**/_EMU_QID emem/**/_EMU_/**/_queues global 1
+        #endloop
+    #endloop
+    #undef _EMU_
+    #undef _nbi
+    #undef _blq
+    #else
     .declare_resource BLQ_EMU_RINGS global 8 emem0_queues+8
 
     /* allocate ring ids from local pool */
@@ -86,6 +108,7 @@
     .alloc_resource BLM_NBI9_BLQ1_EMU_QID BLQ_EMU_RINGS+5 global 1
     .alloc_resource BLM_NBI9_BLQ2_EMU_QID BLQ_EMU_RINGS+6 global 1
     .alloc_resource BLM_NBI9_BLQ3_EMU_QID BLQ_EMU_RINGS+7 global 1
+    #endif
 
     /* allocate memory for NBI8 EMU Ring Qdescriptors */
     .alloc_mem _BLM_NBI8_BLQ0_EMU_QD_BASE   i/**/BLM_NBI8_BLQ0_EMU_Q_ISLAND.BLM_BLQ_EMEM_TYPE   global  16                      16
@@ -166,12 +189,22 @@
      * Two NBI's share EMU rings for packet buffers.
      * grab 4 rings, one for each BLQ - global scope.
      */
+    #ifdef BLM_EMU_RING_SPREAD
+    /* Each ring ID comes from the queues of the EMU holding the ring */
+    #for _blq [0,1,2,3]
+        #define_eval _EMU_  (BLM_NBI8_BLQ/**/_blq/**/_EMU_Q_ISLAND - 24)
+        .alloc_resource BLM_NBI8_BLQ/**/_blq/**/_EMU_QID emem/**/_EMU_/**/_queues global 1
+    #endloop
+    #undef _EMU_
+    #undef _blq
+    #else
     .declare_resource BLQ_EMU_RINGS global 4 emem0_queues+4
 
     .alloc_resource BLM_NBI8_BLQ0_EMU_QID BLQ_EMU_RINGS+0 global 1
     .alloc_resource BLM_NBI8_BLQ1_EMU_QID BLQ_EMU_RINGS+1 global 1
     .alloc_resource BLM_NBI8_BLQ2_EMU_QID BLQ_EMU_RINGS+2 global 1
     .alloc_resource BLM_NBI8_BLQ3_EMU_QID BLQ_EMU_RINGS+3 global 1
+    #endif
 
     #define BLM_NBI9_BLQ0_EMU_QID           BLM_NBI8_BLQ0_EMU_QID
     #define BLM_NBI9_BLQ1_EMU_QID           BLM_NBI8_BLQ1_EMU_QID
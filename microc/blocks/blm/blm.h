@@ -48,6 +48,8 @@
  *  1. BLM ring IDs are always allocated in an ordered sequence.
  *  2. All BLM rings for a given NBI are allocated in the same island.
  *  3. BLM rings are big enough to never overflow.
+ * With BLM_EMU_RING_SPREAD (see blm_cfg.h) 1. and 2. do not hold, the ring
+ * ID and island are then resolved per BLQ.
  */
 
 /**
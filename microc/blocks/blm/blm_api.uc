@@ -38,6 +38,10 @@
  *   NFP_BLM_BUF_POOL_BIND(BLM_NBI8_BLQ1_EMU_QID, BLM_MEDIUM_PKT, BLM_NBI8_BLQ1_EMU_Q_LOCALITY, BLM_NBI8_BLQ1_EMU_Q_ISLAND)
  *   NFP_BLM_BUF_POOL_BIND(BLM_NBI8_BLQ2_EMU_QID, BLM_LARGE_PKT,  BLM_NBI8_BLQ2_EMU_Q_LOCALITY, BLM_NBI8_BLQ2_EMU_Q_ISLAND)
  *   NFP_BLM_BUF_POOL_BIND(BLM_NBI8_BLQ3_EMU_QID, BLM_JUMBO_PKT,  BLM_NBI8_BLQ3_EMU_Q_LOCALITY, BLM_NBI8_BLQ3_EMU_Q_ISLAND)
+ *
+ *   With BLM_EMU_RING_SPREAD the pools are on different EMUs, pass the pool
+ *   itself as base_pool to the macros below, e.g.
+ *   nfp_blm_buf_alloc(b, BLM_MEDIUM_PKT, BLM_MEDIUM_PKT, 1, sig_buf, SIG_WAIT)
  */
 #macro NFP_BLM_BUF_POOL_BIND(symbol, pool, locality, island)
     .declare_resource blm_qid_/**/pool global 1 symbol
@@ -45,6 +45,10 @@
  * Mask defining which BLQ's are active and serviced by BLM.
  * bits[3:0] = Ingress BLQ enable mask. '1' = Enable, '0' = disable
  * bits[7:4] = Egress  BLQ enable mask. '1' = Enable, '0' = disable
+ *
+ * When BLM instance 2 or 3 shares an NBI with instance 0 or 1, the masks of
+ * the two instances must not have a BLQ in common. Ingress and egress of a
+ * BLQ share the cache and belong in the same instance.
  */
 #ifndef BLM_BLQ_ENABLE_MASK
     #define BLM_BLQ_ENABLE_MASK     0xff
@@ -107,8 +111,52 @@
 #endif
 
 
-/* The location of the EMU rings */
+/*
+ * The location of the EMU rings
+ *
+ * By default every ring is in island 24, so the ring pops and journals of
+ * all BLQs of both NBIs go to a single EMU.  With BLM_EMU_RING_SPREAD the
+ * rings default to the three EMUs in turn, NBI9 starting one EMU after
+ * NBI8, and each ring ID is allocated from the queues of the EMU holding
+ * the ring.  The buffers of a BLQ default to the same EMU as its ring to
+ * keep the buffer DMA on that EMU too (see below).  The ring locality
+ * (BLM_NBIx_BLQn_EMU_Q_LOCALITY) is kept per ring.
+ */
+#ifdef BLM_EMU_RING_SPREAD
+
+#ifndef BLM_NBI8_BLQ0_EMU_Q_ISLAND
+    #define BLM_NBI8_BLQ0_EMU_Q_ISLAND 24
+#endif
+
+#ifndef BLM_NBI8_BLQ1_EMU_Q_ISLAND
+    #define BLM_NBI8_BLQ1_EMU_Q_ISLAND 25
+#endif
+
+#ifndef BLM_NBI8_BLQ2_EMU_Q_ISLAND
+    #define BLM_NBI8_BLQ2_EMU_Q_ISLAND 26
+#endif
+
+#ifndef BLM_NBI8_BLQ3_EMU_Q_ISLAND
+    #define BLM_NBI8_BLQ3_EMU_Q_ISLAND 24
+#endif
+
+#ifndef BLM_NBI9_BLQ0_EMU_Q_ISLAND
+    #define BLM_NBI9_BLQ0_EMU_Q_ISLAND 25
+#endif
 
+#ifndef BLM_NBI9_BLQ1_EMU_Q_ISLAND
+    #define BLM_NBI9_BLQ1_EMU_Q_ISLAND 26
+#endif
+
+#ifndef BLM_NBI9_BLQ2_EMU_Q_ISLAND
+    #define BLM_NBI9_BLQ2_EMU_Q_ISLAND 24
+#endif
+
+#ifndef BLM_NBI9_BLQ3_EMU_Q_ISLAND
+    #define BLM_NBI9_BLQ3_EMU_Q_ISLAND 25
+#endif
+
+#endif /* BLM_EMU_RING_SPREAD */
 
 #ifndef BLM_NBI8_BLQ0_EMU_Q_ISLAND
     #define BLM_NBI8_BLQ0_EMU_Q_ISLAND 24
@@ -142,6 +190,379 @@
     #define BLM_NBI9_BLQ3_EMU_Q_ISLAND 24
 #endif
 
+/*
+ * Buffers of each BLQ with BLM_EMU_RING_SPREAD
+ *
+ * A BLQ that does not set any of its BLM_NBIx_BLQn_EMU_EMEMm_NUM_BUFS gets
+ * BLM_NBIx_BLQn_EMU_NUM_BUFS buffers (BLM_NBIx_BLQn_BDSRAM_NUM_BUFS of them
+ * in the BDSRAM) with density BLM_NBIx_BLQn_EMU_DENSITY from the EMU holding
+ * its ring, and none from the others.  The totals default to the sums of
+ * the per EMU defaults below.
+ */
+#ifdef BLM_EMU_RING_SPREAD
+
+#ifndef BLM_NBI8_BLQ0_EMU_NUM_BUFS
+    #define BLM_NBI8_BLQ0_EMU_NUM_BUFS          1024
+#endif
+#ifndef BLM_NBI8_BLQ0_BDSRAM_NUM_BUFS
+    #define BLM_NBI8_BLQ0_BDSRAM_NUM_BUFS       512
+#endif
+#ifndef BLM_NBI8_BLQ0_EMU_DENSITY
+    #define BLM_NBI8_BLQ0_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI8_BLQ0_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ0_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ0_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI8_BLQ0_EMU_Q_ISLAND == 24)
+        #define BLM_NBI8_BLQ0_EMU_EMEM0_NUM_BUFS    BLM_NBI8_BLQ0_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM0_NUM_BUFS BLM_NBI8_BLQ0_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ0_EMU_EMEM0_DENSITY     BLM_NBI8_BLQ0_EMU_DENSITY
+        #define BLM_NBI8_BLQ0_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ0_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ0_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ0_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI8_BLQ0_EMU_Q_ISLAND == 25)
+        #define BLM_NBI8_BLQ0_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ0_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ0_EMU_EMEM1_NUM_BUFS    BLM_NBI8_BLQ0_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM1_NUM_BUFS BLM_NBI8_BLQ0_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ0_EMU_EMEM1_DENSITY     BLM_NBI8_BLQ0_EMU_DENSITY
+        #define BLM_NBI8_BLQ0_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ0_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI8_BLQ0_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ0_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ0_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ0_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ0_EMU_EMEM2_NUM_BUFS    BLM_NBI8_BLQ0_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ0_BDSRAM_EMEM2_NUM_BUFS BLM_NBI8_BLQ0_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ0_EMU_EMEM2_DENSITY     BLM_NBI8_BLQ0_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI8_BLQ1_EMU_NUM_BUFS
+    #define BLM_NBI8_BLQ1_EMU_NUM_BUFS          3072
+#endif
+#ifndef BLM_NBI8_BLQ1_BDSRAM_NUM_BUFS
+    #define BLM_NBI8_BLQ1_BDSRAM_NUM_BUFS       1024
+#endif
+#ifndef BLM_NBI8_BLQ1_EMU_DENSITY
+    #define BLM_NBI8_BLQ1_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI8_BLQ1_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ1_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ1_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI8_BLQ1_EMU_Q_ISLAND == 24)
+        #define BLM_NBI8_BLQ1_EMU_EMEM0_NUM_BUFS    BLM_NBI8_BLQ1_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM0_NUM_BUFS BLM_NBI8_BLQ1_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ1_EMU_EMEM0_DENSITY     BLM_NBI8_BLQ1_EMU_DENSITY
+        #define BLM_NBI8_BLQ1_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ1_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ1_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ1_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI8_BLQ1_EMU_Q_ISLAND == 25)
+        #define BLM_NBI8_BLQ1_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ1_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ1_EMU_EMEM1_NUM_BUFS    BLM_NBI8_BLQ1_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM1_NUM_BUFS BLM_NBI8_BLQ1_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ1_EMU_EMEM1_DENSITY     BLM_NBI8_BLQ1_EMU_DENSITY
+        #define BLM_NBI8_BLQ1_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ1_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI8_BLQ1_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ1_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ1_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ1_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ1_EMU_EMEM2_NUM_BUFS    BLM_NBI8_BLQ1_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ1_BDSRAM_EMEM2_NUM_BUFS BLM_NBI8_BLQ1_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ1_EMU_EMEM2_DENSITY     BLM_NBI8_BLQ1_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI8_BLQ2_EMU_NUM_BUFS
+    #define BLM_NBI8_BLQ2_EMU_NUM_BUFS          0
+#endif
+#ifndef BLM_NBI8_BLQ2_BDSRAM_NUM_BUFS
+    #define BLM_NBI8_BLQ2_BDSRAM_NUM_BUFS       0
+#endif
+#ifndef BLM_NBI8_BLQ2_EMU_DENSITY
+    #define BLM_NBI8_BLQ2_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI8_BLQ2_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ2_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ2_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI8_BLQ2_EMU_Q_ISLAND == 24)
+        #define BLM_NBI8_BLQ2_EMU_EMEM0_NUM_BUFS    BLM_NBI8_BLQ2_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM0_NUM_BUFS BLM_NBI8_BLQ2_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ2_EMU_EMEM0_DENSITY     BLM_NBI8_BLQ2_EMU_DENSITY
+        #define BLM_NBI8_BLQ2_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ2_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ2_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ2_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI8_BLQ2_EMU_Q_ISLAND == 25)
+        #define BLM_NBI8_BLQ2_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ2_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ2_EMU_EMEM1_NUM_BUFS    BLM_NBI8_BLQ2_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM1_NUM_BUFS BLM_NBI8_BLQ2_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ2_EMU_EMEM1_DENSITY     BLM_NBI8_BLQ2_EMU_DENSITY
+        #define BLM_NBI8_BLQ2_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ2_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI8_BLQ2_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ2_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ2_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ2_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ2_EMU_EMEM2_NUM_BUFS    BLM_NBI8_BLQ2_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ2_BDSRAM_EMEM2_NUM_BUFS BLM_NBI8_BLQ2_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ2_EMU_EMEM2_DENSITY     BLM_NBI8_BLQ2_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI8_BLQ3_EMU_NUM_BUFS
+    #define BLM_NBI8_BLQ3_EMU_NUM_BUFS          0
+#endif
+#ifndef BLM_NBI8_BLQ3_BDSRAM_NUM_BUFS
+    #define BLM_NBI8_BLQ3_BDSRAM_NUM_BUFS       0
+#endif
+#ifndef BLM_NBI8_BLQ3_EMU_DENSITY
+    #define BLM_NBI8_BLQ3_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI8_BLQ3_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ3_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI8_BLQ3_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI8_BLQ3_EMU_Q_ISLAND == 24)
+        #define BLM_NBI8_BLQ3_EMU_EMEM0_NUM_BUFS    BLM_NBI8_BLQ3_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM0_NUM_BUFS BLM_NBI8_BLQ3_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ3_EMU_EMEM0_DENSITY     BLM_NBI8_BLQ3_EMU_DENSITY
+        #define BLM_NBI8_BLQ3_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ3_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ3_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ3_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI8_BLQ3_EMU_Q_ISLAND == 25)
+        #define BLM_NBI8_BLQ3_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ3_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ3_EMU_EMEM1_NUM_BUFS    BLM_NBI8_BLQ3_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM1_NUM_BUFS BLM_NBI8_BLQ3_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ3_EMU_EMEM1_DENSITY     BLM_NBI8_BLQ3_EMU_DENSITY
+        #define BLM_NBI8_BLQ3_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI8_BLQ3_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI8_BLQ3_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI8_BLQ3_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI8_BLQ3_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI8_BLQ3_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI8_BLQ3_EMU_EMEM2_NUM_BUFS    BLM_NBI8_BLQ3_EMU_NUM_BUFS
+        #define BLM_NBI8_BLQ3_BDSRAM_EMEM2_NUM_BUFS BLM_NBI8_BLQ3_BDSRAM_NUM_BUFS
+        #define BLM_NBI8_BLQ3_EMU_EMEM2_DENSITY     BLM_NBI8_BLQ3_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI9_BLQ0_EMU_NUM_BUFS
+    #define BLM_NBI9_BLQ0_EMU_NUM_BUFS          1024
+#endif
+#ifndef BLM_NBI9_BLQ0_BDSRAM_NUM_BUFS
+    #define BLM_NBI9_BLQ0_BDSRAM_NUM_BUFS       512
+#endif
+#ifndef BLM_NBI9_BLQ0_EMU_DENSITY
+    #define BLM_NBI9_BLQ0_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI9_BLQ0_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ0_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ0_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI9_BLQ0_EMU_Q_ISLAND == 24)
+        #define BLM_NBI9_BLQ0_EMU_EMEM0_NUM_BUFS    BLM_NBI9_BLQ0_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM0_NUM_BUFS BLM_NBI9_BLQ0_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ0_EMU_EMEM0_DENSITY     BLM_NBI9_BLQ0_EMU_DENSITY
+        #define BLM_NBI9_BLQ0_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ0_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ0_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ0_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI9_BLQ0_EMU_Q_ISLAND == 25)
+        #define BLM_NBI9_BLQ0_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ0_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ0_EMU_EMEM1_NUM_BUFS    BLM_NBI9_BLQ0_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM1_NUM_BUFS BLM_NBI9_BLQ0_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ0_EMU_EMEM1_DENSITY     BLM_NBI9_BLQ0_EMU_DENSITY
+        #define BLM_NBI9_BLQ0_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ0_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI9_BLQ0_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ0_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ0_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ0_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ0_EMU_EMEM2_NUM_BUFS    BLM_NBI9_BLQ0_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ0_BDSRAM_EMEM2_NUM_BUFS BLM_NBI9_BLQ0_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ0_EMU_EMEM2_DENSITY     BLM_NBI9_BLQ0_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI9_BLQ1_EMU_NUM_BUFS
+    #define BLM_NBI9_BLQ1_EMU_NUM_BUFS          3072
+#endif
+#ifndef BLM_NBI9_BLQ1_BDSRAM_NUM_BUFS
+    #define BLM_NBI9_BLQ1_BDSRAM_NUM_BUFS       1024
+#endif
+#ifndef BLM_NBI9_BLQ1_EMU_DENSITY
+    #define BLM_NBI9_BLQ1_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI9_BLQ1_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ1_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ1_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI9_BLQ1_EMU_Q_ISLAND == 24)
+        #define BLM_NBI9_BLQ1_EMU_EMEM0_NUM_BUFS    BLM_NBI9_BLQ1_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM0_NUM_BUFS BLM_NBI9_BLQ1_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ1_EMU_EMEM0_DENSITY     BLM_NBI9_BLQ1_EMU_DENSITY
+        #define BLM_NBI9_BLQ1_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ1_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ1_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ1_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI9_BLQ1_EMU_Q_ISLAND == 25)
+        #define BLM_NBI9_BLQ1_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ1_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ1_EMU_EMEM1_NUM_BUFS    BLM_NBI9_BLQ1_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM1_NUM_BUFS BLM_NBI9_BLQ1_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ1_EMU_EMEM1_DENSITY     BLM_NBI9_BLQ1_EMU_DENSITY
+        #define BLM_NBI9_BLQ1_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ1_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI9_BLQ1_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ1_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ1_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ1_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ1_EMU_EMEM2_NUM_BUFS    BLM_NBI9_BLQ1_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ1_BDSRAM_EMEM2_NUM_BUFS BLM_NBI9_BLQ1_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ1_EMU_EMEM2_DENSITY     BLM_NBI9_BLQ1_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI9_BLQ2_EMU_NUM_BUFS
+    #define BLM_NBI9_BLQ2_EMU_NUM_BUFS          0
+#endif
+#ifndef BLM_NBI9_BLQ2_BDSRAM_NUM_BUFS
+    #define BLM_NBI9_BLQ2_BDSRAM_NUM_BUFS       0
+#endif
+#ifndef BLM_NBI9_BLQ2_EMU_DENSITY
+    #define BLM_NBI9_BLQ2_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI9_BLQ2_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ2_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ2_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI9_BLQ2_EMU_Q_ISLAND == 24)
+        #define BLM_NBI9_BLQ2_EMU_EMEM0_NUM_BUFS    BLM_NBI9_BLQ2_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM0_NUM_BUFS BLM_NBI9_BLQ2_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ2_EMU_EMEM0_DENSITY     BLM_NBI9_BLQ2_EMU_DENSITY
+        #define BLM_NBI9_BLQ2_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ2_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ2_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ2_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI9_BLQ2_EMU_Q_ISLAND == 25)
+        #define BLM_NBI9_BLQ2_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ2_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ2_EMU_EMEM1_NUM_BUFS    BLM_NBI9_BLQ2_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM1_NUM_BUFS BLM_NBI9_BLQ2_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ2_EMU_EMEM1_DENSITY     BLM_NBI9_BLQ2_EMU_DENSITY
+        #define BLM_NBI9_BLQ2_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ2_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI9_BLQ2_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ2_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ2_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ2_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ2_EMU_EMEM2_NUM_BUFS    BLM_NBI9_BLQ2_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ2_BDSRAM_EMEM2_NUM_BUFS BLM_NBI9_BLQ2_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ2_EMU_EMEM2_DENSITY     BLM_NBI9_BLQ2_EMU_DENSITY
+    #endif
+#endif
+
+#ifndef BLM_NBI9_BLQ3_EMU_NUM_BUFS
+    #define BLM_NBI9_BLQ3_EMU_NUM_BUFS          0
+#endif
+#ifndef BLM_NBI9_BLQ3_BDSRAM_NUM_BUFS
+    #define BLM_NBI9_BLQ3_BDSRAM_NUM_BUFS       0
+#endif
+#ifndef BLM_NBI9_BLQ3_EMU_DENSITY
+    #define BLM_NBI9_BLQ3_EMU_DENSITY          1
+#endif
+#if !defined(BLM_NBI9_BLQ3_EMU_EMEM0_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ3_EMU_EMEM1_NUM_BUFS) && \
+    !defined(BLM_NBI9_BLQ3_EMU_EMEM2_NUM_BUFS)
+    #if (BLM_NBI9_BLQ3_EMU_Q_ISLAND == 24)
+        #define BLM_NBI9_BLQ3_EMU_EMEM0_NUM_BUFS    BLM_NBI9_BLQ3_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM0_NUM_BUFS BLM_NBI9_BLQ3_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ3_EMU_EMEM0_DENSITY     BLM_NBI9_BLQ3_EMU_DENSITY
+        #define BLM_NBI9_BLQ3_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ3_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ3_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ3_EMU_EMEM2_DENSITY     0
+    #elif (BLM_NBI9_BLQ3_EMU_Q_ISLAND == 25)
+        #define BLM_NBI9_BLQ3_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ3_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ3_EMU_EMEM1_NUM_BUFS    BLM_NBI9_BLQ3_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM1_NUM_BUFS BLM_NBI9_BLQ3_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ3_EMU_EMEM1_DENSITY     BLM_NBI9_BLQ3_EMU_DENSITY
+        #define BLM_NBI9_BLQ3_EMU_EMEM2_NUM_BUFS    0
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM2_NUM_BUFS 0
+        #define BLM_NBI9_BLQ3_EMU_EMEM2_DENSITY     0
+    #else
+        #define BLM_NBI9_BLQ3_EMU_EMEM0_NUM_BUFS    0
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM0_NUM_BUFS 0
+        #define BLM_NBI9_BLQ3_EMU_EMEM0_DENSITY     0
+        #define BLM_NBI9_BLQ3_EMU_EMEM1_NUM_BUFS    0
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM1_NUM_BUFS 0
+        #define BLM_NBI9_BLQ3_EMU_EMEM1_DENSITY     0
+        #define BLM_NBI9_BLQ3_EMU_EMEM2_NUM_BUFS    BLM_NBI9_BLQ3_EMU_NUM_BUFS
+        #define BLM_NBI9_BLQ3_BDSRAM_EMEM2_NUM_BUFS BLM_NBI9_BLQ3_BDSRAM_NUM_BUFS
+        #define BLM_NBI9_BLQ3_EMU_EMEM2_DENSITY     BLM_NBI9_BLQ3_EMU_DENSITY
+    #endif
+#endif
+
+#endif /* BLM_EMU_RING_SPREAD */
+
 /* EMU packet buffer alignment - MUST be a power of 2 and a mult of 2048 */
 #ifndef EMU_PKTBUF_ALIGNMENT
 #define EMU_PKTBUF_ALIGNMENT 2048
@@ -37,6 +37,66 @@
 #define ALARM_TICKS 32
 #endif
 
+/* Telemetry sample interval in timestamp ticks (16 ME cycles) */
+#ifndef BLM_TELEM_TICKS
+#define BLM_TELEM_TICKS (1 << 20)
+#endif
+
+/* Cache fill level below which a low watermark hit is counted */
+#ifndef BLM_TELEM_CACHE_LWM
+#define BLM_TELEM_CACHE_LWM (NBI_BLQ_EVENT_THRESHOLD * 2)
+#endif
+
+/*
+ * Adaptive refill (BLM_ADAPTIVE_REFILL).
+ * The DMA event rate of a BLQ is measured over windows of
+ * BLM_ADAPT_WINDOW_TICKS. A window without events puts the BLQ in the idle
+ * tier, BLM_ADAPT_BURST_EVNTS events or more in the burst tier.
+ * - Idle: the alarm interval in Mailbox1 is scaled up by BLM_ADAPT_IDLE_SHF,
+ *   alarms hand back all pending DMA events and refill the cache.
+ * - Burst: a wakeup refills at most BLM_ADAPT_BURST_FILL chunks of 16
+ *   buffers from the EMU ring so that DMA events are not held up.
+ * - Normal: unchanged, only alarms refill the cache.
+ * The first DMA event after an idle window starts a burst.
+ * See tools/blm_model.py.
+ */
+#ifndef BLM_ADAPT_WINDOW_TICKS
+#define BLM_ADAPT_WINDOW_TICKS 1024
+#endif
+
+#ifndef BLM_ADAPT_BURST_EVNTS
+#define BLM_ADAPT_BURST_EVNTS 32
+#endif
+
+#ifndef BLM_ADAPT_BURST_FILL
+#define BLM_ADAPT_BURST_FILL 1
+#endif
+
+#ifndef BLM_ADAPT_IDLE_SHF
+#define BLM_ADAPT_IDLE_SHF 4
+#endif
+
+/*
+ * Buffer rebalancing between NBIs (BLM_REBALANCE, needs SPLIT_EMU_RINGS).
+ * Every BLM_REBALANCE_TICKS the egress context of a BLQ compares the depth
+ * of its EMU ring with the ring of the same BLQ on the other NBI. While its
+ * own ring holds more than BLM_REBALANCE_HWM buffers and the other ring less
+ * than BLM_REBALANCE_LWM, buffers leaving the TM BLQ for the EMU are
+ * journaled to the other ring. Both rings must be sized to hold the buffers
+ * of both NBIs.
+ */
+#ifndef BLM_REBALANCE_TICKS
+#define BLM_REBALANCE_TICKS 4096
+#endif
+
+#ifndef BLM_REBALANCE_HWM
+#define BLM_REBALANCE_HWM 1024
+#endif
+
+#ifndef BLM_REBALANCE_LWM
+#define BLM_REBALANCE_LWM 256
+#endif
+
 /*
  * Pre-Load Error checks
  */
@@ -59,6 +119,11 @@
     .alloc_mem id        i0.ctm                 island  BLQ_STATS_SIZE 8
 #endloop
 
+#ifdef BLM_TELEMETRY
+    /* Per BLQ telemetry read by the host, see _h/blm_internal.h */
+    .alloc_mem BLM_TELEM_BASE_/**/BLM_INSTANCE_ID    i24.emem             global  BLM_TELEM_SIZE BLM_TELEM_SIZE
+#endif
+
 #ifndef SINGLE_NBI
     #define BLM_NBI_MODE        BLM_DUAL_NBI_MODE
 
@@ -244,6 +309,12 @@
             .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_CACHE_ADDR_OFFSET BLM_NBI_BLQ/**/id/**/_CACHE_BASE
             .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET 0
             .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_DMA_EVNT_PEND_CNT_OFFSET 0
+            .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_TELEM_SEQ_OFFSET 0
+            .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_CACHE_LWM_HITS_OFFSET 0
+            .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_ADAPT_TIER_OFFSET BLM_ADAPT_TIER_NORMAL
+            .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET BLM_ADAPT_FILL_ALL
+            .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_ADAPT_WIN_EVNTS_OFFSET 0
+            .init BLQ/**/id/**/_DESC_LMEM_BASE+BLM_LM_BLQ_REBAL_DONATE_OFFSET 0
         #endloop
     #else
         .begin
@@ -266,6 +337,28 @@
         immed[lmaddr[BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET], 0]
         immed[lmaddr[BLM_LM_BLQ_DMA_EVNT_PEND_CNT_OFFSET], 0]
         immed[lmaddr[BLM_LM_BLQ_CACHE_RDWR_BUSY_OFFSET], 0]
+        immed[lmaddr[BLM_LM_BLQ_TELEM_SEQ_OFFSET], 0]
+        immed[lmaddr[BLM_LM_BLQ_CACHE_LWM_HITS_OFFSET], 0]
+        immed[lmaddr[BLM_LM_BLQ_ADAPT_TIER_OFFSET], BLM_ADAPT_TIER_NORMAL]
+        immed[lmaddr[BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET], BLM_ADAPT_FILL_ALL]
+        immed[lmaddr[BLM_LM_BLQ_ADAPT_WIN_EVNTS_OFFSET], 0]
+        immed[lmaddr[BLM_LM_BLQ_REBAL_DONATE_OFFSET], 0]
+    #endif
+    #ifdef BLM_ADAPTIVE_REFILL
+        .begin
+        .reg now
+        local_csr_rd[TIMESTAMP_LOW]
+        immed[now, 0]
+        alu[lmaddr[BLM_LM_BLQ_ADAPT_WIN_END_OFFSET], --, b, now]
+        .end
+    #endif
+    #ifdef BLM_REBALANCE
+        .begin
+        .reg now
+        local_csr_rd[TIMESTAMP_LOW]
+        immed[now, 0]
+        alu[lmaddr[BLM_LM_BLQ_REBAL_NEXT_OFFSET], --, b, now]
+        .end
     #endif
         #define_eval INGRESS_BLQ_NULL_RECYCLE   ((BLM_BLQ_NULL_RECYCLE_MASK >>blq) & 1)
         #define_eval EGRESS_BLQ_NULL_RECYCLE    ((BLM_BLQ_NULL_RECYCLE_MASK >>(4+blq)) & 1)
@@ -633,6 +726,191 @@ end_cache_fill#:
 .end
 #endm /* blm_stats */
 
+/*
+ * Classify the DMA event rate of the BLQ at the end of a window and set the
+ * alarm interval for the next wait.
+ */
+#macro blm_adapt_update()
+.begin
+    .reg now
+    .reg tmp
+    .reg evnts
+
+    local_csr_rd[TIMESTAMP_LOW]
+    immed[now, 0]
+    alu[--, now, -, BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_WIN_END_OFFSET]]
+    bmi[adapt_window_open#]
+
+    alu[evnts, blq_evnt_cnt, -, BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_WIN_EVNTS_OFFSET]]
+    alu[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_WIN_EVNTS_OFFSET], --, b, blq_evnt_cnt]
+    move(tmp, BLM_ADAPT_WINDOW_TICKS)
+    alu[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_WIN_END_OFFSET], now, +, tmp]
+    immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET], BLM_ADAPT_FILL_ALL]
+    .if (evnts == 0)
+        immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET], BLM_ADAPT_TIER_IDLE]
+    .elif (evnts >= BLM_ADAPT_BURST_EVNTS)
+        immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET], BLM_ADAPT_TIER_BURST]
+        immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET], BLM_ADAPT_BURST_FILL]
+    .else
+        immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET], BLM_ADAPT_TIER_NORMAL]
+    .endif
+
+adapt_window_open#:
+    local_csr_rd[MAILBOX1]
+    immed[to_ticks, 0]
+    .if (BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET] == BLM_ADAPT_TIER_IDLE)
+        alu[to_ticks, --, b, to_ticks, <<BLM_ADAPT_IDLE_SHF]
+    .endif
+.end
+#endm /* blm_adapt_update */
+
+/*
+ * Setup the EMU ring of the BLQ on the other NBI for an egress context
+ */
+#macro blm_init_rebalance(blq)
+#ifdef BLM_REBALANCE
+    #define_eval _PEER_NBI  (17 - NBII)
+    move(peer_addr, ((_BLM_NBI/**/_PEER_NBI/**/_BLQ/**/blq/**/_EMU_Q_BASE >>8) & 0xFF000000))
+    move(peer_ringid, BLM_NBI/**/_PEER_NBI/**/_BLQ/**/blq/**/_EMU_QID)
+    #undef _PEER_NBI
+#endif
+#endm /* blm_init_rebalance */
+
+/*
+ * Select the EMU ring for buffers pulled from the TM BLQ, see
+ * BLM_REBALANCE. The decision is kept in LM until the next check.
+ */
+#macro blm_rebalance_select(out_addr, out_ringid)
+.begin
+    .reg now
+    .reg tmp
+    .reg own_cnt
+    .reg peer_cnt
+    .sig sig_own_qd sig_peer_qd
+
+    local_csr_rd[TIMESTAMP_LOW]
+    immed[now, 0]
+    alu[--, now, -, BLM_BLQ_LM_REF[BLM_LM_BLQ_REBAL_NEXT_OFFSET]]
+    bmi[rebalance_check_done#]
+    move(tmp, BLM_REBALANCE_TICKS)
+    alu[BLM_BLQ_LM_REF[BLM_LM_BLQ_REBAL_NEXT_OFFSET], now, +, tmp]
+
+    mem[push_qdesc, $nbitmbuf[0], addr, <<8, ringid], sig_done[sig_own_qd]
+    mem[push_qdesc, $nbitmbuf[4], peer_addr, <<8, peer_ringid], sig_done[sig_peer_qd]
+    ctx_arb[sig_own_qd, sig_peer_qd], all
+    /* q_count is bits [23:0] of the third descriptor word */
+    alu[tmp, --, b, $nbitmbuf[2]]
+    alu[own_cnt, tmp, AND~, 0xff, <<24]
+    alu[tmp, --, b, $nbitmbuf[6]]
+    alu[peer_cnt, tmp, AND~, 0xff, <<24]
+
+    immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_REBAL_DONATE_OFFSET], 0]
+    move(tmp, BLM_REBALANCE_HWM)
+    .if (own_cnt > tmp)
+        move(tmp, BLM_REBALANCE_LWM)
+        .if (peer_cnt < tmp)
+            immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_REBAL_DONATE_OFFSET], 1]
+        .endif
+    .endif
+
+rebalance_check_done#:
+    .if (BLM_BLQ_LM_REF[BLM_LM_BLQ_REBAL_DONATE_OFFSET] != 0)
+        alu[out_addr, --, b, peer_addr]
+        alu[out_ringid, --, b, peer_ringid]
+    .else
+        alu[out_addr, --, b, addr]
+        alu[out_ringid, --, b, ringid]
+    .endif
+.end
+#endm /* blm_rebalance_select */
+
+/*
+ * Setup the telemetry block of an ingress context
+ */
+#macro blm_init_telem(blq)
+#ifdef BLM_TELEMETRY
+    move(telem_base, ((BLM_TELEM_BASE_/**/BLM_INSTANCE_ID + (blq * BLM_TELEM_BLQ_SIZE)) & 0xffffffff))
+    immed[telem_blq, blq]
+    local_csr_rd[TIMESTAMP_LOW]
+    immed[telem_next, 0]
+#endif
+#endm /* blm_init_telem */
+
+/*
+ * Count a cache low watermark hit
+ */
+#macro blm_telem_lwm_check()
+#ifdef BLM_TELEMETRY
+    .if (BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET] < BLM_TELEM_CACHE_LWM)
+        alu[BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_LWM_HITS_OFFSET], BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_LWM_HITS_OFFSET], +, 1]
+    .endif
+#endif
+#endm /* blm_telem_lwm_check */
+
+/*
+ * Write the telemetry block of the BLQ if the sample interval has passed.
+ * $nbidmabuf is free between cache fills and is used for all transfers.
+ */
+#macro blm_telem_sample()
+#ifdef BLM_TELEMETRY
+.begin
+    .reg now
+    .reg tmp
+    .reg telem_hi
+    .reg offset
+    .sig sig_telem sig_dma_status sig_tm_status
+
+    local_csr_rd[TIMESTAMP_LOW]
+    immed[now, 0]
+    alu[--, now, -, telem_next]
+    bmi[end_telem_sample#]
+    move(tmp, BLM_TELEM_TICKS)
+    alu[telem_next, now, +, tmp]
+
+    /* Refill/drain counters, the egress context shares the stats block */
+    immed[tmp, 0]
+    mem[read, $nbidmabuf[0], tmp, <<8, blq_stats_base, 8], sig_done[sig_telem]
+    ctx_arb[sig_telem]
+    aggregate_copy($nbidmabuf, $nbidmabuf, 16)
+    move(telem_hi, ((BLM_TELEM_BASE_/**/BLM_INSTANCE_ID >>8) & 0xFF000000))
+    alu[offset, telem_base, +, BLM_TELEM_CNTRS]
+    mem[write, $nbidmabuf[0], telem_hi, <<8, offset, 8], sig_done[sig_telem]
+    ctx_arb[sig_telem]
+
+    /* NBI BLQ pointers and the EMU ring queue descriptor */
+    blm_blq_status(NBII_lsb, telem_blq, ingress, $nbidmabuf[0], sig_dma_status, SIG_NONE)
+    blm_blq_status(NBII_lsb, telem_blq, egress, $nbidmabuf[2], sig_tm_status, SIG_NONE)
+    mem[push_qdesc, $nbidmabuf[4], addr, <<8, ringid], sig_done[sig_telem]
+    ctx_arb[sig_dma_status, sig_tm_status, sig_telem], all
+
+    alu[tmp, BLM_BLQ_LM_REF[BLM_LM_BLQ_TELEM_SEQ_OFFSET], +, 1]
+    alu[BLM_BLQ_LM_REF[BLM_LM_BLQ_TELEM_SEQ_OFFSET], --, b, tmp]
+    alu[$nbidmabuf[0], --, b, tmp]
+    alu[$nbidmabuf[1], --, b, now]
+    alu[$nbidmabuf[2], --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET]]
+    alu[$nbidmabuf[3], --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_DMA_EVNT_PEND_CNT_OFFSET]]
+    /* q_count is bits [23:0] of the third descriptor word */
+    alu[tmp, --, b, $nbidmabuf[6]]
+    alu[$nbidmabuf[4], tmp, AND~, 0xff, <<24]
+    alu[$nbidmabuf[5], --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_LWM_HITS_OFFSET]]
+    alu[$nbidmabuf[6], --, b, $nbidmabuf[0]]
+    alu[$nbidmabuf[7], --, b, $nbidmabuf[1]]
+    alu[$nbidmabuf[8], --, b, $nbidmabuf[2]]
+    alu[$nbidmabuf[9], --, b, $nbidmabuf[3]]
+    alu[$nbidmabuf[10], --, b, cache_hwm]
+    alu[$nbidmabuf[11], --, b, cache_size]
+    immed[$nbidmabuf[12], 0]
+    immed[$nbidmabuf[13], 0]
+    immed[$nbidmabuf[14], 0]
+    immed[$nbidmabuf[15], 0]
+    mem[write, $nbidmabuf[0], telem_hi, <<8, telem_base, 8], sig_done[sig_telem]
+    ctx_arb[sig_telem]
+
+end_telem_sample#:
+.end
+#endif
+#endm /* blm_telem_sample */
+
 /*
  *
  */
@@ -1203,7 +1481,7 @@ ctx0#:
     blm_cfg_blq_evnts(NBII_lsb, 3, egress, NBI_BLQ_EVENT_THRESHOLD_ENCODING, 1, 0)
 
     move(blq_stats_base, (CTM_NBI_BLQ0_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, ((_BLM_NBI/**/_NBIX/**/_BLQ0_EMU_Q_BASE >>8)&0xFF000000))
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ0_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ0_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1218,12 +1496,13 @@ ctx0#:
     blm_init_blq_lm_index(BLQ0_DESC_LMEM_BASE)
     /* Initialize LM */
     blm_init_lm(BLM_BLQ_LM_REF, 0, BLM_NBI_BLQ0_CACHE_BASE)
+    blm_init_telem(0)
     blm_init_info_section()
     /* This should be last macro to be called per context */
     blm_is_blq_enable(0, blm_ingress_blq_processing#)
 ctx1#:
     move(blq_stats_base, (CTM_NBI_BLQ0_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ0_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ0_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ0_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1233,10 +1512,11 @@ ctx1#:
     blm_init_filter_number(cls_ap_filter_number, BLM_BLQ1_AP_FILTER_NUM)
     /* Setup per BLQ LM index */
     blm_init_blq_lm_index(BLQ0_DESC_LMEM_BASE)
+    blm_init_rebalance(0)
     blm_is_blq_enable(4, blm_egress_blq_processing#)
 ctx2#:
     move(blq_stats_base, (CTM_NBI_BLQ1_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ1_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ1_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ1_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1249,10 +1529,11 @@ ctx2#:
     blm_init_blq_lm_index(BLQ1_DESC_LMEM_BASE)
     /* Initialize LM */
     blm_init_lm(BLM_BLQ_LM_REF, 1, BLM_NBI_BLQ1_CACHE_BASE)
+    blm_init_telem(1)
     blm_is_blq_enable(1, blm_ingress_blq_processing#)
 ctx3#:
     move(blq_stats_base, (CTM_NBI_BLQ1_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ1_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ1_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ1_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1262,10 +1543,11 @@ ctx3#:
     blm_init_filter_number(cls_ap_filter_number, BLM_BLQ3_AP_FILTER_NUM)
     /* Setup per BLQ LM index */
     blm_init_blq_lm_index(BLQ1_DESC_LMEM_BASE)
+    blm_init_rebalance(1)
     blm_is_blq_enable(5, blm_egress_blq_processing#)
 ctx4#:
     move(blq_stats_base, (CTM_NBI_BLQ2_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ2_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ2_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ2_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1278,10 +1560,11 @@ ctx4#:
     blm_init_blq_lm_index(BLQ2_DESC_LMEM_BASE)
     /* Initialize LM */
     blm_init_lm(BLM_BLQ_LM_REF, 2, BLM_NBI_BLQ2_CACHE_BASE)
+    blm_init_telem(2)
     blm_is_blq_enable(2, blm_ingress_blq_processing#)
 ctx5#:
     move(blq_stats_base, (CTM_NBI_BLQ2_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ2_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ2_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ2_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1291,10 +1574,11 @@ ctx5#:
     blm_init_filter_number(cls_ap_filter_number, BLM_BLQ5_AP_FILTER_NUM)
     /* Setup per BLQ LM index */
     blm_init_blq_lm_index(BLQ2_DESC_LMEM_BASE)
+    blm_init_rebalance(2)
     blm_is_blq_enable(6, blm_egress_blq_processing#)
 ctx6#:
     move(blq_stats_base, (CTM_NBI_BLQ3_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ3_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ3_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ3_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1307,10 +1591,11 @@ ctx6#:
     blm_init_blq_lm_index(BLQ3_DESC_LMEM_BASE)
     /* Initialize LM */
     blm_init_lm(BLM_BLQ_LM_REF, 3, BLM_NBI_BLQ3_CACHE_BASE)
+    blm_init_telem(3)
     blm_is_blq_enable(3, blm_ingress_blq_processing#)
 ctx7#:
     move(blq_stats_base, (CTM_NBI_BLQ3_STATS_BASE & 0xffffffff))
-    #define_eval _NBIX   (8 + BLM_INSTANCE_ID)
+    #define_eval _NBIX   NBII
     move(addr, (_BLM_NBI/**/_NBIX/**/_BLQ3_EMU_Q_BASE >>8)&0xFF000000)
     move(ringid, BLM_NBI/**/_NBIX/**/_BLQ3_EMU_QID)
     move(cache_hwm, (BLM_NBI_BLQ3_CACHE_SIZE - BLM_NBI_BLQ_CACHE_DEFICIT))
@@ -1320,6 +1605,7 @@ ctx7#:
     blm_init_filter_number(cls_ap_filter_number, BLM_BLQ7_AP_FILTER_NUM)
     /* Setup per BLQ LM index */
     blm_init_blq_lm_index(BLQ3_DESC_LMEM_BASE)
+    blm_init_rebalance(3)
     blm_is_blq_enable(7, blm_egress_blq_processing#)
 
 blm_ctx_init_end#:
@@ -1368,7 +1654,7 @@ blm_ctx_init_end#:
     .init_ctx 7 blq_stats_base CTM_NBI_BLQ3_STATS_BASE
 
     /* Initialize Ring number */
-    #if BLM_INSTANCE_ID == 0
+    #if NBII == 8
          .init_ctx 0  ringid BLM_NBI8_BLQ0_QID
          .init_ctx 1  ringid BLM_NBI8_BLQ0_QID
          .init_ctx 2  ringid BLM_NBI8_BLQ1_QID
@@ -1409,6 +1695,21 @@ blm_ctx_init_end#:
     .reg event_data
     .reg is_aps
     .reg to_ticks
+    #ifdef BLM_TELEMETRY
+        .reg telem_base
+        .reg telem_blq
+        .reg telem_next
+    #endif
+    #ifdef BLM_ADAPTIVE_REFILL
+        .reg pend_max
+        .reg fill_cnt
+    #endif
+    #ifdef BLM_REBALANCE
+        .reg peer_addr
+        .reg peer_ringid
+        .reg jrnl_addr
+        .reg jrnl_ringid
+    #endif
 
     /* Transfer Registers */
     .reg volatile $event_data[1]
@@ -1489,7 +1790,15 @@ blm_egress_blq_processing#:
                     alu[cache_cnt, --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET]]
                     blm_cache_release_lock()
                     .if (cache_cnt >= cache_hwm)
-                        blm_egress_pull_buffers_to_emu_ring(NbiNum, blq, addr, ringid)
+                        #ifdef BLM_REBALANCE
+                            blm_rebalance_select(jrnl_addr, jrnl_ringid)
+                            blm_egress_pull_buffers_to_emu_ring(NbiNum, blq, jrnl_addr, jrnl_ringid)
+                            .if (BLM_BLQ_LM_REF[BLM_LM_BLQ_REBAL_DONATE_OFFSET] != 0)
+                                blm_stats(BLM_STATS_REBALANCE_DONATED)
+                            .endif
+                        #else
+                            blm_egress_pull_buffers_to_emu_ring(NbiNum, blq, addr, ringid)
+                        #endif
                         blm_stats(BLM_STATS_RECYCLE_TM_TO_EMU)
                     .else
                         blm_egress_pull_buffers_to_cache(NbiNum, blq, NBI_BLQ_EVENT_THRESHOLD)
@@ -1590,7 +1899,22 @@ service_check#:
                 blm_incr_dma_evnt_pend_cnt()
             .endw
 
+        #ifdef BLM_ADAPTIVE_REFILL
+            immed[pend_max, BLM_MAX_DMA_PENDING_EVNTS]
+            .if (BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET] == BLM_ADAPT_TIER_IDLE)
+                .if (is_aps)
+                    /* Traffic after an idle window, expect a burst */
+                    immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET], BLM_ADAPT_TIER_BURST]
+                    immed[BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET], BLM_ADAPT_BURST_FILL]
+                .else
+                    /* No TM recycle to wait for, hand back all pending events */
+                    immed[pend_max, 0]
+                .endif
+            .endif
+            .while (BLM_BLQ_LM_REF[BLM_LM_BLQ_DMA_EVNT_PEND_CNT_OFFSET] > pend_max)
+        #else
             .while (BLM_BLQ_LM_REF[BLM_LM_BLQ_DMA_EVNT_PEND_CNT_OFFSET] > BLM_MAX_DMA_PENDING_EVNTS)
+        #endif
                 blm_cache_acquire_lock()
                 alu[cache_cnt, --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET]]
                 blm_cache_release_lock()
@@ -1605,13 +1929,31 @@ service_check#:
                     .break
                 .endif
             .endw
-
+            blm_telem_lwm_check()
+
+        #ifdef BLM_ADAPTIVE_REFILL
+            /* Outside of a burst only alarms refill, as without the mode.
+             * In a burst DMA events refill too, at most fill_max chunks per
+             * wakeup. */
+            .if (BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_TIER_OFFSET] != BLM_ADAPT_TIER_BURST)
+                alu[--, is_aps, XOR, 1]
+                beq[cache_fill_complete#]
+            .endif
+            alu[fill_cnt, --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_ADAPT_FILL_MAX_OFFSET]]
+        #else
             alu[--, is_aps, XOR, 1]
             beq[cache_fill_complete#]
+        #endif
             blm_cache_acquire_lock()
             alu[cache_cnt, --, b, BLM_BLQ_LM_REF[BLM_LM_BLQ_CACHE_ENTRY_CNT_OFFSET]]
             blm_cache_release_lock()
             .while (cache_cnt < cache_hwm)
+            #ifdef BLM_ADAPTIVE_REFILL
+                .if (fill_cnt == 0)
+                    .break
+                .endif
+                alu[fill_cnt, fill_cnt, -, 1]
+            #endif
                 D(MAILBOX3, 0x3333)
                 blm_cache_fill(addr, ringid, sig_memget0, cache_fill_complete#)
                 blm_cache_acquire_lock()
@@ -1620,6 +1962,7 @@ service_check#:
             .endw
             cache_fill_complete#:
         .endif
+        blm_telem_sample()
         D(MAILBOX1, 0xaaaa0000)
 
         #ifdef DEBUG
@@ -1644,8 +1987,12 @@ service_check#:
 
         /* update deficit pointers */
         alu[blq_cnt_prev, --, b, blq_cnt_cur]
+    #ifdef BLM_ADAPTIVE_REFILL
+        blm_adapt_update()
+    #else
         local_csr_rd[MAILBOX1]
         immed[to_ticks, 0]
+    #endif
     .endw
 .end
 
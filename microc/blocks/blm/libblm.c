@@ -23,6 +23,40 @@
 
 #include "blm.h"
 
+/*
+ * Ring number and address of the EMU ring of a BLQ
+ */
+__intrinsic static void
+blm_ring_get(unsigned int blq, unsigned int *rnum, mem_ring_addr_t *raddr_hi)
+{
+#ifdef BLM_EMU_RING_SPREAD
+    /* The rings are on different EMUs, each with its own ring ID */
+    switch (blq) {
+    case 0:
+        *rnum = BLM_EMU_RING_ID(8,0);
+        *raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ0_EMU_Q_BASE);
+        break;
+    case 1:
+        *rnum = BLM_EMU_RING_ID(8,1);
+        *raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ1_EMU_Q_BASE);
+        break;
+    case 2:
+        *rnum = BLM_EMU_RING_ID(8,2);
+        *raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ2_EMU_Q_BASE);
+        break;
+    default:
+        *rnum = BLM_EMU_RING_ID(8,3);
+        *raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ3_EMU_Q_BASE);
+        break;
+    }
+#else
+    /* BLM ring IDs are always allocated in an ordered sequance */
+    *rnum = blq + BLM_EMU_RING_ID(8,0);
+    /* All BLM rings are allocated in the same island */
+    *raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ0_EMU_Q_BASE);
+#endif
+}
+
 __intrinsic int
 __blm_buf_alloc(__xread blm_buf_handle_t *buf, unsigned int blq,
                 SIGNAL_PAIR *sigpair, sync_t sync)
@@ -46,10 +80,7 @@ __blm_buf_alloc_bulk(__xread blm_buf_handle_t *bufs, unsigned int count,
     try_ctassert(blq <= 3);
     try_ctassert(count <= 16);
 
-    /* BLM ring IDs are always allocated in an ordered sequance */
-    rnum = blq + BLM_EMU_RING_ID(8,0);
-    /* All BLM rings are allocated in the same island */
-    raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ0_EMU_Q_BASE);
+    blm_ring_get(blq, &rnum, &raddr_hi);
 
     if (sync == sig_done) {
         __mem_ring_pop(rnum, raddr_hi, bufs, (count << 2), 64,
@@ -82,10 +113,7 @@ blm_buf_free(blm_buf_handle_t buf, unsigned int blq)
 
     try_ctassert(blq <= 3);
 
-    /* BLM ring IDs are always allocated in an ordered sequance */
-    rnum = blq + BLM_EMU_RING_ID(8,0);
-    /* All BLM rings are allocated in the same island */
-    raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ0_EMU_Q_BASE);
+    blm_ring_get(blq, &rnum, &raddr_hi);
 
     mem_ring_journal_fast(rnum, raddr_hi, buf);
 }
@@ -100,10 +128,7 @@ __blm_buf_free_bulk(__xwrite blm_buf_handle_t *bufs, unsigned int count,
     try_ctassert(blq <= 3);
     try_ctassert(count <= 16);
 
-    /* BLM ring IDs are always allocated in an ordered sequance */
-    rnum = blq + BLM_EMU_RING_ID(8,0);
-    /* All BLM rings are allocated in the same island */
-    raddr_hi = mem_ring_get_addr((__dram void *)BLM_NBI8_BLQ0_EMU_Q_BASE);
+    blm_ring_get(blq, &rnum, &raddr_hi);
 
     __mem_ring_journal(rnum, raddr_hi, bufs, (count << 2), 64, sync, sig);
 }
@@ -213,6 +213,15 @@
  *
  ************************************************************************/
 
+/* QoS hierarchy generated by tools/tm_gen.py, see the tool for the format.
+ * The generated nbi_tm_gen.h must be on the include path. */
+#ifdef NBI_TM_GEN_CONFIG
+    #ifdef NBI_TM_H_0_Q
+        #error "NBI_TM_GEN_CONFIG and NBI_TM_H_0_Q can not be used together"
+    #endif
+    #include "nbi_tm_gen.h"
+#endif
+
 /* Packet Sequencing/Ordering.
  *
  * Options:
@@ -71,7 +71,7 @@
  * @NET_ETH_TCI_VLAN_PRESENT    Appropriate the CFI for VLAN indication
  * @NET_ETH_TCI_VID_of          VLAN ID
  */
-#define NET_ETH_TCI_PCP_of(_x)          (((_x) >> 13) & 0x3)
+#define NET_ETH_TCI_PCP_of(_x)          (((_x) >> 13) & 0x7)
 #define NET_ETH_TCI_CFI_MASK            0x1000
 #define NET_ETH_TCI_VLAN_PRESENT        (NET_ETH_TCI_CFI_MASK)
 #define NET_ETH_TCI_VID_of(_x)          ((_x) & 0x0fff)
@@ -0,0 +1,140 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/age_ctl.py
+# @brief        Monitor the wire app aging timer wheel
+#
+
+"""Show the state of the aging timer wheel, switch the export of expired
+entries on or off and print the exported records.
+
+The layouts match apps/wire/age_wheel.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import socket
+import struct
+import sys
+
+import nfp_rtsym
+from host_ring import HostRing
+
+CFG_SYM = "_age_cfg"
+CNTR_SYM = "_age_cntrs"
+CNT_SYM = "_age_cnt"
+EXPORT_SYM = "_age_export"
+
+LEVELS = 3
+SLOTS = 64
+BUCKET_SZ = 4096
+EXPORT_ENTRIES = 4096
+REC_WORDS = 9
+
+CNTRS = ("linked", "relinked", "expired", "stale", "overflow", "exported",
+         "late")
+CNT_MASK = (1 << 31) - 1
+
+TBL_CT = 1
+TBL_FR = 2
+CT_STATES = {1: "SYN_SENT", 2: "SYN_RECV", 3: "ESTABLISHED", 4: "FIN_WAIT",
+             5: "CLOSE_WAIT", 6: "LAST_ACK", 7: "TIME_WAIT", 8: "CLOSE"}
+
+
+def ip_str(addr):
+    return socket.inet_ntoa(struct.pack("!I", addr))
+
+
+def cmd_show(args):
+    vals = nfp_rtsym.read_u64(CNTR_SYM, 0, len(CNTRS))
+    for name, val in zip(CNTRS, vals):
+        print("%-10s %d" % (name, val))
+    cnts = nfp_rtsym.read_words(CNT_SYM, 0, LEVELS * SLOTS)
+    for lvl in range(LEVELS):
+        level = [min(c & CNT_MASK, BUCKET_SZ) for c in cnts[lvl * SLOTS:
+                                                  (lvl + 1) * SLOTS]]
+        print("level %d: %d links, fullest bucket %d/%d" %
+              (lvl, sum(level), max(level), BUCKET_SZ))
+
+
+def cmd_export(args):
+    nfp_rtsym.write_words(CFG_SYM, 0, [(1 << 31) if args.on == "on" else 0])
+
+
+def fmt_rec(rec):
+    tbl, idx, ts = rec[0] >> 28, rec[0] & 0xfffff, rec[1]
+    data = rec[2:]
+    if tbl == TBL_CT:
+        state = (data[3] >> 24) & 0xf
+        orig = "b" if data[3] & (1 << 23) else "a"
+        return ("%d ct %d: %s:%d <-> %s:%d %s opened by %s last seen %d" %
+                (ts, idx, ip_str(data[0]), data[2] >> 16, ip_str(data[1]),
+                 data[2] & 0xffff, CT_STATES.get(state, state), orig,
+                 data[4]))
+    if tbl == TBL_FR:
+        return ("%d flow %d: %s:%d -> %s:%d proto %d" %
+                (ts, idx, ip_str(data[0]), data[3] >> 16, ip_str(data[1]),
+                 data[3] & 0xffff, data[2]))
+    return "%d table %d entry %d: %s" % (ts, tbl, idx, " ".join(
+        "0x%08x" % w for w in data))
+
+
+def cmd_dump(args):
+    ring = HostRing(EXPORT_SYM, EXPORT_ENTRIES, REC_WORDS,
+                    start=0 if args.all else None, seq_word=REC_WORDS - 1)
+    try:
+        if args.follow:
+            for rec in ring.follow(args.interval):
+                print(fmt_rec(rec))
+        else:
+            for rec in ring.read(EXPORT_ENTRIES):
+                print(fmt_rec(rec))
+    except KeyboardInterrupt:
+        pass
+    if ring.lost or ring.torn:
+        print("%d records lost, %d torn" % (ring.lost, ring.torn),
+              file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("show", help="show the counters and bucket fill")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("export", help="export expired entries")
+    p.add_argument("on", choices=("on", "off"))
+    p.set_defaults(func=cmd_export)
+
+    p = sub.add_parser("dump", help="print exported records")
+    p.add_argument("--all", action="store_true",
+                   help="start with the records still in the ring")
+    p.add_argument("--follow", action="store_true",
+                   help="keep printing new records")
+    p.add_argument("--interval", type=float, default=1.0)
+    p.set_defaults(func=cmd_dump)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,360 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/blm_model.py
+# @brief        Host model of the BLM refill of a single BLQ
+#
+
+"""Model of the buffers of one BLQ moving between the NBI DMA BLQ, the
+packet pipeline, the NBI TM BLQ, the BLM CTM cache and the EMU ring, used
+to compare the fixed BLM refill with BLM_ADAPTIVE_REFILL.
+
+The model steps in ME timestamp ticks.  Every frame takes a buffer from the
+DMA BLQ (a drop if it is empty) and hands it to the TM BLQ after the
+pipeline latency.  Every NBI_BLQ_EVENT_THRESHOLD buffers raise a DMA or TM
+BLQ event.  The ingress and egress contexts of the BLQ serve one event or
+alarm at a time and are busy for the cycles of the commands they issue,
+the buffers they move arrive when the commands complete.  The command
+costs are estimates, check them against the BLM stats of a real run.
+
+The traffic is a list of rate:duration phases (Mpps:us).
+"""
+
+from __future__ import print_function
+
+import argparse
+import collections
+import sys
+
+from policer_calc import TSC_CYCLES
+
+THRESHOLD = 32
+CACHE_DEFICIT = 47
+CACHE_FILL = 16
+MAX_PENDING = 5
+
+TIER_IDLE = 0
+TIER_NORMAL = 1
+TIER_BURST = 2
+
+# ME cycles of the ingress and egress context commands
+COSTS = {
+    "event": 30,            # Event dispatch and deficit update
+    "push": 120,            # Cache read and push of 32 buffers to the DMA BLQ
+    "pop": 250,             # EMU ring pop of up to 16 buffers into the cache
+    "recycle": 100,         # Direct TM to DMA BLQ recycle
+    "to_cache": 150,        # TM BLQ pull into the cache
+    "to_ring": 300,         # TM BLQ pull onto the EMU ring
+}
+
+
+class Stats(object):
+    FIELDS = ("frames", "drops", "dma_min", "dma_events", "alarms",
+              "in_busy", "eg_busy", "cache_low", "underflow", "ticks")
+
+    def __init__(self):
+        for f in self.FIELDS:
+            setattr(self, f, 0)
+        self.dma_min = None
+
+
+class BlqModel(object):
+    """Buffers of one BLQ under the fixed or adaptive BLM refill."""
+
+    def __init__(self, adaptive=False, blq_bufs=576, emu_bufs=576,
+                 cache_size=128, latency_us=2.0, alarm_ticks=32,
+                 me_clock_mhz=800.0, costs=None, window_ticks=1024,
+                 burst_evnts=32, burst_fill=1, idle_shf=4):
+        self.adaptive = adaptive
+        self.tick_us = TSC_CYCLES / me_clock_mhz
+        self.latency = max(1, int(latency_us / self.tick_us))
+        self.alarm_ticks = alarm_ticks
+        self.costs = dict(COSTS)
+        self.costs.update(costs or {})
+        self.cache_hwm = cache_size - CACHE_DEFICIT
+        self.window_ticks = window_ticks
+        self.burst_evnts = burst_evnts
+        self.burst_fill = burst_fill
+        self.idle_shf = idle_shf
+
+        self.t = 0
+        self.dma = blq_bufs
+        self.tm = 0
+        self.cache = 0
+        self.ring = emu_bufs
+        self.pend = 0
+        self.dma_used = 0
+        self.dma_evq = 0
+        self.frac = 0.0
+        self.inflight = collections.deque()
+        self.deliveries = []
+
+        self.in_free = 0
+        self.eg_free = 0
+        self.next_alarm = alarm_ticks
+        self.tier = TIER_NORMAL
+        self.fill_max = cache_size
+        self.win_end = window_ticks
+        self.win_evnts = 0
+        self.evnt_cnt = 0
+
+    def total(self):
+        return (self.dma + self.tm + self.cache + self.ring +
+                sum(n for _, n in self.inflight) +
+                sum(n for _, _, n in self.deliveries))
+
+    def _deliver(self, cycles, target, n):
+        done = self.t + -(-cycles // TSC_CYCLES)
+        self.deliveries.append((done, target, n))
+        return done
+
+    def _ingress(self, is_event, st):
+        cycles = self.costs["event"]
+        moves = []
+        limit = MAX_PENDING
+        if is_event:
+            self.pend += 1
+            self.evnt_cnt += 1
+            st.dma_events += 1
+            if self.adaptive and self.tier == TIER_IDLE:
+                # Traffic after an idle window, expect a burst
+                self.tier, self.fill_max = TIER_BURST, self.burst_fill
+        else:
+            st.alarms += 1
+            if self.adaptive and self.tier == TIER_IDLE:
+                limit = 0
+
+        while self.pend > limit:
+            if self.cache < THRESHOLD:
+                st.cache_low += 1
+                break
+            self.cache -= THRESHOLD
+            self.pend -= 1
+            cycles += self.costs["push"]
+            moves.append((cycles, "dma", THRESHOLD))
+
+        # Only alarms refill, DMA events too in an adaptive burst
+        if not is_event or (self.adaptive and self.tier == TIER_BURST):
+            need = self.cache_hwm - self.cache
+            fills = self.fill_max if self.adaptive else need
+            while need > 0 and fills > 0:
+                if self.ring == 0:
+                    st.underflow += 1
+                    break
+                fills -= 1
+                n = min(CACHE_FILL, need, self.ring)
+                self.ring -= n
+                need -= n
+                cycles += self.costs["pop"]
+                moves.append((cycles, "cache", n))
+
+        for c, target, n in moves:
+            self._deliver(c, target, n)
+        done = self._deliver(cycles, None, 0)
+        st.in_busy += done - self.t
+
+        to_ticks = self.alarm_ticks
+        if self.adaptive:
+            if self.t >= self.win_end:
+                evnts = self.evnt_cnt - self.win_evnts
+                self.win_evnts = self.evnt_cnt
+                self.win_end = self.t + self.window_ticks
+                self.fill_max = self.cache_hwm
+                if evnts == 0:
+                    self.tier = TIER_IDLE
+                elif evnts >= self.burst_evnts:
+                    self.tier, self.fill_max = TIER_BURST, self.burst_fill
+                else:
+                    self.tier = TIER_NORMAL
+            if self.tier == TIER_IDLE:
+                to_ticks <<= self.idle_shf
+        self.in_free = done
+        self.next_alarm = done + to_ticks
+
+    def _egress(self, st):
+        self.tm -= THRESHOLD
+        cycles = self.costs["event"]
+        if self.pend > 0:
+            self.pend -= 1
+            cycles += self.costs["recycle"]
+            target = "dma"
+        elif self.cache >= self.cache_hwm:
+            cycles += self.costs["to_ring"]
+            target = "ring"
+        else:
+            cycles += self.costs["to_cache"]
+            target = "cache"
+        done = self._deliver(cycles, target, THRESHOLD)
+        st.eg_busy += done - self.t
+        self.eg_free = done
+
+    def take(self, frames):
+        """Give buffers from the DMA BLQ to frames, returns how many got one.
+
+        The buffers return through the TM BLQ after the pipeline latency.
+        """
+        take = min(frames, self.dma)
+        self.dma -= take
+        if take:
+            self.inflight.append((self.t + self.latency, take))
+            self.dma_used += take
+            self.dma_evq += self.dma_used // THRESHOLD
+            self.dma_used %= THRESHOLD
+        return take
+
+    def in_use(self):
+        """Buffers out of the BLM, in the pipeline or waiting in the TM BLQ."""
+        return self.tm + sum(n for _, n in self.inflight)
+
+    def step(self, mpps, st):
+        """Advance the model by one tick at a rate of mpps."""
+        self.frac += mpps * self.tick_us
+        frames = int(self.frac)
+        self.frac -= frames
+        take = self.take(frames)
+        st.frames += frames
+        st.drops += frames - take
+        self.tick(st)
+
+    def tick(self, st):
+        """Move the buffers and run the BLM contexts for one tick."""
+        while self.inflight and self.inflight[0][0] <= self.t:
+            self.tm += self.inflight.popleft()[1]
+        self.tm_evq = self.tm // THRESHOLD
+
+        if self.deliveries:
+            keep = []
+            for d in self.deliveries:
+                if d[0] > self.t:
+                    keep.append(d)
+                elif d[1] is not None:
+                    setattr(self, d[1], getattr(self, d[1]) + d[2])
+            self.deliveries = keep
+
+        if self.t >= self.in_free:
+            if self.dma_evq:
+                self.dma_evq -= 1
+                self._ingress(True, st)
+            elif self.t >= self.next_alarm:
+                self._ingress(False, st)
+        if self.t >= self.eg_free and self.tm_evq:
+            self._egress(st)
+
+        if st.dma_min is None or self.dma < st.dma_min:
+            st.dma_min = self.dma
+        st.ticks += 1
+        self.t += 1
+
+    def run(self, phases):
+        """Run (mpps, us) phases, returns the Stats of each phase."""
+        res = []
+        for mpps, us in phases:
+            st = Stats()
+            for _ in range(int(us / self.tick_us)):
+                self.step(mpps, st)
+            res.append(st)
+        return res
+
+
+def parse_phases(val):
+    phases = []
+    for p in val.split(","):
+        mpps, us = p.split(":")
+        phases.append((float(mpps), float(us)))
+    return phases
+
+
+def line_rate_mpps(gbps, frame):
+    # 20 bytes of preamble and inter frame gap per frame
+    return gbps * 1e3 / ((frame + 20) * 8)
+
+
+def report(name, model, phases, res):
+    print("%s (total %d buffers at the end)" % (name, model.total()))
+    print("  %-16s %8s %7s %7s %8s %8s %6s %6s %7s" %
+          ("phase", "frames", "drops", "dma_min", "events", "alarms",
+           "in%", "eg%", "c_low"))
+    for (mpps, us), st in zip(phases, res):
+        secs = st.ticks * model.tick_us
+        print("  %-16s %8d %7d %7d %8d %8d %6.1f %6.1f %7d" %
+              ("%.1f Mpps %dus" % (mpps, us), st.frames, st.drops,
+               st.dma_min, st.dma_events, st.alarms,
+               100.0 * st.in_busy / st.ticks, 100.0 * st.eg_busy / st.ticks,
+               st.cache_low))
+        if st.alarms:
+            print("  %16s %d alarm wakeups/s" % ("", st.alarms / secs * 1e6))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--phases", type=parse_phases,
+                        default=None, help="rate:duration list in Mpps:us, "
+                        "default idle, 64B at --gbps, idle, 64B at --gbps")
+    parser.add_argument("--gbps", type=float, default=100)
+    parser.add_argument("--blq-bufs", type=int, default=576,
+                        help="buffers in the DMA BLQ at start (BDSRAM bufs)")
+    parser.add_argument("--emu-bufs", type=int, default=576,
+                        help="buffers on the EMU ring at start")
+    parser.add_argument("--cache-size", type=int, default=128,
+                        help="BLM_NBI_BLQn_CACHE_SIZE")
+    parser.add_argument("--latency-us", type=float, default=2.0,
+                        help="DMA to TM BLQ time of a buffer")
+    parser.add_argument("--alarm-ticks", type=int, default=32,
+                        help="ALARM_TICKS (Mailbox1)")
+    parser.add_argument("--me-clock-mhz", type=float, default=800)
+    parser.add_argument("--cost", action="append", default=[],
+                        metavar="NAME=CYCLES", help="override a command "
+                        "cost, one of " + ", ".join(sorted(COSTS)))
+    parser.add_argument("--window-ticks", type=int, default=1024,
+                        help="BLM_ADAPT_WINDOW_TICKS")
+    parser.add_argument("--burst-evnts", type=int, default=32,
+                        help="BLM_ADAPT_BURST_EVNTS")
+    parser.add_argument("--burst-fill", type=int, default=1,
+                        help="BLM_ADAPT_BURST_FILL")
+    parser.add_argument("--policy", choices=("fixed", "adaptive", "both"),
+                        default="both")
+    args = parser.parse_args()
+
+    costs = {}
+    for c in args.cost:
+        name, cycles = c.split("=")
+        if name not in COSTS:
+            parser.error("unknown cost " + name)
+        costs[name] = int(cycles)
+
+    phases = args.phases
+    if phases is None:
+        line = line_rate_mpps(args.gbps, 64)
+        phases = [(0, 100), (line, 200), (0, 100), (line, 200)]
+
+    for adaptive in (False, True):
+        name = "adaptive" if adaptive else "fixed"
+        if args.policy not in (name, "both"):
+            continue
+        model = BlqModel(adaptive=adaptive, blq_bufs=args.blq_bufs,
+                         emu_bufs=args.emu_bufs, cache_size=args.cache_size,
+                         latency_us=args.latency_us,
+                         alarm_ticks=args.alarm_ticks,
+                         me_clock_mhz=args.me_clock_mhz, costs=costs,
+                         window_ticks=args.window_ticks,
+                         burst_evnts=args.burst_evnts,
+                         burst_fill=args.burst_fill)
+        report(name, model, phases, model.run(phases))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,516 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/blm_sim.py
+# @brief        Simulate the NBI buffer and CTM credit configuration
+#
+
+"""Run traffic profiles against the buffer configuration of an NBI.
+
+The settings are read from the firmware headers, by default
+microc/blocks/init/init_config.h and microc/blocks/blm/blm_cfg.h, with the
+-D and -I options of the firmware build.  Paths given on the command line
+are relative to the current directory, like those of the compiler:
+
+  - BLM_NBI_BLQn_CACHE_SIZE, the BLM cache of each BLQ
+  - BLM_NBIx_BLQn_BDSRAM_*_NUM_BUFS and BLM_NBIx_BLQn_EMU_*_NUM_BUFS, the
+    buffers each BLQ starts with in the NBI and on the EMU ring
+  - NBIx_BLQ_EMU_n_PKTBUF_SIZE, the size of these buffers
+  - NBI_DMA_BPn_BLQ_TARGET, the BLQs of each buffer pool
+  - NBIn_DMA_BPE_CONFIG_ME_ISLANDn, the CTM packet and buffer credits
+
+A profile is a packet size mix at a load of the line rate, sent smooth or
+in bursts of back to back frames.  Frames pick a buffer pool by size like
+the Catamaran picocode, take a packet and buffer credit of the next ME
+island and a buffer of the primary or else the secondary BLQ of the pool.
+Both are held for the pipeline latency.  The BLM side of each BLQ is
+tools/blm_model.py, the simulation steps in its ME timestamp ticks.
+
+The report shows the drops by cause, how low the NBI BLQs and the credits
+ran (the headroom) and the configuration problems found on the way.
+"""
+
+from __future__ import print_function
+
+import argparse
+import bisect
+import heapq
+import json
+import os
+import random
+import re
+import sys
+
+from blm_model import BlqModel, Stats, COSTS
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(
+    os.path.abspath(__file__)), ".."))
+HEADERS = ["microc/blocks/init/init_config.h", "microc/blocks/blm/blm_cfg.h"]
+# Assumed by the headers, B0 silicon
+PREDEFINED = {"__REVISION_A0": "0", "__REVISION_B0": "1",
+              "__REVISION_MIN": "1"}
+
+NUM_BLQS = 4
+NUM_BPS = 8
+NUM_ISLANDS = 7
+MEMS = ("IMEM0", "IMEM1", "EMEM0", "EMEM1", "EMEM2", "EMEM0_CACHE",
+        "EMEM1_CACHE", "EMEM2_CACHE")
+# Catamaran picocode buffer pool by frame size
+BP_SIZES = ((192, 0), (1984, 1), (None, 2))
+FRAME_OVERHEAD = 20
+
+
+class ConfigError(Exception):
+    pass
+
+
+class Headers(object):
+    """Just enough of the C preprocessor for the firmware config headers.
+
+    Conditionals, object-like #defines and #include are handled; anything
+    that does not evaluate in an #if counts as false.
+    """
+
+    TOKEN = re.compile(r"[A-Za-z_]\w*")
+
+    def __init__(self, defines=None, incdirs=None):
+        self.macros = dict(PREDEFINED)
+        self.macros.update(defines or {})
+        self.incdirs = incdirs or []
+
+    def read(self, path):
+        with open(path) as f:
+            text = f.read()
+        text = re.sub(r"/\*.*?\*/", " ", text, flags=re.S)
+        text = re.sub(r"//[^\n]*", "", text)
+        text = text.replace("\\\n", " ")
+        stack = []
+        for line in text.split("\n"):
+            m = re.match(r"\s*#\s*(\w+)\s*(.*?)\s*$", line)
+            if not m:
+                continue
+            cmd, rest = m.groups()
+            active = all(s[0] for s in stack)
+            if cmd in ("if", "ifdef", "ifndef"):
+                if cmd == "ifdef":
+                    val = rest in self.macros
+                elif cmd == "ifndef":
+                    val = rest not in self.macros
+                else:
+                    val = active and self.test(rest)
+                val = active and val
+                stack.append([val, val])
+            elif cmd == "elif":
+                top = stack[-1]
+                outer = all(s[0] for s in stack[:-1])
+                top[0] = outer and not top[1] and self.test(rest)
+                top[1] = top[1] or top[0]
+            elif cmd == "else":
+                top = stack[-1]
+                top[0] = all(s[0] for s in stack[:-1]) and not top[1]
+                top[1] = True
+            elif cmd == "endif":
+                stack.pop()
+            elif not active:
+                continue
+            elif cmd == "define":
+                m = re.match(r"(\w+)(\(?)\s*(.*)$", rest)
+                if m.group(2):
+                    continue
+                self.macros[m.group(1)] = m.group(3)
+            elif cmd == "undef":
+                self.macros.pop(rest, None)
+            elif cmd == "include":
+                self.include(rest.strip('"<>'), os.path.dirname(path))
+
+    def include(self, name, cur):
+        for d in [cur] + self.incdirs:
+            path = os.path.join(d, name)
+            if os.path.exists(path):
+                self.read(path)
+                return
+        raise ConfigError("%s not found, included from %s (-I %s)" %
+                          (name, cur, " ".join(self.incdirs) or "none"))
+
+    def expand(self, expr, depth=0):
+        if depth > 16:
+            raise ConfigError("macro recursion in " + expr)
+        expr = re.sub(r"defined\s*\(?\s*(\w+)\s*\)?",
+                      lambda m: "1" if m.group(1) in self.macros else "0",
+                      expr)
+
+        def sub(m):
+            name = m.group(0)
+            if name in self.macros:
+                return "(" + self.expand(self.macros[name], depth + 1) + ")"
+            return name
+        return self.TOKEN.sub(sub, expr)
+
+    def eval(self, expr):
+        py = self.expand(expr)
+        py = re.sub(r"(0x[0-9a-fA-F]+|\d+)[uUlL]+\b", r"\1", py)
+        py = py.replace("&&", " and ").replace("||", " or ")
+        py = re.sub(r"!(?!=)", " not ", py)
+        py = py.replace("/", "//")
+        if self.TOKEN.search(re.sub(r"\b(and|or|not|0x[0-9a-fA-F]+)\b",
+                                    "", py)):
+            raise ConfigError("cannot evaluate " + expr)
+        return eval(py, {"__builtins__": {}})
+
+    def test(self, expr):
+        try:
+            return bool(self.eval(expr))
+        except (ConfigError, SyntaxError, ZeroDivisionError):
+            return False
+
+    def get(self, name, default=None):
+        if name not in self.macros:
+            if default is None:
+                raise ConfigError(name + " is not defined")
+            return default
+        return self.eval(self.macros[name])
+
+    def get_list(self, name):
+        return [self.eval(v) for v in self.macros[name].split(",")]
+
+
+class NbiConfig(object):
+    """The settings of one NBI taken from the headers."""
+
+    def __init__(self, hdr, nbi):
+        self.nbi = nbi
+        blm_nbi = 8 + nbi
+        self.offset = (hdr.get("PKT_NBI_OFFSET", 64) +
+                       hdr.get("NBI_PKT_PREPEND_BYTES", 0))
+        self.split = 256 << hdr.get("SPLIT_LENGTH", 3)
+        self.blqs = []
+        for blq in range(NUM_BLQS):
+            pre = "BLM_NBI%d_BLQ%d_" % (blm_nbi, blq)
+            self.blqs.append({
+                "cache": hdr.get("BLM_NBI_BLQ%d_CACHE_SIZE" % blq),
+                "pktbuf": hdr.get("NBI%d_BLQ_EMU_%d_PKTBUF_SIZE" %
+                                  (blm_nbi, blq)),
+                "len": hdr.get(pre + "LEN"),
+                "bdsram": sum(hdr.get(pre + "BDSRAM_%s_NUM_BUFS" % m, 0)
+                              for m in MEMS),
+                "emu": sum(hdr.get(pre + "EMU_%s_NUM_BUFS" % m, 0)
+                           for m in MEMS),
+            })
+        self.bp_blqs = [hdr.get_list("NBI_DMA_BP%d_BLQ_TARGET" % bp)
+                        for bp in range(NUM_BPS)]
+        self.islands = []
+        for isl in range(NUM_ISLANDS):
+            name = "NBI%d_DMA_BPE_CONFIG_ME_ISLAND%d" % (nbi, isl)
+            if name not in hdr.macros:
+                continue
+            rx, pkt, buf = hdr.get_list(name)
+            if rx:
+                self.islands.append((isl, pkt, buf))
+
+    def check(self, sizes):
+        """Configuration problems for frames of the given sizes."""
+        warn = []
+        if not self.islands:
+            warn.append("NBI%d has no ME island receiving packets" % self.nbi)
+        if sum(b["len"] for b in self.blqs) > 4096:
+            warn.append("BLQ lengths exceed the 4096 BDSRAM entries")
+        for n, b in enumerate(self.blqs):
+            if b["bdsram"] > b["len"]:
+                warn.append("BLQ%d starts with %d buffers, more than its "
+                            "length %d" % (n, b["bdsram"], b["len"]))
+            if b["cache"] & (b["cache"] - 1) or b["cache"] < 64:
+                warn.append("BLQ%d cache size %d is not a power of 2 of at "
+                            "least 64" % (n, b["cache"]))
+        for size in sizes:
+            blqs = self.bp_blqs[bp_of(size)]
+            if not any(self.blqs[b]["bdsram"] + self.blqs[b]["emu"]
+                       for b in blqs):
+                warn.append("%dB frames go to BLQ%s without buffers" %
+                            (size, ",".join(str(b) for b in blqs)))
+            for blq in blqs:
+                need = size + self.offset
+                if self.blqs[blq]["pktbuf"] < need:
+                    warn.append("%dB frames need %dB buffers, BLQ%d has "
+                                "%dB" % (size, need, blq,
+                                         self.blqs[blq]["pktbuf"]))
+        return warn
+
+
+def bp_of(size):
+    for limit, bp in BP_SIZES:
+        if limit is None or size <= limit:
+            return bp
+
+
+class Profile(object):
+    """Frame sizes and timing of the offered traffic."""
+
+    def __init__(self, name, mix, gbps=100, load=1.0, burst=0,
+                 duration_us=500):
+        self.name = name
+        self.sizes = sorted(mix)
+        self.cum = []
+        total = 0.0
+        for s in self.sizes:
+            total += mix[s]
+            self.cum.append(total)
+        self.gbps = gbps
+        self.load = load
+        self.burst = burst
+        self.duration_us = duration_us
+
+    @classmethod
+    def parse(cls, d):
+        mix = dict((int(k), float(v)) for k, v in d["mix"].items())
+        return cls(d.get("name", "profile"), mix, d.get("gbps", 100),
+                   d.get("load", 1.0), d.get("burst", 0),
+                   d.get("duration_us", 500))
+
+    def pick(self, rnd):
+        return self.sizes[bisect.bisect(self.cum, rnd.random() * self.cum[-1])]
+
+    def frames(self, rnd, tick_us):
+        """Frame sizes sent in each tick, forever.
+
+        Smooth traffic paces frames at the load.  Bursts go out at line rate
+        followed by the gap that brings the average down to the load.
+        """
+        rate = self.gbps * 125.0 * tick_us
+        if not self.burst:
+            rate *= self.load
+        credit = 0.0
+        sent = 0
+        on_ticks = 0
+        gap = 0
+        size = self.pick(rnd)
+        while True:
+            out = []
+            if gap > 0:
+                gap -= 1
+                yield out
+                continue
+            credit += rate
+            on_ticks += 1
+            while credit >= size + FRAME_OVERHEAD:
+                credit -= size + FRAME_OVERHEAD
+                out.append(size)
+                size = self.pick(rnd)
+                sent += 1
+                if self.burst and sent == self.burst:
+                    gap = int(on_ticks * (1.0 / self.load - 1))
+                    sent = on_ticks = 0
+                    credit = 0.0
+                    break
+            yield out
+
+
+class Island(object):
+    def __init__(self, num, pkt, buf):
+        self.num = num
+        self.pkt = self.pkt_min = pkt
+        self.buf = self.buf_min = buf
+        self.releases = []
+
+
+class Sim(object):
+    """One NBI: CTM credits per island and a BlqModel per BLQ."""
+
+    def __init__(self, cfg, args):
+        self.cfg = cfg
+        self.credit_bytes = args.credit_bytes
+        self.islands = [Island(*i) for i in cfg.islands]
+        self.next_isl = 0
+        self.blqs = []
+        self.stats = []
+        for b in cfg.blqs:
+            m = BlqModel(adaptive=args.adaptive, blq_bufs=b["bdsram"],
+                         emu_bufs=b["emu"], cache_size=b["cache"],
+                         latency_us=args.latency_us,
+                         alarm_ticks=args.alarm_ticks,
+                         me_clock_mhz=args.me_clock_mhz, costs=args.costs)
+            self.blqs.append(m)
+            self.stats.append(Stats())
+        self.tick_us = self.blqs[0].tick_us
+        self.latency = self.blqs[0].latency
+        self.t = 0
+        self.frames = 0
+        self.drops = {"credits": 0, "buffers": 0}
+        self.peak_use = [0] * NUM_BLQS
+
+    def frame(self, size):
+        """Take the credits and the buffer of a frame, False if dropped."""
+        isl = self.islands[self.next_isl]
+        self.next_isl = (self.next_isl + 1) % len(self.islands)
+        ctm = min(size + self.cfg.offset, self.cfg.split)
+        bufs = -(-ctm // self.credit_bytes)
+        if isl.pkt < 1 or isl.buf < bufs:
+            self.drops["credits"] += 1
+            return False
+        for blq in self.cfg.bp_blqs[bp_of(size)]:
+            if self.blqs[blq].take(1):
+                break
+        else:
+            self.drops["buffers"] += 1
+            return False
+        isl.pkt -= 1
+        isl.buf -= bufs
+        isl.pkt_min = min(isl.pkt_min, isl.pkt)
+        isl.buf_min = min(isl.buf_min, isl.buf)
+        heapq.heappush(isl.releases, (self.t + self.latency, bufs))
+        return True
+
+    def step(self, sizes):
+        for isl in self.islands:
+            while isl.releases and isl.releases[0][0] <= self.t:
+                isl.pkt += 1
+                isl.buf += heapq.heappop(isl.releases)[1]
+        self.frames += len(sizes)
+        for size in sizes:
+            self.frame(size)
+        for n, (m, st) in enumerate(zip(self.blqs, self.stats)):
+            m.tick(st)
+            self.peak_use[n] = max(self.peak_use[n], m.in_use())
+        self.t += 1
+
+    def run(self, profile, seed):
+        gen = profile.frames(random.Random(seed), self.tick_us)
+        for _ in range(int(profile.duration_us / self.tick_us)):
+            self.step(next(gen))
+
+
+def report(sim, profile):
+    secs = sim.t * sim.tick_us / 1e6
+    lost = sum(sim.drops.values())
+    print("%s: %d frames in %d us (%.1f Mpps), %d dropped (%.3f%%)" %
+          (profile.name, sim.frames, profile.duration_us,
+           sim.frames / secs / 1e6, lost,
+           100.0 * lost / max(1, sim.frames)))
+    print("  drops    no CTM credit %d, no buffer %d" %
+          (sim.drops["credits"], sim.drops["buffers"]))
+    print("  %-5s %6s %6s %6s %8s %8s %8s %6s %6s" %
+          ("blq", "bufs", "cache", "pktbuf", "dma_min", "peak_use",
+           "headroom", "c_low", "uflow"))
+    for n, (b, m, st) in enumerate(zip(sim.cfg.blqs, sim.blqs, sim.stats)):
+        total = b["bdsram"] + b["emu"]
+        if not total:
+            continue
+        print("  %-5d %6d %6d %6d %8d %8d %7.1f%% %6d %6d" %
+              (n, total, b["cache"], b["pktbuf"], st.dma_min,
+               sim.peak_use[n], 100.0 * (total - sim.peak_use[n]) / total,
+               st.cache_low, st.underflow))
+    for isl in sim.islands:
+        print("  island %d  pkt credits %d, min free %d   buf credits %d, "
+              "min free %d" % (isl.num, isl.pkt + len(isl.releases),
+                               isl.pkt_min, isl.buf +
+                               sum(b for _, b in isl.releases), isl.buf_min))
+
+
+def parse_define(val):
+    name, _, value = val.partition("=")
+    return name, value or "1"
+
+
+def parse_mix(val):
+    mix = {}
+    for item in val.split(","):
+        size, _, weight = item.partition(":")
+        mix[int(size)] = float(weight or 1)
+    return mix
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("-D", dest="defines", action="append", default=[],
+                        type=parse_define, metavar="NAME[=VALUE]",
+                        help="define as on the firmware build command line")
+    parser.add_argument("-I", dest="incdirs", action="append", default=[],
+                        help="include directory, e.g. ../apps/wire from "
+                        "tools/ for -DBLM_CUSTOM_CONFIG")
+    parser.add_argument("--header", action="append", default=None,
+                        help="config headers in include order, default " +
+                        " ".join(HEADERS) + " of the repo")
+    parser.add_argument("--nbi", type=int, choices=(0, 1), default=0)
+    parser.add_argument("--profile", help="JSON file with a list of "
+                        "profiles: {name, mix: {size: weight}, gbps, load, "
+                        "burst, duration_us}")
+    parser.add_argument("--mix", type=parse_mix, default={64: 1},
+                        help="size:weight list, e.g. 64:7,576:4,1500:1")
+    parser.add_argument("--gbps", type=float, default=100)
+    parser.add_argument("--load", type=float, default=1.0,
+                        help="average load as a fraction of the line rate")
+    parser.add_argument("--burst", type=int, default=0,
+                        help="frames per line rate burst, 0 for smooth")
+    parser.add_argument("--duration-us", type=float, default=500)
+    parser.add_argument("--latency-us", type=float, default=2.0,
+                        help="time a packet holds its buffer and credits")
+    parser.add_argument("--credit-bytes", type=int, default=2048,
+                        help="CTM bytes per buffer credit")
+    parser.add_argument("--adaptive", action="store_true",
+                        help="BLM_ADAPTIVE_REFILL")
+    parser.add_argument("--alarm-ticks", type=int, default=32)
+    parser.add_argument("--me-clock-mhz", type=float, default=800)
+    parser.add_argument("--cost", action="append", default=[],
+                        metavar="NAME=CYCLES", help="BLM command cost, see "
+                        "tools/blm_model.py")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    args.costs = {}
+    for c in args.cost:
+        name, cycles = c.split("=")
+        if name not in COSTS:
+            parser.error("unknown cost " + name)
+        args.costs[name] = int(cycles)
+
+    for d in args.incdirs:
+        if not os.path.isdir(d):
+            parser.error("-I %s: no such directory" % d)
+    headers = args.header or [os.path.join(ROOT, h) for h in HEADERS]
+    for h in headers:
+        if not os.path.isfile(h):
+            parser.error("--header %s: no such file" % h)
+
+    hdr = Headers(dict(args.defines), args.incdirs)
+    try:
+        for h in headers:
+            hdr.read(h)
+        cfg = NbiConfig(hdr, args.nbi)
+    except ConfigError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+
+    if args.profile:
+        with open(args.profile) as f:
+            profiles = [Profile.parse(p) for p in json.load(f)]
+    else:
+        profiles = [Profile("profile", args.mix, args.gbps, args.load,
+                            args.burst, args.duration_us)]
+
+    sizes = sorted(set(s for p in profiles for s in p.sizes))
+    for w in cfg.check(sizes):
+        print("warning: " + w)
+    if not cfg.islands:
+        return 1
+    for p in profiles:
+        sim = Sim(cfg, args)
+        sim.run(p, args.seed)
+        report(sim, p)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,172 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/blm_telem.py
+# @brief        Read the BLM buffer occupancy telemetry
+#
+
+"""Show where the buffers of each BLQ sit and how they move.
+
+The BLM block built with BLM_TELEMETRY exports one block per BLQ (see
+microc/blocks/blm/_h/blm_internal.h).  "show" prints the buffers in the
+NBI DMA and TM BLQs, the CTM cache and the EMU ring with the cache refill
+and drain counters.  "watch" prints the change between samples as rates;
+a total that keeps falling while the traffic is steady points at a buffer
+leak.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+import time
+
+import nfp_rtsym
+from policer_calc import TSC_CYCLES
+
+TELEM_SYM = "BLM_TELEM_BASE_%d"
+BLQ_SIZE = 128
+BLQ_WORDS = BLQ_SIZE // 4
+CNTRS_OFF = 64
+NUM_BLQS = 4
+
+CNTRS = ("refills", "underflow", "direct", "tm_to_emu", "tm_to_cache",
+         "cache_to_dma", "cache_low", "dma_events")
+
+
+def blq_count(ctrl_lo, ctrl_hi):
+    """Buffers between the head and tail of a BLQueCtrl value."""
+    length = 512 << ((ctrl_hi >> 4) & 0x3)
+    tail = ctrl_lo & 0xfff
+    head = (ctrl_lo >> 12) & 0xfff
+    return ((tail - head) & 0xfff) % length
+
+
+def decode(words):
+    cntrs = [(words[16 + 2 * i] << 32) | words[17 + 2 * i]
+             for i in range(len(CNTRS))]
+    s = {
+        "seq": words[0],
+        "ts": words[1],
+        "cache": words[2],
+        "dma_pend": words[3],
+        "ring": words[4],
+        "lwm_hits": words[5],
+        "dma_blq": blq_count(words[6], words[7]),
+        "tm_blq": blq_count(words[8], words[9]),
+        "cache_hwm": words[10],
+        "cache_size": words[11],
+    }
+    s.update(zip(CNTRS, cntrs))
+    s["total"] = s["dma_blq"] + s["tm_blq"] + s["cache"] + s["ring"]
+    return s
+
+
+def read_blq(sym, blq):
+    """Read a sample, retrying if the firmware rewrote it meanwhile."""
+    off = blq * BLQ_SIZE
+    for _ in range(3):
+        words = nfp_rtsym.read_words(sym, off, BLQ_WORDS)
+        if nfp_rtsym.read_words(sym, off, 1)[0] == words[0]:
+            break
+    return decode(words)
+
+
+def read_all(args):
+    return [read_blq(TELEM_SYM % args.instance, blq) for blq in args.blqs]
+
+
+def cmd_show(args):
+    for blq, s in zip(args.blqs, read_all(args)):
+        if s["seq"] == 0:
+            print("blq %d: no samples" % blq)
+            continue
+        print("blq %d: seq %d" % (blq, s["seq"]))
+        print("  buffers  dma_blq %d tm_blq %d cache %d/%d (hwm %d) "
+              "ring %d total %d" %
+              (s["dma_blq"], s["tm_blq"], s["cache"], s["cache_size"],
+               s["cache_hwm"], s["ring"], s["total"]))
+        print("  events   dma %d pending %d lwm_hits %d" %
+              (s["dma_events"], s["dma_pend"], s["lwm_hits"]))
+        print("  moves    " + " ".join("%s %d" % (c, s[c])
+                                       for c in CNTRS[:-1]))
+
+
+def cmd_watch(args):
+    prev = read_all(args)
+    falling = [0] * len(args.blqs)
+    n = 0
+    while args.count == 0 or n < args.count:
+        time.sleep(args.interval)
+        cur = read_all(args)
+        n += 1
+        print(time.strftime("%H:%M:%S"))
+        for i, blq in enumerate(args.blqs):
+            p, c = prev[i], cur[i]
+            if c["seq"] == p["seq"]:
+                print("  blq %d: not sampled" % blq)
+                continue
+            ticks = (c["ts"] - p["ts"]) & 0xffffffff
+            secs = ticks * TSC_CYCLES / (args.me_clock_mhz * 1e6)
+            rates = " ".join("%s %d/s" % (k, (c[k] - p[k]) / secs)
+                             for k in ("refills", "tm_to_emu",
+                                       "cache_to_dma", "direct"))
+            delta = c["total"] - p["total"]
+            falling[i] = falling[i] + 1 if delta < 0 else 0
+            print("  blq %d: total %d (%+d) cache %d ring %d dma_blq %d "
+                  "lwm_hits +%d underflow +%d" %
+                  (blq, c["total"], delta, c["cache"], c["ring"],
+                   c["dma_blq"], (c["lwm_hits"] - p["lwm_hits"]) &
+                   0xffffffff, c["underflow"] - p["underflow"]))
+            print("          %s" % rates)
+            if falling[i] >= args.leak_samples:
+                print("  blq %d: total fell for %d samples, possible "
+                      "buffer leak" % (blq, falling[i]))
+        prev = cur
+        sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--instance", type=int, default=0,
+                        help="BLM_INSTANCE_ID")
+    parser.add_argument("--blqs",
+                        type=lambda v: [int(i) for i in v.split(",")],
+                        default=list(range(NUM_BLQS)), help="BLQs to read")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("show", help="print the last sample of each BLQ")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("watch", help="print the change between samples")
+    p.add_argument("--interval", type=float, default=1.0,
+                   help="seconds between reads, below 80 s")
+    p.add_argument("--count", type=int, default=0,
+                   help="number of reads, 0 for no limit")
+    p.add_argument("--leak-samples", type=int, default=5,
+                   help="warn after the total fell this many times in a row")
+    p.add_argument("--me-clock-mhz", type=float, default=800)
+    p.set_defaults(func=cmd_watch)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
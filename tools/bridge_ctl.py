@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/bridge_ctl.py
+# @brief        Configure the wire app learning bridge
+#
+
+"""Configure the learning bridge, dump the FDB and show the counters.
+
+The layouts match apps/wire/bridge.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+
+PORT_SYM = "_bridge_port_cfg"
+FLOOD_SYM = "_bridge_vlan_flood"
+AGE_SYM = "_bridge_age_time"
+FDB_SYM = "_bridge_fdb"
+GCNTR_SYM = "_bridge_cntrs"
+NUM_PORTS = 64
+FDB_ENTRIES = 4096 * 16
+FDB_ENTRY_WORDS = 4
+# Entry timestamps count ME timestamp ticks (16 cycles) >> 16
+TS_SHF = 16
+# Entries dumped per nfp-rtsym call
+FDB_CHUNK = 1024
+
+
+def ts_units(secs, me_clock_mhz):
+    return int(secs * me_clock_mhz * 1e6 / 16 / (1 << TS_SHF))
+
+
+def cmd_port(args):
+    word = 0
+    if args.enable:
+        word |= 1 << 31
+        if not args.no_learn:
+            word |= 1 << 30
+    word |= args.pvid & 0xfff
+    nfp_rtsym.write_words(PORT_SYM, args.port * 4, [word])
+
+
+def cmd_vlan(args):
+    mask = 0
+    for port in args.ports:
+        if port >= NUM_PORTS:
+            sys.exit("port out of range: %d" % port)
+        mask |= 1 << port
+    nfp_rtsym.write_words(FLOOD_SYM, args.vid * 8,
+                          [mask >> 32, mask & 0xffffffff])
+
+
+def cmd_age(args):
+    nfp_rtsym.write_words(AGE_SYM, 0,
+                          [ts_units(args.secs, args.me_clock_mhz)])
+
+
+def cmd_fdb(args):
+    for base in range(0, FDB_ENTRIES, FDB_CHUNK):
+        words = nfp_rtsym.read_words(FDB_SYM, base * FDB_ENTRY_WORDS * 4,
+                                     FDB_CHUNK * FDB_ENTRY_WORDS)
+        for i in range(FDB_CHUNK):
+            w = words[i * FDB_ENTRY_WORDS:(i + 1) * FDB_ENTRY_WORDS]
+            if not w[2] >> 31:
+                continue
+            mac = (w[0] << 16) | (w[1] >> 16)
+            print("%s vlan %4d port %2d%s" %
+                  (":".join("%02x" % ((mac >> s) & 0xff)
+                            for s in range(40, -8, -8)),
+                   w[1] & 0xfff, w[2] & 0xff,
+                   " static" if (w[2] >> 30) & 1 else ""))
+
+
+def cmd_show(args):
+    names = ("fwd", "flood", "uuc", "filtered", "learn_req",
+             "learn_limited", "learn_ring_full", "learned", "moved",
+             "aged", "fdb_full", "collision")
+    vals = nfp_rtsym.read_u64(GCNTR_SYM, 0, len(names))
+    for name, val in zip(names, vals):
+        print("%-16s %d" % (name, val))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("port", help="configure an ingress port")
+    p.add_argument("port", type=int)
+    p.add_argument("--enable", action="store_true",
+                   help="bridge frames received on the port")
+    p.add_argument("--no-learn", action="store_true",
+                   help="do not learn source addresses on the port")
+    p.add_argument("--pvid", type=int, default=1,
+                   help="VLAN of untagged frames")
+    p.set_defaults(func=cmd_port)
+
+    p = sub.add_parser("vlan", help="set the flood ports of a VLAN")
+    p.add_argument("vid", type=int)
+    p.add_argument("ports", type=int, nargs="*")
+    p.set_defaults(func=cmd_vlan)
+
+    p = sub.add_parser("age", help="set the FDB age time")
+    p.add_argument("secs", type=float)
+    p.add_argument("--me-clock-mhz", type=float, default=800)
+    p.set_defaults(func=cmd_age)
+
+    p = sub.add_parser("fdb", help="dump the valid FDB entries")
+    p.set_defaults(func=cmd_fdb)
+
+    p = sub.add_parser("show", help="show counters")
+    p.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
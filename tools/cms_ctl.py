@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/cms_ctl.py
+# @brief        Configure the wire app count-min sketch and read heavy hitters
+#
+
+"""Configure the count-min sketch of the wire app, clear it to start a new
+measurement interval and print the heavy hitters it reports.
+
+The layouts match apps/wire/cms.h.  The depth and width must match the
+firmware build (CMS_DEPTH, CMS_WIDTH_SHF).
+"""
+
+from __future__ import print_function
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+import nfp_rtsym
+from host_ring import HostRing
+
+CFG_SYM = "_cms_cfg"
+SKETCH_SYM = "_cms_sketch"
+SKETCH_CLS_SYM = "i%d._cms_sketch"
+HH_SYM = "_cms_hh"
+
+HH_ENTRIES = 1024
+REC_WORDS = 8
+# Words written per nfp-rtsym call when clearing
+CLEAR_CHUNK = 1024
+
+
+def ip_str(addr):
+    return socket.inet_ntoa(struct.pack("!I", addr))
+
+
+def sketch_syms(args):
+    if args.cls:
+        return [SKETCH_CLS_SYM % isl for isl in args.islands]
+    return [SKETCH_SYM]
+
+
+def cmd_set(args):
+    word = (1 << 31) | ((1 << 30) if args.pkts else 0)
+    nfp_rtsym.write_words(CFG_SYM, 0, [0])
+    nfp_rtsym.write_words(CFG_SYM, 4, [args.threshold])
+    nfp_rtsym.write_words(CFG_SYM, 0, [word])
+
+
+def cmd_off(args):
+    nfp_rtsym.write_words(CFG_SYM, 0, [0])
+
+
+def clear(args):
+    words = args.depth * (1 << args.width_shf)
+    for sym in sketch_syms(args):
+        for off in range(0, words, CLEAR_CHUNK):
+            nfp_rtsym.write_words(sym, off * 4,
+                                  [0] * min(CLEAR_CHUNK, words - off))
+
+
+def cmd_clear(args):
+    clear(args)
+
+
+def fmt_rec(rec):
+    ports = rec[3]
+    return ("%s:%d -> %s:%d proto %d estimate %d isl %d port %d ts %d" %
+            (ip_str(rec[0]), ports >> 16, ip_str(rec[1]), ports & 0xffff,
+             rec[2], rec[4], rec[6] >> 24, (rec[6] >> 16) & 0xff, rec[5]))
+
+
+def cmd_hh(args):
+    ring = HostRing(HH_SYM, HH_ENTRIES, REC_WORDS, seq_word=REC_WORDS - 1)
+    next_clear = time.time() + args.interval if args.interval else None
+    try:
+        while True:
+            for rec in ring.read():
+                print(fmt_rec(rec))
+            if next_clear and time.time() >= next_clear:
+                # Heavy hitters are reported again in the next interval
+                clear(args)
+                print("--- new interval")
+                next_clear += args.interval
+            time.sleep(0.5)
+    except KeyboardInterrupt:
+        pass
+    if ring.lost or ring.torn:
+        print("%d records lost, %d torn" % (ring.lost, ring.torn),
+              file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--depth", type=int, default=4, help="CMS_DEPTH")
+    parser.add_argument("--width-shf", type=int, default=None,
+                        help="CMS_WIDTH_SHF")
+    parser.add_argument("--cls", action="store_true",
+                        help="firmware built with CMS_CLS")
+    parser.add_argument("--islands",
+                        type=lambda v: [int(i) for i in v.split(",")],
+                        default=[32, 33], help="islands running the wire app")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("set", help="enable the sketch")
+    p.add_argument("threshold", type=int,
+                   help="heavy hitter threshold in bytes (or packets)")
+    p.add_argument("--pkts", action="store_true", help="count packets")
+    p.set_defaults(func=cmd_set)
+
+    p = sub.add_parser("off", help="disable the sketch")
+    p.set_defaults(func=cmd_off)
+
+    p = sub.add_parser("clear", help="clear the sketch")
+    p.set_defaults(func=cmd_clear)
+
+    p = sub.add_parser("hh", help="print heavy hitters as they are found")
+    p.add_argument("--interval", type=float, default=0,
+                   help="clear the sketch every INTERVAL seconds")
+    p.set_defaults(func=cmd_hh)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    if args.width_shf is None:
+        args.width_shf = 10 if args.cls else 14
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
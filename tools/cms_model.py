@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/cms_model.py
+# @brief        Host model of the wire app count-min sketch
+#
+
+"""Model of the count-min sketch in apps/wire/cms.c, used to choose
+CMS_DEPTH and CMS_WIDTH_SHF.
+
+"bounds" prints the guarantees of a geometry: an estimate exceeds the true
+count by more than e/width of the total with a probability of at most
+e^-depth.  "size" finds the smallest geometry for a target error and
+confidence.  "sim" runs a Zipf distributed flow mix through the same
+update (CRC32 and CRC32-C hashes, row index h1 + row * h2) and compares the
+observed errors and heavy hitter reports with the bounds.
+"""
+
+from __future__ import print_function
+
+import argparse
+import math
+import random
+import struct
+import sys
+import zlib
+
+SEED1 = 0x636d7331
+SEED2 = 0x636d7332
+
+
+def bounds(width, depth, total):
+    eps = math.e / width
+    delta = math.exp(-depth)
+    return eps, delta, eps * total
+
+
+def cmd_bounds(args):
+    width = 1 << args.width_shf
+    eps, delta, err = bounds(width, args.depth, args.total)
+    words = width * args.depth
+    print("%d x %d counters, %d KB" % (args.depth, width, words * 4 // 1024))
+    print("error <= %.3g of the total (%d) with probability %.4f" %
+          (eps, err, 1 - delta))
+
+
+def cmd_size(args):
+    width_shf = max(0, int(math.ceil(math.log(math.e / args.eps, 2))))
+    depth = max(1, int(math.ceil(math.log(1 / args.delta))))
+    print("CMS_WIDTH_SHF=%d CMS_DEPTH=%d (%d KB)" %
+          (width_shf, depth, (depth << width_shf) * 4 // 1024))
+    if depth > 8:
+        print("CMS_DEPTH above 8 is not supported by the firmware")
+
+
+def _crc32c_table():
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0x82f63b78 if crc & 1 else 0)
+        table.append(crc)
+    return table
+
+
+CRC32C_TABLE = _crc32c_table()
+
+
+def crc32c(data, init):
+    crc = ~init & 0xffffffff
+    for byte in bytearray(data):
+        crc = CRC32C_TABLE[(crc ^ byte) & 0xff] ^ (crc >> 8)
+    return ~crc & 0xffffffff
+
+
+def key_bytes(n):
+    # 10.x.y.z:port -> 192.168.0.1:80, TCP
+    return struct.pack("!IIII", 0x0a000000 + (n >> 8), 0xc0a80001, 6,
+                       ((1024 + (n & 0xff)) << 16) | 80)
+
+
+def sketch_idx(key, width, depth):
+    h1 = zlib.crc32(key, SEED1) & 0xffffffff
+    h2 = crc32c(key, SEED2) | 1
+    return [((h1 + row * h2) & 0xffffffff) & (width - 1)
+            for row in range(depth)]
+
+
+def cmd_sim(args):
+    width = 1 << args.width_shf
+    rng = random.Random(args.seed)
+
+    # Zipf flow sizes scaled to the total
+    weights = [1.0 / (r ** args.zipf) for r in range(1, args.flows + 1)]
+    scale = args.total / sum(weights)
+    sizes = [max(1, int(w * scale)) for w in weights]
+    rng.shuffle(sizes)
+    total = sum(sizes)
+
+    # The sketch is linear, adding a flow at once gives the same counters
+    sketch = [[0] * width for _ in range(args.depth)]
+    idxs = []
+    for n, size in enumerate(sizes):
+        idx = sketch_idx(key_bytes(n), width, args.depth)
+        idxs.append(idx)
+        for row, col in enumerate(idx):
+            sketch[row][col] += size
+
+    eps, delta, bound = bounds(width, args.depth, total)
+    over = 0
+    max_err = 0
+    true_hh = est_hh = false_hh = 0
+    for n, size in enumerate(sizes):
+        est = min(sketch[row][col] for row, col in enumerate(idxs[n]))
+        err = est - size
+        assert err >= 0
+        max_err = max(max_err, err)
+        if err > bound:
+            over += 1
+        if size >= args.threshold:
+            true_hh += 1
+        if est >= args.threshold:
+            est_hh += 1
+            if size < args.threshold:
+                false_hh += 1
+
+    print("%d flows, total %d, %d x %d counters" %
+          (args.flows, total, args.depth, width))
+    print("bound: error <= %d (eps %.3g) for all but %.4f of the flows" %
+          (bound, eps, delta))
+    print("observed: max error %d, %.4f of the flows above the bound" %
+          (max_err, float(over) / args.flows))
+    if args.threshold:
+        print("threshold %d: %d heavy hitters, %d reported, %d false" %
+              (args.threshold, true_hh, est_hh, false_hh))
+    if float(over) / args.flows > delta:
+        print("bound violated")
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("bounds", help="guarantees of a geometry")
+    p.add_argument("--width-shf", type=int, default=14)
+    p.add_argument("--depth", type=int, default=4)
+    p.add_argument("--total", type=int, default=10 ** 9,
+                   help="bytes or packets per measurement interval")
+    p.set_defaults(func=cmd_bounds)
+
+    p = sub.add_parser("size", help="geometry for a target error")
+    p.add_argument("--eps", type=float, required=True,
+                   help="error as a fraction of the total")
+    p.add_argument("--delta", type=float, default=0.02,
+                   help="probability of exceeding the error")
+    p.set_defaults(func=cmd_size)
+
+    p = sub.add_parser("sim", help="simulate a flow mix")
+    p.add_argument("--width-shf", type=int, default=14)
+    p.add_argument("--depth", type=int, default=4)
+    p.add_argument("--flows", type=int, default=100000)
+    p.add_argument("--total", type=int, default=10 ** 8)
+    p.add_argument("--zipf", type=float, default=1.1, help="Zipf exponent")
+    p.add_argument("--threshold", type=int, default=0,
+                   help="heavy hitter threshold")
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_sim)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    return args.func(args) or 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,183 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/ct_bench.py
+# @brief        Connection setup/teardown benchmark for the wire app
+#
+
+"""Measure the connection setup and teardown rates of the wire app
+connection tracking.
+
+"gen" writes a pcap file of complete TCP connections (handshake, one
+request and response, FIN teardown) with both directions in one file, to
+be replayed into a port configured with "ct_ctl.py port <port> open",
+e.g. with tcpreplay --topspeed.  "rate" samples the counters while the
+file is replayed and prints the rates per second.  Any invalid or out of
+window drops during a replay of a generated file point at a tracking
+error.
+"""
+
+from __future__ import print_function
+
+import argparse
+import struct
+import sys
+import time
+
+import nfp_rtsym
+
+CNTR_SYM = "_ct_cntrs"
+CNTRS = ("created", "picked_up", "established", "closed", "expired",
+         "evicted", "full", "refused", "invalid", "out_of_window")
+
+SYN, FIN, RST, PSH, ACK = 0x02, 0x01, 0x04, 0x08, 0x10
+
+CLIENT_NET = 0x0a000000
+SERVER_IP = 0x0a010001
+SERVER_PORT = 80
+CLIENT_MAC = b"\x02\x00\x00\x00\x00\x01"
+SERVER_MAC = b"\x02\x00\x00\x00\x00\x02"
+
+
+def csum(data):
+    if len(data) & 1:
+        data += b"\0"
+    total = sum(struct.unpack("!%dH" % (len(data) // 2), data))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    return ~total & 0xffff
+
+
+def frame(src, dst, sport, dport, seq, ack, flags, payload=b"", opts=b""):
+    """Build an Ethernet/IPv4/TCP frame."""
+    thl = 20 + len(opts)
+    tcp = struct.pack("!HHIIBBHHH", sport, dport, seq & 0xffffffff,
+                      ack & 0xffffffff, (thl // 4) << 4, flags, 0xffff, 0,
+                      0) + opts + payload
+    pseudo = struct.pack("!IIBBH", src, dst, 0, 6, len(tcp))
+    tcp = tcp[:16] + struct.pack("!H", csum(pseudo + tcp)) + tcp[18:]
+    ip = struct.pack("!BBHHHBBHII", 0x45, 0, 20 + len(tcp), 0, 0x4000, 64,
+                     6, 0, src, dst)
+    ip = ip[:10] + struct.pack("!H", csum(ip)) + ip[12:]
+    if src == SERVER_IP:
+        eth = CLIENT_MAC + SERVER_MAC
+    else:
+        eth = SERVER_MAC + CLIENT_MAC
+    return eth + b"\x08\x00" + ip + tcp
+
+
+def connection(n, req_len, resp_len):
+    """Return the frames of connection n."""
+    cli = CLIENT_NET + 1 + (n >> 14)
+    sport = 1024 + (n & 0x3fff)
+    c_isn = (n * 2654435761) & 0xffffffff
+    s_isn = (c_isn ^ 0x5a5a5a5a) & 0xffffffff
+    # MSS 1460, window scale 7
+    opts = b"\x02\x04\x05\xb4\x01\x03\x03\x07"
+    c, s = c_isn, s_isn
+
+    def c2s(flags, payload=b"", o=b""):
+        return frame(cli, SERVER_IP, sport, SERVER_PORT, c, s, flags,
+                     payload, o)
+
+    def s2c(flags, payload=b"", o=b""):
+        return frame(SERVER_IP, cli, SERVER_PORT, sport, s, c, flags,
+                     payload, o)
+
+    out = [frame(cli, SERVER_IP, sport, SERVER_PORT, c, 0, SYN, opts=opts)]
+    c += 1
+    out.append(s2c(SYN | ACK, o=opts))
+    s += 1
+    out.append(c2s(ACK))
+    out.append(c2s(PSH | ACK, b"q" * req_len))
+    c += req_len
+    out.append(s2c(PSH | ACK, b"r" * resp_len))
+    s += resp_len
+    out.append(c2s(FIN | ACK))
+    c += 1
+    out.append(s2c(FIN | ACK))
+    s += 1
+    out.append(c2s(ACK))
+    return out
+
+
+def cmd_gen(args):
+    with open(args.pcap, "wb") as f:
+        f.write(struct.pack("<IHHiIII", 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+        ts = 0
+        # Interleave the frames of args.parallel connections at a time so
+        # that many connections are open at once
+        for base in range(0, args.conns, args.parallel):
+            conns = [connection(n, args.req, args.resp)
+                     for n in range(base, min(base + args.parallel,
+                                              args.conns))]
+            for step in range(len(conns[0])):
+                for c in conns:
+                    pkt = c[step]
+                    f.write(struct.pack("<IIII", ts // 1000000,
+                                        ts % 1000000, len(pkt), len(pkt)))
+                    f.write(pkt)
+                    ts += 1
+    print("%d connections, %d frames" % (args.conns, args.conns * 8))
+
+
+def cmd_rate(args):
+    prev = nfp_rtsym.read_u64(CNTR_SYM, 0, len(CNTRS))
+    t_prev = time.time()
+    print("%10s %10s %10s %10s %10s" %
+          ("setup/s", "estab/s", "teardown/s", "evict/s", "drops"))
+    for _ in range(args.count) if args.count else iter(int, 1):
+        time.sleep(args.interval)
+        cur = nfp_rtsym.read_u64(CNTR_SYM, 0, len(CNTRS))
+        now = time.time()
+        d = dict((name, c - p) for name, c, p in zip(CNTRS, cur, prev))
+        dt = now - t_prev
+        drops = d["full"] + d["refused"] + d["invalid"] + d["out_of_window"]
+        print("%10d %10d %10d %10d %10d" %
+              (d["created"] / dt, d["established"] / dt, d["closed"] / dt,
+               d["evicted"] / dt, drops))
+        prev, t_prev = cur, now
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("gen", help="write a pcap file of connections")
+    p.add_argument("pcap")
+    p.add_argument("--conns", type=int, default=100000,
+                   help="number of connections")
+    p.add_argument("--parallel", type=int, default=1000,
+                   help="connections open at the same time")
+    p.add_argument("--req", type=int, default=64, help="request length")
+    p.add_argument("--resp", type=int, default=512, help="response length")
+    p.set_defaults(func=cmd_gen)
+
+    p = sub.add_parser("rate", help="print the rates while replaying")
+    p.add_argument("--interval", type=float, default=1.0)
+    p.add_argument("--count", type=int, default=0,
+                   help="number of samples, 0 runs until interrupted")
+    p.set_defaults(func=cmd_rate)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/ct_ctl.py
+# @brief        Configure and monitor the wire app connection tracking
+#
+
+"""Configure the connection tracking of the wire app per ingress port and
+show its counters and the connections of a table bucket.
+
+The layouts match apps/wire/conntrack.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import socket
+import struct
+import sys
+
+import nfp_rtsym
+
+PORT_SYM = "_ct_port_cfg"
+CNTR_SYM = "_ct_cntrs"
+CAM_SYM = "_ct_cam"
+META_SYM = "_ct_meta"
+TBL_SYM = "_ct_tbl"
+
+BUCKET_SZ = 16
+ENTRY_SIZE = 48
+
+CNTRS = ("created", "picked_up", "established", "closed", "expired",
+         "evicted", "full", "refused", "invalid", "out_of_window",
+         "contended")
+
+STATES = {0: "NONE", 1: "SYN_SENT", 2: "SYN_RECV", 3: "ESTABLISHED",
+          4: "FIN_WAIT", 5: "CLOSE_WAIT", 6: "LAST_ACK", 7: "TIME_WAIT",
+          8: "CLOSE"}
+
+
+def ip_str(addr):
+    return socket.inet_ntoa(struct.pack("!I", addr))
+
+
+def cmd_port(args):
+    word = 0
+    if args.mode != "off":
+        word = 1 << 31
+        if args.mode in ("open", "loose"):
+            word |= 1 << 30
+        if args.mode == "loose":
+            word |= 1 << 29
+    nfp_rtsym.write_words(PORT_SYM, args.port * 4, [word])
+
+
+def cmd_show(args):
+    vals = nfp_rtsym.read_u64(CNTR_SYM, 0, len(CNTRS))
+    for name, val in zip(CNTRS, vals):
+        print("%-14s %d" % (name, val))
+
+
+def cmd_bucket(args):
+    sigs = nfp_rtsym.read_words(CAM_SYM, args.bucket * BUCKET_SZ * 4,
+                                BUCKET_SZ)
+    metas = nfp_rtsym.read_words(META_SYM, args.bucket * BUCKET_SZ * 4,
+                                 BUCKET_SZ)
+    for slot in range(BUCKET_SZ):
+        if not sigs[slot]:
+            continue
+        idx = args.bucket * BUCKET_SZ + slot
+        e = nfp_rtsym.read_words(TBL_SYM, idx * ENTRY_SIZE, 4)
+        state = (metas[slot] >> 27) & 0xf
+        print("%2d: %s:%d <-> %s:%d %s%s ts %d opened by %s" %
+              (slot, ip_str(e[0]), e[2] >> 16, ip_str(e[1]), e[2] & 0xffff,
+               STATES.get(state, state),
+               " (locked)" if metas[slot] >> 31 else "",
+               metas[slot] & ((1 << 27) - 1), "b" if e[3] >> 31 else "a"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("port", help="configure an ingress port")
+    p.add_argument("port", type=int)
+    p.add_argument("mode", choices=("off", "track", "open", "loose"),
+                   help="track: only existing connections pass, "
+                   "open: connections may be opened from the port, "
+                   "loose: also pick up connections in progress")
+    p.set_defaults(func=cmd_port)
+
+    p = sub.add_parser("show", help="show the counters")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("bucket", help="show the connections of a bucket")
+    p.add_argument("bucket", type=int)
+    p.set_defaults(func=cmd_bucket)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
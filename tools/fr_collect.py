@@ -0,0 +1,239 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/fr_collect.py
+# @brief        Flow record collector for the wire app
+#
+
+"""Configure the flow record timeouts and collect the exported records.
+
+"collect" follows the fr_export host ring and writes every batch of
+flow records as an IPFIX message (RFC 7011) with its template to a file,
+or prints the records with --text.  "read" prints the records of such a
+file.  The ME timestamps of the records are turned into wall clock time
+using the write time of each batch.  The layouts match
+apps/wire/flowrec.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+import nfp_rtsym
+from host_ring import HostRing
+from policer_calc import TSC_CYCLES
+
+CFG_SYM = "_fr_cfg"
+CNTR_SYM = "_fr_cntrs"
+EXPORT_SYM = "_fr_export"
+
+EXPORT_ENTRIES = 1024
+BATCH_RECS = 7
+REC_WORDS = 16
+BATCH_WORDS = REC_WORDS * (BATCH_RECS + 1)
+
+# ME timestamp shifts of the records (FR_TS_SHF) and the wheel (AGE_TS_SHF)
+FR_TS_SHF = 10
+AGE_TS_SHF = 20
+
+CNTRS = ("created", "full", "expired", "active", "records", "batches",
+         "collision")
+REASONS = {1: "idle", 2: "active", 3: "end"}
+
+# IPFIX template of the records: (information element, length)
+TEMPLATE_ID = 256
+FIELDS = (
+    (8, 4),         # sourceIPv4Address
+    (12, 4),        # destinationIPv4Address
+    (4, 1),         # protocolIdentifier
+    (7, 2),         # sourceTransportPort
+    (11, 2),        # destinationTransportPort
+    (6, 2),         # tcpControlBits
+    (10, 4),        # ingressInterface
+    (2, 8),         # packetDeltaCount
+    (1, 8),         # octetDeltaCount
+    (152, 8),       # flowStartMilliseconds
+    (153, 8),       # flowEndMilliseconds
+    (136, 1),       # flowEndReason
+)
+DATA_FMT = "!IIBHHHIQQQQB"
+IPFIX_VERSION = 10
+OBS_DOMAIN = 1
+
+
+def ip_str(addr):
+    return socket.inet_ntoa(struct.pack("!I", addr))
+
+
+def tick_s(args, shf):
+    return (1 << shf) * TSC_CYCLES / (args.me_clock_mhz * 1e6)
+
+
+def cmd_set(args):
+    unit = tick_s(args, AGE_TS_SHF)
+    words = []
+    for secs in (args.idle, args.active, args.fin):
+        words.append(0 if secs is None else max(1, int(secs / unit + 0.5)))
+    nfp_rtsym.write_words(CFG_SYM, 0, words + [0])
+
+
+def cmd_show(args):
+    vals = nfp_rtsym.read_u64(CNTR_SYM, 0, len(CNTRS))
+    for name, val in zip(CNTRS, vals):
+        print("%-10s %d" % (name, val))
+
+
+def decode_batch(args, words, wall):
+    """Return the records of a batch as tuples in DATA_FMT order."""
+    ts, cnt = words[2], words[1]
+    tick = tick_s(args, FR_TS_SHF)
+    recs = []
+    for i in range(1, cnt + 1):
+        r = words[i * REC_WORDS:(i + 1) * REC_WORDS]
+        # Times relative to the batch write, the counters wrap
+        start = wall - ((ts - r[8]) & 0xffffffff) * tick
+        end = wall - ((ts - r[9]) & 0xffffffff) * tick
+        recs.append((r[0], r[1], r[2] >> 24, r[3] >> 16, r[3] & 0xffff,
+                     (r[2] >> 16) & 0xff, r[2] & 0xff,
+                     (r[4] << 32) | r[5], (r[6] << 32) | r[7],
+                     int(start * 1000), int(end * 1000),
+                     (r[2] >> 8) & 0xff))
+    return recs
+
+
+def ipfix_msg(recs, seq, export_time):
+    tmpl = struct.pack("!HH", TEMPLATE_ID, len(FIELDS))
+    tmpl += b"".join(struct.pack("!HH", ie, ln) for ie, ln in FIELDS)
+    tmpl_set = struct.pack("!HH", 2, 4 + len(tmpl)) + tmpl
+    data = b"".join(struct.pack(DATA_FMT, *r) for r in recs)
+    data_set = struct.pack("!HH", TEMPLATE_ID, 4 + len(data)) + data
+    body = tmpl_set + data_set
+    return struct.pack("!HHIII", IPFIX_VERSION, 16 + len(body),
+                       int(export_time), seq, OBS_DOMAIN) + body
+
+
+def fmt_rec(r):
+    src, dst, proto, sport, dport, flags, port, pkts, nbytes, start, end, \
+        reason = r
+    return ("%s.%03d %6.3fs port %d %s:%d -> %s:%d proto %d flags 0x%02x "
+            "%d pkts %d bytes %s" %
+            (time.strftime("%H:%M:%S", time.localtime(start / 1000)),
+             start % 1000, (end - start) / 1000.0, port, ip_str(src), sport,
+             ip_str(dst), dport, proto, flags, pkts, nbytes,
+             REASONS.get(reason, reason)))
+
+
+def cmd_collect(args):
+    ring = HostRing(EXPORT_SYM, EXPORT_ENTRIES, BATCH_WORDS,
+                    start=0 if args.all else None)
+    out = None if args.text else open(args.file, "ab")
+    msgs = nrecs = lost = 0
+    try:
+        while True:
+            first = ring.rptr
+            batches = ring.read(64)
+            for i, words in enumerate(batches):
+                seq = (first + i) & 0xffffffff
+                ahead = (words[0] - seq) & 0xffffffff
+                if 0 < ahead < 0x80000000:
+                    # Overwritten by a later batch
+                    lost += 1
+                    continue
+                if ahead != 0 or not 0 < words[1] <= BATCH_RECS:
+                    # Not flushed yet, read it again later
+                    ring.rptr = seq
+                    break
+                recs = decode_batch(args, words, time.time())
+                if out:
+                    out.write(ipfix_msg(recs, nrecs, time.time()))
+                else:
+                    for r in recs:
+                        print(fmt_rec(r))
+                msgs += 1
+                nrecs += len(recs)
+            if not args.follow:
+                break
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    if out:
+        out.close()
+    print("%d batches, %d records, %d batches lost" %
+          (msgs, nrecs, ring.lost + lost), file=sys.stderr)
+
+
+def cmd_read(args):
+    with open(args.file, "rb") as f:
+        buf = f.read()
+    off = 0
+    while off + 16 <= len(buf):
+        ver, length = struct.unpack_from("!HH", buf, off)
+        if ver != IPFIX_VERSION or length < 16:
+            sys.exit("bad IPFIX message at offset %d" % off)
+        pos, end = off + 16, off + length
+        while pos + 4 <= end:
+            set_id, set_len = struct.unpack_from("!HH", buf, pos)
+            if set_id == TEMPLATE_ID:
+                size = struct.calcsize(DATA_FMT)
+                for r in range(pos + 4, pos + set_len - size + 1, size):
+                    print(fmt_rec(struct.unpack_from(DATA_FMT, buf, r)))
+            pos += set_len
+        off = end
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--me-clock-mhz", type=float, default=800)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("set", help="set the timeouts, in seconds")
+    p.add_argument("--idle", type=float, help="idle timeout")
+    p.add_argument("--active", type=float, help="active timeout")
+    p.add_argument("--fin", type=float, help="idle timeout after FIN/RST")
+    p.set_defaults(func=cmd_set)
+
+    p = sub.add_parser("show", help="show the counters")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("collect", help="write the records to an IPFIX file")
+    p.add_argument("file", nargs="?", default="flows.ipfix")
+    p.add_argument("--text", action="store_true",
+                   help="print the records instead")
+    p.add_argument("--all", action="store_true",
+                   help="start with the batches still in the ring")
+    p.add_argument("--follow", action="store_true",
+                   help="keep collecting new records")
+    p.add_argument("--interval", type=float, default=1.0,
+                   help="poll interval with --follow, in seconds")
+    p.set_defaults(func=cmd_collect)
+
+    p = sub.add_parser("read", help="print the records of an IPFIX file")
+    p.add_argument("file")
+    p.set_defaults(func=cmd_read)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/gre_ctl.py
+# @brief        Configure the wire app GRE/NVGRE termination
+#
+
+"""Configure GRE/NVGRE termination per port and show the counters.
+
+The layouts match apps/wire/gre.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+
+PORT_SYM = "_gre_port_cfg"
+VSID_SYM = "_gre_vsid_cntrs"
+GCNTR_SYM = "_gre_cntrs"
+NUM_VSID_CNTRS = 4096
+VSID_CNTR_SIZE = 16
+
+
+def cmd_port(args):
+    word = 0
+    if args.mode != "off":
+        word = 1 << 31
+    if args.mode == "nvgre":
+        word |= 1 << 30
+    nfp_rtsym.write_words(PORT_SYM, args.port * 4, [word])
+
+
+def cmd_show(args):
+    names = ("nvgre", "gre_teb", "gre_ip", "bad_hdr")
+    vals = nfp_rtsym.read_u64(GCNTR_SYM, 0, len(names))
+    print(" ".join("%s %d" % nv for nv in zip(names, vals)))
+    for vsid in args.vsids:
+        idx = vsid & (NUM_VSID_CNTRS - 1)
+        pkts, nbytes = nfp_rtsym.read_u64(VSID_SYM, idx * VSID_CNTR_SIZE, 2)
+        print("VSID/key %d: %d pkts %d bytes" % (vsid, pkts, nbytes))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("port", help="set the termination mode of a port")
+    p.add_argument("port", type=int)
+    p.add_argument("mode", choices=("all", "nvgre", "off"),
+                   help="terminate all GRE, only NVGRE or nothing")
+    p.set_defaults(func=cmd_port)
+
+    p = sub.add_parser("show", help="show counters")
+    p.add_argument("vsids", type=int, nargs="*")
+    p.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
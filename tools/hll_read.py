@@ -0,0 +1,167 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/hll_read.py
+# @brief        Read the wire app HyperLogLog sketches
+#
+
+"""Print the number of distinct source addresses and flows per port.
+
+The registers of the last complete epoch are read from every island,
+merged with a bitwise OR and turned into HyperLogLog estimates.  The
+layouts and build options match apps/wire/hll.h.  "model" runs the same
+estimator over random items to show its error for a register count.
+"""
+
+from __future__ import print_function
+
+import argparse
+import math
+import random
+import struct
+import sys
+import time
+import zlib
+
+import nfp_rtsym
+from policer_calc import TSC_CYCLES
+
+REGS_SYM = "i%d._hll_regs"
+TAG_SYM = "i%d._hll_bank_epoch"
+EPOCH_SYM = "_hll_epoch"
+
+BANKS = 3
+KINDS = ("sources", "flows")
+
+
+def alpha(m):
+    if m == 16:
+        return 0.673
+    if m == 32:
+        return 0.697
+    if m == 64:
+        return 0.709
+    return 0.7213 / (1 + 1.079 / m)
+
+
+def estimate(ranks):
+    """HyperLogLog estimate from the register ranks."""
+    m = len(ranks)
+    est = alpha(m) * m * m / sum(2.0 ** -r for r in ranks)
+    zeros = ranks.count(0)
+    if est <= 2.5 * m and zeros:
+        # Small range correction, linear counting
+        est = m * math.log(float(m) / zeros)
+    return est
+
+
+def read_epoch(args, epoch):
+    """Return the merged registers of an epoch or None if overwritten."""
+    bank = epoch % BANKS
+    words = args.ports * len(KINDS) << args.p
+    merged = [0] * words
+    for isl in args.islands:
+        tag = nfp_rtsym.read_words(TAG_SYM % isl, bank * 4, 1)[0]
+        if tag != epoch:
+            # No traffic on the island in that epoch
+            continue
+        regs = nfp_rtsym.read_words(REGS_SYM % isl, bank * words * 4, words)
+        merged = [a | b for a, b in zip(merged, regs)]
+    if nfp_rtsym.read_words(EPOCH_SYM, 0, 1)[0] > epoch + 1:
+        return None
+    return merged
+
+
+def show(args, epoch, merged):
+    secs = (1 << args.epoch_shf) * TSC_CYCLES / (args.me_clock_mhz * 1e6)
+    m = 1 << args.p
+    print("epoch %d (%.2f s)" % (epoch, secs))
+    for port in range(args.ports):
+        out = []
+        for kind, name in enumerate(KINDS):
+            base = (port * len(KINDS) + kind) * m
+            ranks = [r.bit_length() for r in merged[base:base + m]]
+            est = estimate(ranks)
+            out.append("%s %d (%d/s)" % (name, est, est / secs))
+        print("  port %d: %s" % (port, ", ".join(out)))
+
+
+def cmd_show(args):
+    last = None
+    while True:
+        epoch = nfp_rtsym.read_words(EPOCH_SYM, 0, 1)[0] - 1
+        if epoch != last:
+            merged = read_epoch(args, epoch)
+            if merged is not None:
+                show(args, epoch, merged)
+                last = epoch
+        if not args.follow:
+            break
+        time.sleep(0.2)
+
+
+def cmd_model(args):
+    m = 1 << args.p
+    rng = random.Random(args.seed)
+    errs = []
+    for _ in range(args.trials):
+        regs = [0] * m
+        for _ in range(args.items):
+            h = zlib.crc32(struct.pack("!I", rng.getrandbits(32)))
+            h &= 0xffffffff
+            rest = h >> args.p
+            rank = 33 - args.p if rest == 0 else \
+                (rest & -rest).bit_length()
+            reg = h & (m - 1)
+            regs[reg] = max(regs[reg], rank)
+        errs.append(estimate(regs) / args.items - 1)
+    mean = sum(errs) / len(errs)
+    std = math.sqrt(sum((e - mean) ** 2 for e in errs) / len(errs))
+    print("%d registers, %d items: bias %.3f, std error %.3f "
+          "(expected %.3f)" % (m, args.items, mean, std, 1.04 / math.sqrt(m)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--p", type=int, default=7, help="HLL_P")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("show", help="print the estimates")
+    p.add_argument("--ports", type=int, default=8, help="HLL_NUM_PORTS")
+    p.add_argument("--epoch-shf", type=int, default=26, help="HLL_EPOCH_SHF")
+    p.add_argument("--me-clock-mhz", type=float, default=800)
+    p.add_argument("--islands",
+                   type=lambda v: [int(i) for i in v.split(",")],
+                   default=[32, 33], help="islands running the wire app")
+    p.add_argument("--follow", action="store_true",
+                   help="print every epoch")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("model", help="estimator error on random items")
+    p.add_argument("--items", type=int, default=100000)
+    p.add_argument("--trials", type=int, default=20)
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_model)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,91 @@
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/host_ring.py
+# @brief        Read the host rings of the wire app
+#
+
+"""Reader for the host rings of apps/wire/host_ring.h.
+
+A ring is an array of fixed size records and a write counter, exported
+as <sym> and <sym>_wptr.  The firmware never waits for the reader, so a
+reader that falls behind by more than the ring size loses records.
+
+Every record carries the value of the write counter that claimed its
+slot, written last.  Given the word holding it, the reader drops records
+that are not complete yet or were overwritten while it read them and
+counts them as torn.
+"""
+
+import time
+
+import nfp_rtsym
+
+# Records this close to the write counter may still be being written
+LAG = 4
+
+
+class HostRing(object):
+    """Sequential reader of one host ring."""
+
+    def __init__(self, sym, entries, rec_words, start=None, seq_word=None):
+        self.sym = sym
+        self.entries = entries
+        self.rec_words = rec_words
+        self.seq_word = seq_word
+        self.rptr = self.wptr() if start is None else start
+        self.lost = 0
+        self.torn = 0
+
+    def wptr(self):
+        return nfp_rtsym.read_words(self.sym + "_wptr", 0, 1)[0]
+
+    def read(self, max_recs=1024):
+        """Return the list of new records, each a list of words."""
+        avail = (self.wptr() - self.rptr - LAG) & 0xffffffff
+        if avail & 0x80000000:
+            return []
+        if avail > self.entries - LAG:
+            skip = avail - (self.entries - LAG)
+            self.lost += skip
+            self.rptr = (self.rptr + skip) & 0xffffffff
+            avail -= skip
+        avail = min(avail, max_recs)
+
+        recs = []
+        while avail:
+            slot = self.rptr % self.entries
+            n = min(avail, self.entries - slot)
+            words = nfp_rtsym.read_words(self.sym, slot * self.rec_words * 4,
+                                         n * self.rec_words)
+            for i in range(n):
+                rec = words[i * self.rec_words:(i + 1) * self.rec_words]
+                if (self.seq_word is not None and
+                        rec[self.seq_word] != (self.rptr + i) & 0xffffffff):
+                    self.torn += 1
+                    continue
+                recs.append(rec)
+            self.rptr = (self.rptr + n) & 0xffffffff
+            avail -= n
+        return recs
+
+    def follow(self, interval=1.0):
+        """Yield records as they are written, never returns."""
+        while True:
+            recs = self.read()
+            for rec in recs:
+                yield rec
+            if not recs:
+                time.sleep(interval)
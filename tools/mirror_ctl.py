@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/mirror_ctl.py
+# @brief        Configure the wire app port mirroring
+#
+
+"""Configure mirror sessions, ports and ACL rules and show the counters.
+
+The layouts match apps/wire/mirror.h.  ACL rules live in CLS and are
+written to every island running the wire app.
+"""
+
+from __future__ import print_function
+
+import argparse
+import socket
+import struct
+import sys
+
+import nfp_rtsym
+
+SESSION_SYM = "_mirror_sessions"
+CREDIT_SYM = "_mirror_credit"
+PORT_SYM = "_mirror_port_cfg"
+CNTR_SYM = "_mirror_cntrs"
+ACL_SYM = "i%d._mirror_acl"
+
+NUM_SESSIONS = 16
+NUM_ACL = 8
+SESSION_SIZE = 16
+ACL_SIZE = 16
+CNTR_SIZE = 16
+# MIRROR_NUM_QOFF, the inputs of the level 2 scheduler of the first channel
+# of a port, and MIRROR_DEF_QOFF, the last of them
+NUM_QOFF = 8
+DEF_QOFF = NUM_QOFF - 1
+# Shortest copy worth sending, the MAC pads it to the minimum frame size
+MIN_TRUNC = 60
+
+
+def ip_prefix(val):
+    addr, _, plen = val.partition("/")
+    plen = int(plen) if plen else 32
+    mask = (0xffffffff << (32 - plen)) & 0xffffffff
+    dst = struct.unpack("!I", socket.inet_aton(addr))[0] & mask
+    return dst, mask
+
+
+def cmd_session(args):
+    if args.session >= NUM_SESSIONS:
+        sys.exit("session out of range: %d" % args.session)
+    off = args.session * SESSION_SIZE
+    if args.off:
+        nfp_rtsym.write_words(SESSION_SYM, off, [0])
+        return
+    if args.port is None:
+        sys.exit("--port is required")
+    if args.rate < 1:
+        sys.exit("--rate must be at least 1")
+    if args.trunc and args.trunc < MIN_TRUNC:
+        sys.exit("--trunc must be at least %d" % MIN_TRUNC)
+    if not 0 <= args.queue < NUM_QOFF:
+        sys.exit("--queue must be below %d, the queues of the first channel"
+                 % NUM_QOFF)
+    # Disable while updating, then restart the sampling countdown
+    nfp_rtsym.write_words(SESSION_SYM, off, [0])
+    nfp_rtsym.write_words(SESSION_SYM, off + 4, [args.rate, args.trunc, 0])
+    nfp_rtsym.write_words(CREDIT_SYM, args.session * 4, [1])
+    nfp_rtsym.write_words(SESSION_SYM, off,
+                          [(1 << 31) | (args.port << 16) | (args.queue << 8)])
+
+
+def cmd_port(args):
+    if args.mode == "all":
+        if args.session is None:
+            sys.exit("a session is required")
+        word = (1 << 31) | args.session
+    elif args.mode == "acl":
+        word = 1 << 30
+    else:
+        word = 0
+    nfp_rtsym.write_words(PORT_SYM, args.port * 4, [word])
+
+
+def cmd_acl(args):
+    if args.idx >= NUM_ACL:
+        sys.exit("rule out of range: %d" % args.idx)
+    if args.off:
+        words = [0, 0, 0, 0]
+    else:
+        if args.session is None:
+            sys.exit("--session is required")
+        dst, mask = ip_prefix(args.dst) if args.dst else (0, 0)
+        words = [(1 << 31) | (args.session << 16) | (args.proto << 8),
+                 dst, mask, args.dport]
+    for isl in args.islands:
+        nfp_rtsym.write_words(ACL_SYM % isl, args.idx * ACL_SIZE, words)
+
+
+def cmd_show(args):
+    sessions = args.sessions or range(NUM_SESSIONS)
+    for sess in sessions:
+        cfg = nfp_rtsym.read_words(SESSION_SYM, sess * SESSION_SIZE, 3)
+        if not cfg[0] >> 31 and not args.sessions:
+            continue
+        selected, mirrored = nfp_rtsym.read_u64(CNTR_SYM, sess * CNTR_SIZE, 2)
+        print("session %d: port %d queue %d rate 1:%d trunc %d, "
+              "selected %d mirrored %d" %
+              (sess, (cfg[0] >> 16) & 0xff, (cfg[0] >> 8) & 0xff, cfg[1],
+               cfg[2], selected, mirrored))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("session", help="configure a mirror session")
+    p.add_argument("session", type=int)
+    p.add_argument("--port", type=int, help="analyzer port")
+    p.add_argument("--queue", type=int, default=DEF_QOFF,
+                   help="TX queue offset in the analyzer port (default %d)"
+                   % DEF_QOFF)
+    p.add_argument("--rate", type=int, default=1,
+                   help="mirror 1 in RATE selected packets")
+    p.add_argument("--trunc", type=int, default=0,
+                   help="truncate copies to TRUNC bytes, 0 sends all")
+    p.add_argument("--off", action="store_true", help="disable the session")
+    p.set_defaults(func=cmd_session)
+
+    p = sub.add_parser("port", help="select the packets of a port")
+    p.add_argument("port", type=int)
+    p.add_argument("mode", choices=("all", "acl", "off"))
+    p.add_argument("session", type=int, nargs="?",
+                   help="session of all packets")
+    p.set_defaults(func=cmd_port)
+
+    p = sub.add_parser("acl", help="set an ACL rule")
+    p.add_argument("idx", type=int)
+    p.add_argument("--session", type=int)
+    p.add_argument("--proto", type=int, default=0, help="IP protocol")
+    p.add_argument("--dst", help="destination prefix, a.b.c.d/len")
+    p.add_argument("--dport", type=int, default=0,
+                   help="TCP/UDP destination port")
+    p.add_argument("--off", action="store_true", help="remove the rule")
+    p.add_argument("--islands", type=lambda v: [int(i) for i in v.split(",")],
+                   default=[32, 33], help="islands running the wire app")
+    p.set_defaults(func=cmd_acl)
+
+    p = sub.add_parser("show", help="show sessions and counters")
+    p.add_argument("sessions", type=int, nargs="*")
+    p.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
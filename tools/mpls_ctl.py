@@ -0,0 +1,122 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/mpls_ctl.py
+# @brief        Configure the wire app MPLS label table
+#
+
+"""Configure the MPLS label table and show the counters.
+
+The layouts match apps/wire/mpls_lsr.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+
+LBL_SYM = "_mpls_lbl_tbl"
+CNTR_SYM = "_mpls_lbl_cntrs"
+GCNTR_SYM = "_mpls_cntrs"
+NUM_LABELS = 1 << 20
+NUM_CNTRS = 4096
+LBL_ENTRY_SIZE = 8
+
+OPS = {"swap": 0, "push": 1, "pop": 2}
+
+
+def label(val):
+    val = int(val, 0)
+    if val < 0 or val >= NUM_LABELS:
+        raise argparse.ArgumentTypeError("label out of range: %d" % val)
+    return val
+
+
+def cmd_set(args):
+    if args.op != "pop" and args.out is None:
+        sys.exit("--out is required for %s" % args.op)
+    if args.op == "push" and args.push is None:
+        sys.exit("--push is required for push")
+    if args.cntr >= NUM_CNTRS:
+        sys.exit("counter index out of range: %d" % args.cntr)
+
+    w0 = (1 << 31) | (OPS[args.op] << 29) | (args.out or 0)
+    if args.ttl_prop:
+        w0 |= 1 << 28
+    w1 = (args.cntr << 20) | (args.push or 0)
+    # Write the word holding the valid bit last
+    nfp_rtsym.write_words(LBL_SYM, args.label * LBL_ENTRY_SIZE + 4, [w1])
+    nfp_rtsym.write_words(LBL_SYM, args.label * LBL_ENTRY_SIZE, [w0])
+
+
+def cmd_del(args):
+    nfp_rtsym.write_words(LBL_SYM, args.label * LBL_ENTRY_SIZE, [0])
+
+
+def stats_cntr(idx):
+    """Decode a stats engine packet/byte counter.
+
+    The low 3 bits of the upper word extend the 32 bit byte count in the
+    lower word, the remaining 29 bits hold the packet count.
+    """
+    lo, hi = nfp_rtsym.read_words(CNTR_SYM, idx * 8, 2)
+    return (hi >> 3) & 0x1fffffff, ((hi & 0x7) << 32) | lo
+
+
+def cmd_show(args):
+    names = ("swap", "push", "pop", "php", "miss", "ttl_exceeded",
+             "bad_hdr")
+    vals = nfp_rtsym.read_u64(GCNTR_SYM, 0, len(names))
+    print(" ".join("%s %d" % nv for nv in zip(names, vals)))
+    for idx in args.cntrs:
+        pkts, nbytes = stats_cntr(idx & (NUM_CNTRS - 1))
+        print("counter %d: %d pkts %d bytes" % (idx, pkts, nbytes))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("set", help="add or replace a label entry")
+    p.add_argument("label", type=label)
+    p.add_argument("op", choices=sorted(OPS))
+    p.add_argument("--out", type=label, help="outgoing top label")
+    p.add_argument("--push", type=label, help="label pushed on top")
+    p.add_argument("--ttl-prop", action="store_true",
+                   help="propagate the TTL on pop")
+    p.add_argument("--cntr", type=int, default=0,
+                   help="stats counter index")
+    p.set_defaults(func=cmd_set)
+
+    p = sub.add_parser("del", help="remove a label entry")
+    p.add_argument("label", type=label)
+    p.set_defaults(func=cmd_del)
+
+    p = sub.add_parser("show", help="show counters")
+    p.add_argument("cntrs", type=int, nargs="*")
+    p.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
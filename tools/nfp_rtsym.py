@@ -0,0 +1,60 @@
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/nfp_rtsym.py
+# @brief        Access firmware run time symbols through nfp-rtsym
+#
+
+"""Thin wrapper around the SDK nfp-rtsym utility.
+
+Firmware tables are exported as run time symbols (see __export in the
+Micro-C sources).  The helpers here read and write them as lists of 32 bit
+words in the byte order of the NFP (big endian).
+"""
+
+import os
+import subprocess
+
+NFP_SDK_DIR = os.environ.get("NFP_SDK_DIR", "/opt/netronome")
+NFP_RTSYM = os.path.join(NFP_SDK_DIR, "bin", "nfp-rtsym")
+
+
+def _run(args):
+    return subprocess.check_output([NFP_RTSYM] + args,
+                                   universal_newlines=True)
+
+
+def read_words(sym, off, nwords):
+    """Read nwords 32 bit words from symbol sym at byte offset off."""
+    out = _run(["-l", str(nwords * 4), "%s:%d" % (sym, off)])
+    words = []
+    for line in out.splitlines():
+        if ":" not in line:
+            continue
+        for tok in line.split(":", 1)[1].split():
+            words.append(int(tok, 16))
+    return words[:nwords]
+
+
+def write_words(sym, off, words):
+    """Write a list of 32 bit words to symbol sym at byte offset off."""
+    _run(["%s:%d" % (sym, off)] + ["0x%08x" % (w & 0xffffffff)
+                                   for w in words])
+
+
+def read_u64(sym, off, count):
+    """Read count 64 bit counters from symbol sym at byte offset off."""
+    words = read_words(sym, off, count * 2)
+    return [(words[2 * i] << 32) | words[2 * i + 1] for i in range(count)]
@@ -0,0 +1,197 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/policer_calc.py
+# @brief        Convert policer rates and burst sizes to meter configuration
+#
+
+"""Compute the configuration words of a wire app policer meter.
+
+The layout matches struct policer_cfg in apps/wire/policer.h.  Rates are
+converted to bytes added per refill interval, as an integer part and a
+32 bit binary fraction.  The refill interval is POLICER_REFILL_TICKS ME
+timestamp ticks, each tick being 16 ME clock cycles.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+
+CFG_SYM = "_policer_cfg"
+METER_SYM = "_policer_meters"
+CNTR_SYM = "_policer_cntrs"
+CFG_SIZE = 32
+METER_SIZE = 8
+CNTR_NAMES = ("green", "yellow", "red", "dropped", "remarked", "remark_err")
+
+MODE_PEAK = 0
+MODE_EXCESS = 1
+ACTIONS = {"pass": 0, "drop": 1, "remark": 2}
+
+TSC_CYCLES = 16
+MAX_FRAME = 1518
+
+SUFFIX = {"k": 1e3, "m": 1e6, "g": 1e9}
+BYTE_SUFFIX = {"k": 1024, "m": 1024 * 1024}
+
+
+def parse_num(val, suffixes):
+    val = val.strip().lower()
+    if val and val[-1] in suffixes:
+        return float(val[:-1]) * suffixes[val[-1]]
+    return float(val)
+
+
+def parse_action(val):
+    """Parse pass, drop or remark:<dscp> into (action, dscp)."""
+    name, _, dscp = val.partition(":")
+    if name not in ACTIONS:
+        raise argparse.ArgumentTypeError("unknown action %s" % name)
+    if name == "remark":
+        if not dscp or not 0 <= int(dscp) < 64:
+            raise argparse.ArgumentTypeError("remark needs a DSCP 0-63")
+        return ACTIONS[name], int(dscp)
+    return ACTIONS[name], 0
+
+
+def refill_inc(tokens_per_sec, refill_ticks, me_clock_mhz):
+    """Return the (integer, fraction) tokens added per refill interval."""
+    period = refill_ticks * TSC_CYCLES / (me_clock_mhz * 1e6)
+    tokens = tokens_per_sec * period
+    inc = int(tokens)
+    frac = int(round((tokens - inc) * (1 << 32)))
+    if frac == 1 << 32:
+        inc, frac = inc + 1, 0
+    if inc >= 1 << 32:
+        raise ValueError("rate too high for the refill interval")
+    return inc, frac
+
+
+def rate_to_inc(rate_bps, args):
+    """Return the (integer, fraction) bytes added per refill for a rate."""
+    return refill_inc(rate_bps / 8.0, args.refill_ticks, args.me_clock_mhz)
+
+
+def act_word(mode, yellow, red):
+    """Encode the first word of struct policer_act."""
+    return ((1 << 31) | (mode << 30) | (yellow[0] << 28) | (red[0] << 26) |
+            (yellow[1] << 20) | (red[1] << 14))
+
+
+def check_burst(name, burst, inc):
+    errors = []
+    if burst >= 1 << 32:
+        errors.append("%s of %d bytes does not fit the meter" % (name, burst))
+    if burst < inc:
+        errors.append("%s of %d bytes is below the %d bytes added per "
+                      "refill, the rate can not be reached" %
+                      (name, burst, inc))
+    if burst < MAX_FRAME:
+        print("warning: %s of %d bytes is below a full size frame, large "
+              "frames will never be green" % (name, burst), file=sys.stderr)
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--meter", type=int, default=0,
+                        help="meter index (ports first, then flows)")
+    parser.add_argument("--mode", choices=("trtcm", "srtcm"), default="trtcm",
+                        help="RFC 2698 trTCM or RFC 2697 srTCM")
+    parser.add_argument("--cir", required=True,
+                        help="committed rate in bits per second (k/M/G)")
+    parser.add_argument("--cbs", required=True,
+                        help="committed burst size in bytes (k/M)")
+    parser.add_argument("--pir", help="peak rate in bits per second (trTCM)")
+    parser.add_argument("--pbs", "--ebs", dest="pbs", required=True,
+                        help="peak (trTCM) or excess (srTCM) burst in bytes")
+    parser.add_argument("--yellow", type=parse_action, default=(0, 0),
+                        help="pass, drop or remark:<dscp>")
+    parser.add_argument("--red", type=parse_action, default=(1, 0),
+                        help="pass, drop or remark:<dscp>")
+    parser.add_argument("--refill-ticks", type=int, default=5000,
+                        help="POLICER_REFILL_TICKS of the firmware")
+    parser.add_argument("--me-clock-mhz", type=float, default=800.0,
+                        help="ME clock frequency in MHz")
+    parser.add_argument("--write", action="store_true",
+                        help="write the meter to the loaded firmware")
+    parser.add_argument("--disable", action="store_true",
+                        help="disable the meter (with --write)")
+    parser.add_argument("--show", action="store_true",
+                        help="dump the counters of the meter")
+    args = parser.parse_args()
+
+    cir = parse_num(args.cir, SUFFIX)
+    cbs = int(parse_num(args.cbs, BYTE_SUFFIX))
+    pbs = int(parse_num(args.pbs, BYTE_SUFFIX))
+
+    if args.mode == "trtcm":
+        if args.pir is None:
+            parser.error("--pir is required for trTCM")
+        pir = parse_num(args.pir, SUFFIX)
+        if pir < cir:
+            parser.error("PIR must not be below CIR")
+        mode = MODE_PEAK
+    else:
+        pir = 0
+        mode = MODE_EXCESS
+
+    try:
+        cir_inc, cir_frac = rate_to_inc(cir, args)
+        pir_inc, pir_frac = rate_to_inc(pir, args)
+    except ValueError as err:
+        parser.error(str(err))
+
+    errors = check_burst("CBS", cbs, cir_inc)
+    if mode == MODE_PEAK:
+        errors += check_burst("PBS", pbs, pir_inc)
+    elif pbs >= 1 << 32:
+        errors.append("EBS of %d bytes does not fit the meter" % pbs)
+    if errors:
+        parser.error("; ".join(errors))
+
+    act = 0 if args.disable else act_word(mode, args.yellow, args.red)
+    words = [cir_inc, cir_frac, cbs, pir_inc, pir_frac, pbs, act, 0]
+
+    print("meter %d: %s" % (args.meter, args.mode))
+    print("  cir %d bps -> %d + %d/2^32 bytes per refill" %
+          (cir, cir_inc, cir_frac))
+    if mode == MODE_PEAK:
+        print("  pir %d bps -> %d + %d/2^32 bytes per refill" %
+              (pir, pir_inc, pir_frac))
+    print("  %s:%d = %s" % (CFG_SYM, args.meter * CFG_SIZE,
+                            " ".join("0x%08x" % w for w in words)))
+
+    if args.write:
+        # Disable while updating, then start with full buckets
+        nfp_rtsym.write_words(CFG_SYM, args.meter * CFG_SIZE + 24, [0])
+        nfp_rtsym.write_words(METER_SYM, args.meter * METER_SIZE, [pbs, cbs])
+        nfp_rtsym.write_words(CFG_SYM, args.meter * CFG_SIZE, words)
+
+    if args.show:
+        vals = nfp_rtsym.read_u64(CNTR_SYM, args.meter * len(CNTR_NAMES) * 8,
+                                  len(CNTR_NAMES))
+        for name, val in zip(CNTR_NAMES, vals):
+            print("  %-10s %d" % (name, val))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,137 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/qos_ctl.py
+# @brief        Configure and monitor the wire app PCP/DSCP classification
+#
+
+"""Configure the PCP/DSCP to TM queue classification of the wire app.
+
+The layouts match struct qos_port_cfg and qos_dscp_map in
+apps/wire/qos.h.  Queue 0 of a port is the first input of its level 2
+scheduler, so with strict priority inputs the highest classes belong in
+the lowest queues.  Without a map the PCP or the class selector (top 3
+bits) of the DSCP is mapped to queue 7 - value.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+
+PORT_SYM = "_qos_port_cfg"
+DSCP_SYM = "_qos_dscp_map"
+CNTR_SYM = "_qos_cntrs"
+PORT_SIZE = 8
+CNTR_SIZE = 16
+
+QUEUES = 8
+DSCPS = 64
+TRUST = {"none": 0, "pcp": 1, "dscp": 2, "all": 3}
+
+
+def pack(queues):
+    """Pack a list of queue numbers into 4 bit entries, 8 to a word."""
+    words = []
+    for i in range(0, len(queues), 8):
+        word = 0
+        for j, queue in enumerate(queues[i:i + 8]):
+            word |= queue << (4 * j)
+        words.append(word)
+    return words
+
+
+def parse_map(val, count):
+    """Parse "V=Q,..." into a list of count queues, the others by default."""
+    queues = [QUEUES - 1 - (v * QUEUES // count) for v in range(count)]
+    if not val:
+        return queues
+    for item in val.split(","):
+        key, _, queue = item.partition("=")
+        key, queue = int(key, 0), int(queue, 0)
+        if not 0 <= key < count or not 0 <= queue < QUEUES:
+            sys.exit("bad map entry %s" % item)
+        queues[key] = queue
+    return queues
+
+
+def cmd_port(args):
+    if not 0 <= args.default < QUEUES:
+        sys.exit("--default must be a queue below %d" % QUEUES)
+    words = [(TRUST[args.trust] << 30) | args.default,
+             pack(parse_map(args.pcp_map, QUEUES))[0]]
+    for port in args.ports:
+        print("%s:%d = %s" % (PORT_SYM, port * PORT_SIZE,
+                              " ".join("0x%08x" % w for w in words)))
+        if args.write:
+            nfp_rtsym.write_words(PORT_SYM, port * PORT_SIZE, words)
+
+
+def cmd_dscp(args):
+    words = pack(parse_map(args.map, DSCPS))
+    print("%s:0 = %s" % (DSCP_SYM, " ".join("0x%08x" % w for w in words)))
+    if args.write:
+        nfp_rtsym.write_words(DSCP_SYM, 0, words)
+
+
+def cmd_show(args):
+    print("%-6s %-6s %20s %20s" % ("port", "queue", "pkts", "bytes"))
+    for port in args.ports:
+        vals = nfp_rtsym.read_u64(CNTR_SYM, port * QUEUES * CNTR_SIZE,
+                                  2 * QUEUES)
+        for queue in range(QUEUES):
+            print("%-6d %-6d %20d %20d" %
+                  (port, queue, vals[2 * queue], vals[2 * queue + 1]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p_port = sub.add_parser("port", help="set what ingress ports trust")
+    p_port.add_argument("ports", type=int, nargs="+")
+    p_port.add_argument("--trust", choices=sorted(TRUST, key=TRUST.get),
+                        required=True)
+    p_port.add_argument("--default", type=int, default=QUEUES - 1,
+                        help="queue of packets without a trusted field")
+    p_port.add_argument("--pcp-map",
+                        help="PCP=QUEUE,... (default 7 - PCP)")
+    p_port.add_argument("--write", action="store_true",
+                        help="write the config to the loaded firmware")
+    p_port.set_defaults(func=cmd_port)
+
+    p_dscp = sub.add_parser("dscp", help="set the DSCP map")
+    p_dscp.add_argument("--map", help="DSCP=QUEUE,... (default 7 - DSCP/8)")
+    p_dscp.add_argument("--write", action="store_true",
+                        help="write the map to the loaded firmware")
+    p_dscp.set_defaults(func=cmd_dscp)
+
+    p_show = sub.add_parser("show", help="show the per queue counters")
+    p_show.add_argument("ports", type=int, nargs="+",
+                        help="egress ports")
+    p_show.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,181 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/sflow_read.py
+# @brief        Configure and read the wire app packet sampling
+#
+
+"""Set the per port sampling rates and decode the samples.
+
+"rate" sets the 1:N sampling rate of an ingress port on every island,
+N of 0 turns sampling off.  "dump" reads the sflow_ring host ring and
+prints each sample as an sFlow flow sample with a raw packet header
+record, in the text format of sflowtool, and can also write the sampled
+headers to a pcap file.  The layouts match apps/wire/sflow.h.
+"""
+
+from __future__ import print_function
+
+import argparse
+import struct
+import sys
+import time
+
+import nfp_rtsym
+from host_ring import HostRing
+from policer_calc import TSC_CYCLES
+
+CFG_SYM = "i%d._sflow_port_cfg"
+RING_SYM = "_sflow_ring"
+
+CFG_SIZE = 8
+NUM_PORTS = 64
+RING_ENTRIES = 4096
+HDR_LEN = 128
+# Frame data followed by 8 words of metadata
+REC_WORDS = HDR_LEN // 4 + 8
+
+
+def cmd_rate(args):
+    if args.port >= NUM_PORTS:
+        sys.exit("port out of range: %d" % args.port)
+    if args.rate == 0:
+        thresh = 0
+    else:
+        thresh = min((1 << 32) // args.rate, 0xffffffff)
+    for isl in args.islands:
+        nfp_rtsym.write_words(CFG_SYM % isl, args.port * CFG_SIZE,
+                              [thresh, args.rate])
+
+
+def decode(rec):
+    """Return the metadata dict and the captured bytes of a record."""
+    meta = rec[HDR_LEN // 4:]
+    m = {
+        "seq": meta[0],
+        "isl": meta[1] >> 24,
+        "port": (meta[1] >> 16) & 0xff,
+        "len": meta[1] & 0xffff,
+        "cap": meta[2] & 0xffff,
+        "rate": meta[3],
+        "ts": (meta[4] << 32) | meta[5],
+    }
+    data = struct.pack("!%dI" % (HDR_LEN // 4), *rec[:HDR_LEN // 4])
+    return m, data[:m["cap"]]
+
+
+def mac_str(b):
+    return "".join("%02x" % ord(b[i:i + 1]) for i in range(6))
+
+
+def print_sample(m, data, seqs):
+    # Per source (island, port) sequence numbers, as an agent would keep
+    src = (m["isl"], m["port"])
+    seqs[src] = seqs.get(src, 0) + 1
+    print("startSample ----------------------")
+    print("sampleType_tag 0:1")
+    print("sampleType FLOWSAMPLE")
+    print("sampleSequenceNo %d" % seqs[src])
+    print("sourceId 0:%d" % m["port"])
+    print("meanSkipCount %d" % m["rate"])
+    print("inputPort %d" % m["port"])
+    print("agentIsland %d" % m["isl"])
+    print("timestamp %d" % m["ts"])
+    print("flowBlock_tag 0:1")
+    print("flowSampleType HEADER")
+    print("headerProtocol 1")
+    print("sampledPacketSize %d" % m["len"])
+    print("strippedBytes 0")
+    print("headerLen %d" % len(data))
+    print("headerBytes %s" % "-".join("%02X" % ord(data[i:i + 1])
+                                      for i in range(len(data))))
+    if len(data) >= 14:
+        print("dstMAC %s" % mac_str(data[0:6]))
+        print("srcMAC %s" % mac_str(data[6:12]))
+    print("endSample   ----------------------")
+
+
+def cmd_dump(args):
+    ring = HostRing(RING_SYM, RING_ENTRIES, REC_WORDS,
+                    start=0 if args.all else None)
+    pcap = None
+    if args.pcap:
+        pcap = open(args.pcap, "wb")
+        pcap.write(struct.pack("<IHHiIII", 0xa1b2c3d4, 2, 4, 0, 0, HDR_LEN, 1))
+    tick_us = TSC_CYCLES / float(args.me_clock_mhz)
+    seqs = {}
+    torn = 0
+    try:
+        while True:
+            recs = ring.read()
+            first = (ring.rptr - len(recs)) & 0xffffffff
+            for i, rec in enumerate(recs):
+                m, data = decode(rec)
+                if m["seq"] != (first + i) & 0xffffffff:
+                    # Overwritten or not yet complete
+                    torn += 1
+                    continue
+                if pcap:
+                    us = int(m["ts"] * tick_us)
+                    pcap.write(struct.pack("<IIII", us // 1000000,
+                                           us % 1000000, len(data), m["len"]))
+                    pcap.write(data)
+                else:
+                    print_sample(m, data, seqs)
+            if not args.follow:
+                break
+            if not recs:
+                time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+    if pcap:
+        pcap.close()
+    if ring.lost or torn:
+        print("%d samples lost, %d incomplete" % (ring.lost, torn),
+              file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("rate", help="set the sampling rate of a port")
+    p.add_argument("port", type=int)
+    p.add_argument("rate", type=int, help="sample 1 in N packets, 0 for off")
+    p.add_argument("--islands", type=lambda v: [int(i) for i in v.split(",")],
+                   default=[32, 33], help="islands running the wire app")
+    p.set_defaults(func=cmd_rate)
+
+    p = sub.add_parser("dump", help="print the samples")
+    p.add_argument("--all", action="store_true",
+                   help="start with the samples still in the ring")
+    p.add_argument("--follow", action="store_true",
+                   help="keep printing new samples")
+    p.add_argument("--interval", type=float, default=0.5,
+                   help="poll interval with --follow, in seconds")
+    p.add_argument("--pcap", help="write the sampled headers to a pcap file")
+    p.add_argument("--me-clock-mhz", type=float, default=800)
+    p.set_defaults(func=cmd_dump)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
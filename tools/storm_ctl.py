@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/storm_ctl.py
+# @brief        Configure and monitor the wire app storm control
+#
+
+"""Configure the storm control limits of the wire app.
+
+The layout matches struct storm_cfg in apps/wire/storm.h.  Limits are
+given per port and class either in packets per second or in bits per
+second.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+from policer_calc import SUFFIX, BYTE_SUFFIX, parse_num, refill_inc
+
+CFG_SYM = "_storm_cfg"
+METER_SYM = "_storm_meters"
+CNTR_SYM = "_storm_cntrs"
+CFG_SIZE = 16
+METER_SIZE = 8
+CNTR_SIZE = 16
+
+CLASSES = {"bc": 0, "mc": 1, "uuc": 2}
+CLS_STRIDE = 4
+
+
+def idx(port, cls):
+    return port * CLS_STRIDE + CLASSES[cls]
+
+
+def cmd_set(args):
+    if (args.pps is None) == (args.bps is None):
+        sys.exit("exactly one of --pps and --bps is required")
+
+    if args.pps is not None:
+        rate = parse_num(args.pps, SUFFIX)
+        burst = int(parse_num(args.burst, SUFFIX))
+        flags = (1 << 31) | (1 << 30)
+    else:
+        rate = parse_num(args.bps, SUFFIX) / 8.0
+        burst = int(parse_num(args.burst, BYTE_SUFFIX))
+        flags = 1 << 31
+
+    inc, frac = refill_inc(rate, args.refill_ticks, args.me_clock_mhz)
+    if burst < max(inc, 1):
+        sys.exit("burst %d is below the %d tokens added per refill" %
+                 (burst, inc))
+
+    i = idx(args.port, args.cls)
+    words = [inc, frac, burst, flags]
+    print("%s:%d = %s" % (CFG_SYM, i * CFG_SIZE,
+                          " ".join("0x%08x" % w for w in words)))
+    if args.write:
+        nfp_rtsym.write_words(CFG_SYM, i * CFG_SIZE + 12, [0])
+        nfp_rtsym.write_words(METER_SYM, i * METER_SIZE, [burst, 0])
+        nfp_rtsym.write_words(CFG_SYM, i * CFG_SIZE, words)
+
+
+def cmd_clear(args):
+    nfp_rtsym.write_words(CFG_SYM, idx(args.port, args.cls) * CFG_SIZE + 12,
+                          [0])
+
+
+def cmd_show(args):
+    print("%-6s %-4s %20s %20s" % ("port", "cls", "pass", "drop"))
+    for port in args.ports:
+        for cls in sorted(CLASSES, key=CLASSES.get):
+            vals = nfp_rtsym.read_u64(CNTR_SYM, idx(port, cls) * CNTR_SIZE, 2)
+            print("%-6d %-4s %20d %20d" % (port, cls, vals[0], vals[1]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--refill-ticks", type=int, default=5000,
+                        help="STORM_REFILL_TICKS of the firmware")
+    parser.add_argument("--me-clock-mhz", type=float, default=800.0,
+                        help="ME clock frequency in MHz")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p_set = sub.add_parser("set", help="set a limit")
+    p_set.add_argument("port", type=int)
+    p_set.add_argument("cls", choices=sorted(CLASSES))
+    p_set.add_argument("--pps", help="packets per second (k/M)")
+    p_set.add_argument("--bps", help="bits per second (k/M/G)")
+    p_set.add_argument("--burst", required=True,
+                       help="burst in packets (--pps) or bytes (--bps)")
+    p_set.add_argument("--write", action="store_true",
+                       help="write the limit to the loaded firmware")
+    p_set.set_defaults(func=cmd_set)
+
+    p_clr = sub.add_parser("clear", help="remove a limit")
+    p_clr.add_argument("port", type=int)
+    p_clr.add_argument("cls", choices=sorted(CLASSES))
+    p_clr.set_defaults(func=cmd_clear)
+
+    p_show = sub.add_parser("show", help="show pass/drop counters")
+    p_show.add_argument("ports", type=int, nargs="+")
+    p_show.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/test_tm_gen.py
+# @brief        Unit tests of the tm_gen.py register conversions
+#
+
+"""Unit tests of the register conversions of tm_gen.py.
+
+Run from the tools directory with "python -m unittest test_tm_gen".
+"""
+
+from __future__ import division, print_function
+
+import unittest
+
+import tm_gen
+from tm_gen import (SpecError, OVERSHOOTS, THRESHOLDS, qsize_of,
+                    reg_to_rate, rate_to_reg, size_code)
+
+
+class RateToRegTest(unittest.TestCase):
+
+    def test_exact(self):
+        self.assertEqual(rate_to_reg(10e9), 1000)
+        self.assertEqual(rate_to_reg(10e6), 1)
+
+    def test_rounding(self):
+        # 15 Mbps is 1.5 units at a 1 GHz PClk
+        self.assertEqual(rate_to_reg(15e6, rounding="down"), 1)
+        self.assertEqual(rate_to_reg(15e6, rounding="up"), 2)
+        self.assertEqual(rate_to_reg(15e6, rounding="nearest"), 2)
+        self.assertEqual(rate_to_reg(14e6, rounding="nearest"), 1)
+        self.assertEqual(rate_to_reg(16e6, rounding="down"), 1)
+
+    def test_pclk(self):
+        # The unit grows as the PClk falls below 1 GHz
+        self.assertEqual(rate_to_reg(10e9, pclk_mhz=1000), 1000)
+        self.assertEqual(rate_to_reg(10e9, pclk_mhz=800), 800)
+        self.assertEqual(rate_to_reg(12.5e6, pclk_mhz=800), 1)
+        self.assertEqual(rate_to_reg(12.5e6, pclk_mhz=800, rounding="up"),
+                         1)
+        self.assertEqual(rate_to_reg(13e6, pclk_mhz=800, rounding="up"), 2)
+
+    def test_bounds(self):
+        self.assertEqual(rate_to_reg(120e9), tm_gen.RATE_MAX)
+        self.assertEqual(rate_to_reg(150e9, pclk_mhz=800), tm_gen.RATE_MAX)
+        with self.assertRaises(SpecError):
+            rate_to_reg(9.99e6)
+        with self.assertRaises(SpecError):
+            rate_to_reg(12.4e6, pclk_mhz=800)
+        with self.assertRaises(SpecError):
+            rate_to_reg(120.01e9)
+        with self.assertRaises(SpecError):
+            rate_to_reg(150.1e9, pclk_mhz=800)
+        # Rounding up or to nearest can still land below one unit
+        with self.assertRaises(SpecError):
+            rate_to_reg(4e6, rounding="nearest")
+        self.assertEqual(rate_to_reg(1e6, rounding="up"), 1)
+
+    def test_round_trip(self):
+        for pclk in (800, 1000):
+            for reg in (tm_gen.RATE_MIN, 1, 7, 800, 1000, tm_gen.RATE_MAX):
+                self.assertEqual(
+                    rate_to_reg(reg_to_rate(reg, pclk), pclk_mhz=pclk), reg)
+        self.assertEqual(reg_to_rate(1000), 10e9)
+        self.assertEqual(reg_to_rate(800, pclk_mhz=800), 10e9)
+
+
+class SizeCodeTest(unittest.TestCase):
+
+    def test_thresholds(self):
+        self.assertEqual(size_code(1, THRESHOLDS, "burst"), 0)
+        self.assertEqual(size_code(8192, THRESHOLDS, "burst"), 0)
+        self.assertEqual(size_code(8193, THRESHOLDS, "burst"), 1)
+        self.assertEqual(size_code(65535, THRESHOLDS, "burst"), 7)
+        with self.assertRaises(SpecError):
+            size_code(65536, THRESHOLDS, "burst")
+
+    def test_overshoots(self):
+        self.assertEqual(size_code(16384, OVERSHOOTS, "overshoot"), 0)
+        self.assertEqual(size_code(16385, OVERSHOOTS, "overshoot"), 1)
+        self.assertEqual(size_code(65537, OVERSHOOTS, "overshoot"), 7)
+        self.assertEqual(size_code(131071, OVERSHOOTS, "overshoot"), 7)
+        with self.assertRaises(SpecError):
+            size_code(131072, OVERSHOOTS, "overshoot")
+
+    def test_tables_sorted(self):
+        for table in (THRESHOLDS, OVERSHOOTS):
+            self.assertEqual(list(table), sorted(table))
+            for code, size in enumerate(table):
+                self.assertEqual(size_code(size, table, "size"), code)
+
+
+class QsizeTest(unittest.TestCase):
+
+    def test_limits(self):
+        self.assertEqual(qsize_of(1), tm_gen.QSIZE_MIN)
+        self.assertEqual(qsize_of(1 << tm_gen.QSIZE_MIN), tm_gen.QSIZE_MIN)
+        self.assertEqual(qsize_of((1 << tm_gen.QSIZE_MIN) + 1),
+                         tm_gen.QSIZE_MIN + 1)
+        self.assertEqual(qsize_of(1 << tm_gen.QSIZE_MAX), tm_gen.QSIZE_MAX)
+        with self.assertRaises(SpecError):
+            qsize_of((1 << tm_gen.QSIZE_MAX) + 1)
+
+    def test_power_of_2(self):
+        self.assertEqual(qsize_of(64), 6)
+        self.assertEqual(qsize_of(100), 7)
+
+
+if __name__ == "__main__":
+    unittest.main()
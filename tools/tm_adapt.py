@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/tm_adapt.py
+# @brief        Configure and monitor the adaptive TM shaping loops
+#
+
+"""Configure the adaptive shaping loops of the wire app.
+
+The layouts match struct tm_adapt_cfg and struct tm_adapt_state in
+apps/wire/tm_adapt.h, the firmware is built with CFG_TM_CTL and
+CFG_TM_ADAPT.  A loop cuts the rate of one shaper while a group of
+watched queues is deeper than the target or drops, and raises it again
+step by step otherwise.
+
+The latency target is turned into a depth in packets from the rate the
+watched queues drain at and their mean packet size.  Rates are whole Mbps
+and the shaper register counts 10 Mbps x 1000 / PClk MHz, so the minimum
+rate and the step must be at least one such unit or the firmware refuses
+the loop (see "show").
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+from policer_calc import SUFFIX, parse_num
+
+CFG_SYM = "_tm_adapt_cfg"
+STATE_SYM = "_tm_adapt_state"
+CFG_WORDS = 8
+STATE_WORDS = 8
+
+LOOPS = 8
+MAX_QUEUES = 16
+NUM_QUEUES = 1024
+RATE_MAX = 12000
+
+STATUS = ("off", "running", "bad queues", "no such shaper", "bad rate",
+          "bad step")
+
+
+def mbps(val):
+    return int(parse_num(val, SUFFIX) // 1e6)
+
+
+def rate_reg(rate, pclk_mhz):
+    """Shaper register value of a rate in Mbps, as tm_ctl_rate_reg()."""
+    reg = rate * pclk_mhz // 10000
+    return reg if reg <= RATE_MAX else 0
+
+
+def cmd_set(args):
+    qbase, _, nq = args.queues.partition(":")
+    qbase = int(qbase, 0)
+    nq = int(nq, 0) if nq else 1
+    if not 1 <= nq <= MAX_QUEUES or qbase + nq > NUM_QUEUES:
+        sys.exit("watch 1-%d queues below %d" % (MAX_QUEUES, NUM_QUEUES))
+
+    if (args.target is None) == (args.latency_us is None):
+        sys.exit("exactly one of --target and --latency-us is required")
+    if args.target is not None:
+        target = args.target
+    else:
+        drain = parse_num(args.drain_rate, SUFFIX)
+        target = int(args.latency_us * 1e-6 * drain / (8 * args.pkt_bytes))
+        print("%g us at %s bps of %d B packets: %d packets" %
+              (args.latency_us, args.drain_rate, args.pkt_bytes, target))
+
+    md = int(round(args.decrease * 256))
+    if not 1 <= md <= 255:
+        sys.exit("--decrease must be within 1/256 and 255/256")
+
+    min_rate = mbps(args.min_rate)
+    max_rate = mbps(args.max_rate)
+    step = mbps(args.step)
+    unit = 10000.0 / args.pclk_mhz
+    if not min_rate <= max_rate:
+        sys.exit("need --min-rate <= --max-rate")
+    for name, val in (("--min-rate", min_rate), ("--max-rate", max_rate),
+                      ("--step", step)):
+        if rate_reg(val, args.pclk_mhz) == 0:
+            sys.exit("%s of %d Mbps is outside the %g-%d Mbps a shaper "
+                     "register holds at a %d MHz PClk" %
+                     (name, val, unit, int(RATE_MAX * unit), args.pclk_mhz))
+
+    hdr = ((1 << 31) | (args.nbi << 30) | (args.level << 28) | (md << 8) |
+           args.node)
+    words = [hdr, (qbase << 16) | nq, target, min_rate, max_rate, step,
+             0, 0]
+    off = args.loop * CFG_WORDS * 4
+    print("%s:%d = %s" % (CFG_SYM, off, " ".join("0x%08x" % w for w in words)))
+    if args.write:
+        # Stop the loop while the fields change, enable it last
+        nfp_rtsym.write_words(CFG_SYM, off, [0])
+        nfp_rtsym.write_words(CFG_SYM, off + 4, words[1:])
+        nfp_rtsym.write_words(CFG_SYM, off, words[:1])
+
+
+def cmd_clear(args):
+    nfp_rtsym.write_words(CFG_SYM, args.loop * CFG_WORDS * 4, [0])
+
+
+def cmd_show(args):
+    print("%-4s %-14s %8s %8s %12s %20s %20s" %
+          ("loop", "status", "rate", "depth", "drops", "decr", "incr"))
+    for loop in range(LOOPS):
+        if not nfp_rtsym.read_words(CFG_SYM, loop * CFG_WORDS * 4, 1)[0] >> 31:
+            continue
+        off = loop * STATE_WORDS * 4
+        words = nfp_rtsym.read_words(STATE_SYM, off, 4)
+        status = STATUS[words[3]] if words[3] < len(STATUS) else \
+            "status %d" % words[3]
+        if words[3] != 1:
+            print("%-4d %-14s" % (loop, status))
+            continue
+        decr, incr = nfp_rtsym.read_u64(STATE_SYM, off + 16, 2)
+        rate = words[0] * 10000 // args.pclk_mhz
+        print("%-4d %-14s %7dM %8d %12d %20d %20d" %
+              (loop, status, rate, words[1], words[2], decr, incr))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--pclk-mhz", type=int, default=1000,
+                        help="TM_CTL_PCLK_MHZ of the firmware")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p_set = sub.add_parser("set", help="configure a loop")
+    p_set.add_argument("loop", type=int, choices=range(LOOPS))
+    p_set.add_argument("--nbi", type=int, choices=[0], default=0)
+    p_set.add_argument("--level", type=int, choices=[0, 1, 2], default=2)
+    p_set.add_argument("--node", type=int, required=True,
+                       help="controlled shaper, as in tm_ctl.py")
+    p_set.add_argument("--queues", required=True,
+                       help="watched queues, FIRST[:COUNT]")
+    p_set.add_argument("--target", type=int,
+                       help="depth target in packets")
+    p_set.add_argument("--latency-us", type=float,
+                       help="latency target of the watched queues")
+    p_set.add_argument("--drain-rate", default="10G",
+                       help="bits per second the watched queues drain at")
+    p_set.add_argument("--pkt-bytes", type=int, default=1000,
+                       help="mean packet size of the watched queues")
+    p_set.add_argument("--min-rate", required=True,
+                       help="lowest shaper rate (k/M/G)")
+    p_set.add_argument("--max-rate", required=True,
+                       help="highest shaper rate (k/M/G)")
+    p_set.add_argument("--step", default="100M",
+                       help="rate increase per sample (k/M/G)")
+    p_set.add_argument("--decrease", type=float, default=0.125,
+                       help="fraction of the rate cut per congested sample")
+    p_set.add_argument("--write", action="store_true",
+                       help="write the loop to the loaded firmware")
+    p_set.set_defaults(func=cmd_set)
+
+    p_clr = sub.add_parser("clear", help="stop a loop")
+    p_clr.add_argument("loop", type=int, choices=range(LOOPS))
+    p_clr.set_defaults(func=cmd_clear)
+
+    p_show = sub.add_parser("show", help="show the running loops")
+    p_show.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,213 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/tm_ctl.py
+# @brief        Change the TM shaper rates and scheduler weights at run time
+#
+
+"""Change the traffic manager shapers and schedulers of the wire app.
+
+Requests are posted to the tm_ctl mailbox of a firmware built with
+CFG_TM_CTL, the layouts match struct tm_ctl_req and struct tm_ctl_rep in
+apps/wire/tm_ctl.h.  Each request is waited for and its outcome printed
+with the ME timestamp at which it took effect.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+import time
+
+import nfp_rtsym
+from host_ring import HostRing
+from policer_calc import SUFFIX, BYTE_SUFFIX, parse_num
+
+MBOX_SYM = "_tm_ctl_mbox"
+WPTR_SYM = "_tm_ctl_mbox_wptr"
+RPTR_SYM = "_tm_ctl_mbox_rptr"
+DONE_SYM = "_tm_ctl_done"
+CNTR_SYM = "_tm_ctl_cntrs"
+
+MBOX_ENTRIES = 64
+DONE_ENTRIES = 256
+REQ_WORDS = 12
+REP_WORDS = 8
+SCHED_INPUTS = 8
+
+OP_SHAPER = 1
+OP_SCHED = 2
+OPS = {OP_SHAPER: "shaper", OP_SCHED: "sched"}
+
+STATUS = ["ok", "bad op", "bad node", "bad argument", "read back differs"]
+
+
+def req_hdr(op, nbi, level, node, sp=0, dwrr=0):
+    return ((op << 28) | (nbi << 27) | (level << 25) | (sp << 23) |
+            (dwrr << 22) | node)
+
+
+def decode_rep(words):
+    return {"op": words[0] >> 28,
+            "nbi": (words[0] >> 27) & 1,
+            "level": (words[0] >> 25) & 3,
+            "status": (words[0] >> 8) & 0xf,
+            "node": words[0] & 0xff,
+            "seq": words[1],
+            "ts": (words[2] << 32) | words[3],
+            "reg": words[4]}
+
+
+def fmt_rep(rep):
+    status = rep["status"]
+    return ("seq %d: %s nbi %d level %d node %d: %s at ts %d%s" %
+            (rep["seq"], OPS.get(rep["op"], "op %d" % rep["op"]), rep["nbi"],
+             rep["level"], rep["node"],
+             STATUS[status] if status < len(STATUS) else "status %d" % status,
+             rep["ts"],
+             ", rate reg %d" % rep["reg"] if rep["op"] == OP_SHAPER else ""))
+
+
+def post(words, timeout):
+    """Post one request and return its report."""
+    wptr = nfp_rtsym.read_words(WPTR_SYM, 0, 1)[0]
+    rptr = nfp_rtsym.read_words(RPTR_SYM, 0, 1)[0]
+    if ((wptr - rptr) & 0xffffffff) >= MBOX_ENTRIES:
+        sys.exit("mailbox full, is the firmware built with CFG_TM_CTL?")
+
+    # The context is the only writer of the done ring, the reports from
+    # done_ptr on answer the requests from rptr on
+    done_ptr = nfp_rtsym.read_words(DONE_SYM + "_wptr", 0, 1)[0]
+    seq = wptr
+    words[1] = seq
+    nfp_rtsym.write_words(MBOX_SYM, (wptr % MBOX_ENTRIES) * REQ_WORDS * 4,
+                          words)
+    nfp_rtsym.write_words(WPTR_SYM, 0, [(wptr + 1) & 0xffffffff])
+
+    deadline = time.time() + timeout
+    while True:
+        rptr = nfp_rtsym.read_words(RPTR_SYM, 0, 1)[0]
+        if ((rptr - wptr - 1) & 0x80000000) == 0:
+            break
+        if time.time() > deadline:
+            sys.exit("no report for seq %d after %g s" % (seq, timeout))
+        time.sleep(0.01)
+
+    end = nfp_rtsym.read_words(DONE_SYM + "_wptr", 0, 1)[0]
+    while done_ptr != end:
+        slot = done_ptr % DONE_ENTRIES
+        words = nfp_rtsym.read_words(DONE_SYM, slot * REP_WORDS * 4,
+                                     REP_WORDS)
+        rep = decode_rep(words)
+        if words[REP_WORDS - 1] == done_ptr and rep["seq"] == seq:
+            return rep
+        done_ptr = (done_ptr + 1) & 0xffffffff
+    sys.exit("report for seq %d was overwritten" % seq)
+
+
+def cmd_shaper(args):
+    rate = int(parse_num(args.rate, SUFFIX) // 1e6)
+    burst = int(parse_num(args.burst, BYTE_SUFFIX))
+    over = int(parse_num(args.overshoot, BYTE_SUFFIX))
+    words = [0] * REQ_WORDS
+    words[0] = req_hdr(OP_SHAPER, args.nbi, args.level, args.node)
+    words[2:6] = [rate, burst, over, args.adjust & 0xffffffff]
+    rep = post(words, args.timeout)
+    print(fmt_rep(rep))
+    return rep["status"] != 0
+
+
+def cmd_sched(args):
+    weights = [int(w, 0) for w in args.weights.split(",")]
+    if len(weights) > SCHED_INPUTS:
+        sys.exit("a scheduler has %d inputs" % SCHED_INPUTS)
+    weights += [0] * (SCHED_INPUTS - len(weights))
+    words = [0] * REQ_WORDS
+    words[0] = req_hdr(OP_SCHED, args.nbi, args.level, args.node, args.sp,
+                       0 if args.no_dwrr else 1)
+    words[2:2 + SCHED_INPUTS] = weights
+    rep = post(words, args.timeout)
+    print(fmt_rep(rep))
+    return rep["status"] != 0
+
+
+def cmd_done(args):
+    ring = HostRing(DONE_SYM, DONE_ENTRIES, REP_WORDS,
+                    start=0 if args.all else None, seq_word=REP_WORDS - 1)
+    recs = ring.follow(args.interval) if args.follow else ring.read()
+    for rec in recs:
+        print(fmt_rep(decode_rep(rec)))
+    return 0
+
+
+def cmd_show(args):
+    vals = nfp_rtsym.read_u64(CNTR_SYM, 0, 3)
+    for name, val in zip(("applied", "rejected", "verify"), vals):
+        print("%-10s %20d" % (name, val))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--timeout", type=float, default=2.0,
+                        help="seconds to wait for a report")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p_shp = sub.add_parser("shaper", help="set the rate of a shaper")
+    p_shp.add_argument("nbi", type=int, choices=[0, 1])
+    p_shp.add_argument("level", type=int, choices=[0, 1, 2])
+    p_shp.add_argument("node", type=int,
+                       help="L1 or L2 scheduler of the shaper, 0 for L0")
+    p_shp.add_argument("--rate", required=True,
+                       help="bits per second (k/M/G), multiple of 1M")
+    p_shp.add_argument("--burst", default="64k",
+                       help="threshold in bytes (k/M)")
+    p_shp.add_argument("--overshoot", default="0",
+                       help="maximum overshoot in bytes, 0 for the burst")
+    p_shp.add_argument("--adjust", type=int, default=0,
+                       help="bytes not counted per packet (-512..1023)")
+    p_shp.set_defaults(func=cmd_shaper)
+
+    p_sch = sub.add_parser("sched", help="set the weights of a scheduler")
+    p_sch.add_argument("nbi", type=int, choices=[0, 1])
+    p_sch.add_argument("level", type=int, choices=[1, 2])
+    p_sch.add_argument("node", type=int)
+    p_sch.add_argument("--weights", required=True,
+                       help="comma separated DWRR weights of inputs 0-7")
+    p_sch.add_argument("--sp", type=int, choices=[0, 1, 2], default=0,
+                       help="inputs in strict priority")
+    p_sch.add_argument("--no-dwrr", action="store_true",
+                       help="round robin instead of DWRR")
+    p_sch.set_defaults(func=cmd_sched)
+
+    p_done = sub.add_parser("done", help="print the reports")
+    p_done.add_argument("--all", action="store_true",
+                        help="from the start of the ring")
+    p_done.add_argument("--follow", action="store_true")
+    p_done.add_argument("--interval", type=float, default=1.0)
+    p_done.set_defaults(func=cmd_done)
+
+    p_show = sub.add_parser("show", help="show the request counters")
+    p_show.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    return 1 if args.func(args) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
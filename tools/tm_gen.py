@@ -0,0 +1,610 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/tm_gen.py
+# @brief        Compile a QoS hierarchy into NBI traffic manager config
+#
+
+"""Compile a JSON (or YAML) QoS hierarchy into NBI traffic manager config.
+
+The hierarchy is the one set up by microc/blocks/init with the default
+NBI_TM_L1_INPUT_SELECT=1 and NBI_TM_CHANNEL_LEVEL_SELECT=1: MAC channel c
+is level 2 scheduler c, fed by the TM queues 8c to 8c+7 and shaped by
+shaper c.  The level 2 scheduler feeds input c % 8 of level 1 scheduler
+c / 8, shaped by shaper 128 + c / 8.  Shaper 144 shapes the whole NBI.
+
+  {
+    "nbi": 0,
+    "rate": "100G",
+    "depth": 256,
+    "ports": [
+      {"channel": 0, "rate": "10G", "burst": "16k", "weight": 4,
+       "strict": 1,
+       "queues": [{"depth": 64}, {"weight": 3}, {"weight": 1}]},
+      {"channel": 1, "queues": 8}
+    ],
+    "l1": [{"sched": 0, "rate": "40G", "strict": 0}]
+  }
+
+A port lists up to 8 queues, or just their number.  The first "strict"
+(0-2) queues are served in strict priority, the others by DWRR with the
+given relative weights (default 1).  The "weight" of a port is its DWRR
+weight in the level 1 scheduler, which may put its first inputs in strict
+priority the same way.  Queue "depth" is in packets and rounded up to a
+power of 2.  Rates are in bits per second, "burst" is the shaper threshold
+and "overshoot" the maximum overshoot, both in bytes, and "rate_adjust" the
+bytes the shaper ignores per packet (e.g. -20 to also count the preamble
+and inter frame gap).  A list of such descriptions configures both NBIs.
+
+The description is checked against the limits of the TM and of the
+init_nbi_tm.uc macros, then written either as the NBIn_TM_*_CFG_RANGEk
+defines of init_config.h (--format init, include it by building with
+-DNBI_TM_GEN_CONFIG and the output on the include path as nbi_tm_gen.h) or
+as a struct nfp_nbi_tm_config_spec with a function applying it at run
+time through lib/nfp/tm_config.h (--format tm_config).
+"""
+
+from __future__ import division, print_function
+
+import argparse
+import json
+import os
+import sys
+from fractions import Fraction
+
+from policer_calc import parse_num, SUFFIX, BYTE_SUFFIX
+
+NUM_NBIS = 2
+NUM_CHANNELS = 128
+NUM_L1 = 16
+SCHED_INPUTS = 8
+L1_SCHED_BASE = 128
+L1_SHAPER_BASE = 128
+L0_SHAPER = 144
+NUM_SHAPERS = 145
+
+HT_ENTRIES = 16384
+QSIZE_MIN = 3
+QSIZE_MAX = 13
+MAX_RANGES = 24
+
+# Shaper rate unit at a 1 GHz PClk, in bits per second
+RATE_UNIT = 10 * 1000 * 1000
+RATE_MIN = 1
+RATE_MAX = 12000
+THRESHOLDS = (8192, 16384, 24576, 32768, 40960, 49152, 57344, 65535)
+OVERSHOOTS = (16384, 24576, 32768, 40960, 49152, 57344, 65536, 131071)
+RATE_ADJ_MIN = -512
+RATE_ADJ_MAX = 1023
+WEIGHT_MAX = 0xffffff
+
+# Shaper left open when shaping is enabled but the node is not shaped
+OPEN_SHAPER = (RATE_MAX, len(THRESHOLDS) - 1, len(OVERSHOOTS) - 1, 0)
+
+# Word counts of struct nfp_nbi_tm_config_spec and its members
+Q_CLUSTER_WORDS = 5
+SHAPER_CLUSTER_WORDS = 8
+SCHED_CLUSTER_WORDS = 5 + SCHED_INPUTS
+L0_SCHED_WORDS = 2 + NUM_CHANNELS
+SPEC_WORDS = (1 + MAX_RANGES * (Q_CLUSTER_WORDS + SHAPER_CLUSTER_WORDS +
+                                SCHED_CLUSTER_WORDS) + L0_SCHED_WORDS)
+
+# TrafficManagerConfig, QueueConfig and SchedulerConfig bits
+TM_CFG_L1INPUTSELECT = 1 << 0
+TM_CFG_NUMSEQUENCERS_SHF = 1
+TM_CFG_CHANNELLEVELSELECT = 1 << 5
+TM_CFG_MINIPACKETFCENABLE = 1 << 6
+TM_CFG_SHAPERENABLE = 1 << 7
+TM_CFG_SCHEDULERENABLE = 1 << 8
+Q_CFG_QUEUEENABLE = 1 << 0
+Q_CFG_DROPENABLE = 1 << 1
+Q_CFG_QUEUESIZE_SHF = 6
+SCHED_CFG_DWRRENABLE = 1 << 0
+SCHED_CFG_SP0ENABLE = 1 << 1
+SCHED_CFG_SP1ENABLE = 1 << 2
+
+
+class SpecError(Exception):
+    pass
+
+
+def rate_to_reg(bps, pclk_mhz=1000, rounding="down"):
+    """Return the ShaperRate register value for a rate in bits per second.
+
+    The register counts RATE_UNIT at a 1 GHz PClk, the unit scales with
+    1 GHz / PClk.  Rounding down never lets the shaper exceed the rate
+    asked for.
+    """
+    exact = Fraction(bps) * Fraction(pclk_mhz) / (RATE_UNIT * 1000)
+    if rounding == "down":
+        reg = exact.numerator // exact.denominator
+    elif rounding == "up":
+        reg = -(-exact.numerator // exact.denominator)
+    else:
+        reg = int(exact + Fraction(1, 2))
+    if not RATE_MIN <= reg <= RATE_MAX:
+        raise SpecError("rate of %s bps is outside the %s-%s bps a shaper "
+                        "can do at a %g MHz PClk" %
+                        (fmt_num(bps), fmt_num(reg_to_rate(RATE_MIN,
+                                                           pclk_mhz)),
+                         fmt_num(reg_to_rate(RATE_MAX, pclk_mhz)),
+                         pclk_mhz))
+    return reg
+
+
+def reg_to_rate(reg, pclk_mhz=1000):
+    """Return the rate in bits per second of a ShaperRate value."""
+    return reg * RATE_UNIT * 1000.0 / pclk_mhz
+
+
+def size_code(nbytes, table, name):
+    """Return the smallest code of table covering nbytes."""
+    for code, size in enumerate(table):
+        if size >= nbytes:
+            return code
+    raise SpecError("%s of %d bytes is above the maximum of %d" %
+                    (name, nbytes, table[-1]))
+
+
+def qsize_of(depth):
+    """Return the queue size exponent holding depth packets."""
+    size = QSIZE_MIN
+    while (1 << size) < depth:
+        size += 1
+    if size > QSIZE_MAX:
+        raise SpecError("queue depth %d is above the maximum of %d" %
+                        (depth, 1 << QSIZE_MAX))
+    return size
+
+
+def fmt_num(val):
+    for div, sfx in ((1e9, "G"), (1e6, "M"), (1e3, "k")):
+        if val >= div:
+            return "%g%s" % (val / div, sfx)
+    return "%g" % val
+
+
+def get_num(node, key, suffixes, default=None):
+    val = node.get(key, default)
+    if val is None or isinstance(val, (int, float)):
+        return val
+    try:
+        return parse_num(str(val), suffixes)
+    except ValueError:
+        raise SpecError("bad %s %r" % (key, val))
+
+
+def get_int(node, key, lo, hi, default=None):
+    val = node.get(key, default)
+    if val is None:
+        return None
+    if not isinstance(val, int) or isinstance(val, bool) or \
+       not lo <= val <= hi:
+        raise SpecError("%s must be an integer between %d and %d, not %r" %
+                        (key, lo, hi, val))
+    return val
+
+
+class Tm(object):
+    """The TM configuration of one NBI."""
+
+    def __init__(self, desc, args):
+        self.nbi = get_int(desc, "nbi", 0, NUM_NBIS - 1, 0)
+        self.pclk_mhz = get_num(desc, "pclk_mhz", {}, args.pclk_mhz)
+        self.rounding = args.rounding
+        self.queues = {}
+        self.scheds = {}
+        self.shapers = {}
+        self.lines = []
+        self.warnings = []
+        self.child_rates = {}
+
+        if not desc.get("ports"):
+            raise SpecError("nbi%d: no ports" % self.nbi)
+        l1s = dict((get_int(l1, "sched", 0, NUM_L1 - 1), l1)
+                   for l1 in desc.get("l1", []))
+        l1_weights = {}
+
+        for port in desc["ports"]:
+            chan = get_int(port, "channel", 0, NUM_CHANNELS - 1)
+            if chan is None:
+                raise SpecError("nbi%d: port without a channel" % self.nbi)
+            if chan in self.scheds:
+                raise SpecError("nbi%d: channel %d listed twice" %
+                                (self.nbi, chan))
+            try:
+                self.add_port(chan, port, desc)
+            except SpecError as err:
+                raise SpecError("nbi%d channel %d: %s" % (self.nbi, chan, err))
+            l1_weights.setdefault(chan // SCHED_INPUTS, {})[
+                chan % SCHED_INPUTS] = get_int(port, "weight", 1, WEIGHT_MAX,
+                                               1)
+
+        for l1, weights in sorted(l1_weights.items()):
+            node = l1s.pop(l1, {})
+            try:
+                self.scheds[L1_SCHED_BASE + l1] = self.sched_cfg(node,
+                                                                 weights)
+                if "rate" in node:
+                    self.shaper(L1_SHAPER_BASE + l1, node)
+            except SpecError as err:
+                raise SpecError("nbi%d l1 %d: %s" % (self.nbi, l1, err))
+        for l1 in l1s:
+            raise SpecError("nbi%d l1 %d: no ports feed it" % (self.nbi, l1))
+
+        if "rate" in desc:
+            try:
+                self.shaper(L0_SHAPER, desc)
+            except SpecError as err:
+                raise SpecError("nbi%d: %s" % (self.nbi, err))
+        self.check_rates()
+
+        self.q_ranges = self.queue_ranges()
+        self.ht_used = self.alloc_ht()
+        self.shaper_ranges = self.ranges(self.all_shapers())
+        self.sched_ranges = self.ranges(self.scheds)
+        for name, rngs in (("queue", self.q_ranges),
+                           ("shaper", self.shaper_ranges),
+                           ("scheduler", self.sched_ranges)):
+            if len(rngs) > MAX_RANGES:
+                raise SpecError("nbi%d: needs %d %s ranges, the maximum is "
+                                "%d, make neighbouring nodes alike" %
+                                (self.nbi, len(rngs), name, MAX_RANGES))
+
+    def add_port(self, chan, port, desc):
+        queues = port.get("queues", SCHED_INPUTS)
+        if isinstance(queues, int):
+            queues = [{}] * queues
+        if not 1 <= len(queues) <= SCHED_INPUTS:
+            raise SpecError("needs 1 to %d queues" % SCHED_INPUTS)
+        depth = get_num(port, "depth", BYTE_SUFFIX,
+                        get_num(desc, "depth", BYTE_SUFFIX, 256))
+
+        weights = {}
+        for idx, queue in enumerate(queues):
+            qsize = qsize_of(get_num(queue, "depth", BYTE_SUFFIX, depth))
+            self.queues[chan * SCHED_INPUTS + idx] = qsize
+            weights[idx] = get_int(queue, "weight", 1, WEIGHT_MAX, 1)
+        self.scheds[chan] = self.sched_cfg(port, weights)
+        if "rate" in port:
+            self.shaper(chan, port)
+            self.child_rates.setdefault(
+                L1_SHAPER_BASE + chan // SCHED_INPUTS, []).append(chan)
+        self.lines.append("channel %3d: queues %d-%d, %s" %
+                          (chan, chan * SCHED_INPUTS,
+                           chan * SCHED_INPUTS + len(queues) - 1,
+                           self.sched_str(self.scheds[chan], "q")))
+
+    def sched_cfg(self, node, weights):
+        """Return the (config, weights) of a level 1 or 2 scheduler."""
+        strict = get_int(node, "strict", 0, 2, 0)
+        if any(idx not in weights for idx in range(strict)):
+            raise SpecError("strict priority on %d inputs needs inputs "
+                            "0-%d in use" % (strict, strict - 1))
+        cfg = 0
+        if strict >= 1:
+            cfg |= SCHED_CFG_SP0ENABLE
+        if strict >= 2:
+            cfg |= SCHED_CFG_SP1ENABLE
+        wts = [0] * SCHED_INPUTS
+        for idx, weight in weights.items():
+            if idx >= strict:
+                wts[idx] = weight
+                cfg |= SCHED_CFG_DWRRENABLE
+        return cfg, tuple(wts)
+
+    def sched_str(self, sched, pfx):
+        cfg, wts = sched
+        parts = []
+        if cfg & SCHED_CFG_SP0ENABLE:
+            parts.append("sp0 %s0" % pfx)
+        if cfg & SCHED_CFG_SP1ENABLE:
+            parts.append("sp1 %s1" % pfx)
+        total = sum(wts)
+        if total:
+            parts.append("dwrr " + " ".join(
+                "%s%d=%.1f%%" % (pfx, idx, 100.0 * wt / total)
+                for idx, wt in enumerate(wts) if wt))
+        return ", ".join(parts)
+
+    def shaper(self, sid, node):
+        bps = get_num(node, "rate", SUFFIX)
+        reg = rate_to_reg(bps, self.pclk_mhz, self.rounding)
+        burst = get_num(node, "burst", BYTE_SUFFIX, THRESHOLDS[0])
+        thresh = size_code(burst, THRESHOLDS, "burst")
+        over = get_num(node, "overshoot", BYTE_SUFFIX, OVERSHOOTS[thresh])
+        over = size_code(over, OVERSHOOTS, "overshoot")
+        adj = get_int(node, "rate_adjust", RATE_ADJ_MIN, RATE_ADJ_MAX, 0)
+        real = reg_to_rate(reg, self.pclk_mhz)
+        self.lines.append("shaper %-7s %s bps -> rate %d = %s bps (%+.2f%%), "
+                          "threshold %d B, overshoot %d B" %
+                          (shaper_name(sid, sid) + ":", fmt_num(bps), reg,
+                           fmt_num(real), 100.0 * (real - bps) / bps,
+                           THRESHOLDS[thresh], OVERSHOOTS[over]))
+        self.shapers[sid] = (reg, thresh, over, adj & 0x3ff)
+
+    def check_rates(self):
+        """Warn about nodes that can never reach their shaped rate."""
+        for l1, chans in self.child_rates.items():
+            parent = self.shapers.get(l1, self.shapers.get(L0_SHAPER))
+            if parent is None:
+                continue
+            for chan in chans:
+                if self.shapers[chan][0] > parent[0]:
+                    self.warnings.append(
+                        "nbi%d channel %d is shaped above its level 1 or "
+                        "NBI rate" % (self.nbi, chan))
+
+    def all_shapers(self):
+        """Return every shaper to write, unshaped nodes left open.
+
+        Shaping is enabled for all nodes or none, so once a node is shaped
+        the others get the highest rate rather than the reset value.
+        """
+        if not self.shapers:
+            return {}
+        shapers = dict.fromkeys(range(NUM_SHAPERS), OPEN_SHAPER)
+        shapers.update(self.shapers)
+        return shapers
+
+    def queue_ranges(self):
+        """Return the (first, last, size) ranges of enabled queues.
+
+        The head/tail SRAM is handed out in range order with each range
+        aligned to its queue size, largest queues first wastes none.
+        """
+        rngs = []
+        order = sorted(self.queues, key=lambda q: (-self.queues[q], q))
+        for queue in order:
+            size = self.queues[queue]
+            if rngs and rngs[-1][2] == size and rngs[-1][1] == queue - 1:
+                rngs[-1][1] = queue
+            else:
+                rngs.append([queue, queue, size])
+        return [tuple(rng) for rng in rngs]
+
+    def alloc_ht(self):
+        ptr = 0
+        for idx, (first, last, size) in enumerate(self.q_ranges):
+            if size == QSIZE_MAX and (idx or first != last):
+                raise SpecError("nbi%d: only one queue can hold %d packets" %
+                                (self.nbi, 1 << QSIZE_MAX))
+            ptr = (ptr + (1 << size) - 1) & ~((1 << size) - 1)
+            ptr += (last - first + 1) << size
+        if ptr > HT_ENTRIES:
+            raise SpecError("nbi%d: the queues need %d head/tail SRAM "
+                            "entries, there are %d" %
+                            (self.nbi, ptr, HT_ENTRIES))
+        return ptr
+
+    @staticmethod
+    def ranges(nodes):
+        """Merge neighbouring nodes of equal config into (first, last, cfg)."""
+        rngs = []
+        for node in sorted(nodes):
+            if rngs and rngs[-1][2] == nodes[node] and \
+               rngs[-1][1] == node - 1:
+                rngs[-1][1] = node
+            else:
+                rngs.append([node, node, nodes[node]])
+        return [tuple(rng) for rng in rngs]
+
+    def tm_config(self, args):
+        cfg = (TM_CFG_L1INPUTSELECT | TM_CFG_CHANNELLEVELSELECT |
+               TM_CFG_MINIPACKETFCENABLE | TM_CFG_SCHEDULERENABLE |
+               args.sequencers << TM_CFG_NUMSEQUENCERS_SHF)
+        if self.shapers:
+            cfg |= TM_CFG_SHAPERENABLE
+        return cfg
+
+
+def sched_name(sched):
+    if sched >= L1_SCHED_BASE:
+        return "L1 %d" % (sched - L1_SCHED_BASE)
+    return "L2 %d" % sched
+
+
+def shaper_name(first, last):
+    def one(shaper):
+        if shaper == L0_SHAPER:
+            return "L0"
+        if shaper >= L1_SHAPER_BASE:
+            return "L1 %d" % (shaper - L1_SHAPER_BASE)
+        return "L2 %d" % shaper
+    if first == last:
+        return one(first)
+    return "%s - %s" % (one(first), one(last))
+
+
+def emit_init(tms, args, out):
+    shaping = any(tm.shapers for tm in tms)
+    out.write("/*\n * Generated by tools/tm_gen.py from %s, do not edit.\n"
+              " *\n * Build with -DNBI_TM_GEN_CONFIG for init_config.h to "
+              "include it.\n */\n\n" % os.path.basename(args.spec))
+    out.write("#ifndef _NBI_TM_GEN_H_\n#define _NBI_TM_GEN_H_\n\n")
+    out.write("#define NBI_TM_CHANNEL_LEVEL_SELECT 1\n")
+    out.write("#define NBI_TM_L1_INPUT_SELECT 1\n")
+    out.write("#define NBI_TM_NUM_SEQUENCERS %d\n" % args.sequencers)
+    out.write("#define NBI_TM_ENABLE_SHAPER %d\n" % shaping)
+
+    for tm in tms:
+        out.write("\n/* NBI %d: %d queues, %d of %d head/tail SRAM entries "
+                  "*/\n" % (tm.nbi, len(tm.queues), tm.ht_used, HT_ENTRIES))
+        for idx, (first, last, size) in enumerate(tm.q_ranges):
+            out.write("#define NBI%d_TM_Q_CFG_RANGE%d 1,%d,%d,%d\n" %
+                      (tm.nbi, idx, first, last, size))
+        for idx, (first, last, cfg) in enumerate(tm.sched_ranges):
+            sched, wts = cfg
+            out.write("#define NBI%d_TM_L2L1_SCHED_CFG_RANGE%d "
+                      "1,%d,%d,%d,%d,%d,%s\n" %
+                      (tm.nbi, idx, first, last,
+                       bool(sched & SCHED_CFG_SP0ENABLE),
+                       bool(sched & SCHED_CFG_SP1ENABLE),
+                       bool(sched & SCHED_CFG_DWRRENABLE),
+                       ",".join("%d" % wt for wt in wts)))
+        for idx, (first, last, cfg) in enumerate(tm.shaper_ranges):
+            rate, thresh, over, adj = cfg
+            if adj & 0x200:
+                adj -= 0x400
+            out.write("#define NBI%d_TM_SHAPER_CFG_RANGE%d "
+                      "1,%d,%d,%d,%d,%d,%d\n" %
+                      (tm.nbi, idx, first, last, rate, thresh, over, adj))
+
+    out.write("\n#endif /* _NBI_TM_GEN_H_ */\n")
+
+
+def spec_words(tm, args):
+    """Return struct nfp_nbi_tm_config_spec of tm as (words, comment) rows."""
+    rows = [([tm.tm_config(args)], "tm_config")]
+
+    def clusters(rngs, words, comment):
+        for idx in range(MAX_RANGES):
+            if idx < len(rngs):
+                first, last, cfg = rngs[idx]
+                rows.append(([1, first, last, int(idx == len(rngs) - 1)] +
+                             words(cfg), comment(first, last, cfg)))
+            else:
+                # Unused clusters are still written, the layout is fixed
+                rows.append(([0, 0, 0, int(idx == 0)] +
+                             [0] * len(words(None)), None))
+
+    clusters(tm.q_ranges,
+             lambda size: [size is not None and
+                           (Q_CFG_QUEUEENABLE | Q_CFG_DROPENABLE |
+                            size << Q_CFG_QUEUESIZE_SHF) or 0],
+             lambda first, last, size: "queues %d-%d, %d packets" %
+             (first, last, 1 << size))
+    clusters(tm.shaper_ranges,
+             lambda cfg: list(cfg or (0, 0, 0, 0)),
+             lambda first, last, cfg: "shapers %s, %s bps" %
+             (shaper_name(first, last),
+              fmt_num(reg_to_rate(cfg[0], tm.pclk_mhz))))
+    clusters(tm.sched_ranges,
+             lambda cfg: [cfg[0]] + list(cfg[1]) if cfg else
+             [0] * (1 + SCHED_INPUTS),
+             lambda first, last, cfg: "schedulers %s" %
+             (sched_name(first) if first == last else
+              "%s - %s" % (sched_name(first), sched_name(last))))
+    rows.append(([0] * L0_SCHED_WORDS, "tm_l0_scheduler, not in use"))
+    assert sum(len(words) for words, _ in rows) == SPEC_WORDS
+    return rows
+
+
+def emit_tm_config(tms, args, out):
+    out.write("/*\n * Generated by tools/tm_gen.py from %s, do not edit.\n"
+              " *\n * Quiesce and drain the TM queues before calling "
+              "tm_gen_nbiN_apply(), see\n * lib/nfp/tm_config.h.\n */\n\n" %
+              os.path.basename(args.spec))
+    out.write("#include <nfp.h>\n#include <stdint.h>\n\n"
+              "#include <nfp/tm_config.h>\n")
+    for tm in tms:
+        out.write("\n__export __emem __align8 uint32_t tm_gen_nbi%d_spec[%d] "
+                  "= {\n" % (tm.nbi, SPEC_WORDS))
+        for words, comment in spec_words(tm, args):
+            if comment:
+                out.write("    /* %s */\n" % comment)
+            for pos in range(0, len(words), 8):
+                out.write("    %s,\n" % ", ".join(
+                    "%d" % word for word in words[pos:pos + 8]))
+        out.write("};\n\n")
+        out.write("""int
+tm_gen_nbi%(nbi)d_apply(void)
+{
+    __mem40 struct nfp_nbi_tm_config_spec *spec =
+        (__mem40 struct nfp_nbi_tm_config_spec *)tm_gen_nbi%(nbi)d_spec;
+    struct nfp_nbi_tm_traffic_manager_config tm_config;
+    int ret;
+
+    ret = nbi_tm_config_shapers(%(nbi)d, spec->tm_shapers_cluster);
+    if (ret)
+        return ret;
+    ret = nfp_nbi_tm_config_schedulers(%(nbi)d, spec->tm_scheduler_cluster);
+    if (ret)
+        return ret;
+    tm_config.__raw = 0x%(cfg)x;
+    ret = nfp_nbi_tm_config(%(nbi)d, tm_config);
+    if (ret)
+        return ret;
+    /* Queues last, this enables them again */
+    return nfp_nbi_tm_config_queues(%(nbi)d, spec->tm_queue_cluster);
+}
+""" % {"nbi": tm.nbi, "cfg": tm.tm_config(args)})
+
+
+def load(path):
+    with open(path) as f:
+        if path.endswith((".yaml", ".yml")):
+            try:
+                import yaml
+            except ImportError:
+                raise SpecError("reading %s needs the python yaml module" %
+                                path)
+            return yaml.safe_load(f)
+        return json.load(f)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("spec", help="JSON or YAML hierarchy description")
+    parser.add_argument("--format", choices=("init", "tm_config"),
+                        default="init",
+                        help="init_config.h defines or tm_config.h spec")
+    parser.add_argument("-o", "--output",
+                        help="output file, - or none for stdout")
+    parser.add_argument("--pclk-mhz", type=float, default=1000.0,
+                        help="PClk frequency in MHz, scales the shaper rates")
+    parser.add_argument("--rounding", choices=("down", "nearest", "up"),
+                        default="down", help="shaper rate register rounding")
+    parser.add_argument("--sequencers", type=int, choices=range(7),
+                        default=0, help="NBI_TM_NUM_SEQUENCERS to set")
+    parser.add_argument("-q", "--quiet", action="store_true",
+                        help="do not print the summary")
+    args = parser.parse_args()
+
+    try:
+        desc = load(args.spec)
+        tms = [Tm(nbi, args)
+               for nbi in (desc if isinstance(desc, list) else [desc])]
+        if len(set(tm.nbi for tm in tms)) != len(tms):
+            raise SpecError("an NBI is described twice")
+    except (IOError, ValueError, SpecError) as err:
+        print("error: %s" % err, file=sys.stderr)
+        return 1
+
+    for tm in tms:
+        for warn in tm.warnings:
+            print("warning: %s" % warn, file=sys.stderr)
+        if not args.quiet:
+            print("nbi%d: %d queues in %d ranges, %d head/tail entries, "
+                  "%d scheduler and %d shaper ranges" %
+                  (tm.nbi, len(tm.queues), len(tm.q_ranges), tm.ht_used,
+                   len(tm.sched_ranges), len(tm.shaper_ranges)),
+                  file=sys.stderr)
+            for line in tm.lines:
+                print("  " + line, file=sys.stderr)
+
+    emit = emit_init if args.format == "init" else emit_tm_config
+    if args.output and args.output != "-":
+        with open(args.output, "w") as out:
+            emit(tms, args, out)
+    else:
+        emit(tms, args, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
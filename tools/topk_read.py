@@ -0,0 +1,217 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/topk_read.py
+# @brief        Read the wire app top-K flow tables
+#
+
+"""Print the largest flows of the last complete epoch.
+
+The space-saving tables of every island are read from the bank of the
+last complete epoch, merged by flow and scaled by the sampling rate.  The
+layouts and build options match apps/wire/topk.h.  "model" runs the same
+sampled, bucketed space-saving algorithm over Zipf traffic and compares
+the result with the exact top flows.
+"""
+
+from __future__ import print_function
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import time
+import zlib
+
+import nfp_rtsym
+from policer_calc import TSC_CYCLES
+
+TBL_SYM = "_topk_tbl"
+TAG_SYM = "_topk_bank_epoch"
+EPOCH_SYM = "_topk_epoch"
+
+BANKS = 3
+NUM_ISL = 8
+ISL_BASE = 32
+BUCKET_SZ = 16
+# sig, bytes, err and pkts arrays followed by 4 key words per slot
+BUCKET_WORDS = 4 * BUCKET_SZ + 4 * BUCKET_SZ
+
+PROTOS = {1: "icmp", 6: "tcp", 17: "udp"}
+
+
+def ip_str(addr):
+    return socket.inet_ntoa(struct.pack("!I", addr))
+
+
+def key_str(key):
+    src, dst, proto, ports = key
+    name = PROTOS.get(proto, str(proto))
+    if proto in (6, 17):
+        return "%s:%d -> %s:%d %s" % (ip_str(src), ports >> 16, ip_str(dst),
+                                      ports & 0xffff, name)
+    return "%s -> %s %s" % (ip_str(src), ip_str(dst), name)
+
+
+def read_bucket(words, flows):
+    """Add the used slots of a bucket to @flows (key -> [bytes, err, pkts])."""
+    for slot in range(BUCKET_SZ):
+        if words[slot] == 0:
+            continue
+        nbytes = words[BUCKET_SZ + slot]
+        err = words[2 * BUCKET_SZ + slot]
+        pkts = words[3 * BUCKET_SZ + slot]
+        base = 4 * BUCKET_SZ + 4 * slot
+        key = tuple(words[base:base + 4])
+        ent = flows.setdefault(key, [0, 0, 0])
+        ent[0] += nbytes
+        ent[1] += err
+        ent[2] += pkts
+
+
+def read_epoch(args, epoch):
+    """Return the merged flows of an epoch or None if overwritten."""
+    bank = epoch % BANKS
+    buckets = (1 << args.k_shf) // BUCKET_SZ
+    isl_words = buckets * BUCKET_WORDS
+    flows = {}
+    for isl in args.islands:
+        idx = (isl - ISL_BASE) & (NUM_ISL - 1)
+        tag = nfp_rtsym.read_words(TAG_SYM, (idx * BANKS + bank) * 4, 1)[0]
+        if tag != epoch:
+            # No sampled traffic on the island in that epoch
+            continue
+        off = (bank * NUM_ISL + idx) * isl_words * 4
+        words = nfp_rtsym.read_words(TBL_SYM, off, isl_words)
+        for b in range(buckets):
+            read_bucket(words[b * BUCKET_WORDS:(b + 1) * BUCKET_WORDS], flows)
+    if nfp_rtsym.read_words(EPOCH_SYM, 0, 1)[0] > epoch + 1:
+        return None
+    return flows
+
+
+def show(args, epoch, flows):
+    secs = (1 << args.epoch_shf) * TSC_CYCLES / (args.me_clock_mhz * 1e6)
+    scale = 1 << args.sample_shf
+    top = sorted(flows.items(), key=lambda f: f[1][0], reverse=True)
+    print("epoch %d (%.2f s), %d flows tracked" % (epoch, secs, len(flows)))
+    for key, (nbytes, err, pkts) in top[:args.num]:
+        print("  %-48s %12d bytes (+-%d) %10d pkts %10.1f Mbps" %
+              (key_str(key), nbytes * scale, err * scale, pkts * scale,
+               nbytes * scale * 8 / secs / 1e6))
+
+
+def cmd_show(args):
+    last = None
+    while True:
+        epoch = nfp_rtsym.read_words(EPOCH_SYM, 0, 1)[0] - 1
+        if epoch != last:
+            flows = read_epoch(args, epoch)
+            if flows is not None:
+                show(args, epoch, flows)
+                last = epoch
+        if not args.follow:
+            break
+        time.sleep(0.2)
+
+
+def cmd_model(args):
+    rng = random.Random(args.seed)
+    k = 1 << args.k_shf
+    buckets = k // BUCKET_SZ
+    sample = 1 << args.sample_shf
+
+    # Zipf packet counts per flow, fixed size packets
+    weights = [1.0 / (r ** args.zipf) for r in range(1, args.flows + 1)]
+    scale = args.pkts / sum(weights)
+    sizes = [max(1, int(w * scale)) for w in weights]
+
+    # The sampled packets in arrival order
+    stream = []
+    for flow, size in enumerate(sizes):
+        hits = sum(rng.randrange(sample) == 0 for _ in range(size))
+        stream.extend([flow] * hits)
+    rng.shuffle(stream)
+
+    bucket_of = [zlib.crc32(struct.pack("!I", f)) % buckets
+                 for f in range(args.flows)]
+    tbl = [dict() for _ in range(buckets)]
+    for flow in stream:
+        slots = tbl[bucket_of[flow]]
+        if flow in slots:
+            slots[flow][0] += args.len
+            continue
+        low = 0
+        if len(slots) == BUCKET_SZ:
+            evict = min(slots, key=lambda f: slots[f][0])
+            low = slots.pop(evict)[0]
+        slots[flow] = [low + args.len, low]
+
+    est = {}
+    for slots in tbl:
+        for flow, (nbytes, err) in slots.items():
+            est[flow] = (nbytes * sample, err * sample)
+
+    top = sorted(range(args.flows), key=lambda f: sizes[f],
+                 reverse=True)[:args.num]
+    found = [f for f in top if f in est]
+    rel = [abs(est[f][0] - sizes[f] * args.len) / float(sizes[f] * args.len)
+           for f in found]
+    print("%d flows, %d packets, 1:%d sampling, %d counters in %d buckets" %
+          (args.flows, sum(sizes), sample, k, buckets))
+    print("top %d: %d tracked, mean error %.3f, max error %.3f" %
+          (args.num, len(found), sum(rel) / max(1, len(rel)),
+           max(rel or [0])))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--k-shf", type=int, default=8, help="TOPK_K_SHF")
+    parser.add_argument("--sample-shf", type=int, default=6,
+                        help="TOPK_SAMPLE_SHF")
+    parser.add_argument("--num", type=int, default=20,
+                        help="number of flows to print")
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("show", help="print the top flows")
+    p.add_argument("--epoch-shf", type=int, default=28,
+                   help="TOPK_EPOCH_SHF")
+    p.add_argument("--me-clock-mhz", type=float, default=800)
+    p.add_argument("--islands",
+                   type=lambda v: [int(i) for i in v.split(",")],
+                   default=[32, 33], help="islands running the wire app")
+    p.add_argument("--follow", action="store_true",
+                   help="print every epoch")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("model", help="accuracy on Zipf traffic")
+    p.add_argument("--flows", type=int, default=100000)
+    p.add_argument("--pkts", type=int, default=2000000)
+    p.add_argument("--zipf", type=float, default=1.1)
+    p.add_argument("--len", type=int, default=1000, help="packet length")
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_model)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    return args.func(args) or 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,202 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/vxlan_ctl.py
+# @brief        Configure the wire app VXLAN stage
+#
+
+"""Manage the VXLAN templates, VNI table and port configuration.
+
+The layouts match apps/wire/vxlan.h.  Outer header templates live in CLS,
+so they are written to every island running the wire app.
+"""
+
+from __future__ import print_function
+
+import argparse
+import socket
+import struct
+import sys
+
+import nfp_rtsym
+
+PORT_SYM = "_vxlan_port_cfg"
+CAM_SYM = "_vxlan_vni_cam"
+TBL_SYM = "_vxlan_vni_tbl"
+CNTR_SYM = "_vxlan_vni_cntrs"
+GCNTR_SYM = "_vxlan_cntrs"
+TMPL_SYM = "i%d._vxlan_tmpl"
+
+VNI_BUCKETS = 256
+BUCKET_SZ = 16
+TMPL_SIZE = 64
+ENTRY_SIZE = 8
+CNTR_SIZE = 32
+UDP_PORT = 4789
+
+
+def vni_bucket(vni):
+    """Must match VXLAN_VNI_BUCKET() in vxlan.c"""
+    return (vni ^ (vni >> 8) ^ (vni >> 16)) & (VNI_BUCKETS - 1)
+
+
+def mac(val):
+    return bytearray(int(b, 16) for b in val.split(":"))
+
+
+def ip_csum(hdr):
+    total = sum(struct.unpack("!10H", bytes(hdr)))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    return ~total & 0xffff
+
+
+def build_tmpl(args):
+    """Return the template words, see VXLAN_TMPL_* in vxlan.h"""
+    eth = mac(args.dmac) + mac(args.smac) + struct.pack("!H", 0x0800)
+    # Total length, identification and checksum are patched per packet
+    ip = bytearray(struct.pack("!BBHHHBBH4s4s", 0x45, args.tos, 0, 0,
+                               0x4000, args.ttl, 17, 0,
+                               socket.inet_aton(args.sip),
+                               socket.inet_aton(args.dip)))
+    ip[10:12] = struct.pack("!H", ip_csum(ip))
+    udp = struct.pack("!HHHH", 0, args.dport, 0, 0)
+    vxlan = struct.pack("!II", 0x08000000, args.vni << 8)
+    data = bytearray(2) + eth + ip + udp + vxlan
+    data += bytearray(TMPL_SIZE - len(data))
+    return list(struct.unpack("!16I", bytes(data)))
+
+
+def cmd_tmpl(args):
+    words = build_tmpl(args)
+    print(" ".join("0x%08x" % w for w in words))
+    for isl in args.islands:
+        nfp_rtsym.write_words(TMPL_SYM % isl, args.idx * TMPL_SIZE, words)
+
+
+def find_vni(vni):
+    bucket = vni_bucket(vni)
+    cam = nfp_rtsym.read_words(CAM_SYM, bucket * BUCKET_SZ * 4, BUCKET_SZ)
+    for slot, val in enumerate(cam):
+        if val & 0xffffff == vni:
+            return bucket, slot, cam
+    return bucket, None, cam
+
+
+def cmd_vni_add(args):
+    if not 0 < args.vni < 1 << 24:
+        sys.exit("VNI must be in 1-16777215")
+    bucket, slot, cam = find_vni(args.vni)
+    if slot is None:
+        if 0 not in cam:
+            sys.exit("VNI bucket %d is full" % bucket)
+        slot = cam.index(0)
+    idx = bucket * BUCKET_SZ + slot
+    nfp_rtsym.write_words(TBL_SYM, idx * ENTRY_SIZE,
+                          [(1 << 31) | args.vni,
+                           (args.tenant << 16) | args.tmpl])
+    nfp_rtsym.write_words(CAM_SYM, idx * 4, [args.vni])
+    print("VNI %d -> entry %d" % (args.vni, idx))
+
+
+def cmd_vni_del(args):
+    bucket, slot, _ = find_vni(args.vni)
+    if slot is None:
+        sys.exit("VNI %d not found" % args.vni)
+    idx = bucket * BUCKET_SZ + slot
+    nfp_rtsym.write_words(CAM_SYM, idx * 4, [0])
+    nfp_rtsym.write_words(TBL_SYM, idx * ENTRY_SIZE, [0, 0])
+
+
+def cmd_port(args):
+    if args.decap:
+        word = 1 << 31
+    elif args.encap is not None:
+        bucket, slot, _ = find_vni(args.encap)
+        if slot is None:
+            sys.exit("VNI %d not found" % args.encap)
+        word = (1 << 30) | (bucket * BUCKET_SZ + slot)
+    else:
+        word = 0
+    nfp_rtsym.write_words(PORT_SYM, args.port * 4, [word])
+
+
+def cmd_show(args):
+    unknown, bad_hdr, bad_encap = nfp_rtsym.read_u64(GCNTR_SYM, 0, 3)
+    print("unknown_vni %d bad_hdr %d bad_encap %d" %
+          (unknown, bad_hdr, bad_encap))
+    for vni in args.vnis:
+        bucket, slot, _ = find_vni(vni)
+        if slot is None:
+            print("VNI %d not found" % vni)
+            continue
+        idx = bucket * BUCKET_SZ + slot
+        vals = nfp_rtsym.read_u64(CNTR_SYM, idx * CNTR_SIZE, 4)
+        print("VNI %d: decap %d pkts %d bytes, encap %d pkts %d bytes" %
+              tuple([vni] + vals))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p = sub.add_parser("tmpl", help="write an outer header template")
+    p.add_argument("idx", type=int)
+    p.add_argument("--vni", type=int, required=True)
+    p.add_argument("--smac", required=True)
+    p.add_argument("--dmac", required=True)
+    p.add_argument("--sip", required=True)
+    p.add_argument("--dip", required=True)
+    p.add_argument("--ttl", type=int, default=64)
+    p.add_argument("--tos", type=int, default=0)
+    p.add_argument("--dport", type=int, default=UDP_PORT)
+    p.add_argument("--islands", type=lambda v: [int(i) for i in v.split(",")],
+                   default=[32, 33], help="islands running the wire app")
+    p.set_defaults(func=cmd_tmpl)
+
+    p = sub.add_parser("vni-add", help="add or update a VNI")
+    p.add_argument("vni", type=int)
+    p.add_argument("--tenant", type=int, required=True)
+    p.add_argument("--tmpl", type=int, default=0,
+                   help="template used to encapsulate into this VNI")
+    p.set_defaults(func=cmd_vni_add)
+
+    p = sub.add_parser("vni-del", help="remove a VNI")
+    p.add_argument("vni", type=int)
+    p.set_defaults(func=cmd_vni_del)
+
+    p = sub.add_parser("port", help="set the tunnel mode of a port")
+    p.add_argument("port", type=int)
+    grp = p.add_mutually_exclusive_group()
+    grp.add_argument("--decap", action="store_true",
+                     help="terminate VXLAN received on the port")
+    grp.add_argument("--encap", type=int, metavar="VNI",
+                     help="encapsulate frames received on the port")
+    p.set_defaults(func=cmd_port)
+
+    p = sub.add_parser("show", help="show counters")
+    p.add_argument("vnis", type=int, nargs="*")
+    p.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015-2018,  Netronome Systems, Inc.  All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# @file         tools/wred_ctl.py
+# @brief        Configure and monitor the wire app WRED/ECN profiles
+#
+
+"""Configure the WRED/ECN profiles of the wire app.
+
+The layout matches struct wred_profile in apps/wire/wred.h.  A class is
+the offset of a TM queue within the queues of its port.  Thresholds are
+average queue depths in packets, the probability grows linearly from 0 at
+the minimum to --max-p at the maximum threshold.
+"""
+
+from __future__ import print_function
+
+import argparse
+import sys
+
+import nfp_rtsym
+
+PROF_SYM = "_wred_profile"
+CNTR_SYM = "_wred_cntrs"
+PROF_SIZE = 16
+CNTR_SIZE = 24
+
+CLASSES = 8
+# Width of the TM queue level
+MAX_TH = 8191
+PROB_ONE = 1 << 16
+
+
+def cmd_set(args):
+    if not 0 <= args.min < args.max <= MAX_TH:
+        sys.exit("need 0 <= --min < --max <= %d" % MAX_TH)
+    if not 0.0 < args.max_p <= 1.0:
+        sys.exit("--max-p must be within 0 and 1")
+
+    # Rounded down, so the probability never exceeds --max-p on the ramp
+    slope = int(args.max_p * PROB_ONE) // (args.max - args.min)
+    if slope == 0:
+        sys.exit("--max-p is below one 1/65536 step per packet of the ramp")
+
+    flags = (1 << 31) | ((1 << 30) if args.ecn else 0)
+    words = [flags, (args.min << 16) | args.max, slope, 0]
+    off = args.cls * PROF_SIZE
+    print("%s:%d = %s" % (PROF_SYM, off, " ".join("0x%08x" % w for w in words)))
+    print("p = %.4f at %d packets" %
+          (float(slope * (args.max - args.min)) / PROB_ONE, args.max))
+    if args.write:
+        nfp_rtsym.write_words(PROF_SYM, off, [0])
+        nfp_rtsym.write_words(PROF_SYM, off + 4, words[1:])
+        nfp_rtsym.write_words(PROF_SYM, off, words[:1])
+
+
+def cmd_clear(args):
+    nfp_rtsym.write_words(PROF_SYM, args.cls * PROF_SIZE, [0])
+
+
+def cmd_show(args):
+    print("%-4s %-4s %6s %6s %20s %20s %20s" %
+          ("cls", "ecn", "min", "max", "mark", "drop", "forced"))
+    for cls in range(CLASSES):
+        words = nfp_rtsym.read_words(PROF_SYM, cls * PROF_SIZE, 2)
+        if not words[0] >> 31:
+            continue
+        vals = nfp_rtsym.read_u64(CNTR_SYM, cls * CNTR_SIZE, 3)
+        print("%-4d %-4s %6d %6d %20d %20d %20d" %
+              (cls, "yes" if (words[0] >> 30) & 1 else "no",
+               words[1] >> 16, words[1] & 0xffff, vals[0], vals[1], vals[2]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    sub = parser.add_subparsers(dest="cmd")
+
+    p_set = sub.add_parser("set", help="set the profile of a class")
+    p_set.add_argument("cls", type=int, choices=range(CLASSES))
+    p_set.add_argument("--min", type=int, required=True,
+                       help="minimum threshold in packets")
+    p_set.add_argument("--max", type=int, required=True,
+                       help="maximum threshold in packets")
+    p_set.add_argument("--max-p", type=float, default=0.1,
+                       help="mark/drop probability at the maximum threshold")
+    p_set.add_argument("--ecn", action="store_true",
+                       help="mark ECN capable packets instead of dropping")
+    p_set.add_argument("--write", action="store_true",
+                       help="write the profile to the loaded firmware")
+    p_set.set_defaults(func=cmd_set)
+
+    p_clr = sub.add_parser("clear", help="disable the profile of a class")
+    p_clr.add_argument("cls", type=int, choices=range(CLASSES))
+    p_clr.set_defaults(func=cmd_clear)
+
+    p_show = sub.add_parser("show", help="show the profiles and counters")
+    p_show.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd is None:
+        parser.error("a command is required")
+    args.func(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())